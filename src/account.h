@@ -35,12 +35,18 @@ struct account_data {
 struct account_stash_slot {
   struct obj_data *obj;  /* owned by the stash while stored */
   int count;             /* number of items in this slot, 0 if empty */
+  unsigned long key;     /* identity hash of obj, while occupied */
+  int next;              /* next occupied slot in the same bucket, or -1 */
 };
 struct account_stash {
   int capacity;
   int used;
   struct account_stash_slot *slots;
   int dirty; /* use int to avoid stdbool in header */
+  int *buckets;            /* first occupied slot per key bucket, or -1 */
+  int num_buckets;         /* a power of two */
+  unsigned long *free_map; /* a bit set for each empty slot */
+  struct account_data *owner;
 };
 
 
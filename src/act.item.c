@@ -23,6 +23,8 @@
 #include "act.h"
 #include "quest.h"
 #include "boards.h"
+#include "kwindex.h"
+#include "journal.h"
 
 
 /* local function prototypes */
@@ -625,7 +627,7 @@ ACMD(do_drop)
   if (amount && (subcmd == SCMD_JUNK)) {
     send_to_char(ch, "You have been rewarded by the gods!\r\n");
     act("$n has been rewarded by the gods!", TRUE, ch, 0, 0, TO_ROOM);
-    GET_GOLD(ch) += amount;
+    increase_gold(ch, amount);
   }
 }
 
@@ -808,7 +810,7 @@ void name_from_drinkcon(struct obj_data *obj)
   new_name = right_trim_whitespace(obj->name);
   free(obj->name);
   obj->name = new_name;
- 
+  kw_reindex_obj(obj);
 }
 
 void name_to_drinkcon(struct obj_data *obj, int type)
@@ -825,6 +827,7 @@ void name_to_drinkcon(struct obj_data *obj, int type)
     free(obj->name);
 
   obj->name = new_name;
+  kw_reindex_obj(obj);
 }
 
 ACMD(do_drink)
@@ -1619,10 +1622,14 @@ ACMD(do_sac)
     case 2:
       send_to_char(ch, "You sacrifice %s to the Gods.\r\nThe gods give you %d experience points.\r\n", GET_OBJ_SHORT(j), 1+2*GET_OBJ_LEVEL(j));
       GET_EXP(ch) += (1+2*GET_OBJ_LEVEL(j));
+      SET_SAVE_DIRTY(ch, SAVE_STATS);
+      journal_points(ch);
     break;
     case 3:
       send_to_char(ch, "You sacrifice %s to the Gods.\r\nYou receive %d experience points.\r\n", GET_OBJ_SHORT(j), 1+GET_OBJ_LEVEL(j));
       GET_EXP(ch) += (1+GET_OBJ_LEVEL(j));
+      SET_SAVE_DIRTY(ch, SAVE_STATS);
+      journal_points(ch);
     break;
     case 4:
       send_to_char(ch, "Your sacrifice to the Gods is rewarded with %d gold coins.\r\n", 1+GET_OBJ_LEVEL(j));
@@ -31,6 +31,7 @@
 #include "quest.h"
 #include "modify.h"
 #include "account.h"
+#include "journal.h"
 
 /* Local defined utility functions */
 /* do_group utility functions */
@@ -893,6 +894,8 @@ ACMD(do_gen_tog)
     return;
   }
 
+  SET_SAVE_DIRTY(ch, SAVE_STATS);
+
   if (result)
     send_to_char(ch, "%s", tog_messages[subcmd][TOG_ON]);
   else
@@ -1222,6 +1225,9 @@ if (!strcasecmp(a1, "put")) {
   }
 
   acc_stash_list(ch);
+  /* The stash file must be written before the journal drops the item. */
+  acc_stash_flush(ch);
+  journal_objs(ch);
   return;
 }
 
@@ -1240,6 +1246,8 @@ if (!strcasecmp(a1, "take") || !strcasecmp(a1, "get")) {
   }
 
   acc_stash_list(ch);
+  acc_stash_flush(ch);
+  journal_objs(ch);
   return;
 }
 
@@ -36,6 +36,9 @@
 #include "ban.h"
 #include "screen.h"
 #include "account.h"
+#include "kwindex.h"
+#include "savequeue.h"
+#include "journal.h"
 
 #ifndef CRYPT
 #define CRYPT(a, b) ((char *) crypt((a), (b)))
@@ -2471,7 +2474,7 @@ static size_t print_zone_to_buf(char *bufptr, size_t left, zone_rnum zone, int l
 	zone_table[zone].bot, zone_table[zone].top);
         j = k = l = m = n = o = 0;
 
-        for (i = 0; i < top_of_world; i++)
+        for (i = 0; i <= top_of_world; i++)
           if (world[i].number >= zone_table[zone].bot && world[i].number <= zone_table[zone].top)
             j++;
 
@@ -2504,9 +2507,10 @@ static size_t print_zone_to_buf(char *bufptr, size_t left, zone_rnum zone, int l
                         "         Mobiles:  %2d\r\n"
                         "         Shops:    %2d\r\n"
                         "         Triggers: %2d\r\n"
-                        "         Quests:   %2d\r\n",
+                        "         Quests:   %2d\r\n"
+                        "         Loaded:   %s\r\n",
 			buf, zone_table[zone].min_level, zone_table[zone].max_level,
-                        j, k, l, m, n, o);
+                        j, k, l, m, n, o, YESNO(zone_table[zone].populated));
 
     return tmp;
   }
@@ -2708,6 +2712,14 @@ ACMD(do_show)
 	buf_largecount, total_quests,
 	buf_switches, buf_overflows, global_lists->iSize
 	);
+    {
+      long uids, slots;
+      int probe;
+
+      lookup_table_stats(&uids, &slots, &probe);
+      send_to_char(ch, "  %5ld script uids in %ld slots (%ld%% load, longest probe %d)\r\n",
+        uids, slots, slots ? uids * 100 / slots : 0, probe);
+    }
     break;
 
   /* show errors */
@@ -3371,6 +3383,8 @@ static int perform_set(struct char_data *ch, struct char_data *vict, int mode, c
       send_to_char(ch, "Can't set that!\r\n");
       return (0);
     }
+  SET_SAVE_DIRTY(vict, SAVE_PFILE);
+  journal_points(vict);
   /* Show the new value of the variable */
   if (set_fields[mode].type == BINARY) {
     send_to_char(ch, "%s %s for %s.\r\n", set_fields[mode].cmd, ONOFF(on), GET_NAME(vict));
@@ -3501,6 +3515,8 @@ ACMD(do_saveall)
  else {
     save_all();
     House_save_all();
+    room_save_dirty_rooms();
+    acc_stash_save_dirty();
     send_to_char(ch, "World and house files saved.\n\r");
  }
 }
@@ -3510,7 +3526,7 @@ ACMD(do_links)
   zone_rnum zrnum;
   zone_vnum zvnum;
   room_rnum nr, to_room;
-  int first, last, j;
+  int first, last, vnum, j;
   char arg[MAX_INPUT_LENGTH];
 
 
@@ -3534,8 +3550,8 @@ ACMD(do_links)
   first = zone_table[zrnum].bot;
 
   send_to_char(ch, "Zone %d is linked to the following zones:\r\n", zvnum);
-  for (nr = 0; nr <= top_of_world && (GET_ROOM_VNUM(nr) <= last); nr++) {
-    if (GET_ROOM_VNUM(nr) >= first) {
+  for (vnum = first; vnum <= last; vnum++) {
+    if ((nr = real_room(vnum)) != NOWHERE) {
       for (j = 0; j < DIR_COUNT; j++) {
         if (world[nr].dir_option[j]) {
           to_room = world[nr].dir_option[j]->to_room;
@@ -3900,7 +3916,7 @@ ACMD (do_zcheck)
 
   /* Check rooms */
   send_to_char(ch, "\r\nChecking Rooms for limits...\r\n");
-  for (i=0; i<top_of_world;i++) {
+  for (i=0; i<=top_of_world;i++) {
     if (world[i].zone==zrnum) {
       for (j = 0; j < DIR_COUNT; j++) {
         /*check for exit, but ignore off limits if you're in an offlimit zone*/
@@ -3965,7 +3981,7 @@ ACMD (do_zcheck)
     } /*is room in this zone?*/
   } /*checking rooms*/
 
-  for (i=0; i<top_of_world;i++) {
+  for (i=0; i<=top_of_world;i++) {
     if (world[i].zone==zrnum) {
       m++;
       for (j = 0, k = 0; j < DIR_COUNT; j++)
@@ -4183,7 +4199,7 @@ static void trg_checkload(struct char_data *ch, trig_vnum tvnum)
       }
   }
 
-  for (k = 0;k < top_of_world; k++) {
+  for (k = 0;k <= top_of_world; k++) {
     if (!world[k].proto_script)
       continue;
 
@@ -4274,6 +4290,12 @@ ACMD(do_copyover)
   fprintf (fp, "-1\n");
   fclose (fp);
 
+  /* The writer thread does not survive the exec, so finish its work now. */
+  room_save_dirty_rooms();
+  acc_stash_save_dirty();
+  saveq_shutdown();
+  journal_shutdown();
+
   /* exec - descriptors are inherited */
   sprintf (buf, "%d", port);
   sprintf (buf2, "-C%d", mother_desc);
@@ -4685,7 +4707,7 @@ ACMD(do_wizupdate)
 bool change_player_name(struct char_data *ch, struct char_data *vict, char *new_name)
 {
   struct char_data *temp_ch=NULL;
-  int plr_i = 0, i, k;
+  int plr_i = 0, i;
   char old_name[MAX_NAME_LENGTH], old_pfile[50], new_pfile[50], buf[MAX_STRING_LENGTH];
 
   if (!ch)
@@ -4726,11 +4748,7 @@ bool change_player_name(struct char_data *ch, struct char_data *vict, char *new_
   }
 
   /* New playername is OK - find the entry in the index */
-  for (i = 0; i <= top_of_p_table; i++)
-    if (player_table[i].id == GET_IDNUM(vict))
-      break;
-
-  if (player_table[i].id != GET_IDNUM(vict))
+  if ((i = get_ptable_by_id(GET_IDNUM(vict))) < 0)
   {
     send_to_char(ch, "Your target was not found in the player index.\r\n");
     log("SYSERR: Player %s, with ID %ld, could not be found in the player index.", GET_NAME(vict), GET_IDNUM(vict));
@@ -4751,12 +4769,12 @@ bool change_player_name(struct char_data *ch, struct char_data *vict, char *new_
   }
 
   /* Now start changing the name over - all checks and setup have passed */
-  free(player_table[i].name);              // Free the old name in the index
-  player_table[i].name = strdup(new_name); // Insert the new name into the index
-  for (k=0; (*(player_table[i].name+k) = LOWER(*(player_table[i].name+k))); k++);
+  saveq_wait(old_pfile);
+  set_ptable_name(i, new_name);            // Replace the name in the index
 
   free(GET_PC_NAME(vict));
   GET_PC_NAME(vict) = strdup(CAP(new_name));    // Change the name in the victims char struct
+  kw_reindex_char(vict);
 
   /* Rename the player's pfile */
   sprintf(buf, "mv %s %s", old_pfile, new_pfile);
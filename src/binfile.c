@@ -0,0 +1,125 @@
+/**
+* @file binfile.c
+* Little endian byte buffers for the binary save file formats.
+*
+* Part of the core tbaMUD source code distribution, which is a derivative
+* of, and continuation of, CircleMUD.
+*
+* Integers are written in a fixed width of 1 to 8 bytes, least significant
+* byte first, and read back sign-extended. Strings are their length in a
+* fixed width followed by the bytes, with no terminating nul.
+*/
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include "structs.h"
+#include "utils.h"
+#include "binfile.h"
+
+/** Make room for len more bytes at the end of b. */
+void bin_need(struct bin_buf *b, size_t len)
+{
+  if (b->len + len <= b->size)
+    return;
+  b->size = MAX(b->len + len, MAX(b->size * 2, 4096));
+  RECREATE(b->data, unsigned char, b->size);
+}
+
+/** Overwrite width bytes at pos, which must already be in b. */
+void bin_patch(struct bin_buf *b, size_t pos, long long val, int width)
+{
+  int i;
+
+  for (i = 0; i < width; i++, val >>= 8)
+    b->data[pos + i] = (unsigned char) (val & 0xFF);
+}
+
+void bin_put(struct bin_buf *b, long long val, int width)
+{
+  bin_need(b, width);
+  bin_patch(b, b->len, val, width);
+  b->len += width;
+}
+
+void bin_put_bytes(struct bin_buf *b, const void *data, size_t len)
+{
+  if (!len)
+    return;
+  bin_need(b, len);
+  memcpy(b->data + b->len, data, len);
+  b->len += len;
+}
+
+/** Write str, or an empty string for NULL, after a length of width bytes.
+ * Anything that does not fit the length is cut off. */
+void bin_put_str(struct bin_buf *b, const char *str, int width)
+{
+  size_t len = str ? strlen(str) : 0;
+
+  if (width < (int) sizeof(size_t) && len >= ((size_t) 1 << (width * 8 - 1)))
+    len = ((size_t) 1 << (width * 8 - 1)) - 1;
+  bin_put(b, len, width);
+  bin_put_bytes(b, str, len);
+}
+
+void bin_reader_init(struct bin_reader *r, const void *data, size_t len)
+{
+  r->pos = data;
+  r->end = r->pos + len;
+  r->bad = FALSE;
+}
+
+long long bin_get(struct bin_reader *r, int width)
+{
+  unsigned long long val = 0;
+  int i;
+
+  if (r->end - r->pos < width) {
+    r->bad = TRUE;
+    r->pos = r->end;
+    return (0);
+  }
+  for (i = width - 1; i >= 0; i--)
+    val = (val << 8) | r->pos[i];
+  r->pos += width;
+
+  /* Sign-extend. */
+  if (width < 8 && (val & (1ULL << (width * 8 - 1))))
+    val |= ~0ULL << (width * 8);
+  return ((long long) val);
+}
+
+/** Step over len bytes and return where they start, or NULL if there are not
+ * that many left. */
+const unsigned char *bin_get_bytes(struct bin_reader *r, size_t len)
+{
+  const unsigned char *start = r->pos;
+
+  if ((size_t) (r->end - r->pos) < len) {
+    r->bad = TRUE;
+    r->pos = r->end;
+    return (NULL);
+  }
+  r->pos += len;
+  return (start);
+}
+
+/** Read a string with a length of width bytes in front into new memory. */
+char *bin_get_str(struct bin_reader *r, int width)
+{
+  long long len = bin_get(r, width);
+  const unsigned char *data;
+  char *str;
+
+  if (len < 0 || !(data = bin_get_bytes(r, len))) {
+    r->bad = TRUE;
+    len = 0;
+    data = NULL;
+  }
+  CREATE(str, char, len + 1);
+  if (len)
+    memcpy(str, data, len);
+  str[len] = '\0';
+  return (str);
+}
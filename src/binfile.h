@@ -0,0 +1,38 @@
+/**
+* @file binfile.h
+* Little endian byte buffers for the binary save file formats.
+*
+* Part of the core tbaMUD source code distribution, which is a derivative
+* of, and continuation of, CircleMUD.
+*/
+
+#ifndef _BINFILE_H_
+#define _BINFILE_H_
+
+/** A growable buffer a binary record or file is built in. Start it zeroed. */
+struct bin_buf {
+  unsigned char *data;
+  size_t len;
+  size_t size;
+};
+
+/** A position in a binary record being read. Reading past the end sets
+ * 'bad' and returns zeroes, so a parser can check once at the end. */
+struct bin_reader {
+  const unsigned char *pos;
+  const unsigned char *end;
+  int bad;
+};
+
+void bin_need(struct bin_buf *b, size_t len);
+void bin_put(struct bin_buf *b, long long val, int width);
+void bin_patch(struct bin_buf *b, size_t pos, long long val, int width);
+void bin_put_bytes(struct bin_buf *b, const void *data, size_t len);
+void bin_put_str(struct bin_buf *b, const char *str, int width);
+
+void bin_reader_init(struct bin_reader *r, const void *data, size_t len);
+long long bin_get(struct bin_reader *r, int width);
+const unsigned char *bin_get_bytes(struct bin_reader *r, size_t len);
+char *bin_get_str(struct bin_reader *r, int width);
+
+#endif /* _BINFILE_H_ */
@@ -134,6 +134,12 @@ static void cedit_setup(struct descriptor_data *d)
   OLC_CONFIG(d)->operation.protocol_negotiation = CONFIG_PROTOCOL_NEGOTIATION;
   OLC_CONFIG(d)->operation.special_in_comm    = CONFIG_SPECIAL_IN_COMM;
   OLC_CONFIG(d)->operation.debug_mode    = CONFIG_DEBUG_MODE;
+  OLC_CONFIG(d)->operation.script_pulse_lines = CONFIG_SCRIPT_PULSE_LINES;
+  OLC_CONFIG(d)->operation.script_pulse_msec  = CONFIG_SCRIPT_PULSE_MSEC;
+  OLC_CONFIG(d)->operation.lazy_zones         = CONFIG_LAZY_ZONES;
+  OLC_CONFIG(d)->operation.lazy_zone_idle     = CONFIG_LAZY_ZONE_IDLE;
+  OLC_CONFIG(d)->operation.binary_pfiles      = CONFIG_BINARY_PFILES;
+  OLC_CONFIG(d)->operation.binary_objfiles    = CONFIG_BINARY_OBJFILES;
   
   /* Autowiz */
   OLC_CONFIG(d)->autowiz.use_autowiz          = CONFIG_USE_AUTOWIZ;
@@ -238,6 +244,12 @@ static void cedit_save_internally(struct descriptor_data *d)
   CONFIG_PROTOCOL_NEGOTIATION = OLC_CONFIG(d)->operation.protocol_negotiation;
   CONFIG_SPECIAL_IN_COMM      = OLC_CONFIG(d)->operation.special_in_comm;
   CONFIG_DEBUG_MODE           = OLC_CONFIG(d)->operation.debug_mode;
+  CONFIG_SCRIPT_PULSE_LINES   = OLC_CONFIG(d)->operation.script_pulse_lines;
+  CONFIG_SCRIPT_PULSE_MSEC    = OLC_CONFIG(d)->operation.script_pulse_msec;
+  CONFIG_LAZY_ZONES           = OLC_CONFIG(d)->operation.lazy_zones;
+  CONFIG_LAZY_ZONE_IDLE       = OLC_CONFIG(d)->operation.lazy_zone_idle;
+  CONFIG_BINARY_PFILES        = OLC_CONFIG(d)->operation.binary_pfiles;
+  CONFIG_BINARY_OBJFILES      = OLC_CONFIG(d)->operation.binary_objfiles;
     
   /* Autowiz */
   CONFIG_USE_AUTOWIZ          = OLC_CONFIG(d)->autowiz.use_autowiz;
@@ -571,6 +583,26 @@ int save_config( IDXTYPE nowhere )
               "debug_mode = %d\n\n",
               CONFIG_DEBUG_MODE);
 
+  fprintf(fl, "* How many script lines and milliseconds triggers may use per pulse\n"
+              "* before they are suspended until the next pulse (0 = no limit).\n"
+              "script_pulse_lines = %d\n\n"
+              "script_pulse_msec = %d\n\n",
+              CONFIG_SCRIPT_PULSE_LINES, CONFIG_SCRIPT_PULSE_MSEC);
+
+  fprintf(fl, "* Populate zones on first player entry instead of at boot, and\n"
+              "* unload them after this many minutes without players (0 = never).\n"
+              "lazy_zones = %d\n\n"
+              "lazy_zone_idle = %d\n\n",
+              CONFIG_LAZY_ZONES, CONFIG_LAZY_ZONE_IDLE);
+
+  fprintf(fl, "* Write player files in the binary format instead of ASCII.\n"
+              "binary_pfiles = %d\n\n",
+              CONFIG_BINARY_PFILES);
+
+  fprintf(fl, "* Write rent and house files in the binary format instead of ASCII.\n"
+              "binary_objfiles = %d\n\n",
+              CONFIG_BINARY_OBJFILES);
+
   fclose(fl);
 
   if (in_save_list(NOWHERE, SL_CFG))
@@ -762,6 +794,12 @@ static void cedit_disp_operation_options(struct descriptor_data *d)
   	"%sR%s) Enable Protocol Negotiation : %s%s\r\n"
   	"%sS%s) Enable Special Char in Comm : %s%s\r\n"
   	"%sT%s) Current Debug Mode : %s%s\r\n"
+  	"%sU%s) Script Lines Per Pulse : %s%d\r\n"
+  	"%sV%s) Script Msec Per Pulse  : %s%d\r\n"
+  	"%sW%s) Lazy Zone Loading      : %s%s\r\n"
+  	"%sX%s) Idle Zone Unload (min) : %s%d\r\n"
+  	"%sY%s) Binary Player Files    : %s%s\r\n"
+  	"%sZ%s) Binary Object Files    : %s%s\r\n"
     "%sQ%s) Exit To The Main Menu\r\n"
     "Enter your choice : ",
     grn, nrm, cyn, OLC_CONFIG(d)->operation.DFLT_PORT,
@@ -783,6 +821,12 @@ static void cedit_disp_operation_options(struct descriptor_data *d)
     grn, nrm, cyn, OLC_CONFIG(d)->operation.protocol_negotiation ? "Yes" : "No",
     grn, nrm, cyn, OLC_CONFIG(d)->operation.special_in_comm ? "Yes" : "No",
     grn, nrm, cyn, OLC_CONFIG(d)->operation.debug_mode == 0 ? "OFF" : (OLC_CONFIG(d)->operation.debug_mode == 1 ? "BRIEF" : (OLC_CONFIG(d)->operation.debug_mode == 2 ? "NORMAL" : "COMPLETE")),
+    grn, nrm, cyn, OLC_CONFIG(d)->operation.script_pulse_lines,
+    grn, nrm, cyn, OLC_CONFIG(d)->operation.script_pulse_msec,
+    grn, nrm, cyn, YESNO(OLC_CONFIG(d)->operation.lazy_zones),
+    grn, nrm, cyn, OLC_CONFIG(d)->operation.lazy_zone_idle,
+    grn, nrm, cyn, YESNO(OLC_CONFIG(d)->operation.binary_pfiles),
+    grn, nrm, cyn, YESNO(OLC_CONFIG(d)->operation.binary_objfiles),
     grn, nrm
     );
 
@@ -1281,6 +1325,39 @@ void cedit_parse(struct descriptor_data *d, char *arg)
            OLC_MODE(d) = CEDIT_DEBUG_MODE;
            return;
 
+         case 'u':
+         case 'U':
+           write_to_output(d, "Enter the script lines allowed per pulse (0 for no limit) : ");
+           OLC_MODE(d) = CEDIT_SCRIPT_PULSE_LINES;
+           return;
+
+         case 'v':
+         case 'V':
+           write_to_output(d, "Enter the script milliseconds allowed per pulse (0 for no limit) : ");
+           OLC_MODE(d) = CEDIT_SCRIPT_PULSE_MSEC;
+           return;
+
+         case 'w':
+         case 'W':
+           TOGGLE_VAR(OLC_CONFIG(d)->operation.lazy_zones);
+           break;
+
+         case 'x':
+         case 'X':
+           write_to_output(d, "Enter the minutes an empty zone stays loaded (0 to never unload) : ");
+           OLC_MODE(d) = CEDIT_LAZY_ZONE_IDLE;
+           return;
+
+         case 'y':
+         case 'Y':
+           TOGGLE_VAR(OLC_CONFIG(d)->operation.binary_pfiles);
+           break;
+
+         case 'z':
+         case 'Z':
+           TOGGLE_VAR(OLC_CONFIG(d)->operation.binary_objfiles);
+           break;
+
          case 'q':
          case 'Q':
            cedit_disp_menu(d);
@@ -1671,6 +1748,21 @@ void cedit_parse(struct descriptor_data *d, char *arg)
       cedit_disp_operation_options(d);
       break;
 
+    case CEDIT_SCRIPT_PULSE_LINES:
+      OLC_CONFIG(d)->operation.script_pulse_lines = MAX(atoi(arg), 0);
+      cedit_disp_operation_options(d);
+      break;
+
+    case CEDIT_SCRIPT_PULSE_MSEC:
+      OLC_CONFIG(d)->operation.script_pulse_msec = LIMIT(atoi(arg), 0, 1000 / PASSES_PER_SEC);
+      cedit_disp_operation_options(d);
+      break;
+
+    case CEDIT_LAZY_ZONE_IDLE:
+      OLC_CONFIG(d)->operation.lazy_zone_idle = MAX(atoi(arg), 0);
+      cedit_disp_operation_options(d);
+      break;
+
     case CEDIT_MIN_WIZLIST_LEV:
       if (atoi(arg) > LVL_IMPL) {
         write_to_output(d,
@@ -1730,7 +1822,7 @@ static void reassign_rooms(void)
   int i;
 
   /* remove old funcs */
-  for (i = 0; i < top_of_world; i++)
+  for (i = 0; i <= top_of_world; i++)
     world[i].func = NULL;
 
   /* reassign spec_procs */
@@ -83,6 +83,9 @@
 #include "ibt.h" /* for free_ibt_lists */
 #include "mud_event.h"
 #include "account.h"
+#include "savequeue.h"
+#include "journal.h"
+#include "mail.h"
 
 #ifndef INVALID_SOCKET
 #define INVALID_SOCKET (-1)
@@ -131,6 +134,7 @@ static RETSIGTYPE unrestrict_game(int sig);
 static RETSIGTYPE reap(int sig);
 static RETSIGTYPE checkpointing(int sig);
 static RETSIGTYPE hupsig(int sig);
+static volatile sig_atomic_t hupsig_received = 0;
 static ssize_t perform_socket_read(socket_t desc, char *read_point,size_t space_left);
 static ssize_t perform_socket_write(socket_t desc, const char *txt,size_t length);
 static void circle_sleep(struct timeval *timeout);
@@ -521,6 +525,9 @@ static void init_game(ush_int local_port)
 
   event_init();
 
+  /* start the background writer for player, rent and variable files */
+  saveq_init();
+
   /* set up hash table for find_char() */
   init_lookup_table();
 
@@ -541,7 +548,13 @@ static void init_game(ush_int local_port)
 
   game_loop(mother_desc);
 
+  if (hupsig_received)
+    log("SYSERR: Received SIGHUP, SIGINT, or SIGTERM.  Shutting down...");
+
   Crash_save_all();
+  House_save_all();
+  room_save_dirty_rooms();
+  acc_stash_save_dirty();
 
   log("Closing all sockets.");
   while (descriptor_list)
@@ -555,6 +568,10 @@ static void init_game(ush_int local_port)
   log("Saving current MUD time.");
   save_mud_time(&time_info);
 
+  log("Flushing queued saves.");
+  saveq_shutdown();
+  journal_shutdown();
+
   if (circle_reboot) {
     log("Rebooting.");
     exit(52);			/* what's so great about HHGTTG, anyhow? */
@@ -765,6 +782,9 @@ void game_loop(socket_t local_mother_desc)
 
     /* Sleep if we don't have any connections */
     if (descriptor_list == NULL) {
+      /* Nothing runs the heartbeat while asleep, so save what is waiting. */
+      room_save_dirty_rooms();
+      acc_stash_save_dirty();
       log("No connections.  Going to sleep.");
       FD_ZERO(&input_set);
       FD_SET(local_mother_desc, &input_set);
@@ -982,8 +1002,7 @@ void game_loop(socket_t local_mother_desc)
 
 void heartbeat(int heart_pulse)
 {
-  static int mins_since_crashsave = 0;
-
+  script_budget_reset();
   event_process();
 
   if (!(heart_pulse % PULSE_DG_SCRIPT))
@@ -999,6 +1018,7 @@ void heartbeat(int heart_pulse)
 
   if (!(heart_pulse % PULSE_ZONE))
     zone_update();
+  continue_zone_reset();
 
   if (!(heart_pulse % PULSE_IDLEPWD))		/* 15 seconds */
     check_idle_passwords();
@@ -1017,12 +1037,22 @@ void heartbeat(int heart_pulse)
     check_timed_quests();
   }
 
-  if (CONFIG_AUTO_SAVE && !(heart_pulse % PULSE_AUTOSAVE)) {	/* 1 minute */
-    if (++mins_since_crashsave >= CONFIG_AUTOSAVE_TIME) {
-      mins_since_crashsave = 0;
-      Crash_save_all();
-      House_save_all();
-    }
+  if (CONFIG_AUTO_SAVE) {
+    Crash_autosave();
+    House_autosave();
+  }
+
+  saveq_pulse();
+
+  if (!(heart_pulse % PULSE_JOURNAL))
+    journal_pulse();
+
+  if (!(heart_pulse % PULSE_MAIL))
+    mail_pulse();
+
+  if (!(heart_pulse % PULSE_PERSIST)) {
+    room_save_dirty_rooms();
+    acc_stash_save_dirty();
   }
 
   if (!(heart_pulse % PULSE_USAGE))
@@ -2271,11 +2301,12 @@ static RETSIGTYPE checkpointing(int sig)
 #endif
 }
 
-/* Dying anyway... */
+/* Shut down the normal way, so rooms, stashes and the save queue are flushed
+ * before the process goes. Only sets flags; game_loop() does the rest. */
 static RETSIGTYPE hupsig(int sig)
 {
-  log("SYSERR: Received SIGHUP, SIGINT, or SIGTERM.  Shutting down...");
-  exit(1); /* perhaps something more elegant should substituted */
+  hupsig_received = 1;
+  circle_shutdown = 1;
 }
 
 #endif	/* CIRCLE_UNIX */
@@ -2475,7 +2506,7 @@ void send_to_range(room_vnum start, room_vnum finish, const char *messg, ...)
   if (messg == NULL)
     return;
 
-  for (j = 0; j < top_of_world; j++) {
+  for (j = 0; j <= top_of_world; j++) {
     if (GET_ROOM_VNUM(j) >= start && GET_ROOM_VNUM(j) <= finish) {
       for (i = world[j].people; i; i = i->next_in_room) {
         if (!i->desc)
@@ -318,6 +318,30 @@ int special_in_comm = YES;
 /* Current Debug Mode */
 int debug_mode = OFF;
 
+/* Per-pulse budget for DG script execution. Once the triggers run during a
+ * pulse have used up this many script lines or milliseconds, a random, time
+ * or zone reset trigger that keeps going is suspended where it is and
+ * continues next pulse. Other triggers always run to the end. 0 means no
+ * limit. */
+int script_pulse_lines = 10000;
+int script_pulse_msec = 25;
+
+/* Lazy zones. If set to YES, zones are not reset at boot; each one is
+ * populated the first time a player walks into it. lazy_zone_idle is the
+ * number of minutes a populated zone may go without players before its mobs
+ * and loose objects are extracted again (0 = never). Rooms in persistent
+ * rooms keep their contents. */
+int lazy_zones = NO;
+int lazy_zone_idle = 0;
+
+/* Write player files in the binary format instead of ASCII? Either kind is
+ * read back regardless, so a player file changes format the next time it is
+ * saved. bin/plrconv converts files offline in both directions. */
+int binary_pfiles = NO;
+
+/* The same for rent, crash and house object files. */
+int binary_objfiles = NO;
+
 /*
 * Do you want to treat all objects as unique? Set to YES and
 * every object created in the game will be flagged as UNIQUE. This
@@ -71,6 +71,12 @@ extern int display_closed_doors;
 extern int protocol_negotiation;
 extern int special_in_comm;
 extern int debug_mode;
+extern int script_pulse_lines;
+extern int script_pulse_msec;
+extern int lazy_zones;
+extern int lazy_zone_idle;
+extern int binary_pfiles;
+extern int binary_objfiles;
 /* Automap and map options */
 extern int map_option;
 extern int default_map_size;
@@ -17,6 +17,7 @@
 #include "handler.h"
 #include "spells.h"
 #include "mail.h"
+#include "itemmail.h"
 #include "interpreter.h"
 #include "house.h"
 #include "constants.h"
@@ -41,12 +42,15 @@
 #include "htree.h"
 #include <sys/stat.h>
 #include "boards.h"
+#include "kwindex.h"
+#include "journal.h"
 
 /*  declarations of most of the 'global' variables */
 struct config_data config_info; /* Game configuration list.	 */
 
 struct room_data *world = NULL;	/* array of rooms		 */
 room_rnum top_of_world = 0;	/* ref to top element of world	 */
+static bool world_strings_shared = FALSE; /* fread_string() shares room text */
 
 struct char_data *character_list = NULL; /* global linked list of chars	*/
 struct index_data *mob_index;	/* index table for mobile file	 */
@@ -115,10 +119,13 @@ struct help_index_element *help_table = NULL;
 struct social_messg *soc_mess_list = NULL;      /* list of socials */
 int top_of_socialt = -1;                        /* number of socials */
 
-/* HTREE defines */
+/* HTREE defines - vnum to rnum maps, kept in step with the tables below */
 struct htree_node *room_htree = NULL;
 struct htree_node *mob_htree = NULL;
 struct htree_node *obj_htree = NULL;
+struct htree_node *zone_htree = NULL;
+struct htree_node *trig_htree = NULL;
+struct htree_node *qst_htree = NULL;
 void   free_obj_unique_hash();
 void   init_obj_unique_hash();
 
@@ -136,6 +143,7 @@ struct happyhour happy_data = {0,0,0,0};
 
 /* declaration of local (file scope) variables */
 static int converting = FALSE;
+static bool zone_reset_running = FALSE; /* an automatic reset is in progress */
 
 /* Local (file scope) utility functions */
 static int check_bitvector_names(bitvector_t bits, size_t namecount, const char *whatami, const char *whatbits);
@@ -154,6 +162,8 @@ static void get_one_line(FILE *fl, char *buf);
 static void check_start_rooms(void);
 static void renum_zone_table(void);
 static void log_zone_error(zone_rnum zone, int cmd_no, const char *message);
+static void update_lazy_zones(void);
+static void begin_zone_reset(zone_rnum zone);
 static void reset_time(void);
 static char fread_letter(FILE *fp);
 static void free_followers(struct follow_type *k);
@@ -161,6 +171,11 @@ static void load_default_config( void );
 static void free_extra_descriptions(struct extra_descr_data *edesc);
 static bitvector_t asciiflag_conv_aff(char *flag);
 static int hsort(const void *a, const void *b);
+static char *fread_string_dup(char *buf, int length);
+static void boot_table_reserve(int mode, int nr);
+static void boot_table_trim(int mode, const char *prefix, const char *index_filename);
+static void world_strings_booted(void);
+static void free_world_strings(void);
 
 /* routines for booting the system */
 char *fread_action(FILE *fl, int nr)
@@ -463,7 +478,10 @@ void boot_world(void)
   index_boot(DB_BOOT_TRG);
 
   log("Loading rooms.");
+  world_strings_shared = TRUE;
   index_boot(DB_BOOT_WLD);
+  world_strings_shared = FALSE;
+  world_strings_booted();
 
   log("Renumbering rooms.");
   renum_world();
@@ -502,8 +520,8 @@ static void free_extra_descriptions(struct extra_descr_data *edesc)
   for (; edesc; edesc = enext) {
     enext = edesc->next;
 
-    free(edesc->keyword);
-    free(edesc->description);
+    free_world_string(edesc->keyword);
+    free_world_string(edesc->description);
     free(edesc);
   }
 }
@@ -540,10 +558,8 @@ void destroy_db(void)
 
   /* Rooms */
   for (cnt = 0; cnt <= top_of_world; cnt++) {
-    if (world[cnt].name)
-      free(world[cnt].name);
-    if (world[cnt].description)
-      free(world[cnt].description);
+    free_world_string(world[cnt].name);
+    free_world_string(world[cnt].description);
     free_extra_descriptions(world[cnt].ex_description);
 
   if (world[cnt].events != NULL) {
@@ -567,16 +583,16 @@ void destroy_db(void)
       if (!world[cnt].dir_option[itr])
         continue;
 
-      if (world[cnt].dir_option[itr]->general_description)
-        free(world[cnt].dir_option[itr]->general_description);
-      if (world[cnt].dir_option[itr]->keyword)
-        free(world[cnt].dir_option[itr]->keyword);
+      free_world_string(world[cnt].dir_option[itr]->general_description);
+      free_world_string(world[cnt].dir_option[itr]->keyword);
       free(world[cnt].dir_option[itr]);
     }
   }
   free(world);
+  free_world_strings();
   top_of_world = 0;
   htree_free(room_htree);
+  room_htree = NULL;
 
   /* Objects */
   for (cnt = 0; cnt <= top_of_objt; cnt++) {
@@ -596,6 +612,7 @@ void destroy_db(void)
   free(obj_proto);
   free(obj_index);
   htree_free(obj_htree);
+  obj_htree = NULL;
 
   /* Mobiles */
   for (cnt = 0; cnt <= top_of_mobt; cnt++) {
@@ -619,6 +636,7 @@ void destroy_db(void)
   free(mob_proto);
   free(mob_index);
   htree_free(mob_htree);
+  mob_htree = NULL;
 
   /* Shops */
   destroy_shops();
@@ -648,6 +666,8 @@ void destroy_db(void)
     }
   }
   free(zone_table);
+  htree_free(zone_htree);
+  zone_htree = NULL;
 
 #undef THIS_CMD
 
@@ -666,26 +686,16 @@ void destroy_db(void)
     if (trig_index[cnt]->proto) {
       /* make sure to nuke the command list (memory leak) */
       /* free_trigger() doesn't free the command list */
-      if (trig_index[cnt]->proto->cmdlist) {
-        struct cmdlist_element *i, *j;
-        i = trig_index[cnt]->proto->cmdlist;
-        while (i) {
-          j = i->next;
-          if (i->cmd)
-            free(i->cmd);
-          free(i);
-          i = j;
-        }
-      }
+      free_cmdlist(trig_index[cnt]->proto->cmdlist);
       free_trigger(trig_index[cnt]->proto);
     }
     free(trig_index[cnt]);
   }
   free(trig_index);
+  htree_free(trig_htree);
+  trig_htree = NULL;
   free_obj_unique_hash();
 
-  /* Htree shutdown */
-  htree_shutdown(); 
   /* Events */
   event_free_all();
 
@@ -766,6 +776,9 @@ void boot_db(void)
     clean_pfiles();
   }
 
+  log("Replaying the player journal.");
+  journal_boot();
+
   log("Loading fight messages.");
   load_messages();
 
@@ -805,6 +818,7 @@ void boot_db(void)
     log("    Mail boot failed -- Mail system disabled");
     no_mail = 1;
   }
+  itemmail_boot();
 
   log("Loading boards.");
   init_boards();
@@ -850,11 +864,14 @@ void boot_db(void)
 }
 #endif
 
-  for (i = 0; i <= top_of_zone_table; i++) {
-    log("Resetting #%d: %s (rooms %d-%d).", zone_table[i].number,
-	zone_table[i].name, zone_table[i].bot, zone_table[i].top);
-    reset_zone(i);
-  }
+  if (CONFIG_LAZY_ZONES)
+    log("Lazy zones: deferring zone resets until first entry.");
+  else
+    for (i = 0; i <= top_of_zone_table; i++) {
+      log("Resetting #%d: %s (rooms %d-%d).", zone_table[i].number,
+	  zone_table[i].name, zone_table[i].bot, zone_table[i].top);
+      reset_zone(i);
+    }
 
   reset_q.head = reset_q.tail = NULL;
 
@@ -978,16 +995,108 @@ ackeof:
 /* function to count how many hash-mark delimited records exist in a file */
 int count_hash_records(FILE *fl)
 {
-  char buf[128];
+  char buf[READ_SIZE];	/* same chunks get_line() will see */
   int count = 0;
 
-  while (fgets(buf, 128, fl))
+  while (fgets(buf, READ_SIZE, fl))
     if (*buf == '#')
       count++;
 
   return (count);
 }
 
+/* Rooms, mobs, objects, triggers and quests are not counted before they are
+ * loaded; that took a second read of every file. Instead discrete_load() makes
+ * room for each record as it meets it, growing the table by doubling, and
+ * index_boot() trims it to size once the last file has been parsed. */
+#define BOOT_SIZED_WHILE_PARSING(mode) ((mode) == DB_BOOT_WLD || \
+  (mode) == DB_BOOT_MOB || (mode) == DB_BOOT_OBJ || (mode) == DB_BOOT_TRG || \
+  (mode) == DB_BOOT_QST)
+
+static int boot_records;	/* records of the current type parsed so far */
+static int boot_table_size;	/* records the current table has room for */
+
+static void boot_table_reserve(int mode, int nr)
+{
+  int old = boot_table_size;
+
+  if (nr < boot_table_size)
+    return;
+
+  boot_table_size = MAX(nr + 1, MAX(2 * boot_table_size, 128));
+
+  switch (mode) {
+  case DB_BOOT_TRG:
+    RECREATE(trig_index, struct index_data *, boot_table_size);
+    memset(trig_index + old, 0, sizeof(struct index_data *) * (boot_table_size - old));
+    break;
+  case DB_BOOT_WLD:
+    RECREATE(world, struct room_data, boot_table_size);
+    memset(world + old, 0, sizeof(struct room_data) * (boot_table_size - old));
+    break;
+  case DB_BOOT_MOB:
+    RECREATE(mob_proto, struct char_data, boot_table_size);
+    memset(mob_proto + old, 0, sizeof(struct char_data) * (boot_table_size - old));
+    RECREATE(mob_index, struct index_data, boot_table_size);
+    memset(mob_index + old, 0, sizeof(struct index_data) * (boot_table_size - old));
+    break;
+  case DB_BOOT_OBJ:
+    RECREATE(obj_proto, struct obj_data, boot_table_size);
+    memset(obj_proto + old, 0, sizeof(struct obj_data) * (boot_table_size - old));
+    RECREATE(obj_index, struct index_data, boot_table_size);
+    memset(obj_index + old, 0, sizeof(struct index_data) * (boot_table_size - old));
+    break;
+  case DB_BOOT_QST:
+    RECREATE(aquest_table, struct aq_data, boot_table_size);
+    memset(aquest_table + old, 0, sizeof(struct aq_data) * (boot_table_size - old));
+    break;
+  }
+}
+
+static void boot_table_trim(int mode, const char *prefix, const char *index_filename)
+{
+  int size[2];
+
+  /* Exit if 0 records, unless this is quests */
+  if (!boot_records) {
+    if (mode == DB_BOOT_QST)
+      return;
+    log("SYSERR: boot error - 0 records counted in %s/%s.", prefix,
+	index_filename);
+    exit(1);
+  }
+
+  switch (mode) {
+  case DB_BOOT_TRG:
+    RECREATE(trig_index, struct index_data *, boot_records);
+    break;
+  case DB_BOOT_WLD:
+    RECREATE(world, struct room_data, boot_records);
+    size[0] = sizeof(struct room_data) * boot_records;
+    log("   %d rooms, %d bytes.", boot_records, size[0]);
+    break;
+  case DB_BOOT_MOB:
+    RECREATE(mob_proto, struct char_data, boot_records);
+    RECREATE(mob_index, struct index_data, boot_records);
+    size[0] = sizeof(struct index_data) * boot_records;
+    size[1] = sizeof(struct char_data) * boot_records;
+    log("   %d mobs, %d bytes in index, %d bytes in prototypes.", boot_records, size[0], size[1]);
+    break;
+  case DB_BOOT_OBJ:
+    RECREATE(obj_proto, struct obj_data, boot_records);
+    RECREATE(obj_index, struct index_data, boot_records);
+    size[0] = sizeof(struct index_data) * boot_records;
+    size[1] = sizeof(struct obj_data) * boot_records;
+    log("   %d objs, %d bytes in index, %d bytes in prototypes.", boot_records, size[0], size[1]);
+    break;
+  case DB_BOOT_QST:
+    RECREATE(aquest_table, struct aq_data, boot_records);
+    size[0] = sizeof(struct aq_data) * boot_records;
+    log("   %d entries, %d bytes.", boot_records, size[0]);
+    break;
+  }
+}
+
 void index_boot(int mode)
 {
   const char *index_filename, *prefix = NULL;	/* NULL or egcs 1.1 complains */
@@ -1055,6 +1164,10 @@ void index_boot(int mode)
     if (*buf1 == '$')
       break;
 
+    /* these tables are sized while the files are parsed instead */
+    if (BOOT_SIZED_WHILE_PARSING(mode))
+      continue;
+
     snprintf(buf2, sizeof(buf2), "%s%s", prefix, buf1);
     if (!(db_file = fopen(buf2, "r"))) {
       log("SYSERR: File '%s' listed in '%s/%s': %s", buf2, prefix,
@@ -1071,7 +1184,7 @@ void index_boot(int mode)
   }
 
   /* Exit if 0 records, unless this is shops */
-  if (!rec_count) {
+  if (!rec_count && !BOOT_SIZED_WHILE_PARSING(mode)) {
     if (mode == DB_BOOT_SHP || mode == DB_BOOT_QST)
       return;
     log("SYSERR: boot error - 0 records counted in %s/%s.", prefix,
@@ -1081,28 +1194,6 @@ void index_boot(int mode)
 
   /* "bytes" does _not_ include strings or other later malloc'd things. */
   switch (mode) {
-  case DB_BOOT_TRG:
-    CREATE(trig_index, struct index_data *, rec_count);
-    break;
-  case DB_BOOT_WLD:
-    CREATE(world, struct room_data, rec_count);
-    size[0] = sizeof(struct room_data) * rec_count;
-    log("   %d rooms, %d bytes.", rec_count, size[0]);
-    break;
-  case DB_BOOT_MOB:
-    CREATE(mob_proto, struct char_data, rec_count);
-    CREATE(mob_index, struct index_data, rec_count);
-    size[0] = sizeof(struct index_data) * rec_count;
-    size[1] = sizeof(struct char_data) * rec_count;
-    log("   %d mobs, %d bytes in index, %d bytes in prototypes.", rec_count, size[0], size[1]);
-    break;
-  case DB_BOOT_OBJ:
-    CREATE(obj_proto, struct obj_data, rec_count);
-    CREATE(obj_index, struct index_data, rec_count);
-    size[0] = sizeof(struct index_data) * rec_count;
-    size[1] = sizeof(struct obj_data) * rec_count;
-    log("   %d objs, %d bytes in index, %d bytes in prototypes.", rec_count, size[0], size[1]);
-    break;
   case DB_BOOT_ZON:
     CREATE(zone_table, struct zone_data, rec_count);
     size[0] = sizeof(struct zone_data) * rec_count;
@@ -1113,14 +1204,10 @@ void index_boot(int mode)
     size[0] = sizeof(struct help_index_element) * rec_count;
     log("   %d entries, %d bytes.", rec_count, size[0]);
     break;
-  case DB_BOOT_QST:
-    CREATE(aquest_table, struct aq_data, rec_count);
-    size[0] = sizeof(struct aq_data) * rec_count;
-    log("   %d entries, %d bytes.", rec_count, size[0]);
-    break;
   }
 
   rewind(db_index);
+  boot_records = boot_table_size = 0;
 
   for (line_number = 1;; ++line_number) {
     if (fscanf(db_index, "%s\n", buf1) != 1) {
@@ -1167,6 +1254,9 @@ void index_boot(int mode)
   }
   fclose(db_index);
 
+  if (BOOT_SIZED_WHILE_PARSING(mode))
+    boot_table_trim(mode, prefix, index_filename);
+
   /* Sort the help index. */
   if (mode == DB_BOOT_HLP) {
     qsort(help_table, top_of_helpt, sizeof(struct help_index_element), hsort);
@@ -1207,8 +1297,9 @@ void discrete_load(FILE *fl, int mode, char *filename)
       }
       if (nr >= 99999)
 	return;
-      else
-	switch (mode) {
+
+      boot_table_reserve(mode, boot_records++);
+      switch (mode) {
 	case DB_BOOT_WLD:
 	  parse_room(fl, nr);
 	  break;
@@ -1224,7 +1315,7 @@ void discrete_load(FILE *fl, int mode, char *filename)
   case DB_BOOT_QST:
     parse_quest(fl, nr);
     break;
-	}
+      }
     } else {
       log("SYSERR: Format error in %s file %s near %s #%d", modes[mode],
 	  filename, modes[mode], nr);
@@ -1302,7 +1393,7 @@ void ensure_newline_terminated(struct extra_descr_data* new_descr) {
   if (end > new_descr->description && *(end - 1) != '\n') {
     CREATE(with_term, char, strlen(new_descr->description) + 3);
     sprintf(with_term, "%s\r\n", new_descr->description); /* snprintf ok : size checked above*/
-    free(new_descr->description);
+    free_world_string(new_descr->description);
     new_descr->description = with_term;
   }
 }
@@ -1583,6 +1674,9 @@ static void renum_zone_table(void)
 	ZCMD.command = '*';
       }
     }
+
+  for (zone = 0; zone <= top_of_zone_table; zone++)
+    compile_zone_resets(zone);
 }
 
 static void parse_simple_mob(FILE *mob_f, int i, int nr)
@@ -1786,6 +1880,7 @@ void parse_mobile(FILE *mob_f, int nr)
 
   mob_index[i].vnum = nr;
   mob_index[i].number = 0;
+  mob_index[i].mobs = NULL;
   mob_index[i].func = NULL;
 
   clear_char(mob_proto + i);
@@ -1939,6 +2034,7 @@ char *parse_object(FILE *obj_f, int nr)
 
   obj_index[i].vnum = nr;
   obj_index[i].number = 0;
+  obj_index[i].objs = NULL;
   obj_index[i].func = NULL;
 
   if (!obj_htree)
@@ -2283,6 +2379,10 @@ static void load_zones(FILE *fl, char *zonename)
     exit(1);
   }
 
+  if (!zone_htree)
+    zone_htree = htree_init();
+  htree_add(zone_htree, Z.number, zone);
+
   top_of_zone_table = zone++;
 }
 #undef Z
@@ -2455,6 +2555,7 @@ struct char_data *create_char(void)
   
   ch->next = character_list;
   character_list = ch;
+  kw_index_char(ch);
 
   ch->script_id = 0;	// set later by char_script_id
 
@@ -2505,7 +2606,8 @@ struct char_data *read_mobile(mob_vnum nr, int type) /* and mob_rnum */
   mob->player.time.played = 0;
   mob->player.time.logon = time(0);
 
-  mob_index[i].number++;
+  mob_to_index(mob);
+  kw_index_char(mob);
 
   mob->script_id = 0;	// this is set later by char_script_id
 
@@ -2524,6 +2626,7 @@ struct obj_data *create_obj(void)
   clear_object(obj);
   obj->next = object_list;
   object_list = obj;
+  kw_index_obj(obj);
   
   obj->events = NULL;
 
@@ -2554,7 +2657,8 @@ struct obj_data *read_object(obj_vnum nr, int type) /* and obj_rnum */
   
   obj->events = NULL;
 
-  obj_index[i].number++;
+  obj_to_index(obj);
+  kw_index_obj(obj);
 
   obj->script_id = 0;	// this is set later by obj_script_id
 
@@ -2572,7 +2676,7 @@ struct obj_data *read_object(obj_vnum nr, int type) /* and obj_rnum */
 void zone_update(void)
 {
   int i;
-  struct reset_q_element *update_u, *temp;
+  struct reset_q_element *update_u, *prev;
   static int timer = 0;
 
   /* jelson 10/22/92 */
@@ -2582,8 +2686,15 @@ void zone_update(void)
 
     timer = 0;
 
+    if (CONFIG_LAZY_ZONES)
+      update_lazy_zones();
+
     /* since one minute has passed, increment zone ages */
     for (i = 0; i <= top_of_zone_table; i++) {
+      /* A lazy zone nobody has entered yet has nothing to reset. */
+      if (!zone_table[i].populated)
+        continue;
+
       if (zone_table[i].age < zone_table[i].lifespan &&
 	  zone_table[i].reset_mode)
 	(zone_table[i].age)++;
@@ -2610,11 +2721,14 @@ void zone_update(void)
   }	/* end - one minute has passed */
 
   /* Dequeue zones (if possible) and reset. This code is executed every 10
-   * seconds (i.e. PULSE_ZONE). */
-  for (update_u = reset_q.head; update_u; update_u = update_u->next)
+   * seconds (i.e. PULSE_ZONE). One automatic reset runs at a time. */
+  if (zone_reset_running)
+    return;
+
+  for (prev = NULL, update_u = reset_q.head; update_u; prev = update_u, update_u = update_u->next)
     if (zone_table[update_u->zone_to_reset].reset_mode == 2 ||
 	is_empty(update_u->zone_to_reset)) {
-      reset_zone(update_u->zone_to_reset);
+      begin_zone_reset(update_u->zone_to_reset);
       mudlog(CMP, LVL_IMPL+1, FALSE, "Auto zone reset: %s (Zone %d)",
           zone_table[update_u->zone_to_reset].name, zone_table[update_u->zone_to_reset].number);
       struct descriptor_data *pt;
@@ -2624,17 +2738,13 @@ void zone_update(void)
             CCGRN(pt->character, C_NRM), zone_table[update_u->zone_to_reset].name, 
             zone_table[update_u->zone_to_reset].number, CCNRM(pt->character, C_NRM));
       /* dequeue */
-      if (update_u == reset_q.head)
-	reset_q.head = reset_q.head->next;
-      else {
-	for (temp = reset_q.head; temp->next != update_u;
-	     temp = temp->next);
+      if (prev)
+	prev->next = update_u->next;
+      else
+	reset_q.head = update_u->next;
 
-	if (!update_u->next)
-	  reset_q.tail = temp;
-
-	temp->next = update_u->next;
-      }
+      if (update_u == reset_q.tail)
+	reset_q.tail = prev;
 
       free(update_u);
       break;
@@ -2651,22 +2761,96 @@ static void log_zone_error(zone_rnum zone, int cmd_no, const char *message)
 #define ZONE_ERROR(message) \
 	{ log_zone_error(zone, cmd_no, message); last_cmd = 0; }
 
-/* execute the reset command table of a given zone */
-void reset_zone(zone_rnum zone)
+/* A zone reset in progress. Automatic resets run a slice of commands each
+ * pulse, so the cursor and the mob/obj the next command may refer to are kept
+ * here between slices; while parked, those are held by script id. */
+struct reset_run {
+  zone_rnum zone;
+  int cmd_no, last_cmd;
+  struct char_data *mob, *tmob;
+  struct obj_data *tobj;
+  long mob_id, tmob_id, tobj_id;
+};
+
+static struct reset_run zone_reset_run;
+
+/* Remember the object a command loaded when a later 'P' wants it. */
+#define NOTE_CONTAINER(obj) \
+	{ if (ZCMD.container) ZCMD.loaded = obj_script_id(obj); }
+
+/* Precompile a zone's reset table: point every 'P' at the command that loads
+ * its container, so the reset does not have to search the object list, and
+ * throw out commands that could never run. Call again whenever the table is
+ * rebuilt. */
+void compile_zone_resets(zone_rnum zone)
 {
-  int cmd_no, last_cmd = 0;
-  struct char_data *mob = NULL;
+  int cmd_no, i;
+
+  for (cmd_no = 0; ZCMD.command != 'S'; cmd_no++) {
+    ZCMD.target = -1;
+    ZCMD.container = FALSE;
+    ZCMD.loaded = 0;
+  }
+
+  for (cmd_no = 0; ZCMD.command != 'S'; cmd_no++)
+    switch (ZCMD.command) {
+    case 'P':
+      for (i = cmd_no - 1; i >= 0; i--)
+        if (strchr("OPGE", zone_table[zone].cmd[i].command) &&
+            zone_table[zone].cmd[i].arg1 == ZCMD.arg3) {
+          ZCMD.target = i;
+          zone_table[zone].cmd[i].container = TRUE;
+          break;
+        }
+      break;
+    case 'E':
+      if (ZCMD.arg3 < 0 || ZCMD.arg3 >= NUM_WEARS) {
+        log_zone_error(zone, cmd_no, "invalid equipment pos number, cmd disabled");
+        ZCMD.command = '*';
+      }
+      break;
+    }
+}
+
+/* The container a 'P' command puts its object in: the one its target
+ * command last loaded if that is still around, else any copy in the game. */
+static struct obj_data *reset_container(zone_rnum zone, int cmd_no)
+{
+  struct reset_com *target;
+  struct obj_data *obj;
+
+  if (ZCMD.target >= 0 && ZCMD.target < cmd_no) {
+    target = &zone_table[zone].cmd[ZCMD.target];
+    if (target->container && target->loaded &&
+        (obj = find_obj(target->loaded)) && GET_OBJ_RNUM(obj) == ZCMD.arg3)
+      return obj;
+  }
+  return get_obj_num(ZCMD.arg3);
+}
+
+/* Run a reset from its cursor until the 'S' or until budget commands have
+ * run (budget < 0: no limit). Returns TRUE once the whole table is done. */
+static bool run_zone_reset(struct reset_run *run, int budget)
+{
+  zone_rnum zone = run->zone;
+  int cmd_no = run->cmd_no, last_cmd = run->last_cmd;
+  struct char_data *mob = run->mob;
   struct obj_data *obj, *obj_to;
   room_vnum rvnum;
   room_rnum rrnum;
-  struct char_data *tmob=NULL; /* for trigger assignment */
-  struct obj_data *tobj=NULL;  /* for trigger assignment */
+  struct char_data *tmob = run->tmob; /* for trigger assignment */
+  struct obj_data *tobj = run->tobj;  /* for trigger assignment */
 
-  for (cmd_no = 0; ZCMD.command != 'S'; cmd_no++) {
+  for (; ZCMD.command != 'S'; cmd_no++) {
 
     if (ZCMD.if_flag && !last_cmd)
       continue;
 
+    if (!budget)
+      break;
+    if (budget > 0)
+      budget--;
+
     /* This is the list of actual zone commands. If any new zone commands are
      * added to the game, be certain to update the list of commands in load_zone
      * () so that the counting will still be correct. - ae. */
@@ -2691,12 +2875,14 @@ void reset_zone(zone_rnum zone)
       if (obj_index[ZCMD.arg1].number < ZCMD.arg2) {
 	if (ZCMD.arg3 != NOWHERE) {
 	  obj = read_object(ZCMD.arg1, REAL);
+	  NOTE_CONTAINER(obj);
 	  obj_to_room(obj, ZCMD.arg3);
 	  last_cmd = 1;
           load_otrigger(obj);
           tobj = obj;
 	} else {
 	  obj = read_object(ZCMD.arg1, REAL);
+	  NOTE_CONTAINER(obj);
 	  IN_ROOM(obj) = NOWHERE;
 	  last_cmd = 1;
           tobj = obj;
@@ -2708,12 +2894,19 @@ void reset_zone(zone_rnum zone)
 
     case 'P':			/* object to object */
       if (obj_index[ZCMD.arg1].number < ZCMD.arg2) {
-	obj = read_object(ZCMD.arg1, REAL);
-	if (!(obj_to = get_obj_num(ZCMD.arg3))) {
+	if (!(obj_to = reset_container(zone, cmd_no))) {
+	  /* Its container was loaded but has since gone, perhaps between two
+	   * slices of this reset: skip it, there is nothing to disable. */
+	  if (ZCMD.target >= 0 && zone_table[zone].cmd[ZCMD.target].loaded) {
+	    last_cmd = 0;
+	    break;
+	  }
 	  ZONE_ERROR("target obj not found, command disabled");
 	  ZCMD.command = '*';
 	  break;
 	}
+	obj = read_object(ZCMD.arg1, REAL);
+	NOTE_CONTAINER(obj);
 	obj_to_obj(obj, obj_to);
 	last_cmd = 1;
         load_otrigger(obj);
@@ -2733,6 +2926,7 @@ void reset_zone(zone_rnum zone)
       }
       if (obj_index[ZCMD.arg1].number < ZCMD.arg2) {
 	obj = read_object(ZCMD.arg1, REAL);
+	NOTE_CONTAINER(obj);
 	obj_to_char(obj, mob);
 	last_cmd = 1;
         load_otrigger(obj);
@@ -2757,6 +2951,7 @@ void reset_zone(zone_rnum zone)
 	  ZONE_ERROR(error);
 	} else {
 	  obj = read_object(ZCMD.arg1, REAL);
+	  NOTE_CONTAINER(obj);
           IN_ROOM(obj) = IN_ROOM(mob);
           load_otrigger(obj);
           if (wear_otrigger(obj, mob, ZCMD.arg3)) {
@@ -2873,6 +3068,15 @@ void reset_zone(zone_rnum zone)
     }
   }
 
+  run->cmd_no = cmd_no;
+  run->last_cmd = last_cmd;
+  run->mob = mob;
+  run->tmob = tmob;
+  run->tobj = tobj;
+
+  if (ZCMD.command != 'S')
+    return FALSE;
+
   zone_table[zone].age = 0;
 
   /* handle reset_wtrigger's */
@@ -2882,6 +3086,223 @@ void reset_zone(zone_rnum zone)
     if (rrnum != NOWHERE) reset_wtrigger(&world[rrnum]);
     rvnum++;
   }
+
+  return TRUE;
+}
+
+static void start_reset_run(struct reset_run *run, zone_rnum zone)
+{
+  memset(run, 0, sizeof(*run));
+  run->zone = zone;
+
+  zone_table[zone].populated = TRUE;
+  zone_table[zone].idle = 0;
+}
+
+/* Between slices the game moves on: hold the run's mob and objects by id,
+ * and drop any that were extracted by the time the reset picks up again. */
+static void park_reset_run(struct reset_run *run)
+{
+  run->mob_id = run->mob ? char_script_id(run->mob) : 0;
+  run->tmob_id = run->tmob ? char_script_id(run->tmob) : 0;
+  run->tobj_id = run->tobj ? obj_script_id(run->tobj) : 0;
+  run->mob = run->tmob = NULL;
+  run->tobj = NULL;
+}
+
+static struct char_data *reset_run_char(long id)
+{
+  struct char_data *ch;
+
+  if (!id || !(ch = find_char(id)) || MOB_FLAGGED(ch, MOB_NOTDEADYET))
+    return NULL;
+  return ch;
+}
+
+static void resume_reset_run(struct reset_run *run)
+{
+  run->mob = reset_run_char(run->mob_id);
+  /* The mob was killed meanwhile: skip the commands that depend on it this
+   * time round, rather than have them find no mob and disable themselves. */
+  if (run->mob_id && !run->mob)
+    run->last_cmd = 0;
+  run->tmob = reset_run_char(run->tmob_id);
+  run->tobj = run->tobj_id ? find_obj(run->tobj_id) : NULL;
+}
+
+/* execute the reset command table of a given zone */
+void reset_zone(zone_rnum zone)
+{
+  struct reset_run run;
+
+  /* Already being reset a slice at a time: just see it through. */
+  if (zone_reset_running && zone_reset_run.zone == zone) {
+    finish_zone_reset(zone);
+    return;
+  }
+
+  start_reset_run(&run, zone);
+  run_zone_reset(&run, -1);
+}
+
+/* Start an automatic reset; it runs RESET_CMDS_PER_PULSE commands now and
+ * carries on from continue_zone_reset() each pulse until it is done. */
+static void begin_zone_reset(zone_rnum zone)
+{
+  start_reset_run(&zone_reset_run, zone);
+  zone_reset_running = TRUE;
+
+  if (run_zone_reset(&zone_reset_run, RESET_CMDS_PER_PULSE))
+    zone_reset_running = FALSE;
+  else
+    park_reset_run(&zone_reset_run);
+}
+
+void continue_zone_reset(void)
+{
+  if (!zone_reset_running)
+    return;
+
+  resume_reset_run(&zone_reset_run);
+  if (run_zone_reset(&zone_reset_run, RESET_CMDS_PER_PULSE))
+    zone_reset_running = FALSE;
+  else
+    park_reset_run(&zone_reset_run);
+}
+
+/* Run the rest of an automatic reset right away, before something edits the
+ * zone's command table or moves zones around. NOWHERE means any zone. */
+void finish_zone_reset(zone_rnum zone)
+{
+  if (!zone_reset_running || (zone != NOWHERE && zone_reset_run.zone != zone))
+    return;
+
+  resume_reset_run(&zone_reset_run);
+  run_zone_reset(&zone_reset_run, -1);
+  zone_reset_running = FALSE;
+}
+
+/* Lazy zones: populate a zone that has not been reset since boot or since it
+ * was last unloaded. char_to_room() calls this when a player walks in. */
+void load_lazy_zone(zone_rnum zone)
+{
+  if (zone == NOWHERE || zone > top_of_zone_table || zone_table[zone].populated)
+    return;
+
+  reset_zone(zone);
+  mudlog(CMP, LVL_IMPL+1, FALSE, "Lazy zone load: %s (Zone %d)",
+      zone_table[zone].name, zone_table[zone].number);
+}
+
+/* Can an idle lazy zone be unloaded? Not if anyone is still in it or it is
+ * part way through a reset, and not while a room event, a waiting room
+ * trigger or a decaying object (corpses, temporary portals) would be cut
+ * short. */
+static bool lazy_zone_unloadable(zone_rnum zone)
+{
+  struct char_data *ch;
+  struct obj_data *obj;
+  struct trig_data *trig;
+  room_rnum rnum;
+  int vnum;
+
+  if (zone_reset_running && zone_reset_run.zone == zone)
+    return FALSE;
+
+  for (vnum = zone_table[zone].bot; vnum <= zone_table[zone].top; vnum++) {
+    if ((rnum = real_room(vnum)) == NOWHERE)
+      continue;
+
+    if (world[rnum].events && world[rnum].events->iSize > 0)
+      return FALSE;
+
+    if (SCRIPT(&world[rnum]))
+      for (trig = TRIGGERS(SCRIPT(&world[rnum])); trig; trig = trig->next)
+        if (GET_TRIG_WAIT(trig))
+          return FALSE;
+
+    for (ch = world[rnum].people; ch; ch = ch->next_in_room)
+      if (!IS_NPC(ch))
+        return FALSE;
+
+    for (obj = world[rnum].contents; obj; obj = obj->next_content)
+      if (GET_OBJ_TIMER(obj) > 0)
+        return FALSE;
+  }
+  return TRUE;
+}
+
+/* Extract the mobs and loose objects of an idle lazy zone, so it costs
+ * nothing until a player comes back and load_lazy_zone() resets it. Pets of
+ * players and the contents of persistent rooms and houses are kept. */
+static void unload_lazy_zone(zone_rnum zone)
+{
+  struct char_data *ch;
+  room_rnum rnum;
+  int vnum, j;
+
+  for (vnum = zone_table[zone].bot; vnum <= zone_table[zone].top; vnum++) {
+    if ((rnum = real_room(vnum)) == NOWHERE)
+      continue;
+
+    for (ch = world[rnum].people; ch; ch = ch->next_in_room) {
+      if (!IS_NPC(ch) || (ch->master && !IS_NPC(ch->master)))
+        continue;
+
+      while (ch->carrying)
+        extract_obj(ch->carrying);
+      for (j = 0; j < NUM_WEARS; j++)
+        if (GET_EQ(ch, j))
+          extract_obj(GET_EQ(ch, j));
+      extract_char(ch);
+    }
+
+    /* Emptying a house room would mark it for House_save_all() to save
+     * empty. */
+    if (!ROOM_FLAGGED(rnum, ROOM_PERSISTENT) && !ROOM_FLAGGED(rnum, ROOM_HOUSE))
+      while (world[rnum].contents)
+        extract_obj(world[rnum].contents);
+  }
+
+  zone_table[zone].populated = FALSE;
+  zone_table[zone].age = 0;
+  zone_table[zone].idle = 0;
+}
+
+/* Called once a minute with lazy zones on: track how long each populated zone
+ * has been without players and unload the ones idle past lazy_zone_idle.
+ * Zones that never reset are never unloaded, and zones already queued for a
+ * reset wait until it has run. */
+static void update_lazy_zones(void)
+{
+  struct descriptor_data *d;
+  zone_rnum i;
+  int unloaded = 0;
+
+  for (i = 0; i <= top_of_zone_table; i++)
+    if (zone_table[i].populated)
+      zone_table[i].idle++;
+
+  for (d = descriptor_list; d; d = d->next)
+    if (STATE(d) == CON_PLAYING && d->character && IN_ROOM(d->character) != NOWHERE)
+      zone_table[world[IN_ROOM(d->character)].zone].idle = 0;
+
+  if (!CONFIG_LAZY_ZONE_IDLE)
+    return;
+
+  for (i = 0; i <= top_of_zone_table; i++) {
+    if (!zone_table[i].populated || !zone_table[i].reset_mode ||
+        zone_table[i].age >= ZO_DEAD || zone_table[i].idle < CONFIG_LAZY_ZONE_IDLE)
+      continue;
+    if (!lazy_zone_unloadable(i))
+      continue;
+    unload_lazy_zone(i);
+    unloaded++;
+  }
+
+  if (unloaded)
+    mudlog(CMP, LVL_IMPL+1, FALSE, "Lazy zones: unloaded %d idle zone%s.",
+        unloaded, unloaded == 1 ? "" : "s");
 }
 
 /* for use in reset_zone; return TRUE if zone 'nr' is free of PC's  */
@@ -2908,6 +3329,168 @@ int is_empty(zone_rnum zone_nr)
 }
 
 /* Functions of a general utility nature. */
+/* Room text read at boot (names, descriptions, exits and extra descriptions)
+ * is packed into large blocks instead of one malloc per string, and identical
+ * strings - the same corridor description in a dozen rooms, stock exit
+ * keywords - are stored once. Such strings are never freed on their own, so
+ * anything that replaces room text must release the old value with
+ * free_world_string(). */
+#define WORLD_STRING_BLOCK  (256 * 1024)
+
+struct world_string_block {
+  char *data;
+  size_t used, size;
+};
+
+static struct world_string_block *world_string_blocks = NULL;
+static int num_world_string_blocks = 0;
+static char **world_string_hash = NULL;	/* only kept while booting */
+static size_t world_string_hash_size = 0, world_string_count = 0;
+static unsigned long world_string_bytes = 0, world_string_saved = 0;
+
+static unsigned long world_string_key(const char *str, size_t length)
+{
+  unsigned long h = 2166136261UL;	/* FNV-1a */
+
+  while (length--)
+    h = (h ^ (unsigned char) *str++) * 16777619UL;
+
+  return (h);
+}
+
+static char *world_string_alloc(size_t length)
+{
+  struct world_string_block *blk = NULL;
+
+  if (num_world_string_blocks) {
+    blk = &world_string_blocks[num_world_string_blocks - 1];
+    if (blk->size - blk->used < length)
+      blk = NULL;
+  }
+
+  if (!blk) {
+    RECREATE(world_string_blocks, struct world_string_block, num_world_string_blocks + 1);
+    blk = &world_string_blocks[num_world_string_blocks++];
+    blk->size = MAX(length, WORLD_STRING_BLOCK);
+    blk->used = 0;
+    CREATE(blk->data, char, blk->size);
+  }
+
+  blk->used += length;
+  return (blk->data + blk->used - length);
+}
+
+static void world_string_rehash(void)
+{
+  char **old = world_string_hash;
+  size_t old_size = world_string_hash_size, i, slot;
+
+  world_string_hash_size = old_size ? old_size * 2 : 16384;
+  CREATE(world_string_hash, char *, world_string_hash_size);
+
+  for (i = 0; i < old_size; i++) {
+    if (!old[i])
+      continue;
+    slot = world_string_key(old[i], strlen(old[i])) & (world_string_hash_size - 1);
+    while (world_string_hash[slot])
+      slot = (slot + 1) & (world_string_hash_size - 1);
+    world_string_hash[slot] = old[i];
+  }
+
+  if (old)
+    free(old);
+}
+
+/* Returns the shared copy of buf, adding it if this is its first use. */
+static char *world_string_intern(const char *buf, size_t length)
+{
+  size_t slot;
+  char *str;
+
+  if (2 * (world_string_count + 1) > world_string_hash_size)
+    world_string_rehash();
+
+  slot = world_string_key(buf, length) & (world_string_hash_size - 1);
+  for (; (str = world_string_hash[slot]); slot = (slot + 1) & (world_string_hash_size - 1))
+    if (!strcmp(str, buf)) {
+      world_string_saved += length + 1;
+      return (str);
+    }
+
+  str = world_string_alloc(length + 1);
+  memcpy(str, buf, length + 1);
+  world_string_hash[slot] = str;
+  world_string_count++;
+  world_string_bytes += length + 1;
+  return (str);
+}
+
+/* TRUE if str lives in the shared room text blocks. */
+bool is_world_string(const char *str)
+{
+  int i;
+
+  for (i = 0; i < num_world_string_blocks; i++)
+    if (str >= world_string_blocks[i].data &&
+        str < world_string_blocks[i].data + world_string_blocks[i].size)
+      return (TRUE);
+
+  return (FALSE);
+}
+
+/* Frees room text, leaving strings shared from the boot blocks alone. */
+void free_world_string(char *str)
+{
+  if (str && !is_world_string(str))
+    free(str);
+}
+
+/* The lookup table is only needed while the world files are read; the
+ * strings themselves stay until destroy_db(). */
+static void world_strings_booted(void)
+{
+  if (world_string_hash)
+    free(world_string_hash);
+  world_string_hash = NULL;
+  world_string_hash_size = 0;
+
+  log("   %lu room strings, %lu bytes in %d blocks, %lu bytes shared.",
+      (unsigned long) world_string_count, world_string_bytes,
+      num_world_string_blocks, world_string_saved);
+}
+
+static void free_world_strings(void)
+{
+  int i;
+
+  for (i = 0; i < num_world_string_blocks; i++)
+    free(world_string_blocks[i].data);
+  if (world_string_blocks)
+    free(world_string_blocks);
+  world_string_blocks = NULL;
+  num_world_string_blocks = 0;
+  world_string_count = world_string_bytes = world_string_saved = 0;
+}
+
+/* Finishes a string read by fread_string() or fread_clean_string(): converts
+ * the @ color codes and copies it to the heap using the length counted while
+ * reading, instead of measuring it again. */
+static char *fread_string_dup(char *buf, int length)
+{
+  char *str;
+
+  if (!length)
+    return (NULL);
+
+  parse_at(buf);
+  if (world_strings_shared)
+    return (world_string_intern(buf, length));
+
+  CREATE(str, char, length + 1);
+  memcpy(str, buf, length + 1);
+  return (str);
+}
+
 /* read and allocate space for a '~'-terminated string from a given file */
 char *fread_string(FILE *fl, const char *error)
 {
@@ -2946,14 +3529,12 @@ char *fread_string(FILE *fl, const char *error)
       log("%s", error);
       exit(1);
     } else {
-      strcat(buf + length, tmp);	/* strcat: OK (size checked above) */
+      memcpy(buf + length, tmp, templength + 1);	/* size checked above */
       length += templength;
     }
   } while (!done);
-  
-  parse_at(buf);
-  /* allocate space for the new string and copy it */
-  return (strlen(buf) ? strdup(buf) : NULL);
+
+  return (fread_string_dup(buf, length));
 }
 
 /* fread_clean_string is the same as fread_string, but skips preceding spaces */
@@ -3002,14 +3583,12 @@ char *fread_clean_string(FILE *fl, const char *error)
       log("%s", error);
       exit(1);
     } else {
-      strcat(buf + length, tmp);	/* strcat: OK (size checked above) */
+      memcpy(buf + length, tmp, templength + 1);	/* size checked above */
       length += templength;
     }
   } while (!done);
-  
-  parse_at(buf);
-  /* allocate space for the new string and copy it */
-  return (strlen(buf) ? strdup(buf) : NULL);
+
+  return (fread_string_dup(buf, length));
 }
 
 /* Read a numerical value from a given file */
@@ -3465,6 +4044,8 @@ void free_char(struct char_data *ch)
   int i;
   struct alias_data *a;
 
+  kw_unindex_char(ch);
+
   if (ch->player_specials != NULL && ch->player_specials != &dummy_mob) {
     while ((a = GET_ALIASES(ch)) != NULL) {
       GET_ALIASES(ch) = (GET_ALIASES(ch))->next;
@@ -3556,6 +4137,7 @@ void free_char(struct char_data *ch)
 /* release memory allocated for an obj struct */
 void free_obj(struct obj_data *obj)
 {
+  kw_unindex_obj(obj);
   remove_unique_id(obj);
   if (GET_OBJ_RNUM(obj) == NOWHERE) {
     free_object_strings(obj);
@@ -3785,7 +4367,7 @@ void init_char(struct char_data *ch)
   }
 
   if ((i = get_ptable_by_name(GET_NAME(ch))) != -1)
-    player_table[i].id = GET_IDNUM(ch) = ++top_idnum;
+    set_ptable_id(i, GET_IDNUM(ch) = ++top_idnum);
   else
     log("SYSERR: init_char: Character '%s' not found in player table.", GET_NAME(ch));
 
@@ -3836,147 +4418,61 @@ void init_char(struct char_data *ch)
 /* returns the real number of the room with given virtual number */
 room_rnum real_room(room_vnum vnum)
 {
-  room_rnum bot, top, mid, i, last_top;
-      
-  if (vnum == NOWHERE)
-    return NOWHERE;
-  
-  i = htree_find(room_htree, vnum);
-  
-  if (i != NOWHERE && world[i].number == vnum)
-    return i;
-  else {
-    bot = 0;
-    top = top_of_world;
+  room_rnum i;
 
-  if (world[bot].number > vnum || world[top].number < vnum)
+  if (vnum == NOWHERE || (i = htree_find(room_htree, vnum)) == NOWHERE)
     return (NOWHERE);
 
-  /* perform binary search on world-table */
-  for (;;) {
-    last_top = top;
-    mid = (bot + top) / 2;
-
-    if ((world + mid)->number == vnum) {
-      log("room_htree sync fix: %d: %d -> %d", vnum, i, mid);
-      htree_add(room_htree, vnum, mid);      
-       return (mid);
-    }
-    if (bot >= top)
-      return (NOWHERE);
-
-     if ((world + mid)->number > vnum)
-       top = mid - 1;
-     else
-       bot = mid + 1;
- 
-    if (top > last_top)
-      return NOWHERE;
-   }
+  if (i > top_of_world || world[i].number != vnum) {
+    log("SYSERR: room_htree out of sync: %d -> %d", vnum, i);
+    return (NOWHERE);
   }
+  return (i);
 }
- 
 
 /* returns the real number of the monster with given virtual number */
 mob_rnum real_mobile(mob_vnum vnum)
 {
-  mob_rnum bot, top, mid, i, last_top;
-  
-  if (vnum == NOBODY)
-    return NOBODY;
-  
-  i = htree_find(mob_htree, vnum);
-   
-  if (i != NOBODY && mob_index[i].vnum == vnum)
-    return i;
-  else { 
-   bot = 0;
-   top = top_of_mobt;
-
-  /* perform binary search on mob-table */
-  for (;;) {
-    last_top = top;
-    mid = (bot + top) / 2;
+  mob_rnum i;
 
-    if ((mob_index + mid)->vnum == vnum){
-      log("mob_htree sync fix: %d: %d -> %d", vnum, i, mid);
-       htree_add(mob_htree, vnum, mid);
-       return (mid);
-    }
-    
-    if (bot >= top)
-      return (NOBODY);
-    if ((mob_index + mid)->vnum > vnum)
-      top = mid - 1;
-    else
-      bot = mid + 1;
-    if (top > last_top)
-     return NOWHERE;
-   }
- }
+  if (vnum == NOBODY || (i = htree_find(mob_htree, vnum)) == NOBODY)
+    return (NOBODY);
+
+  if (i > top_of_mobt || mob_index[i].vnum != vnum) {
+    log("SYSERR: mob_htree out of sync: %d -> %d", vnum, i);
+    return (NOBODY);
+  }
+  return (i);
 }
 
 /* returns the real number of the object with given virtual number */
 obj_rnum real_object(obj_vnum vnum)
 {
-  obj_rnum bot, top, mid, i, last_top;
-        
-  if (vnum == NOTHING)
-    return NOTHING;
-      
-  i = htree_find(obj_htree, vnum);
-  
-  if (i != NOWHERE && obj_index[i].vnum == vnum)
-    return i;
-  else {
-   bot = 0;
-   top = top_of_objt;
+  obj_rnum i;
 
-  /* perform binary search on obj-table */
-  for (;;) {
-    last_top = top;
-    mid = (bot + top) / 2;
+  if (vnum == NOTHING || (i = htree_find(obj_htree, vnum)) == NOTHING)
+    return (NOTHING);
 
-    if ((obj_index + mid)->vnum == vnum){
-      log("obj_htree sync fix: %d: %d -> %d", vnum, i, mid);
-      htree_add(obj_htree, vnum, mid);
-      return (mid);
-      }
-    if (bot >= top)
-      return (NOTHING);
-    if ((obj_index + mid)->vnum > vnum)
-      top = mid - 1;
-    else
-      bot = mid + 1;
-    if (top > last_top)
-      return NOWHERE;
-  }     
- }
+  if (i > top_of_objt || obj_index[i].vnum != vnum) {
+    log("SYSERR: obj_htree out of sync: %d -> %d", vnum, i);
+    return (NOTHING);
+  }
+  return (i);
 }
 
 /* returns the real number of the zone with given virtual number */
 zone_rnum real_zone(zone_vnum vnum)
 {
-  zone_rnum bot, top, mid;
-
-  bot = 0;
-  top = top_of_zone_table;
+  zone_rnum i;
 
-  if (zone_table[bot].number > vnum || zone_table[top].number < vnum)
+  if (vnum == NOWHERE || (i = htree_find(zone_htree, vnum)) == NOWHERE)
     return (NOWHERE);
 
-  /* perform binary search on zone-table */
-  while (bot <= top) {
-    mid = (bot + top) / 2;
-
-    if ((zone_table + mid)->number == vnum)
-      return (mid);
-    if ((zone_table + mid)->number > vnum)
-      top = mid - 1;
-    else
-      bot = mid + 1;
+  if (i > top_of_zone_table || zone_table[i].number != vnum) {
+    log("SYSERR: zone_htree out of sync: %d -> %d", vnum, i);
+    return (NOWHERE);
   }
-  return (NOWHERE);
+  return (i);
 }
 
 /* Extend later to include more checks and add checks for unknown bitvectors. */
@@ -4201,6 +4697,12 @@ static void load_default_config( void )
   CONFIG_START_MESSG            = strdup(START_MESSG);
   CONFIG_MEDIT_ADVANCED         = medit_advanced_stats;
   CONFIG_IBT_AUTOSAVE           = ibt_autosave;
+  CONFIG_SCRIPT_PULSE_LINES     = script_pulse_lines;
+  CONFIG_SCRIPT_PULSE_MSEC      = script_pulse_msec;
+  CONFIG_LAZY_ZONES             = lazy_zones;
+  CONFIG_LAZY_ZONE_IDLE         = lazy_zone_idle;
+  CONFIG_BINARY_PFILES          = binary_pfiles;
+  CONFIG_BINARY_OBJFILES        = binary_objfiles;
   /* Autowiz options. */
   CONFIG_USE_AUTOWIZ            = use_autowiz;
   CONFIG_MIN_WIZLIST_LEV        = min_wizlist_lev;
@@ -4240,6 +4742,13 @@ void load_config( void )
          CONFIG_ALL_ITEMS_UNIQUE = num;
         break;
 
+      case 'b':
+        if (!str_cmp(tag, "binary_pfiles"))
+          CONFIG_BINARY_PFILES = num;
+        else if (!str_cmp(tag, "binary_objfiles"))
+          CONFIG_BINARY_OBJFILES = num;
+        break;
+
       case 'c':
         if (!str_cmp(tag, "crash_file_timeout"))
           CONFIG_CRASH_TIMEOUT = num;
@@ -4324,7 +4833,11 @@ void load_config( void )
         break;
 
       case 'l':
-        if (!str_cmp(tag, "level_can_shout"))
+        if (!str_cmp(tag, "lazy_zones"))
+          CONFIG_LAZY_ZONES = num;
+        else if (!str_cmp(tag, "lazy_zone_idle"))
+          CONFIG_LAZY_ZONE_IDLE = num;
+        else if (!str_cmp(tag, "level_can_shout"))
           CONFIG_LEVEL_CAN_SHOUT = num;
         else if (!str_cmp(tag, "load_into_inventory"))
           CONFIG_LOAD_INVENTORY = num;
@@ -4422,6 +4935,10 @@ void load_config( void )
           CONFIG_SITEOK_ALL = num;
         else if (!str_cmp(tag, "script_players"))
           CONFIG_SCRIPT_PLAYERS = num;
+        else if (!str_cmp(tag, "script_pulse_lines"))
+          CONFIG_SCRIPT_PULSE_LINES = num;
+        else if (!str_cmp(tag, "script_pulse_msec"))
+          CONFIG_SCRIPT_PULSE_MSEC = num;
         else if (!str_cmp(tag, "special_in_comm"))
           CONFIG_SPECIAL_IN_COMM = num;
         else if (!str_cmp(tag, "start_messg")) {
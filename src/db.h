@@ -49,6 +49,7 @@
 #define LIB_PLRFILES    "plrfiles/"
 #define LIB_ITEMMAIL "itemmail/"
 #define PERSISTENT_PATH "persistent/"
+#define PERSIST_MANIFEST PERSISTENT_PATH "rooms.lst" /* rooms with saved objects */
 #define ACCOUNT_STASH_PATH "accounts_stash/"
 #define SLASH		"/"
 #else
@@ -135,10 +136,11 @@
 #define CONFIG_FILE	LIB_ETC"config"    /* OasisOLC * GAME CONFIG FL */
 #define PLAYER_FILE	LIB_ETC"players"   /* the player database	*/
 #define MAIL_FILE	LIB_ETC"plrmail"   /* for the mudmail system	*/
-#define MAIL_FILE_TMP	LIB_ETC"plrmail_tmp"   /* for the mudmail system	*/
 #define BAN_FILE	LIB_ETC"badsites"  /* for the siteban system	*/
 #define HCONTROL_FILE	LIB_ETC"hcontrol"  /* for the house system	*/
 #define TIME_FILE	LIB_ETC"time"	   /* for calendar system	*/
+#define JOURNAL_FILE	LIB_PLRFILES"journal"     /* player state journal */
+#define JOURNAL_OLD_FILE LIB_PLRFILES"journal.old" /* ... until checkpointed */
 #define CHANGE_LOG_FILE "../changelog"     /* for the changelog         */
 
 /* new bitvector data for use in player_index_element */
@@ -162,6 +164,11 @@ struct reset_com {
    char *sarg1;		/* string argument                      */
    char *sarg2;		/* string argument                      */
 
+   /* Filled in by compile_zone_resets(), not saved. */
+   int target;		/* 'P': command that loads the container */
+   bool container;	/* a later 'P' puts objects in our load */
+   long loaded;		/* script id of the last container loaded */
+
    /* Commands:
     *  'M': Read a mobile
     *  'O': Read an object
@@ -192,6 +199,9 @@ struct zone_data {
    zone_vnum number;	    /* virtual number of this zone	  */
    struct reset_com *cmd;   /* command table for reset	          */
 
+   bool populated;          /* reset since boot or the last unload? */
+   int	idle;               /* minutes without players (lazy zones) */
+
    /* Reset mode:
     *   0: Don't reset, and don't update age.
     *   1: Reset if no PC's are located in zone.
@@ -218,6 +228,8 @@ struct player_index_element {
    int level;
    int flags;
    time_t last;
+   int next_by_name;   /* name hash chain, see players.c */
+   int next_by_id;     /* id hash chain, see players.c */
 };
 
 struct help_index_element {
@@ -245,6 +257,7 @@ void  destroy_db(void);
 char *fread_action(FILE *fl, int nr);
 int   create_entry(char *name);
 void  zone_update(void);
+void  continue_zone_reset(void);
 char  *fread_string(FILE *fl, const char *error);
 char  *fread_clean_string(FILE *fl, const char *error);
 int   fread_number(FILE *fp);
@@ -271,8 +284,10 @@ obj_rnum real_object(obj_vnum vnum);
 
 /* Public Procedures from objsave.c */
 void  Crash_save_all(void);
+void  Crash_autosave(void);
 void  Crash_idlesave(struct char_data *ch);
 void  Crash_crashsave(struct char_data *ch);
+int   Crash_write_crashfile(FILE *fp, struct char_data *ch);
 int Crash_load(struct char_data *ch);
 void  Crash_listrent(struct char_data *ch, char *name);
 int Crash_clean_file(char *name);
@@ -282,6 +297,8 @@ void update_obj_file(void);
 void Crash_rentsave(struct char_data *ch, int cost);
 obj_save_data *objsave_parse_objects(FILE *fl);
 int objsave_save_obj_record(struct obj_data *obj, FILE *fl, int location);
+void objsave_start_file(FILE *fl);
+void objsave_end_file(FILE *fl);
 /* Special functions */
 SPECIAL(receptionist);
 SPECIAL(cryogenicist);
@@ -299,6 +316,9 @@ void   reset_char(struct char_data *ch);
 void   free_char(struct char_data *ch);
 void   save_player_index(void);
 long   get_ptable_by_name(const char *name);
+long   get_ptable_by_id(long id);
+void   set_ptable_id(int pos, long id);
+void   set_ptable_name(int pos, const char *name);
 void   remove_player(int pfilepos);
 void   clean_pfiles(void);
 void   build_player_index(void);
@@ -319,10 +339,15 @@ void parse_mobile(FILE *mob_f, int nr);
 char *parse_object(FILE *obj_f, int nr);
 int is_empty(zone_rnum zone_nr);
 void reset_zone(zone_rnum zone);
+void finish_zone_reset(zone_rnum zone);
+void compile_zone_resets(zone_rnum zone);
+void load_lazy_zone(zone_rnum zone);
 void reboot_wizlists(void);
 ACMD(do_reboot);
 void boot_world(void);
 int count_hash_records(FILE *fl);
+bool is_world_string(const char *str);
+void free_world_string(char *str);
 bitvector_t asciiflag_conv(char *flag);
 void renum_world(void);
 void load_config( void );
@@ -331,6 +356,9 @@ void load_config( void );
 extern struct htree_node *room_htree;
 extern struct htree_node *mob_htree;
 extern struct htree_node *obj_htree;
+extern struct htree_node *zone_htree;
+extern struct htree_node *trig_htree;
+extern struct htree_node *qst_htree;
 
 /* Various Files */
 extern char *credits;
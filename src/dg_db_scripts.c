@@ -23,6 +23,7 @@
 #include "comm.h"
 #include "constants.h"
 #include "interpreter.h" /* For half_chop */
+#include "htree.h"
 
 /* local functions */
 static void trig_data_init(trig_data *this_data);
@@ -70,6 +71,9 @@ void parse_trigger(FILE *trig_f, int nr)
 
     free(cmds);
 
+    if (!trig_htree)
+      trig_htree = htree_init();
+    htree_add(trig_htree, nr, top_of_trigt);
     trig_index[top_of_trigt++] = t_index;
 }
 
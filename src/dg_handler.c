@@ -18,6 +18,7 @@
 #include "utils.h"
 #include "dg_scripts.h"
 #include "comm.h"
+#include "savequeue.h"
 #include "db.h"
 #include "handler.h"
 #include "spells.h"
@@ -90,6 +91,21 @@ void free_trigger(struct trig_data *trig)
     free(trig);
 }
 
+/* Return memory used by a trigger's command list, which is shared between the
+ * prototype and every live instance of it. */
+void free_cmdlist(struct cmdlist_element *cmdlist)
+{
+  struct cmdlist_element *next;
+
+  for (; cmdlist; cmdlist = next) {
+    next = cmdlist->next;
+    if (cmdlist->cmd)
+      free(cmdlist->cmd);
+    free_var_template(cmdlist->tmpl);
+    free(cmdlist);
+  }
+}
+
 /* remove a single trigger from a mob/obj/room */
 void extract_trigger(struct trig_data *trig)
 {
@@ -147,7 +163,7 @@ void extract_script(void *thing, int type)
       for ( ; j ; j = j->next)
         assert(sc != SCRIPT(j));
 
-      for (k = 0; k < top_of_world; k++)
+      for (k = 0; k <= top_of_world; k++)
         assert(sc != SCRIPT(&world[k]));
     }
   }
@@ -212,7 +228,7 @@ void free_proto_script(void *thing, int type)
       for ( ; j ; j = j->next)
         assert(proto != j->proto_script);
 
-      for (k = 0; k < top_of_world; k++)
+      for (k = 0; k <= top_of_world; k++)
         assert(proto != world[k].proto_script);
     }
   }
@@ -271,6 +287,7 @@ void delete_variables(const char *charname)
   if (!get_filename(filename, sizeof(filename), SCRIPT_VARS_FILE, charname))
     return;
 
+  saveq_wait(filename);
   if (remove(filename) < 0 && errno != ENOENT)
     log("SYSERR: deleting variable file %s: %s", filename, strerror(errno));
 }
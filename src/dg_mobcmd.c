@@ -22,6 +22,7 @@
 #include "genzon.h" /* for real_zone_by_thing */
 #include "act.h"
 #include "fight.h"
+#include "kwindex.h"
 
 
 /* Local file scope functions. */
@@ -959,6 +960,9 @@ ACMD(do_mtransform)
     tmpmob.events = ch->events;
     tmpmob.next_in_room = ch->next_in_room;
     tmpmob.next = ch->next;
+    tmpmob.next_instance = ch->next_instance;
+    tmpmob.prev_instance = ch->prev_instance;
+    tmpmob.keywords = ch->keywords;
     tmpmob.next_fighting = ch->next_fighting;
     tmpmob.followers = ch->followers;
     tmpmob.master = ch->master;
@@ -984,6 +988,7 @@ ACMD(do_mtransform)
     }
 
     ch->nr = this_rnum;
+    kw_reindex_char(ch);
     extract_char(m);
   }
 }
@@ -1043,10 +1048,8 @@ ACMD(do_mdoor)
     /* purge exit */
     if (fd == 0) {
         if (newexit) {
-            if (newexit->general_description)
-                free(newexit->general_description);
-            if (newexit->keyword)
-                free(newexit->keyword);
+            free_world_string(newexit->general_description);
+            free_world_string(newexit->keyword);
             free(newexit);
             rm->dir_option[dir] = NULL;
         }
@@ -1060,8 +1063,7 @@ ACMD(do_mdoor)
 
         switch (fd) {
         case 1:  /* description */
-            if (newexit->general_description)
-                free(newexit->general_description);
+            free_world_string(newexit->general_description);
             CREATE(newexit->general_description, char, strlen(value) + 3);
             strcpy(newexit->general_description, value);
             strcat(newexit->general_description, "\r\n");
@@ -1073,8 +1075,7 @@ ACMD(do_mdoor)
             newexit->key = atoi(value);
             break;
         case 4:  /* name        */
-            if (newexit->keyword)
-                free(newexit->keyword);
+            free_world_string(newexit->keyword);
             CREATE(newexit->keyword, char, strlen(value) + 1);
             strcpy(newexit->keyword, value);
             break;
@@ -20,6 +20,7 @@
 #include "constants.h"
 #include "genzon.h" /* for access to real_zone_by_thing */
 #include "fight.h" /* for die() */
+#include "kwindex.h"
 
 
 
@@ -322,6 +323,9 @@ static OCMD(do_otransform)
       unequip_char(obj->worn_by, pos);
     }
 
+    /* obj becomes a copy of o's prototype, so it moves to o's index */
+    obj_from_index(obj);
+
     /* move new obj info over to old object and delete new obj */
     memcpy(&tmpobj, o, sizeof(*o));
     tmpobj.in_room = IN_ROOM(obj);
@@ -335,7 +339,10 @@ static OCMD(do_otransform)
     tmpobj.script = obj->script;
     tmpobj.next_content = obj->next_content;
     tmpobj.next = obj->next;
+    tmpobj.keywords = obj->keywords;
     memcpy(obj, &tmpobj, sizeof(*obj));
+    obj_to_index(obj);
+    kw_reindex_obj(obj);
 
     if (wearer) {
       equip_char(wearer, obj, pos);
@@ -644,10 +651,8 @@ static OCMD(do_odoor)
     /* purge exit */
     if (fd == 0) {
         if (newexit) {
-            if (newexit->general_description)
-                free(newexit->general_description);
-            if (newexit->keyword)
-                free(newexit->keyword);
+            free_world_string(newexit->general_description);
+            free_world_string(newexit->keyword);
             free(newexit);
             rm->dir_option[dir] = NULL;
         }
@@ -661,8 +666,7 @@ static OCMD(do_odoor)
 
         switch (fd) {
         case 1:  /* description */
-            if (newexit->general_description)
-                free(newexit->general_description);
+            free_world_string(newexit->general_description);
             CREATE(newexit->general_description, char, strlen(value) + 3);
             strcpy(newexit->general_description, value);
             strcat(newexit->general_description, "\r\n"); /* strcat : OK */
@@ -674,8 +678,7 @@ static OCMD(do_odoor)
             newexit->key = atoi(value);
             break;
         case 4:  /* name        */
-            if (newexit->keyword)
-                free(newexit->keyword);
+            free_world_string(newexit->keyword);
             CREATE(newexit->keyword, char, strlen(value) + 1);
             strcpy(newexit->keyword, value);
             break;
@@ -21,6 +21,7 @@
 #include "genzon.h"      /* for real_zone_by_thing */
 #include "constants.h"   /* for the *trig_types */
 #include "modify.h"      /* for smash_tilde */
+#include "htree.h"
 
 
 /* local functions */
@@ -627,7 +628,7 @@ void trigedit_save(struct descriptor_data *d)
   trig_data *proto;
   trig_data *trig = OLC_TRIG(d);
   trig_data *live_trig;
-  struct cmdlist_element *cmd, *next_cmd;
+  struct cmdlist_element *cmd;
   struct index_data **new_index;
   struct descriptor_data *dsc;
   FILE *trig_file;
@@ -638,12 +639,7 @@ void trigedit_save(struct descriptor_data *d)
 
   if ((rnum = real_trigger(OLC_NUM(d))) != NOTHING) {
     proto = trig_index[rnum]->proto;
-    for (cmd = proto->cmdlist; cmd; cmd = next_cmd) {
-      next_cmd = cmd->next;
-      if (cmd->cmd)
-        free(cmd->cmd);
-      free(cmd);
-    }
+    free_cmdlist(proto->cmdlist);
 
 
     free(proto->arglist);
@@ -782,6 +778,10 @@ void trigedit_save(struct descriptor_data *d)
     trig_index = new_index;
     top_of_trigt++;
 
+    /* Map the new trigger and every trigger shifted up to make room for it. */
+    for (i = rnum; i < top_of_trigt; i++)
+      htree_add(trig_htree, trig_index[i]->vnum, i);
+
     /* HERE IT HAS TO GO THROUGH AND FIX ALL SCRIPTS/TRIGS OF HIGHER RNUM */
     for (live_trig = trigger_list; live_trig; live_trig = live_trig->next_in_world)
       GET_TRIG_RNUM(live_trig) += (GET_TRIG_RNUM(live_trig) != NOTHING && GET_TRIG_RNUM(live_trig) > rnum);
@@ -27,13 +27,15 @@
 #include "spells.h"
 #include "oasis.h"
 #include "genzon.h" /* for real_zone_by_thing */
+#include "htree.h"
 #include "act.h"
 #include "modify.h"
+#include "kwindex.h"
+#include "savequeue.h"
 
 #define PULSES_PER_MUD_HOUR     (SECS_PER_MUD_HOUR*PASSES_PER_SEC)
 
 /* Local functions not used elsewhere */
-static obj_data *find_obj(long n);
 static room_data *find_room(long n);
 static void do_stat_trigger(struct char_data *ch, trig_data *trig);
 static void script_stat(char_data *ch, struct script_data *sc);
@@ -74,6 +76,47 @@ static struct cmdlist_element *find_done(struct cmdlist_element *cl);
 static struct char_data *find_char_by_uid_in_lookup_table(long uid);
 static struct obj_data *find_obj_by_uid_in_lookup_table(long uid);
 static EVENTFUNC(trig_wait_event);
+static int script_run(void *go_adress, trig_data *trig, int type, int mode);
+static void script_suspend(void *go, trig_data *trig, int type,
+                  struct cmdlist_element *resume, long when);
+static bool script_budget_spent(void);
+static bool script_may_yield(trig_data *trig, int type);
+static struct trig_prof_data *trig_prof_find(trig_vnum vnum);
+
+/* Script profiler. One entry per trigger vnum that has ever run, hashed on
+ * the vnum. Entries are never freed, only zeroed, so script_driver() can hold
+ * on to one across a run that ends up resetting the table. */
+#define TPROF_BUCKETS 256 /* Must be power of 2. */
+
+struct trig_prof_data {
+  trig_vnum vnum;
+  unsigned long runs;             /**< started from the top (TRIG_NEW)   */
+  unsigned long slices;           /**< script_driver calls, incl. restarts */
+  unsigned long long total_usec;  /**< own time, excluding nested triggers */
+  unsigned long long max_usec;    /**< longest single slice              */
+  unsigned long cmds;             /**< script lines executed             */
+  unsigned long waits;            /**< suspensions, explicit or by loop  */
+  unsigned long loop_limits;      /**< runs stopped by the loop limit    */
+  struct trig_prof_data *next;
+};
+
+static struct trig_prof_data *trig_prof_table[TPROF_BUCKETS];
+static time_t trig_prof_since = 0;
+/* The entry of the trigger currently executing, and the time spent so far in
+ * triggers it fired. */
+static struct trig_prof_data *tprof_cur = NULL;
+static unsigned long long tprof_child_usec = 0;
+
+/* What the scripts have used of this pulse's budget, see script_budget_reset()
+ * and CONFIG_SCRIPT_PULSE_LINES/MSEC. The time of a slice still running is
+ * not in usec yet; it is measured from slice_start. Until the first pulse
+ * (while booting) there is no budget. */
+static struct {
+  bool active;
+  long lines;
+  unsigned long long usec;
+  struct timeval slice_start;
+} script_budget;
 
 
 /* Return pointer to first occurrence of string ct in cs, or NULL if not 
@@ -303,7 +346,7 @@ struct char_data *find_char(long n)
  * @retval obj_data * Pointer to the object if it exists, or NULL if it cannot
  * be found.
  */
-static obj_data *find_obj(long n)
+obj_data *find_obj(long n)
 {
   if (n < OBJ_ID_BASE) /* see note in dg_scripts.h */
     return NULL;
@@ -339,6 +382,8 @@ static room_data *find_room(long n)
 char_data *get_char(char *name)
 {
   char_data *i;
+  void **found;
+  int nfound, k = 0;
 
   if (*name == UID_CHAR) {
     i = find_char(atoi(name + 1));
@@ -346,7 +391,9 @@ char_data *get_char(char *name)
     if (i && valid_dg_target(i, DG_ALLOW_GODS))
       return i;
   } else {
-    for (i = character_list; i; i = i->next)
+    found = kw_lookup(KW_CHARS, name, &nfound);
+    for (i = KW_FIRST(found, nfound, character_list); i;
+         i = KW_NEXT(found, nfound, k, i, next))
       if (isname(name, i->player.name) &&
           valid_dg_target(i, DG_ALLOW_GODS))
         return i;
@@ -469,11 +516,15 @@ obj_data *get_obj_near_obj(obj_data *obj, char *name)
 obj_data *get_obj(char *name)
 {
   obj_data *obj;
+  void **found;
+  int nfound, k = 0;
 
   if (*name == UID_CHAR)
     return find_obj(atoi(name + 1));
   else {
-    for (obj = object_list; obj; obj = obj->next)
+    found = kw_lookup(KW_OBJS, name, &nfound);
+    for (obj = KW_FIRST(found, nfound, object_list); obj;
+         obj = KW_NEXT(found, nfound, k, obj, next))
       if (isname(name, obj->name))
         return obj;
   }
@@ -499,6 +550,8 @@ room_data *get_room(char *name)
 char_data *get_char_by_obj(obj_data *obj, char *name)
 {
   char_data *ch;
+  void **found;
+  int nfound, k = 0;
 
   if (*name == UID_CHAR) {
     ch = find_char(atoi(name + 1));
@@ -516,7 +569,9 @@ char_data *get_char_by_obj(obj_data *obj, char *name)
         valid_dg_target(obj->worn_by, DG_ALLOW_GODS))
       return obj->worn_by;
 
-    for (ch = character_list; ch; ch = ch->next)
+    found = kw_lookup(KW_CHARS, name, &nfound);
+    for (ch = KW_FIRST(found, nfound, character_list); ch;
+         ch = KW_NEXT(found, nfound, k, ch, next))
       if (isname(name, ch->player.name) &&
           valid_dg_target(ch, DG_ALLOW_GODS))
         return ch;
@@ -530,6 +585,8 @@ char_data *get_char_by_obj(obj_data *obj, char *name)
 char_data *get_char_by_room(room_data *room, char *name)
 {
   char_data *ch;
+  void **found;
+  int nfound, k = 0;
 
   if (*name == UID_CHAR) {
     ch = find_char(atoi(name + 1));
@@ -542,7 +599,9 @@ char_data *get_char_by_room(room_data *room, char *name)
           valid_dg_target(ch, DG_ALLOW_GODS))
         return ch;
 
-    for (ch = character_list; ch; ch = ch->next)
+    found = kw_lookup(KW_CHARS, name, &nfound);
+    for (ch = KW_FIRST(found, nfound, character_list); ch;
+         ch = KW_NEXT(found, nfound, k, ch, next))
       if (isname(name, ch->player.name) &&
           valid_dg_target(ch, DG_ALLOW_GODS))
         return ch;
@@ -608,6 +667,8 @@ obj_data *get_obj_in_room(room_data *room, char *name)
 obj_data *get_obj_by_room(room_data *room, char *name)
 {
   obj_data *obj;
+  void **found;
+  int nfound, k = 0;
 
   if (*name == UID_CHAR)
     return find_obj(atoi(name+1));
@@ -616,7 +677,9 @@ obj_data *get_obj_by_room(room_data *room, char *name)
     if (isname(name, obj->name))
       return obj;
 
-  for (obj = object_list; obj; obj = obj->next)
+  found = kw_lookup(KW_OBJS, name, &nfound);
+  for (obj = KW_FIRST(found, nfound, object_list); obj;
+       obj = KW_NEXT(found, nfound, k, obj, next))
     if (isname(name, obj->name))
       return obj;
 
@@ -735,7 +798,7 @@ static EVENTFUNC(trig_wait_event)
           found = TRUE;
     } else {
       room_rnum i;
-      for (i = 0;i<top_of_world && !found;i++)
+      for (i = 0;i<=top_of_world && !found;i++)
         if (&world[i] == (struct room_data *)go)
           found = TRUE;
     }
@@ -1692,7 +1755,6 @@ static void process_wait(void *go, trig_data *trig, int type, char *cmd,
                   struct cmdlist_element *cl)
 {
   char buf[MAX_INPUT_LENGTH], *arg;
-  struct wait_event_data *wait_event_obj;
   long when, hr, min, ntime;
   char c;
 
@@ -1735,13 +1797,71 @@ static void process_wait(void *go, trig_data *trig, int type, char *cmd,
     }
   }
 
+  script_suspend(go, trig, type, cl->next, when);
+}
+
+/* Puts the trigger to sleep for when pulses, to go on from line resume. */
+static void script_suspend(void *go, trig_data *trig, int type,
+                  struct cmdlist_element *resume, long when)
+{
+  struct wait_event_data *wait_event_obj;
+
   CREATE(wait_event_obj, struct wait_event_data, 1);
   wait_event_obj->trigger = trig;
   wait_event_obj->go = go;
   wait_event_obj->type = type;
 
   GET_TRIG_WAIT(trig) = event_create(trig_wait_event, wait_event_obj, when);
-  trig->curr_state = cl->next;
+  trig->curr_state = resume;
+}
+
+/* Called at the start of every pulse to hand the scripts a fresh budget. */
+void script_budget_reset(void)
+{
+  script_budget.active = TRUE;
+  script_budget.lines = 0;
+  script_budget.usec = 0;
+  gettimeofday(&script_budget.slice_start, (struct timezone *) 0);
+}
+
+/* May the pulse budget put off the rest of this trigger? Only if every type
+ * it has is one whose return value nobody reads and whose owner stays around,
+ * so random, time and zone reset triggers. A death trigger's mob is extracted
+ * as soon as it returns, and command, speech and the like decide the action
+ * with what they return, so those always run to the end. */
+static bool script_may_yield(trig_data *trig, int type)
+{
+  long types;
+
+  switch (type) {
+  case MOB_TRIGGER: types = MTRIG_GLOBAL | MTRIG_RANDOM | MTRIG_TIME; break;
+  case OBJ_TRIGGER: types = OTRIG_GLOBAL | OTRIG_RANDOM | OTRIG_TIME; break;
+  case WLD_TRIGGER: types = WTRIG_GLOBAL | WTRIG_RANDOM | WTRIG_RESET | WTRIG_TIME; break;
+  default: return FALSE;
+  }
+  return !(GET_TRIG_TYPE(trig) & ~types);
+}
+
+/* Have the scripts used up what they may run this pulse? */
+static bool script_budget_spent(void)
+{
+  struct timeval now;
+  long long used;
+
+  if (!script_budget.active)
+    return FALSE;
+
+  if (CONFIG_SCRIPT_PULSE_LINES && script_budget.lines >= CONFIG_SCRIPT_PULSE_LINES)
+    return TRUE;
+
+  if (!CONFIG_SCRIPT_PULSE_MSEC)
+    return FALSE;
+
+  gettimeofday(&now, (struct timezone *) 0);
+  used = (long long) (now.tv_sec - script_budget.slice_start.tv_sec) * 1000000 +
+         (now.tv_usec - script_budget.slice_start.tv_usec);
+
+  return script_budget.usec + MAX(used, 0) >= CONFIG_SCRIPT_PULSE_MSEC * 1000ULL;
 }
 
 /* processes a script set command */
@@ -2159,6 +2279,7 @@ static void process_remote(struct script_data *sc, trig_data *trig, char *cmd)
     sc_remote = SCRIPT(room);
   } else if ((mob = find_char(uid))) {
     sc_remote = SCRIPT(mob);
+    SET_SAVE_DIRTY(mob, SAVE_VARS);
     if (!IS_NPC(mob)) context = 0;
   } else if ((obj = find_obj(uid))) {
     sc_remote = SCRIPT(obj);
@@ -2209,6 +2330,7 @@ ACMD(do_vdelete)
     sc_remote = SCRIPT(room);
   } else if ((mob = find_char(uid))) {
     sc_remote = SCRIPT(mob);
+    SET_SAVE_DIRTY(mob, SAVE_VARS);
   } else if ((obj = find_obj(uid))) {
     sc_remote = SCRIPT(obj);
   } else {
@@ -2277,6 +2399,7 @@ int perform_set_dg_var(struct char_data *ch, struct char_data *vict, char *val_a
     CREATE(SCRIPT(vict), struct script_data, 1);
 
   add_var(&(SCRIPT(vict)->global_vars), var_name, var_value, 0);
+  SET_SAVE_DIRTY(vict, SAVE_VARS);
   return 1;
 }
 
@@ -2318,6 +2441,7 @@ static void process_rdelete(struct script_data *sc, trig_data *trig, char *cmd)
     sc_remote = SCRIPT(room);
   } else if ((mob = find_char(uid))) {
     sc_remote = SCRIPT(mob);
+    SET_SAVE_DIRTY(mob, SAVE_VARS);
   } else if ((obj = find_obj(uid))) {
     sc_remote = SCRIPT(obj);
   } else {
@@ -2479,11 +2603,60 @@ static void dg_letter_value(struct script_data *sc, trig_data *trig, char *cmd)
  *
  * int mode
      TRIG_NEW     just started from dg_triggers.c
-     TRIG_RESTART restarted after a 'wait' */
+     TRIG_RESTART restarted after a 'wait'
+ *
+ * Every call is timed and charged to the trigger's vnum in the profiler
+ * table (see do_tprofile). Time spent in triggers fired from inside this one
+ * is charged to those triggers only, not to the caller as well. */
 int script_driver(void *go_adress, trig_data *trig, int type, int mode)
+{
+  struct trig_prof_data *prof, *outer_prof;
+  struct timeval start, finish;
+  unsigned long long outer_child_usec, elapsed, self;
+  long long diff;
+  int ret_val;
+
+  /* Look the entry up before running; trig may be gone when we return. */
+  prof = trig_prof_find(GET_TRIG_VNUM(trig));
+  if (mode == TRIG_NEW)
+    prof->runs++;
+  prof->slices++;
+
+  outer_prof = tprof_cur;
+  outer_child_usec = tprof_child_usec;
+  tprof_cur = prof;
+  tprof_child_usec = 0;
+
+  gettimeofday(&start, (struct timezone *) 0);
+  if (!outer_prof)
+    script_budget.slice_start = start;
+  ret_val = script_run(go_adress, trig, type, mode);
+  gettimeofday(&finish, (struct timezone *) 0);
+
+  diff = (long long) (finish.tv_sec - start.tv_sec) * 1000000 + (finish.tv_usec - start.tv_usec);
+  elapsed = diff > 0 ? diff : 0; /* the clock may have stepped backwards */
+  if (!outer_prof) {
+    script_budget.usec += elapsed;
+    script_budget.slice_start = finish;
+  }
+
+  /* Charge our own time to us, the full time to whoever fired us. */
+  self = elapsed > tprof_child_usec ? elapsed - tprof_child_usec : 0;
+  prof->total_usec += self;
+  if (self > prof->max_usec)
+    prof->max_usec = self;
+
+  tprof_cur = outer_prof;
+  tprof_child_usec = outer_child_usec + elapsed;
+
+  return ret_val;
+}
+
+/* The actual interpreter behind script_driver(). */
+static int script_run(void *go_adress, trig_data *trig, int type, int mode)
 {
   static int depth = 0;
-  int ret_val = 1;
+  int ret_val = 1, slice_lines = 0;
   struct cmdlist_element *cl;
   char cmd[MAX_INPUT_LENGTH], *p;
   struct script_data *sc = 0;
@@ -2540,6 +2713,7 @@ int script_driver(void *go_adress, trig_data *trig, int type, int mode)
   if (mode == TRIG_NEW) {
     GET_TRIG_DEPTH(trig) = 1;
     GET_TRIG_LOOPS(trig) = 0;
+    trig->budget_yields = 0;
     sc->context = 0;
   }
 
@@ -2552,7 +2726,24 @@ int script_driver(void *go_adress, trig_data *trig, int type, int mode)
     if (*p == '*') /* comment */
       continue;
 
-    else if (!strn_cmp(p, "if ", 3)) {
+    /* Out of budget for this pulse: finish the rest of the trigger next pulse,
+     * starting with this line, if it is one that can wait. Every slice gets a
+     * few lines first, so short triggers still run in one go. */
+    if (++slice_lines > SCRIPT_MIN_SLICE && script_may_yield(trig, type) &&
+        script_budget_spent()) {
+      if (!trig->budget_yields++)
+        script_log("Trigger VNum %d ran out of script budget for this pulse, continuing next pulse.",
+                   GET_TRIG_VNUM(trig));
+      tprof_cur->waits++;
+      script_suspend(go, trig, type, cl, 1);
+      depth--;
+      return ret_val;
+    }
+
+    script_budget.lines++;
+    tprof_cur->cmds++;
+
+    if (!strn_cmp(p, "if ", 3)) {
       if (process_if(p + 3, go, sc, trig, type))
         GET_TRIG_DEPTH(trig)++;
       else
@@ -2604,6 +2795,7 @@ int script_driver(void *go_adress, trig_data *trig, int type, int mode)
         GET_TRIG_LOOPS(trig)++;
         if (cl->loops == 30) {
           cl->loops = 0;
+          tprof_cur->waits++;
           process_wait(go, trig, type, "wait 1", cl);
            depth--;
           return ret_val;
@@ -2611,6 +2803,7 @@ int script_driver(void *go_adress, trig_data *trig, int type, int mode)
           if (GET_TRIG_LOOPS(trig) >= 100) {
           script_log("Trigger VNum %d has looped 100 times!!!",
             GET_TRIG_VNUM(trig));
+            tprof_cur->loop_limits++;
             break;
           }
         } else {
@@ -2624,7 +2817,7 @@ int script_driver(void *go_adress, trig_data *trig, int type, int mode)
     }
 
     else {
-      var_subst(go, sc, trig, type, p, cmd);
+      var_subst_cmd(go, sc, trig, type, cl, p, cmd);
 
       if (!strn_cmp(cmd, "eval ", 5))
         process_eval(go, sc, trig, type, cmd);
@@ -2671,6 +2864,7 @@ int script_driver(void *go_adress, trig_data *trig, int type, int mode)
         process_unset(sc, trig, cmd);
 
       else if (!strn_cmp(cmd, "wait ", 5)) {
+        tprof_cur->waits++;
         process_wait(go, trig, type, cmd, cl);
         depth--;
         return ret_val;
@@ -2722,26 +2916,16 @@ int script_driver(void *go_adress, trig_data *trig, int type, int mode)
 /* returns the real number of the trigger with given virtual number */
 trig_rnum real_trigger(trig_vnum vnum)
 {
-  trig_rnum bot, top, mid;
-
-  bot = 0;
-  top = top_of_trigt - 1;
+  trig_rnum i;
 
-  if (!top_of_trigt || trig_index[bot]->vnum > vnum || trig_index[top]->vnum < vnum)
+  if (vnum == NOTHING || (i = htree_find(trig_htree, vnum)) == NOTHING)
     return (NOTHING);
 
-  /* perform binary search on trigger-table */
-  while (bot <= top) {
-    mid = (bot + top) / 2;
-
-    if (trig_index[mid]->vnum == vnum)
-      return (mid);
-    if (trig_index[mid]->vnum > vnum)
-      top = mid - 1;
-    else
-      bot = mid + 1;
+  if (i >= top_of_trigt || trig_index[i]->vnum != vnum) {
+    log("SYSERR: trig_htree out of sync: %d -> %d", vnum, i);
+    return (NOTHING);
   }
-  return (NOTHING);
+  return (i);
 }
 
 ACMD(do_tstat)
@@ -2762,6 +2946,120 @@ ACMD(do_tstat)
     send_to_char(ch, "Usage: tstat <vnum>\r\n");
 }
 
+static struct trig_prof_data *trig_prof_find(trig_vnum vnum)
+{
+  struct trig_prof_data *prof;
+  int bucket = (int) (vnum & (TPROF_BUCKETS - 1));
+
+  for (prof = trig_prof_table[bucket]; prof; prof = prof->next)
+    if (prof->vnum == vnum)
+      return prof;
+
+  if (!trig_prof_since)
+    trig_prof_since = time(0);
+
+  CREATE(prof, struct trig_prof_data, 1);
+  prof->vnum = vnum;
+  prof->next = trig_prof_table[bucket];
+  trig_prof_table[bucket] = prof;
+  return prof;
+}
+
+static void trig_prof_reset(void)
+{
+  struct trig_prof_data *prof, *next;
+  trig_vnum vnum;
+  int i;
+
+  for (i = 0; i < TPROF_BUCKETS; i++)
+    for (prof = trig_prof_table[i]; prof; prof = next) {
+      next = prof->next;
+      vnum = prof->vnum;
+      memset(prof, 0, sizeof(struct trig_prof_data));
+      prof->vnum = vnum;
+      prof->next = next;
+    }
+
+  trig_prof_since = time(0);
+}
+
+static int trig_prof_compare(const void *a, const void *b)
+{
+  const struct trig_prof_data *pa = *(const struct trig_prof_data **)a;
+  const struct trig_prof_data *pb = *(const struct trig_prof_data **)b;
+
+  if (pa->total_usec != pb->total_usec)
+    return pa->total_usec < pb->total_usec ? 1 : -1;
+  return pa->vnum < pb->vnum ? -1 : pa->vnum > pb->vnum;
+}
+
+/* Lists the triggers that have cost the most time since boot or the last
+ * reset. Usage: tprofile [<count> | reset] */
+ACMD(do_tprofile)
+{
+  struct trig_prof_data *prof, **list;
+  char arg[MAX_INPUT_LENGTH], buf[MAX_STRING_LENGTH];
+  unsigned long long total = 0;
+  int i, count = 0, shown = 20, len;
+  trig_rnum rnum;
+
+  one_argument(argument, arg);
+
+  if (*arg && is_abbrev(arg, "reset")) {
+    if (GET_LEVEL(ch) < LVL_GRGOD) {
+      send_to_char(ch, "You are not holy enough to reset the script profile.\r\n");
+      return;
+    }
+    trig_prof_reset();
+    mudlog(BRF, MAX(LVL_BUILDER, GET_INVIS_LEV(ch)), TRUE, "(GC) %s reset the script profile.", GET_NAME(ch));
+    send_to_char(ch, "Script profile reset.\r\n");
+    return;
+  } else if (*arg && (!is_number(arg) || (shown = atoi(arg)) < 1)) {
+    send_to_char(ch, "Usage: tprofile [<count> | reset]\r\n");
+    return;
+  }
+
+  for (i = 0; i < TPROF_BUCKETS; i++)
+    for (prof = trig_prof_table[i]; prof; prof = prof->next)
+      if (prof->slices)
+        count++;
+
+  if (!count) {
+    send_to_char(ch, "No triggers have run since the profile was last reset.\r\n");
+    return;
+  }
+
+  CREATE(list, struct trig_prof_data *, count);
+  for (count = 0, i = 0; i < TPROF_BUCKETS; i++)
+    for (prof = trig_prof_table[i]; prof; prof = prof->next)
+      if (prof->slices) {
+        list[count++] = prof;
+        total += prof->total_usec;
+      }
+  qsort(list, count, sizeof(struct trig_prof_data *), trig_prof_compare);
+
+  len = snprintf(buf, sizeof(buf),
+    "Script profile for the last %ld seconds: %d triggers, %.1f ms total.\r\n"
+    "VNum    Name                  Runs   Total ms  Avg us  Max us     Cmds  Waits Loops\r\n"
+    "------- -------------------- ------ --------- ------- ------- -------- ------ -----\r\n",
+    (long) (time(0) - trig_prof_since), count, total / 1000.0);
+
+  for (i = 0; i < count && i < shown && len < sizeof(buf) - 100; i++) {
+    prof = list[i];
+    rnum = real_trigger(prof->vnum);
+    len += snprintf(buf + len, sizeof(buf) - len,
+      "[%s%5d%s] %-20.20s %6lu %9.1f %7llu %7llu %8lu %6lu %5lu\r\n",
+      QGRN, prof->vnum, QNRM,
+      rnum == NOTHING ? "<deleted>" : GET_TRIG_NAME(trig_index[rnum]->proto),
+      prof->runs, prof->total_usec / 1000.0,
+      prof->total_usec / MAX(1, prof->slices), prof->max_usec,
+      prof->cmds, prof->waits, prof->loop_limits);
+  }
+  free(list);
+
+  page_string(ch->desc, buf, TRUE);
+}
+
 /* Scans for a case/default instance. Returns the line containg the correct 
  * case instance, or the last line of the trigger if not found. */
 static struct cmdlist_element *
@@ -2844,6 +3142,7 @@ void read_saved_vars(struct char_data *ch)
 
   /* find the file that holds the saved variables and open it*/
   get_filename(fn, sizeof(fn), SCRIPT_VARS_FILE, GET_NAME(ch));
+  saveq_wait(fn);
   file = fopen(fn,"r");
 
   /* if we failed to open the file, return */
@@ -2884,13 +3183,16 @@ void save_char_vars(struct char_data *ch)
   if (IS_NPC(ch)) return;
 
   get_filename(fn, sizeof(fn), SCRIPT_VARS_FILE, GET_NAME(ch));
-  unlink(fn);
 
   /* make sure this char has global variables to save */
-  if (ch->script->global_vars == NULL) return;
+  if (ch->script->global_vars == NULL) {
+    saveq_wait(fn);
+    unlink(fn);
+    return;
+  }
   vars = ch->script->global_vars;
 
-  file = fopen(fn,"wt");
+  file = saveq_open(fn);
   if (!file) {
     mudlog( NRM, LVL_GOD, TRUE,
             "SYSERR: Could not open player variable file %s for writing.:%s",
@@ -2905,7 +3207,7 @@ void save_char_vars(struct char_data *ch)
     vars = vars->next;
   }
 
-  fclose(file);
+  saveq_commit(file);
 }
 
 /* load in a character's saved variables from an ASCII pfile*/
@@ -2974,40 +3276,121 @@ void save_char_vars_ascii(FILE *file, struct char_data *ch)
 }
 
 /* find_char() helpers */
-/* Must be power of 2. */
-#define BUCKET_COUNT 64
-/* To recognize an empty bucket. */
-#define UID_OUT_OF_RANGE 1000000000
+/* The uid lookup table is an open addressing hash table using Robin Hood
+ * probing: an entry may only displace entries that sit closer to their home
+ * slot than it would, which keeps every probe sequence short. Removal shifts
+ * the entries after the hole back one slot instead of leaving tombstones.
+ * The table doubles when it gets 3/4 full, so lookups stay O(1) however many
+ * mobs and objects are loaded. */
+#define LOOKUP_MIN_BITS 10
+/* Grow when count would exceed size * LOOKUP_LOAD_NUM / LOOKUP_LOAD_DEN. */
+#define LOOKUP_LOAD_NUM 3
+#define LOOKUP_LOAD_DEN 4
 
 struct lookup_table_t {
-  long uid;
+  long uid; /* 0 marks an empty slot; uid 0 is never used. */
   void * c;
-  struct lookup_table_t *next;
 };
-static struct lookup_table_t lookup_table[BUCKET_COUNT];
 
-void init_lookup_table(void)
+static struct lookup_table_t *lookup_table = NULL;
+static int lookup_bits = 0;   /* the table has 1 << lookup_bits slots */
+static long lookup_count = 0; /* slots in use */
+static int lookup_max_probe = 0; /* longest displacement seen since growth */
+
+#define LOOKUP_SIZE  (1L << lookup_bits)
+#define LOOKUP_MASK  (LOOKUP_SIZE - 1)
+
+/* Fibonacci hashing spreads the sequential uid ranges of mobs and objects
+ * over the whole table. */
+static inline long lookup_home(long uid)
 {
-  int i;
-  for (i = 0; i < BUCKET_COUNT; i++) {
-    lookup_table[i].uid  = UID_OUT_OF_RANGE;
-    lookup_table[i].c    = NULL;
-    lookup_table[i].next = NULL;
+  return (long) (((unsigned long long) uid * 11400714819323198485ULL) >> (64 - lookup_bits));
+}
+
+static inline long lookup_dist(long slot, long uid)
+{
+  return (slot - lookup_home(uid)) & LOOKUP_MASK;
+}
+
+static void lookup_table_alloc(int bits)
+{
+  lookup_bits = bits;
+  lookup_count = 0;
+  lookup_max_probe = 0;
+  CREATE(lookup_table, struct lookup_table_t, LOOKUP_SIZE);
+}
+
+/* Puts an entry known not to be in the table yet into it. */
+static void lookup_table_place(long uid, void *c)
+{
+  struct lookup_table_t carry, tmp;
+  long slot, dist, d;
+
+  carry.uid = uid;
+  carry.c = c;
+
+  for (slot = lookup_home(uid), dist = 0;; slot = (slot + 1) & LOOKUP_MASK, dist++) {
+    if (!lookup_table[slot].uid) {
+      lookup_table[slot] = carry;
+      lookup_count++;
+      lookup_max_probe = MAX(lookup_max_probe, dist);
+      return;
+    }
+    if ((d = lookup_dist(slot, lookup_table[slot].uid)) < dist) {
+      /* Take from the rich: the resident is closer to home than we are. */
+      lookup_max_probe = MAX(lookup_max_probe, dist);
+      tmp = lookup_table[slot];
+      lookup_table[slot] = carry;
+      carry = tmp;
+      dist = d;
+    }
   }
 }
 
-static inline struct lookup_table_t *get_bucket_head(long uid)
+static void lookup_table_grow(void)
+{
+  struct lookup_table_t *old = lookup_table;
+  long i, old_size = LOOKUP_SIZE;
+
+  lookup_table_alloc(lookup_bits + 1);
+
+  for (i = 0; i < old_size; i++)
+    if (old[i].uid)
+      lookup_table_place(old[i].uid, old[i].c);
+
+  free(old);
+}
+
+void init_lookup_table(void)
 {
-  int bucket = (int) (uid & (BUCKET_COUNT - 1));
-  return &lookup_table[bucket];
+  if (lookup_table)
+    free(lookup_table);
+  lookup_table_alloc(LOOKUP_MIN_BITS);
+}
+
+/* Returns the slot holding uid, or -1. */
+static inline long lookup_table_slot(long uid)
+{
+  long slot, dist;
+
+  if (!uid)
+    return -1;
+
+  for (slot = lookup_home(uid), dist = 0; lookup_table[slot].uid; slot = (slot + 1) & LOOKUP_MASK, dist++) {
+    if (lookup_table[slot].uid == uid)
+      return slot;
+    /* Anything we are looking for would have displaced this one. */
+    if (lookup_dist(slot, lookup_table[slot].uid) < dist)
+      break;
+  }
+  return -1;
 }
 
 static inline struct lookup_table_t *find_element_by_uid_in_lookup_table(long uid)
 {
-  struct lookup_table_t *lt = get_bucket_head(uid);
+  long slot = lookup_table_slot(uid);
 
-  for (;lt && lt->uid != uid ; lt = lt->next) ;
-  return lt;
+  return slot < 0 ? NULL : &lookup_table[slot];
 }
 
 static struct char_data *find_char_by_uid_in_lookup_table(long uid)
@@ -3041,47 +3424,57 @@ int has_obj_by_uid_in_lookup_table(long uid)
 
 void add_to_lookup_table(long uid, void *c)
 {
-  struct lookup_table_t *lt = get_bucket_head(uid);
+  struct lookup_table_t *lt = find_element_by_uid_in_lookup_table(uid);
 
-  if (lt && lt->uid == uid) {
-   log("add_to_lookup updating existing value for uid=%ld (%p -> %p)", uid, lt->c, c);
-   lt->c = c;
-   return;
+  if (lt) {
+    log("add_to_lookup updating existing value for uid=%ld (%p -> %p)", uid, lt->c, c);
+    lt->c = c;
+    return;
   }
 
-  for (;lt && lt->next; lt = lt->next)
-    if (lt->next->uid == uid) {
-      log("add_to_lookup updating existing value for uid=%ld (%p -> %p)", uid, lt->next->c, c);
-      lt->next->c = c;
-      return;
-    }
+  if (!uid) {
+    log("SYSERR: add_to_lookup_table: uid 0 is reserved.");
+    return;
+  }
+
+  if ((lookup_count + 1) * LOOKUP_LOAD_DEN > LOOKUP_SIZE * LOOKUP_LOAD_NUM)
+    lookup_table_grow();
 
-  CREATE(lt->next, struct lookup_table_t, 1);
-  lt->next->uid = uid;
-  lt->next->c = c;
+  lookup_table_place(uid, c);
 }
 
 void remove_from_lookup_table(long uid)
 {
-  int bucket = (int) (uid & (BUCKET_COUNT - 1));
-  struct lookup_table_t *lt = &lookup_table[bucket], *flt = NULL;
+  long slot, next;
 
   /* This is not supposed to happen. UID 0 is not used. However, while I'm 
    * debugging the issue, let's just return right away. - Welcor */
   if (uid == 0)
     return;
 
-  flt = find_element_by_uid_in_lookup_table(uid);
-
-  if (flt) {
-    for (lt = &lookup_table[bucket];lt->next != flt;lt = lt->next)
-      ;
-    lt->next = flt->next;
-    free(flt);
+  if ((slot = lookup_table_slot(uid)) < 0) {
+    log("remove_from_lookup. UID %ld not found.", uid);
     return;
   }
 
-  log("remove_from_lookup. UID %ld not found.", uid);
+  /* Backward shift: pull every following entry that is not at its home slot
+   * one step closer, until an empty slot or an entry already at home. */
+  for (next = (slot + 1) & LOOKUP_MASK;
+       lookup_table[next].uid && lookup_dist(next, lookup_table[next].uid);
+       slot = next, next = (next + 1) & LOOKUP_MASK)
+    lookup_table[slot] = lookup_table[next];
+
+  lookup_table[slot].uid = 0;
+  lookup_table[slot].c = NULL;
+  lookup_count--;
+}
+
+/* Fills in the number of entries, slots and the longest probe for show stats. */
+void lookup_table_stats(long *count, long *size, int *max_probe)
+{
+  *count = lookup_count;
+  *size = lookup_table ? LOOKUP_SIZE : 0;
+  *max_probe = lookup_max_probe;
 }
 
 bool check_flags_by_name_ar(int *array, int numflags, char *search, const char *namelist[]) 
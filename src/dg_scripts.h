@@ -128,6 +128,9 @@
 #define MAX_SCRIPT_DEPTH      10          /* maximum depth triggers can
 					     recurse into each other */
 
+#define SCRIPT_MIN_SLICE      20          /* lines a trigger may always run
+					     before the pulse budget applies */
+
 #define SCRIPT_ERROR_CODE     -9999999   /* this shouldn't happen too often */
 
 /* one line of the trigger */
@@ -136,6 +139,7 @@ struct cmdlist_element {
   struct cmdlist_element *original;
   struct cmdlist_element *next;
   int loops;        /* for counting number of runs in a while loop */
+  struct var_template *tmpl; /* cmd pre-parsed for var_subst_cmd(), or NULL */
 };
 
 struct trig_var_data {
@@ -159,6 +163,7 @@ struct trig_data {
     char *arglist;                      /**< argument list                   */
     int depth;                          /**< depth into nest ifs/whiles/etc  */
     int loops;                          /**< loop iteration counter          */
+    int budget_yields;                  /**< times suspended for the pulse budget */
     struct event *wait_event;           /**< event to pause the trigger  */
     ubyte purged;                       /**< trigger is set to be purged     */
     struct trig_var_data *var_list;	    /**< list of local vars for trigger  */
@@ -269,10 +274,12 @@ ACMD(do_attach) ;
 ACMD(do_detach);
 ACMD(do_vdelete);
 ACMD(do_tstat);
+ACMD(do_tprofile);
 char *str_str(char *cs, char *ct);
 int find_eq_pos_script(char *arg);
 int can_wear_on_pos(struct obj_data *obj, int pos);
 struct char_data *find_char(long n);
+obj_data *find_obj(long n);
 char_data *get_char(char *name);
 char_data *get_char_near_obj(obj_data *obj, char *name);
 char_data *get_char_in_room(room_data *room, char *name);
@@ -289,6 +296,7 @@ obj_data *get_obj_in_list(char *name, obj_data *list);
 obj_data *get_object_in_equip(char_data * ch, char *name);
 void script_trigger_check(void);
 void check_time_triggers(void);
+void script_budget_reset(void);
 void find_uid_name(char *uid, char *name, size_t nlen);
 void do_sstat_room(struct char_data * ch, room_data *r);
 void do_sstat_object(char_data *ch, obj_data *j);
@@ -315,6 +323,7 @@ void save_char_vars(struct char_data *ch);
 void init_lookup_table(void);
 void add_to_lookup_table(long uid, void *c);
 void remove_from_lookup_table(long uid);
+void lookup_table_stats(long *count, long *size, int *max_probe);
 
 /* from dg_db_scripts.c */
 void parse_trigger(FILE *trig_f, int nr);
@@ -331,6 +340,9 @@ char *skill_percent(struct char_data *ch, char *skill);
 int char_has_item(char *item, struct char_data *ch);
 void var_subst(void *go, struct script_data *sc, trig_data *trig,
                int type, char *line, char *buf);
+void var_subst_cmd(void *go, struct script_data *sc, trig_data *trig,
+                   int type, struct cmdlist_element *cl, char *line, char *buf);
+void free_var_template(struct var_template *vt);
 int text_processed(char *field, char *subfield, struct trig_var_data *vd,
                    char *str, size_t slen);
 void find_replacement(void *go, struct script_data *sc, trig_data *trig,
@@ -341,6 +353,7 @@ void free_var_el(struct trig_var_data *var);
 void free_varlist(struct trig_var_data *vd);
 int remove_var(struct trig_var_data **var_list, char *name);
 void free_trigger(trig_data *trig);
+void free_cmdlist(struct cmdlist_element *cmdlist);
 void extract_trigger(struct trig_data *trig);
 void extract_script(void *thing, int type);
 void extract_script_mem(struct script_memory *sc);
@@ -246,6 +246,40 @@ int text_processed(char *field, char *subfield, struct trig_var_data *vd,
   return FALSE;
 }
 
+/* %door%, %force% and friends expand to the command of that name for the
+ * type of the running trigger (mob, obj, wld). Kept sorted by name so that
+ * find_replacement() can bsearch() it instead of walking a str_cmp() chain. */
+struct script_cmd_alias {
+  const char *name;
+  const char *cmd[3];
+};
+
+static const struct script_cmd_alias script_cmd_aliases[] = {
+  { "asound",     {"masound ",     "oasound ",     "wasound "    } },
+  { "at",         {"mat ",         "oat ",         "wat "        } },
+  { "damage",     {"mdamage ",     "odamage ",     "wdamage "    } },
+  { "door",       {"mdoor ",       "odoor ",       "wdoor "      } },
+  { "echo",       {"mecho ",       "oecho ",       "wecho "      } },
+  { "echoaround", {"mechoaround ", "oechoaround ", "wechoaround "} },
+  { "force",      {"mforce ",      "oforce ",      "wforce "     } },
+  { "load",       {"mload ",       "oload ",       "wload "      } },
+  { "log",        {"mlog ",        "olog ",        "wlog "       } },
+  /* there is no such thing as mmove, thus the mecho */
+  { "move",       {"mecho ",       "omove ",       "wmove "      } },
+  { "purge",      {"mpurge ",      "opurge ",      "wpurge "     } },
+  { "recho",      {"mrecho ",      "orecho ",      "wrecho "     } },
+  { "send",       {"msend ",       "osend ",       "wsend "      } },
+  { "teleport",   {"mteleport ",   "oteleport ",   "wteleport "  } },
+  /* there is no such thing as wtransform, thus the wecho */
+  { "transform",  {"mtransform ",  "otransform ",  "wecho "      } },
+  { "zoneecho",   {"mzoneecho ",   "ozoneecho ",   "wzoneecho "  } },
+};
+
+static int script_cmd_alias_cmp(const void *key, const void *elem)
+{
+  return str_cmp((const char *) key, ((const struct script_cmd_alias *) elem)->name);
+}
+
 /* sets str to be the value of var.field */
 void find_replacement(void *go, struct script_data *sc, trig_data *trig,
                 int type, char *var, char *field, char *subfield, char *str, size_t slen)
@@ -254,29 +288,10 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig,
   char_data *ch, *c = NULL, *rndm;
   obj_data *obj, *o = NULL;
   struct room_data *room, *r = NULL;
+  const struct script_cmd_alias *alias;
   char *name;
   int num, count, i, j, doors;
 
-  char *log_cmd[]        = {"mlog ",        "olog ",        "wlog "       };
-  char *send_cmd[]       = {"msend ",       "osend ",       "wsend "      };
-  char *echo_cmd[]       = {"mecho ",       "oecho ",       "wecho "      };
-  char *echoaround_cmd[] = {"mechoaround ", "oechoaround ", "wechoaround "};
-  char *door[]           = {"mdoor ",       "odoor ",       "wdoor "      };
-  char *force[]          = {"mforce ",      "oforce ",      "wforce "     };
-  char *load[]           = {"mload ",       "oload ",       "wload "      };
-  char *purge[]          = {"mpurge ",      "opurge ",      "wpurge "     };
-  char *teleport[]       = {"mteleport ",   "oteleport ",   "wteleport "  };
-  /* the x kills a 'shadow' warning in gcc. */
-  char *xdamage[]        = {"mdamage ",     "odamage ",     "wdamage "    };
-  char *zoneecho[]       = {"mzoneecho ",   "ozoneecho ",   "wzoneecho "  };
-  char *asound[]         = {"masound ",     "oasound ",     "wasound "    };
-  char *at[]             = {"mat ",         "oat ",         "wat "        };
-  /* there is no such thing as wtransform, thus the wecho below  */
-  char *transform[]      = {"mtransform ",  "otransform ",  "wecho "      };
-  char *recho[]          = {"mrecho ",      "orecho ",      "wrecho "     };
-  /* there is no such thing as mmove, thus the mecho below  */
-  char *omove[]          = {"mecho ",      "omove ",      "wmove "     };
-
   *str = '\0';
 
   /* X.global() will have a NULL trig */
@@ -314,38 +329,10 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig,
         snprintf(str, slen, "%d", ROOM_ID_BASE);
         return;
       }
-      else if (!str_cmp(var, "door"))
-        snprintf(str, slen, "%s", door[type]);
-      else if (!str_cmp(var, "force"))
-        snprintf(str, slen, "%s", force[type]);
-      else if (!str_cmp(var, "load"))
-        snprintf(str, slen, "%s", load[type]);
-      else if (!str_cmp(var, "purge"))
-        snprintf(str, slen, "%s", purge[type]);
-      else if (!str_cmp(var, "teleport"))
-        snprintf(str, slen, "%s", teleport[type]);
-      else if (!str_cmp(var, "damage"))
-        snprintf(str, slen, "%s", xdamage[type]);
-      else if (!str_cmp(var, "send"))
-        snprintf(str, slen, "%s", send_cmd[type]);
-      else if (!str_cmp(var, "echo"))
-        snprintf(str, slen, "%s", echo_cmd[type]);
-      else if (!str_cmp(var, "echoaround"))
-        snprintf(str, slen, "%s", echoaround_cmd[type]);
-      else if (!str_cmp(var, "zoneecho"))
-        snprintf(str, slen, "%s", zoneecho[type]);
-      else if (!str_cmp(var, "asound"))
-        snprintf(str, slen, "%s", asound[type]);
-      else if (!str_cmp(var, "at"))
-        snprintf(str, slen, "%s", at[type]);
-      else if (!str_cmp(var, "transform"))
-        snprintf(str, slen, "%s", transform[type]);
-      else if (!str_cmp(var, "recho"))
-        snprintf(str, slen, "%s", recho[type]);
-      else if (!str_cmp(var, "move"))
-        snprintf(str, slen, "%s", omove[type]);
-      else if (!str_cmp(var, "log"))
-        snprintf(str, slen, "%s", log_cmd[type]);
+      else if ((alias = bsearch(var, script_cmd_aliases,
+                   sizeof(script_cmd_aliases) / sizeof(script_cmd_aliases[0]),
+                   sizeof(script_cmd_aliases[0]), script_cmd_alias_cmp)))
+        snprintf(str, slen, "%s", alias->cmd[type]);
       else
         *str = '\0';
     }
@@ -965,6 +952,7 @@ void find_replacement(void *go, struct script_data *sc, trig_data *trig,
             if (subfield && *subfield) {
               int addition = atoi(subfield);
               GET_QUESTPOINTS(c) += addition;
+              SET_SAVE_DIRTY(c, SAVE_QUESTS);
             }
             snprintf(str, slen, "%d", GET_QUESTPOINTS(c));
           }
@@ -1632,10 +1620,9 @@ void var_subst(void *go, struct script_data *sc, trig_data *trig,
     return;
   }
   /*lets just empty these to start with*/
-  *repl_str = *tmp = *tmp2 = '\0';
+  *repl_str = *tmp = *tmp2 = *subfield = '\0';
 
   p = strcpy(tmp, line);
-  subfield_p = subfield;
 
   left = MAX_INPUT_LENGTH - 1;
 
@@ -1661,6 +1648,9 @@ void var_subst(void *go, struct script_data *sc, trig_data *trig,
     /* so it wasn't double %'s */
     else if (*p && (left > 0)) {
 
+      /* each reference starts with an empty subfield */
+      subfield_p = subfield;
+
       /* search until end of var or beginning of field */
       for (var = p; *p && (*p != '%') && (*p != '.'); p++);
 
@@ -1677,6 +1667,7 @@ void var_subst(void *go, struct script_data *sc, trig_data *trig,
               process_eval(go, sc, trig, type, tmp2);
               strcpy(var, "tmpvr");
               field = p;
+              subfield_p = subfield;
               dots = 0;
               continue;
             }
@@ -1714,3 +1705,207 @@ void var_subst(void *go, struct script_data *sc, trig_data *trig,
   } /* while *p .. */
   buf[sizeof(buf) - 1] = '\0';
 }
+
+
+/* Script lines are substituted every time they run, so var_subst_cmd() splits
+ * each line once into literal text and %var.field(subfield)% references and
+ * keeps the result on the cmdlist element. The element (and so the template)
+ * is shared by every instance of the trigger. */
+#define VT_LITERAL 0   /* text copied as is                                */
+#define VT_REF     1   /* %var%, %var.field% or %var.field(subfield)%      */
+#define VT_CHAIN   2   /* %var.field.field%, left to var_subst() as a whole */
+
+struct var_segment {
+  int type;
+  char *text;     /* literal, var\0field\0subfield\0, or the whole %chain% */
+  size_t len;     /* bytes of text, including the NULs of a VT_REF       */
+  size_t field;   /* offsets of field and subfield in a VT_REF           */
+  size_t subfield;
+  bool subst;     /* the subfield holds a % and must be substituted first */
+};
+
+struct var_template {
+  int num_segs;
+  struct var_segment *segs;
+};
+
+static void add_var_segment(struct var_template *vt, int type, const char *text,
+                            size_t len)
+{
+  struct var_segment *seg;
+
+  /* merge runs of literal text, e.g. around a %% */
+  if (type == VT_LITERAL && vt->num_segs &&
+      vt->segs[vt->num_segs - 1].type == VT_LITERAL) {
+    seg = &vt->segs[vt->num_segs - 1];
+    RECREATE(seg->text, char, seg->len + len + 1);
+    memcpy(seg->text + seg->len, text, len);
+    seg->len += len;
+    seg->text[seg->len] = '\0';
+    return;
+  }
+
+  RECREATE(vt->segs, struct var_segment, vt->num_segs + 1);
+  seg = &vt->segs[vt->num_segs++];
+  memset(seg, 0, sizeof(*seg));
+  seg->type = type;
+  seg->len = len;
+  CREATE(seg->text, char, len + 1);
+  memcpy(seg->text, text, len);
+}
+
+/* Splits line the same way var_subst() walks it. */
+static struct var_template *parse_var_template(const char *line)
+{
+  struct var_template *vt;
+  struct var_segment *seg;
+  char ref[MAX_INPUT_LENGTH], field[MAX_INPUT_LENGTH], subfield[MAX_INPUT_LENGTH];
+  const char *p = line, *start;
+  size_t vlen, flen, slen;
+  int paren_count, dots;
+  bool chain, in_field;
+
+  CREATE(vt, struct var_template, 1);
+
+  while (*p) {
+    for (start = p; *p && *p != '%'; p++);
+    if (p > start)
+      add_var_segment(vt, VT_LITERAL, start, p - start);
+
+    if (!*p || !*(++p))
+      break;
+
+    /* double % */
+    if (*p == '%') {
+      add_var_segment(vt, VT_LITERAL, p++, 1);
+      continue;
+    }
+
+    start = p - 1;
+    for (vlen = 0; *p && *p != '%' && *p != '.'; p++)
+      if (vlen < sizeof(ref) - 3)
+        ref[vlen++] = *p;
+
+    flen = slen = 0;
+    chain = FALSE;
+    if (*p == '.') {
+      in_field = TRUE;
+      paren_count = dots = 0;
+      for (p++; *p && (*p != '%' || paren_count > 0 || dots); p++) {
+        if (dots > 0) {
+          chain = TRUE;
+          dots = 0;
+        } else if (*p == '(') {
+          in_field = FALSE;
+          paren_count++;
+        } else if (*p == ')') {
+          in_field = FALSE;
+          paren_count--;
+        } else if (paren_count > 0) {
+          if (slen < sizeof(subfield) - 1)
+            subfield[slen++] = *p;
+        } else if (*p == '.') {
+          in_field = FALSE;
+          dots++;
+        } else if (in_field && flen < sizeof(field) - 1)
+          field[flen++] = *p;
+      }
+    }
+    if (*p)
+      p++;
+
+    if (chain) {
+      add_var_segment(vt, VT_CHAIN, start, p - start);
+      continue;
+    }
+
+    flen = MIN(flen, sizeof(ref) - vlen - 2);
+    slen = MIN(slen, sizeof(ref) - vlen - flen - 3);
+    ref[vlen] = '\0';
+    memcpy(ref + vlen + 1, field, flen);
+    ref[vlen + 1 + flen] = '\0';
+    memcpy(ref + vlen + flen + 2, subfield, slen);
+    ref[vlen + flen + 2 + slen] = '\0';
+
+    add_var_segment(vt, VT_REF, ref, vlen + flen + slen + 3);
+    seg = &vt->segs[vt->num_segs - 1];
+    seg->field = vlen + 1;
+    seg->subfield = vlen + flen + 2;
+    seg->subst = (memchr(subfield, '%', slen) != NULL);
+  }
+
+  return vt;
+}
+
+void free_var_template(struct var_template *vt)
+{
+  int i;
+
+  if (!vt)
+    return;
+
+  for (i = 0; i < vt->num_segs; i++)
+    free(vt->segs[i].text);
+  if (vt->segs)
+    free(vt->segs);
+  free(vt);
+}
+
+/* var_subst() for the command line cl, using its cached template. line is
+ * cl->cmd with the leading spaces skipped. */
+void var_subst_cmd(void *go, struct script_data *sc, trig_data *trig,
+                   int type, struct cmdlist_element *cl, char *line, char *buf)
+{
+  struct var_template *vt;
+  struct var_segment *seg;
+  char ref[MAX_INPUT_LENGTH], subfield[MAX_INPUT_LENGTH];
+  char repl_str[MAX_INPUT_LENGTH];
+  const char *src;
+  size_t used = 0, len, left;
+  int i;
+
+  /* skip out if no %'s */
+  if (!strchr(line, '%')) {
+    strcpy(buf, line);
+    return;
+  }
+
+  if (!cl->tmpl)
+    cl->tmpl = parse_var_template(line);
+  vt = cl->tmpl;
+
+  for (i = 0; i < vt->num_segs && used < MAX_INPUT_LENGTH - 1; i++) {
+    seg = &vt->segs[i];
+
+    switch (seg->type) {
+    case VT_REF:
+      /* find_replacement() may scribble on its arguments, so hand it a copy */
+      memcpy(ref, seg->text, seg->len);
+      if (seg->subst) {
+        var_subst(go, sc, trig, type, ref + seg->subfield, subfield);
+        src = subfield;
+      } else
+        src = ref + seg->subfield;
+      find_replacement(go, sc, trig, type, ref, ref + seg->field,
+                       (char *) src, repl_str, sizeof(repl_str) - 20);
+      src = repl_str;
+      len = strlen(repl_str);
+      break;
+    case VT_CHAIN:
+      var_subst(go, sc, trig, type, seg->text, repl_str);
+      src = repl_str;
+      len = strlen(repl_str);
+      break;
+    default:
+      src = seg->text;
+      len = seg->len;
+      break;
+    }
+
+    left = MAX_INPUT_LENGTH - 1 - used;
+    len = MIN(len, left);
+    memcpy(buf + used, src, len);
+    used += len;
+  }
+  buf[used] = '\0';
+}
@@ -25,6 +25,8 @@
 #include "fight.h"
 #include "shop.h"
 #include "quest.h"
+#include "kwindex.h"
+#include "journal.h"
 
 
 /* locally defined global variables, used externally */
@@ -203,6 +205,7 @@ static void make_corpse(struct char_data *ch)
   corpse->item_number = NOTHING;
   IN_ROOM(corpse) = NOWHERE;
   corpse->name = strdup("corpse");
+  kw_reindex_obj(corpse);
 
   snprintf(buf2, sizeof(buf2), "The corpse of %s is lying here.", GET_NAME(ch));
   corpse->description = strdup(buf2);
@@ -253,6 +256,7 @@ static void make_corpse(struct char_data *ch)
       obj_to_obj(money, corpse);
     }
     GET_GOLD(ch) = 0;
+    journal_points(ch);
   }
   ch->carrying = NULL;
   IS_CARRYING_N(ch) = 0;
@@ -406,10 +410,12 @@ void die(struct char_data * ch, struct char_data * killer)
     REMOVE_BIT_AR(PLR_FLAGS(ch), PLR_KILLER);
     REMOVE_BIT_AR(PLR_FLAGS(ch), PLR_THIEF);
     GET_DEATHS(ch)++;
+    SET_SAVE_DIRTY(ch, SAVE_STATS);
   }
 
   if (!IS_NPC(killer) && IS_NPC(ch)) {
     GET_KILLS_TOTAL(killer)++;
+    SET_SAVE_DIRTY(killer, SAVE_STATS);
 
     int vnum = GET_MOB_VNUM(ch);
     bool found = FALSE;
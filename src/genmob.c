@@ -18,6 +18,7 @@
 #include "dg_olc.h"
 #include "spells.h"
 #include "htree.h"
+#include "kwindex.h"
 
 /* local functions */
 static void extract_mobile_all(mob_vnum vnum);
@@ -33,9 +34,10 @@ int add_mobile(struct char_data *mob, mob_vnum vnum)
     copy_mobile(&mob_proto[rnum], mob);
 
     /* Now re-point all existing mobile strings to here. */
-    for (live_mob = character_list; live_mob; live_mob = live_mob->next)
-      if (rnum == live_mob->nr)
-        update_mobile_strings(live_mob, &mob_proto[rnum]);
+    for (live_mob = mob_index[rnum].mobs; live_mob; live_mob = live_mob->next_instance) {
+      update_mobile_strings(live_mob, &mob_proto[rnum]);
+      kw_reindex_char(live_mob);
+    }
 
     add_to_save_list(zone_table[real_zone_by_thing(vnum)].number, SL_MOB);
     log("GenOLC: add_mobile: Updated existing mobile #%d.", vnum);
@@ -53,7 +55,9 @@ int add_mobile(struct char_data *mob, mob_vnum vnum)
       copy_mobile_strings(mob_proto + i, mob);
       mob_index[i].vnum = vnum;
       mob_index[i].number = 0;
+      mob_index[i].mobs = NULL;
       mob_index[i].func = 0;
+      htree_add(mob_htree, vnum, i);
       found = i;
       break;
     }
@@ -68,6 +72,7 @@ int add_mobile(struct char_data *mob, mob_vnum vnum)
     copy_mobile_strings(&mob_proto[0], mob);
     mob_index[0].vnum = vnum;
     mob_index[0].number = 0;
+    mob_index[0].mobs = NULL;
     mob_index[0].func = 0;
     htree_add(mob_htree, mob_index[0].vnum, 0);
   }
@@ -164,15 +169,16 @@ int delete_mobile(mob_rnum refpt)
   extract_mobile_all(vnum);
   extract_char(proto);
 
+  /* Remove from htree table, and re-point the mobiles shifted down below. */
+  htree_del(mob_htree, vnum);
+
   for (counter = refpt; counter < top_of_mobt; counter++) {
     mob_index[counter] = mob_index[counter + 1];
     mob_proto[counter] = mob_proto[counter + 1];
     mob_proto[counter].nr--;
+    htree_add(mob_htree, mob_index[counter].vnum, counter);
   }
 
-  /* Remove from htree table */
-  htree_del(mob_htree, vnum);
-
   top_of_mobt--;
   RECREATE(mob_index, struct index_data, top_of_mobt + 1);
   RECREATE(mob_proto, struct char_data, top_of_mobt + 1);
@@ -19,6 +19,7 @@
 #include "handler.h"
 #include "interpreter.h"
 #include "htree.h"
+#include "kwindex.h"
 
 
 /* local functions */
@@ -53,10 +54,7 @@ static int update_all_objects(struct obj_data *refobj)
   struct obj_data *obj, swap;
   int count = 0;
 
-  for (obj = object_list; obj; obj = obj->next) {
-    if (obj->item_number != refobj->item_number)
-      continue;
-
+  for (obj = obj_index[refobj->item_number].objs; obj; obj = obj->next_instance) {
     count++;
 
     /* Update the existing object but save a copy for private information. */
@@ -73,9 +71,13 @@ static int update_all_objects(struct obj_data *refobj)
     obj->contains = swap.contains;
     obj->next_content = swap.next_content;
     obj->next = swap.next;
+    obj->next_instance = swap.next_instance;
+    obj->prev_instance = swap.prev_instance;
+    obj->keywords = swap.keywords;
     obj->sitting_here = swap.sitting_here;
     obj->unique_id = swap.unique_id;
     obj->generation = swap.generation; 
+    kw_reindex_obj(obj);
   }
 
   return count;
@@ -167,6 +169,7 @@ obj_rnum index_object(struct obj_data *obj, obj_vnum ovnum, obj_rnum ornum)
   obj->item_number = ornum;
   obj_index[ornum].vnum = ovnum;
   obj_index[ornum].number = 0;
+  obj_index[ornum].objs = NULL;
   obj_index[ornum].func = NULL;
 
   copy_object_preserve(&obj_proto[ornum], obj);
@@ -434,14 +437,14 @@ int delete_object(obj_rnum rnum)
     GET_OBJ_RNUM(tmp) -= (GET_OBJ_RNUM(tmp) > rnum);
   }
 
-  /* Remove from htree table */
-  htree_del(obj_htree, obj_index[rnum].number);
-
+  /* Remove from htree table, and re-point the objects shifted down below. */
+  htree_del(obj_htree, obj_index[rnum].vnum);
 
   for (i = rnum; i < top_of_objt; i++) {
     obj_index[i] = obj_index[i + 1];
     obj_proto[i] = obj_proto[i + 1];
     obj_proto[i].item_number = i;
+    htree_add(obj_htree, obj_index[i].vnum, i);
   }
 
   top_of_objt--;
@@ -501,6 +504,7 @@ bool oset_alias(struct obj_data *obj, char * argument)
     free(obj->name);  
 		   	   
   obj->name = strdup(argument);  
+  kw_reindex_obj(obj);
   
   return TRUE;
 }
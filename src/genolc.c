@@ -157,10 +157,8 @@ void free_ex_descriptions(struct extra_descr_data *head)
 
   for (thised = head; thised; thised = next_one) {
     next_one = thised->next;
-    if (thised->keyword)
-      free(thised->keyword);
-    if (thised->description)
-      free(thised->description);
+    free_world_string(thised->keyword);
+    free_world_string(thised->description);
     free(thised);
   }
 }
@@ -16,6 +16,7 @@
 #include "quest.h"
 #include "genolc.h"
 #include "genzon.h" /* for create_world_index */
+#include "htree.h"
 
 
 /*-------------------------------------------------------------------*/
@@ -81,7 +82,7 @@ void free_quest(struct aq_data *quest)
 
 int add_quest(struct aq_data *nqst)
 {
-  qst_rnum rnum;
+  qst_rnum rnum, i;
   mob_rnum qmrnum;
   zone_rnum rznum = real_zone_by_thing(nqst->vnum);
 
@@ -105,6 +106,11 @@ int add_quest(struct aq_data *nqst)
       aquest_table[rnum] = aquest_table[rnum - 1]; //shift quest up one
     }
     copy_quest(&aquest_table[rnum], nqst, FALSE);
+    /* Map the new quest and every quest shifted up to make room for it. */
+    if (!qst_htree)
+      qst_htree = htree_init();
+    for (i = rnum; i < total_quests; i++)
+      htree_add(qst_htree, QST_NUM(i), i);
   }
   qmrnum = real_mobile(QST_MASTER(rnum));
   /* Make sure we assign spec procs to the questmaster */
@@ -143,9 +149,11 @@ int delete_quest(qst_rnum rnum)
   tempfunc = QST_FUNC(rnum);
 
 
+  htree_del(qst_htree, QST_NUM(rnum));
   free_quest_strings(&aquest_table[rnum]);
   for (i = rnum; i < total_quests - 1; i++) {
     aquest_table[i] = aquest_table[i + 1];
+    htree_add(qst_htree, QST_NUM(i), i);
   }
   total_quests--;
   if (total_quests > 0)
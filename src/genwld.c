@@ -20,13 +20,42 @@
 #include "mud_event.h"
 #include "htree.h"
 
+/* Rooms live in stable slots: a room keeps its rnum until it is deleted, and
+ * vnum order is only kept by room_htree. New rooms take the next slot past
+ * top_of_world, and the array grows in chunks so most additions never touch
+ * the rest of the world. world_slots is the allocated size, or 0 while the
+ * array is still exactly as boot left it. */
+#define WORLD_SLOT_CHUNK 128
+
+static int world_slots = 0;
+
+/* Re-point everything that holds the address of world[rnum] after the room
+ * has been copied there from another slot or the array has moved. */
+static void relink_room(room_rnum rnum)
+{
+  struct room_data *room = &world[rnum];
+  struct char_data *tch;
+  struct obj_data *tobj;
+  struct event *pEvent;
+
+  for (tch = room->people; tch; tch = tch->next_in_room)
+    IN_ROOM(tch) = rnum;
+  for (tobj = room->contents; tobj; tobj = tobj->next_content)
+    IN_ROOM(tobj) = rnum;
+
+  update_wait_events(room, room);
+
+  if (room->events && room->events->iSize > 0)
+    while ((pEvent = simple_list(room->events)) != NULL)
+      ((struct mud_event_data *)pEvent->event_obj)->pStruct = room;
+}
+
 /* This function will copy the strings so be sure you free your own copies of 
  * the description, title, and such. */
 room_rnum add_room(struct room_data *room)
 {
   struct char_data *tch;
   struct obj_data *tobj;
-  int j, found = FALSE;
   room_rnum i;
 
   if (room == NULL)
@@ -45,87 +74,30 @@ room_rnum add_room(struct room_data *room)
     return i;
   }
 
-  RECREATE(world, struct room_data, top_of_world + 2);
-  top_of_world++;
-
-  for (i = top_of_world; i > 0; i--) {
-    if (room->number > world[i - 1].number) {
-      world[i] = *room;
-      copy_room_strings(&world[i], room);
-      found = i;
-      break;
-    } else {
-      /* Copy the room over now. */
-      world[i] = world[i - 1];
-      update_wait_events(&world[i], &world[i-1]);
-
-      /* People in this room must have their in_rooms moved up one. */
-      for (tch = world[i].people; tch; tch = tch->next_in_room)
-	IN_ROOM(tch) += (IN_ROOM(tch) != NOWHERE);
-
-      /* Move objects too. */
-      for (tobj = world[i].contents; tobj; tobj = tobj->next_content)
-	IN_ROOM(tobj) += (IN_ROOM(tobj) != NOWHERE);
-    }
-    htree_add(room_htree, world[i].number, i);
-  }
-  if (!found) {
-    world[0] = *room;	/* Last place, in front. */
-    copy_room_strings(&world[0], room);
+  if (world_slots < top_of_world + 2) {
+    world_slots = top_of_world + 2 + MAX(WORLD_SLOT_CHUNK, (top_of_world + 1) / 8);
+    RECREATE(world, struct room_data, world_slots);
+    /* The array may have moved, so every room's address has changed. */
+    for (i = 0; i <= top_of_world; i++)
+      relink_room(i);
   }
 
-  log("GenOLC: add_room: Added room %d at index #%d.", room->number, found);
-  /* found is equal to the array index where we added the room. */
-
-  /* Find what zone that room was in so we can update the loading table. */
-  for (i = room->zone; i <= top_of_zone_table; i++)
-    for (j = 0; ZCMD(i, j).command != 'S'; j++)
-      switch (ZCMD(i, j).command) {
-      case 'M':
-      case 'O':
-      case 'T':
-      case 'V':
-	ZCMD(i, j).arg3 += (ZCMD(i, j).arg3 != NOWHERE && ZCMD(i, j).arg3 >= found);
-	break;
-      case 'D':
-      case 'R':
-	ZCMD(i, j).arg1 += (ZCMD(i, j).arg1 != NOWHERE && ZCMD(i, j).arg1 >= found);
-      case 'G':
-      case 'P':
-      case 'E':
-      case '*':
-	/* Known zone entries we don't care about. */
-        break;
-      default:
-        mudlog(BRF, LVL_GOD, TRUE, "SYSERR: GenOLC: add_room: Unknown zone entry found!");
-      }
-
-  /* Update the loadroom table. Adds 1 or 0. */
-  r_mortal_start_room += (r_mortal_start_room >= found);
-  r_immort_start_room += (r_immort_start_room >= found);
-  r_frozen_start_room += (r_frozen_start_room >= found);
+  i = ++top_of_world;
+  world[i] = *room;
+  copy_room_strings(&world[i], room);
+  htree_add(room_htree, world[i].number, i);
 
-  /* Update world exits. */
-  i = top_of_world + 1;
-  do {
-    i--;
-    for (j = 0; j < DIR_COUNT; j++)
-      if (W_EXIT(i, j) && W_EXIT(i, j)->to_room != NOWHERE)
-	W_EXIT(i, j)->to_room += (W_EXIT(i, j)->to_room >= found);
-  } while (i > 0);
+  log("GenOLC: add_room: Added room %d at index #%d.", room->number, i);
 
   add_to_save_list(zone_table[room->zone].number, SL_WLD);
 
-  /* remove from realnum lookup tree */
-  htree_del(room_htree, room->number);
-
   /* Return what array entry we placed the new room in. */
-  return found;
+  return i;
 }
 
 int delete_room(room_rnum rnum)
 {
-  room_rnum i;
+  room_rnum i, last = top_of_world;
   int j;
   struct char_data *ppl, *next_ppl;
   struct obj_data *obj, *next_obj;
@@ -154,6 +126,15 @@ int delete_room(room_rnum rnum)
     r_frozen_start_room = 0;	/* The Void */
   }
 
+  /* The last room moves into the freed slot, so it is the only other rnum
+   * that changes. */
+  if (r_mortal_start_room == last)
+    r_mortal_start_room = rnum;
+  if (r_immort_start_room == last)
+    r_immort_start_room = rnum;
+  if (r_frozen_start_room == last)
+    r_frozen_start_room = rnum;
+
   /* Dump the contents of this room into the Void.  We could also just extract 
    * the people, mobs, and objects here. */
   for (obj = world[rnum].contents; obj; obj = next_obj) {
@@ -184,23 +165,21 @@ int delete_room(room_rnum rnum)
   }
 
   /* Change any exit going to this room to go the void. Also fix all the exits 
-   * pointing to rooms above this. */
+   * pointing to the last room, which is about to take this one's slot. */
   i = top_of_world + 1;
   do {
     i--;
     for (j = 0; j < DIR_COUNT; j++) {
       if (W_EXIT(i, j) == NULL)
         continue;
-      else if (W_EXIT(i, j)->to_room > rnum)
-        W_EXIT(i, j)->to_room -= (W_EXIT(i, j)->to_room != NOWHERE); /* with unsigned NOWHERE > any rnum */
+      else if (W_EXIT(i, j)->to_room == last && last != rnum)
+        W_EXIT(i, j)->to_room = rnum;
       else if (W_EXIT(i, j)->to_room == rnum) {
       	if ((!W_EXIT(i, j)->keyword || !*W_EXIT(i, j)->keyword) &&
       	    (!W_EXIT(i, j)->general_description || !*W_EXIT(i, j)->general_description)) {
           /* no description, remove exit completely */
-          if (W_EXIT(i, j)->keyword)
-            free(W_EXIT(i, j)->keyword);
-          if (W_EXIT(i, j)->general_description)
-            free(W_EXIT(i, j)->general_description);
+          free_world_string(W_EXIT(i, j)->keyword);
+          free_world_string(W_EXIT(i, j)->general_description);
           free(W_EXIT(i, j));
           W_EXIT(i, j) = NULL;
         } else {
@@ -221,15 +200,15 @@ int delete_room(room_rnum rnum)
       case 'V':
 	if (ZCMD(i, j).arg3 == rnum)
 	  ZCMD(i, j).command = '*';	/* Cancel command. */
-	else if (ZCMD(i, j).arg3 > rnum)
-	  ZCMD(i, j).arg3 -= (ZCMD(i, j).arg3 != NOWHERE); /* with unsigned NOWHERE > any rnum */
+	else if (ZCMD(i, j).arg3 == last)
+	  ZCMD(i, j).arg3 = rnum;
 	break;
       case 'D':
       case 'R':
 	if (ZCMD(i, j).arg1 == rnum)
 	  ZCMD(i, j).command = '*';	/* Cancel command. */
-	else if (ZCMD(i, j).arg1 > rnum)
-	  ZCMD(i, j).arg1 -= (ZCMD(i, j).arg1 != NOWHERE); /* with unsigned NOWHERE > any rnum */
+	else if (ZCMD(i, j).arg1 == last)
+	  ZCMD(i, j).arg1 = rnum;
       case 'G':
       case 'P':
       case 'E':
@@ -247,20 +226,25 @@ int delete_room(room_rnum rnum)
         SHOP_ROOM(i, j) = 0; /* set to the void */
     }
   }
-  /* Now we actually move the rooms down. */
-  for (i = rnum; i < top_of_world; i++) {
-    world[i] = world[i + 1];
-    update_wait_events(&world[i], &world[i+1]);
-
-    for (ppl = world[i].people; ppl; ppl = ppl->next_in_room)
-      IN_ROOM(ppl) -= (IN_ROOM(ppl) != NOWHERE);	/* Redundant check? */
-
-    for (obj = world[i].contents; obj; obj = obj->next_content)
-      IN_ROOM(obj) -= (IN_ROOM(obj) != NOWHERE);	/* Redundant check? */
+  /* Linkless players remember the room they were taken out of. */
+  for (ppl = character_list; ppl; ppl = ppl->next)
+    if (GET_WAS_IN(ppl) == rnum)
+      GET_WAS_IN(ppl) = 0;
+    else if (GET_WAS_IN(ppl) == last)
+      GET_WAS_IN(ppl) = rnum;
+
+  /* Now move the last room into the freed slot, keeping the realnum map in
+   * step. The slot stays allocated for the next add_room(). */
+  htree_del(room_htree, world[rnum].number);
+  if (rnum != last) {
+    world[rnum] = world[last];
+    relink_room(rnum);
+    htree_add(room_htree, world[rnum].number, rnum);
   }
 
+  if (world_slots == 0)
+    world_slots = top_of_world + 1;
   top_of_world--;
-  RECREATE(world, struct room_data, top_of_world + 1);
 
   return TRUE;
 }
@@ -451,21 +435,16 @@ int free_room_strings(struct room_data *room)
   int i;
 
   /* Free descriptions. */
-  if (room->name)
-    free(room->name);
-  if (room->description)
-    free(room->description);
+  free_world_string(room->name);
+  free_world_string(room->description);
   if (room->ex_description)
     free_ex_descriptions(room->ex_description);
 
   /* Free exits. */
   for (i = 0; i < DIR_COUNT; i++) {
     if (room->dir_option[i]) {
-      if (room->dir_option[i]->general_description)
-        free(room->dir_option[i]->general_description);
-
-      if (room->dir_option[i]->keyword)
-        free(room->dir_option[i]->keyword);
+      free_world_string(room->dir_option[i]->general_description);
+      free_world_string(room->dir_option[i]->keyword);
 
       free(room->dir_option[i]);
       room->dir_option[i] = NULL;
@@ -13,6 +13,7 @@
 #include "genolc.h"
 #include "genzon.h"
 #include "dg_scripts.h"
+#include "htree.h"
 
 /* local functions */
 static void remove_cmd_from_list(struct reset_com **list, int pos);
@@ -174,6 +175,7 @@ zone_rnum create_new_zone(zone_vnum vzone_num, room_vnum bottom, room_vnum top,
    * The variable is 'top_of_zone_table_table + 2' because we need record 0
    * through top_of_zone (top_of_zone_table + 1 items) and a new one which
    * makes it top_of_zone_table + 2 elements large. */
+  finish_zone_reset(NOWHERE);	/* its zone rnum may be about to move */
   RECREATE(zone_table, struct zone_data, top_of_zone_table + 2);
   zone_table[top_of_zone_table + 1].number = 32000;
 
@@ -202,6 +204,8 @@ rznum = i;
   zone->reset_mode = 2;
   zone->min_level = -1;
   zone->max_level = -1;
+  zone->populated = TRUE;
+  zone->idle = 0;
 
   for (i=0; i<ZN_ARRAY_MAX; i++)  zone->zone_flags[i] = 0;
 
@@ -211,6 +215,10 @@ rznum = i;
 
   top_of_zone_table++;
 
+  /* Map the new zone and every zone shifted up to make room for it. */
+  for (i = rznum; i <= top_of_zone_table; i++)
+    htree_add(zone_htree, zone_table[i].number, i);
+
   add_to_save_list(zone->number, SL_ZON);
   return rznum;
 }
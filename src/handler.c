@@ -24,6 +24,8 @@
 #include "fight.h"
 #include "quest.h"
 #include "mud_event.h"
+#include "kwindex.h"
+#include "journal.h"
 
 /* local file scope variables */
 static int extractions_pending = 0;
@@ -281,6 +283,87 @@ void affect_total(struct char_data *ch)
   }
 }
 
+/* Take one applied modifier back off a char_base_data, the way
+ * affect_modify_ar() takes it off the character. Only the values that are
+ * saved are tracked. */
+static void base_remove_modify(struct char_base_data *base, byte loc, sbyte mod, int bitv[])
+{
+  int i;
+
+  for (i = 0; i < AF_ARRAY_MAX; i++)
+    base->affected_by[i] &= ~bitv[i];
+
+  switch (loc) {
+  case APPLY_AGE:
+    base->birth += (mod * SECS_PER_MUD_YEAR);
+    break;
+  case APPLY_CHAR_WEIGHT:
+    base->weight -= mod;
+    break;
+  case APPLY_CHAR_HEIGHT:
+    base->height -= mod;
+    break;
+  case APPLY_MANA:
+    base->points.max_mana -= mod;
+    break;
+  case APPLY_HIT:
+    base->points.max_hit -= mod;
+    break;
+  case APPLY_MOVE:
+    base->points.max_move -= mod;
+    break;
+  case APPLY_AC:
+    base->points.armor -= mod;
+    break;
+  case APPLY_HITROLL:
+    base->points.hitroll -= mod;
+    break;
+  case APPLY_DAMROLL:
+    base->points.damroll -= mod;
+    break;
+  case APPLY_MAGIC_RESISTANCE:
+    base->magic_resistance -= mod;
+    break;
+  case APPLY_ELEMENTAL_RESISTANCE:
+    base->elemental_resistance -= mod;
+    break;
+  default:
+    break;
+  }
+}
+
+/* Work out what ch's values would be with all equipment removed and all
+ * affects stripped, without touching ch. */
+void char_base_values(struct char_data *ch, struct char_base_data *base)
+{
+  struct affected_type *af;
+  int i, j;
+
+  base->abils = ch->real_abils;
+  base->points = ch->points;
+  for (i = 0; i < AF_ARRAY_MAX; i++)
+    base->affected_by[i] = AFF_FLAGS(ch)[i];
+  base->magic_resistance = GET_MAGIC_RESISTANCE(ch);
+  base->elemental_resistance = GET_ELEMENTAL_RESISTANCE(ch);
+  base->weight = GET_WEIGHT(ch);
+  base->height = GET_HEIGHT(ch);
+  base->birth = ch->player.time.birth;
+
+  for (i = 0; i < NUM_WEARS; i++) {
+    if (!GET_EQ(ch, i))
+      continue;
+    if (GET_OBJ_TYPE(GET_EQ(ch, i)) == ITEM_ARMOR)
+      base->points.armor += apply_ac(ch, i);
+    for (j = 0; j < MAX_OBJ_AFFECT; j++)
+      base_remove_modify(base, GET_EQ(ch, i)->affected[j].location,
+                         GET_EQ(ch, i)->affected[j].modifier,
+                         GET_OBJ_AFFECT(GET_EQ(ch, i)));
+  }
+
+  for (af = ch->affected; af; af = af->next)
+    base_remove_modify(base, af->location, af->modifier, af->bitvector);
+}
+
 /* Insert an affect_type in a char_data structure. Automatically sets
  * apropriate bits and apply's */
 void affect_to_char(struct char_data *ch, struct affected_type *af)
@@ -295,6 +378,7 @@ void affect_to_char(struct char_data *ch, struct affected_type *af)
 
   affect_modify_ar(ch, af->location, af->modifier, af->bitvector, TRUE);
   affect_total(ch);
+  SET_SAVE_DIRTY(ch, SAVE_STATS);
 }
 
 /* Remove an affected_type structure from a char (called when duration reaches
@@ -313,6 +397,7 @@ void affect_remove(struct char_data *ch, struct affected_type *af)
   REMOVE_FROM_LIST(af, ch->affected, next);
   free(af);
   affect_total(ch);
+  SET_SAVE_DIRTY(ch, SAVE_STATS);
 }
 
 /* Call affect_remove with every affect from the spell "type" */
@@ -400,6 +485,10 @@ void char_to_room(struct char_data *ch, room_rnum room)
     log("SYSERR: Illegal value(s) passed to char_to_room. (Room: %d/%d Ch: %p",
 		room, top_of_world, (void *)ch);
   else {
+    /* With lazy zones, a player's first step into a zone populates it. */
+    if (!IS_NPC(ch) && !zone_table[world[room].zone].populated)
+      load_lazy_zone(world[room].zone);
+
     ch->next_in_room = world[room].people;
     world[room].people = ch;
     IN_ROOM(ch) = room;
@@ -434,8 +523,7 @@ void obj_to_char(struct obj_data *object, struct char_data *ch)
     autoquest_trigger_check(ch, NULL, object, AQ_OBJ_FIND);
 
     /* set flag for crash-save system, but not on mobs! */
-    if (!IS_NPC(ch))
-      SET_BIT_AR(PLR_FLAGS(ch), PLR_CRASH);
+    SET_SAVE_DIRTY(ch, SAVE_INVENTORY);
   } else
     log("SYSERR: NULL obj (%p) or char (%p) passed to obj_to_char.", (void *)object, (void *)ch);
 }
@@ -452,8 +540,7 @@ void obj_from_char(struct obj_data *object)
   REMOVE_FROM_LIST(object, object->carried_by->carrying, next_content);
 
   /* set flag for crash-save system, but not on mobs! */
-  if (!IS_NPC(object->carried_by))
-    SET_BIT_AR(PLR_FLAGS(object->carried_by), PLR_CRASH);
+  SET_SAVE_DIRTY(object->carried_by, SAVE_INVENTORY);
 
   IS_CARRYING_W(object->carried_by) -= GET_OBJ_WEIGHT(object);
   IS_CARRYING_N(object->carried_by)--;
@@ -537,6 +624,7 @@ void equip_char(struct char_data *ch, struct obj_data *obj, int pos)
   GET_EQ(ch, pos) = obj;
   obj->worn_by = ch;
   obj->worn_on = pos;
+  SET_SAVE_DIRTY(ch, SAVE_INVENTORY);
 
   if (GET_OBJ_TYPE(obj) == ITEM_ARMOR)
     GET_AC(ch) -= apply_ac(ch, pos);
@@ -569,6 +657,7 @@ struct obj_data *unequip_char(struct char_data *ch, int pos)
   obj = GET_EQ(ch, pos);
   obj->worn_by = NULL;
   obj->worn_on = -1;
+  SET_SAVE_DIRTY(ch, SAVE_INVENTORY);
 
   if (GET_OBJ_TYPE(obj) == ITEM_ARMOR)
     GET_AC(ch) += apply_ac(ch, pos);
@@ -629,13 +718,48 @@ struct obj_data *get_obj_in_list_num(int num, struct obj_data *list)
 /* search the entire world for an object number, and return a pointer  */
 struct obj_data *get_obj_num(obj_rnum nr)
 {
-  struct obj_data *i;
+  if (nr == NOTHING || nr > top_of_objt)
+    return (NULL);
 
-  for (i = object_list; i; i = i->next)
-    if (GET_OBJ_RNUM(i) == nr)
-      return (i);
+  return (obj_index[nr].objs);
+}
 
-  return (NULL);
+/* Each prototype keeps a list of its live copies, newest first like
+ * object_list. read_object() adds to it and extract_obj() takes away. */
+void obj_to_index(struct obj_data *obj)
+{
+  struct index_data *index;
+
+  if (GET_OBJ_RNUM(obj) == NOTHING)
+    return;
+
+  index = &obj_index[GET_OBJ_RNUM(obj)];
+  obj->prev_instance = NULL;
+  if ((obj->next_instance = index->objs) != NULL)
+    index->objs->prev_instance = obj;
+  index->objs = obj;
+  index->number++;
+}
+
+void obj_from_index(struct obj_data *obj)
+{
+  struct index_data *index;
+
+  if (GET_OBJ_RNUM(obj) == NOTHING)
+    return;
+
+  index = &obj_index[GET_OBJ_RNUM(obj)];
+  if (obj->prev_instance)
+    obj->prev_instance->next_instance = obj->next_instance;
+  else if (index->objs == obj)
+    index->objs = obj->next_instance;
+  else	/* never indexed, e.g. mail made with create_obj() */
+    return;
+
+  if (obj->next_instance)
+    obj->next_instance->prev_instance = obj->prev_instance;
+  obj->next_instance = obj->prev_instance = NULL;
+  index->number--;
 }
 
 /* search a room for a char, and return a pointer if found..  */
@@ -663,13 +787,47 @@ struct char_data *get_char_room(char *name, int *number, room_rnum room)
 /* search all over the world for a char num, and return a pointer if found */
 struct char_data *get_char_num(mob_rnum nr)
 {
-  struct char_data *i;
+  if (nr == NOBODY || nr > top_of_mobt)
+    return (NULL);
 
-  for (i = character_list; i; i = i->next)
-    if (GET_MOB_RNUM(i) == nr)
-      return (i);
+  return (mob_index[nr].mobs);
+}
 
-  return (NULL);
+/* The mobile counterparts of obj_to_index() and obj_from_index(). */
+void mob_to_index(struct char_data *ch)
+{
+  struct index_data *index;
+
+  if (!IS_NPC(ch) || GET_MOB_RNUM(ch) == NOBODY)
+    return;
+
+  index = &mob_index[GET_MOB_RNUM(ch)];
+  ch->prev_instance = NULL;
+  if ((ch->next_instance = index->mobs) != NULL)
+    index->mobs->prev_instance = ch;
+  index->mobs = ch;
+  index->number++;
+}
+
+void mob_from_index(struct char_data *ch)
+{
+  struct index_data *index;
+
+  if (!IS_NPC(ch) || GET_MOB_RNUM(ch) == NOBODY)
+    return;
+
+  index = &mob_index[GET_MOB_RNUM(ch)];
+  if (ch->prev_instance)
+    ch->prev_instance->next_instance = ch->next_instance;
+  else if (index->mobs == ch)
+    index->mobs = ch->next_instance;
+  else
+    return;
+
+  if (ch->next_instance)
+    ch->next_instance->prev_instance = ch->prev_instance;
+  ch->next_instance = ch->prev_instance = NULL;
+  index->number--;
 }
 
 /* put an object in a room */
@@ -734,6 +892,16 @@ void obj_from_room(struct obj_data *object)
   object->next_content = NULL;
 }
 
+/* Mark the persistent room whatever holds obj lies in, if any, for saving. */
+static void obj_mark_room_dirty(struct obj_data *obj)
+{
+  while (obj->in_obj)
+    obj = obj->in_obj;
+
+  if (IN_ROOM(obj) != NOWHERE && ROOM_FLAGGED(IN_ROOM(obj), ROOM_PERSISTENT))
+    mark_room_dirty(world[IN_ROOM(obj)].number);
+}
+
 /* put an object in an object (quaint)  */
 void obj_to_obj(struct obj_data *obj, struct obj_data *obj_to)
 {
@@ -759,6 +927,7 @@ void obj_to_obj(struct obj_data *obj, struct obj_data *obj_to)
     if (tmp_obj->carried_by)
       IS_CARRYING_W(tmp_obj->carried_by) += GET_OBJ_WEIGHT(obj);
   }
+  obj_mark_room_dirty(obj_to);
 }
 
 /* remove an object from an object */
@@ -783,6 +952,7 @@ void obj_from_obj(struct obj_data *obj)
     if (temp->carried_by)
       IS_CARRYING_W(temp->carried_by) -= GET_OBJ_WEIGHT(obj);
   }
+  obj_mark_room_dirty(obj_from);
   obj->in_obj = NULL;
   obj->next_content = NULL;
 }
@@ -829,9 +999,9 @@ void extract_obj(struct obj_data *obj)
     extract_obj(obj->contains);
 
   REMOVE_FROM_LIST(obj, object_list, next);
+  kw_unindex_obj(obj);
 
-  if (GET_OBJ_RNUM(obj) != NOTHING)
-    (obj_index[GET_OBJ_RNUM(obj)].number)--;
+  obj_from_index(obj);
 
   if (SCRIPT(obj))
     extract_script(obj, OBJ_TRIGGER);
@@ -900,6 +1070,8 @@ void extract_char_final(struct char_data *ch)
   struct cooldown_node *cd = NULL, *next_cd = NULL;
   struct kill_node *kill = NULL, *next_kill = NULL;
 
+  kw_unindex_char(ch);
+
   for (kill = ch->kill_mem; kill; kill = next_kill) {
     next_kill = kill->next;
     free(kill);
@@ -993,8 +1165,7 @@ void extract_char_final(struct char_data *ch)
   char_from_room(ch);
 
   if (IS_NPC(ch)) {
-    if (GET_MOB_RNUM(ch) != NOTHING)	/* prototyped */
-      mob_index[GET_MOB_RNUM(ch)].number--;
+    mob_from_index(ch);
     clearMemory(ch);
 
     if (SCRIPT(ch))
@@ -1004,6 +1175,7 @@ void extract_char_final(struct char_data *ch)
       extract_script_mem(SCRIPT_MEM(ch));
   } else {
     save_char(ch);
+    journal_done(ch);
         if(ch->cooldown) {
       for (cd = ch->cooldown; cd; cd = next_cd) {
          next_cd = cd->next;
@@ -1087,14 +1259,18 @@ void extract_pending_chars(void)
 struct char_data *get_player_vis(struct char_data *ch, char *name, int *number, int inroom)
 {
   struct char_data *i;
-  int num;
+  void **found;
+  int num, nfound, k = 0;
 
   if (!number) {
     number = &num;
     num = get_number(&name);
   }
 
-  for (i = character_list; i; i = i->next) {
+  /* Walk the keyword index's candidates when the name is long enough. */
+  found = kw_lookup(KW_CHARS, name, &nfound);
+
+  for (i = KW_FIRST(found, nfound, character_list); i; i = KW_NEXT(found, nfound, k, i, next)) {
     if (IS_NPC(i))
       continue;
     if (inroom == FIND_CHAR_ROOM && IN_ROOM(i) != IN_ROOM(ch))
@@ -1141,7 +1317,8 @@ struct char_data *get_char_room_vis(struct char_data *ch, char *name, int *numbe
 struct char_data *get_char_world_vis(struct char_data *ch, char *name, int *number)
 {
   struct char_data *i;
-  int num;
+  void **found;
+  int num, nfound, k = 0;
 
   if (!number) {
     number = &num;
@@ -1154,7 +1331,9 @@ struct char_data *get_char_world_vis(struct char_data *ch, char *name, int *numb
   if (*number == 0)
     return get_player_vis(ch, name, NULL, 0);
 
-  for (i = character_list; i && *number; i = i->next) {
+  found = kw_lookup(KW_CHARS, name, &nfound);
+
+  for (i = KW_FIRST(found, nfound, character_list); i && *number; i = KW_NEXT(found, nfound, k, i, next)) {
     if (IN_ROOM(ch) == IN_ROOM(i))
       continue;
     if (!isname(name, i->player.name))
@@ -1205,7 +1384,8 @@ struct obj_data *get_obj_in_list_vis(struct char_data *ch, char *name, int *numb
 struct obj_data *get_obj_vis(struct char_data *ch, char *name, int *number)
 {
   struct obj_data *i;
-  int num;
+  void **found;
+  int num, nfound, k = 0;
 
   if (!number) {
     number = &num;
@@ -1223,8 +1403,11 @@ struct obj_data *get_obj_vis(struct char_data *ch, char *name, int *number)
   if ((i = get_obj_in_list_vis(ch, name, number, world[IN_ROOM(ch)].contents)) != NULL)
     return (i);
 
-  /* ok.. no luck yet. scan the entire obj list   */
-  for (i = object_list; i && *number; i = i->next)
+  /* ok.. no luck yet. scan the entire obj list, or just the objects the
+   * keyword index says could match */
+  found = kw_lookup(KW_OBJS, name, &nfound);
+
+  for (i = KW_FIRST(found, nfound, object_list); i && *number; i = KW_NEXT(found, nfound, k, i, next))
     if (isname(name, i->name))
       if (CAN_SEE_OBJ(ch, i))
 	if (--(*number) == 0)
@@ -1360,6 +1543,7 @@ struct obj_data *create_money(int amount)
   GET_OBJ_VAL(obj, 0) = amount;
   GET_OBJ_COST(obj) = amount;
   obj->item_number = NOTHING;
+  kw_reindex_obj(obj);
 
   return (obj);
 }
@@ -14,6 +14,7 @@
 
 /* handling the affected-structures */
 void	affect_total(struct char_data *ch);
+void	char_base_values(struct char_data *ch, struct char_base_data *base);
 void	affect_to_char(struct char_data *ch, struct affected_type *af);
 void	affect_remove(struct char_data *ch, struct affected_type *af);
 void	affect_from_char(struct char_data *ch, int type);
@@ -44,12 +45,16 @@ void	obj_from_obj(struct obj_data *obj);
 void	object_list_new_owner(struct obj_data *list, struct char_data *ch);
 
 void	extract_obj(struct obj_data *obj);
+void	obj_to_index(struct obj_data *obj);
+void	obj_from_index(struct obj_data *obj);
 
 void update_char_objects(struct char_data *ch);
 
 /* characters*/
 struct char_data *get_char_room(char *name, int *num, room_rnum room);
 struct char_data *get_char_num(mob_rnum nr);
+void	mob_to_index(struct char_data *ch);
+void	mob_from_index(struct char_data *ch);
 
 void	char_from_room(struct char_data *ch);
 void	char_to_room(struct char_data *ch, room_rnum room);
@@ -23,6 +23,8 @@
 /* local (file scope only) globals */
 static struct house_control_rec house_control[MAX_HOUSES];
 static int num_of_houses = 0;
+/* When each house in house_control was last crash-saved, for autosave. */
+static time_t house_saved[MAX_HOUSES];
 
 /* local functions */
 static int House_get_filename(room_vnum vnum, char *filename, size_t maxlen);
@@ -120,7 +122,7 @@ static void House_restore_weight(struct obj_data *obj)
 /* Save all objects in a house */
 void House_crashsave(room_vnum vnum)
 {
-  int rnum;
+  int rnum, i;
   char buf[MAX_STRING_LENGTH];
   FILE *fp;
 
@@ -132,13 +134,17 @@ void House_crashsave(room_vnum vnum)
     perror("SYSERR: Error saving house file");
     return;
   }
+  objsave_start_file(fp);
   if (!House_save(world[rnum].contents, fp)) {
     fclose(fp);
     return;
   }
+  objsave_end_file(fp);
   fclose(fp);
   House_restore_weight(world[rnum].contents);
   REMOVE_BIT_AR(ROOM_FLAGS(rnum), ROOM_HOUSE_CRASH);
+  if ((i = find_house(vnum)) != NOWHERE)
+    house_saved[i] = time(0);
 }
 
 /* Delete a house save file */
@@ -454,8 +460,10 @@ static void hcontrol_destroy_house(struct char_data *ch, char *arg)
   }
   House_delete_file(house_control[i].vnum);
 
-  for (j = i; j < num_of_houses - 1; j++)
+  for (j = i; j < num_of_houses - 1; j++) {
     house_control[j] = house_control[j + 1];
+    house_saved[j] = house_saved[j + 1];
+  }
 
   num_of_houses--;
 
@@ -563,6 +571,26 @@ void House_save_all(void)
 	House_crashsave(house_control[i].vnum);
 }
 
+/* Called every pulse. Crash-saves the changed houses that were last saved at
+ * least CONFIG_AUTOSAVE_TIME minutes ago, AUTOSAVES_PER_PULSE at a time. */
+void House_autosave(void)
+{
+  int i, saved = 0;
+  room_rnum real_house;
+  time_t due = time(0) - CONFIG_AUTOSAVE_TIME * SECS_PER_REAL_MIN;
+
+  for (i = 0; i < num_of_houses && saved < AUTOSAVES_PER_PULSE; i++) {
+    if (house_saved[i] > due)
+      continue;
+    if ((real_house = real_room(house_control[i].vnum)) == NOWHERE)
+      continue;
+    if (ROOM_FLAGGED(real_house, ROOM_HOUSE_CRASH)) {
+      House_crashsave(house_control[i].vnum);
+      saved++;
+    }
+  }
+}
+
 /* note: arg passed must be house vnum, so there. */
 int House_can_enter(struct char_data *ch, room_vnum house)
 {
@@ -682,6 +710,7 @@ static int ascii_convert_house(struct char_data *ch, obj_vnum vnum)
 		fclose(in);
     return (0);
   }
+  objsave_start_file(out);
 
   while (!feof(in)) {
     struct obj_file_elem object;
@@ -710,7 +739,7 @@ static int ascii_convert_house(struct char_data *ch, obj_vnum vnum)
     }
   }
 
-	fprintf(out, "$~\n");
+	objsave_end_file(out);
 
 	fclose(in);
 	fclose(out);
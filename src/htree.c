@@ -1,6 +1,6 @@
 /***************************************************************************
  *   File: htree.c                                                         *
- *  Usage: Generalized hash tree code for fast lookups                     *
+ *  Usage: Direct-index vnum to rnum maps for fast lookups                 *
  *                                                                         *
  * This code is released under the CircleMud License                       *
  * Written by Elie Rosenblum <fnord@cosanostra.net>                        *
@@ -15,41 +15,16 @@
 #include "db.h"
 #include "htree.h"
 
-#undef HTREE_TEST_CYCLES
+/* Maps an index (which may be a signed type) onto its slot in the key space. */
+#define HTREE_KEY(index)  ((unsigned int)(index) & ((1U << HTREE_KEY_BITS) - 1))
 
-struct htree_node *HTREE_NULL = NULL;
-int htree_total_nodes = 0;
-int htree_depth_used = 0;
+int htree_total_pages = 0;
 
-void htree_shutdown()
-{
-  free(HTREE_NULL);
-  HTREE_NULL = NULL;
-}
-
-struct htree_node *htree_init()
+struct htree_node *htree_init(void)
 {
   struct htree_node *newnode;
-  int i;
-
-  if (! HTREE_NULL) {
-    htree_total_nodes++;
-    CREATE(HTREE_NULL, struct htree_node, 1);
-    for (i = 0; i < HTREE_NODE_SUBS; i++) {
-      HTREE_NULL->subs[i] = HTREE_NULL;
-    }
-    HTREE_NULL->content = NOWHERE;
-    HTREE_NULL->parent = NULL;
-  }
-
-  if (! htree_depth_used)
-    htree_depth_used = 1;
 
-  htree_total_nodes++;
   CREATE(newnode, struct htree_node, 1);
-  memcpy(newnode->subs, HTREE_NULL->subs, HTREE_NODE_SUBS * sizeof(struct htree_node *));
-  newnode->content = NOWHERE;
-  newnode->parent = HTREE_NULL;
 
   return newnode;
 }
@@ -58,137 +33,62 @@ void htree_free(struct htree_node *root)
 {
   int i;
 
-  if (! root || root == HTREE_NULL)
+  if (! root)
     return;
 
-  for (i = 0; i < HTREE_NODE_SUBS; i++)
-    htree_free(root->subs[i]);
+  for (i = 0; i < HTREE_PAGES; i++)
+    if (root->pages[i]) {
+      free(root->pages[i]);
+      htree_total_pages--;
+    }
 
   free(root);
 }
 
 void htree_add(struct htree_node *root, IDXTYPE index, IDXTYPE content)
 {
-  struct htree_node *tmp;
-  int i, depth;
+  unsigned int key = HTREE_KEY(index);
+  IDXTYPE *page;
+  int i;
 
   if (! root)
     return;
-  
-  tmp = root;
-  depth = 0;
-  while (index) {
-    depth++;
-    i = index & HTREE_NODE_MASK;
-    index >>= HTREE_NODE_BITS;
-    if (tmp->subs[i] == HTREE_NULL) {
-      htree_total_nodes++;
-      CREATE(tmp->subs[i], struct htree_node, 1);
-      memcpy(tmp->subs[i]->subs, HTREE_NULL->subs, HTREE_NODE_SUBS * sizeof(struct htree_node *));
-      tmp->subs[i]->content = NOWHERE;
-      tmp->subs[i]->parent = HTREE_NULL;
-    }
-    tmp = tmp->subs[i];
-  }
-
-  if (tmp == HTREE_NULL) /* We fell off somehow! Time to crap our pants */
-    return;
-
-  if (depth > htree_depth_used)
-    htree_depth_used = depth;
 
-  tmp->content = content;
-}
-
-struct htree_node *htree_find_node(struct htree_node *root, IDXTYPE index)
-{
-  struct htree_node *tmp;
-  int i;
-  
-  tmp = root;
-  while (index) {
-    i = index & HTREE_NODE_MASK;
-    index >>= HTREE_NODE_BITS;
-    tmp = tmp->subs[i];
+  if (! (page = root->pages[key >> HTREE_PAGE_BITS])) {
+    htree_total_pages++;
+    CREATE(page, IDXTYPE, HTREE_PAGE_SIZE);
+    for (i = 0; i < HTREE_PAGE_SIZE; i++)
+      page[i] = NOWHERE;
+    root->pages[key >> HTREE_PAGE_BITS] = page;
   }
 
-  return tmp;
+  page[key & HTREE_PAGE_MASK] = content;
 }
 
 void htree_del(struct htree_node *root, IDXTYPE index)
 {
-  struct htree_node *tmp;
+  unsigned int key = HTREE_KEY(index);
+  IDXTYPE *page;
 
-  tmp = htree_find_node(root, index);
-  tmp->content = NOWHERE;
+  if (root && (page = root->pages[key >> HTREE_PAGE_BITS]))
+    page[key & HTREE_PAGE_MASK] = NOWHERE;
 }
 
 IDXTYPE htree_find(struct htree_node *root, IDXTYPE index)
 {
-  struct htree_node *tmp;
+  unsigned int key = HTREE_KEY(index);
+  IDXTYPE *page;
 
-  tmp = htree_find_node(root, index);
-  return tmp->content;
-}
+  if (! root || ! (page = root->pages[key >> HTREE_PAGE_BITS]))
+    return NOWHERE;
 
-room_rnum real_room_old(room_vnum vnum)
-{
-  room_rnum bot, top, mid;
-  bot = 0;
-  top = top_of_world;
-
-  /* perform binary search on world-table */
-  for (;;) {
-    mid = (bot + top) / 2;
-
-    if ((world + mid)->number == vnum)
-      return (mid);
-
-    if (bot >= top)
-      return (NOWHERE);
-    if ((world + mid)->number > vnum)
-      top = mid - 1;
-    else
-      bot = mid + 1;
-  }
+  return page[key & HTREE_PAGE_MASK];
 }
 
-void htree_test()
+void htree_test(void)
 {
-#ifdef HTREE_TEST_CYCLES
-  int i, n, l;
-  struct timeval start, finish;
-  float t1, t2;
-
-  if (gettimeofday(&start, NULL)) {
-    log("error getting time: gettimeofday(): %s", strerror(errno));
-  }
-  for (i = 0; i < HTREE_TEST_CYCLES; i++) {
-    n = rand_number(1, top_of_world);
-    l = real_room_old(world[n].number);
-  }
-  if (gettimeofday(&finish, NULL)) {
-    log("error getting time: gettimeofday(): %s", strerror(errno));
-  }
-  log("old start: %2d.%06d", start.tv_sec, start.tv_usec);
-  log("old   end: %2d.%06d", finish.tv_sec, finish.tv_usec);
-  t1 = ((float)finish.tv_sec + ((float)finish.tv_usec) / 1000000) -
-       ((float)start.tv_sec + ((float)start.tv_usec) / 1000000);
-  if (gettimeofday(&start, NULL)) {
-    log("error getting time: gettimeofday(): %s", strerror(errno));
-  }
-  for (i = 0; i < HTREE_TEST_CYCLES; i++) {
-    n = rand_number(1, top_of_world);
-    l = real_room(world[n].number);
-  }
-  if (gettimeofday(&finish, NULL)) {
-    log("error getting time: gettimeofday(): %s", strerror(errno));
-  }
-  log("new start: %2d.%06d", start.tv_sec, start.tv_usec);
-  log("new   end: %2d.%06d", finish.tv_sec, finish.tv_usec);
-  t2 = ((float)finish.tv_sec + ((float)finish.tv_usec) / 1000000) -
-       ((float)start.tv_sec + ((float)start.tv_usec) / 1000000);
-  log("htree_test: htree speedup factor: %.0f%% (%.2f/%.2f)", t1 * 100 / t2, t1, t2);
-#endif /* HTREE_TEST_CYCLES */
-  log("htree stats (global): %d nodes, %lu bytes (depth %d/%lu used/possible)", htree_total_nodes, (long unsigned int)(htree_total_nodes * sizeof(struct htree_node)), htree_depth_used, (long unsigned int)HTREE_MAX_DEPTH);
-}
\ No newline at end of file
+  log("htree stats (global): %d pages, %lu bytes (%lu slots per page)",
+      htree_total_pages,
+      (long unsigned int)(htree_total_pages * HTREE_PAGE_SIZE * sizeof(IDXTYPE)),
+      (long unsigned int)HTREE_PAGE_SIZE);
+}
@@ -1,6 +1,6 @@
 /***************************************************************************
  *   File: htree.h                                                         *
- *  Usage: Generalized hash tree code for fast lookups                     *
+ *  Usage: Direct-index vnum to rnum maps for fast lookups                 *
  *                                                                         *
  * This code is released under the CircleMud License                       *
  * Written by Elie Rosenblum <fnord@cosanostra.net>                        *
@@ -9,29 +9,28 @@
 
 /* Magic constants: */
 /* Don't change these unless you know what you're doing, the constants must
- * match */
+ * match. The key space (every possible IDXTYPE) is split into HTREE_PAGES
+ * pages of HTREE_PAGE_SIZE slots each. Only pages that hold at least one vnum
+ * are allocated, so a map over a sparse vnum range stays small while every
+ * lookup is two array reads. */
 
-#define HTREE_NODE_BITS 5
-#define HTREE_NODE_SUBS (1 << HTREE_NODE_BITS)
-#define HTREE_NODE_MASK (HTREE_NODE_SUBS - 1)
-#define HTREE_MAX_DEPTH (((sizeof(IDXTYPE) * 8) / HTREE_NODE_BITS) + 1)
+#define HTREE_KEY_BITS  (sizeof(IDXTYPE) * 8)
+#define HTREE_PAGE_BITS 8
+#define HTREE_PAGE_SIZE (1 << HTREE_PAGE_BITS)
+#define HTREE_PAGE_MASK (HTREE_PAGE_SIZE - 1)
+#define HTREE_PAGES     (1 << (HTREE_KEY_BITS - HTREE_PAGE_BITS))
 
 /* End of magic constants */
 
 struct htree_node {
-  IDXTYPE content;
-  struct htree_node *parent;
-  struct htree_node *subs[HTREE_NODE_SUBS];
+  IDXTYPE *pages[HTREE_PAGES];
 };
 
-extern struct htree_node *HTREE_NULL;
-extern int htree_total_nodes;
-extern int htree_depth_used;
+extern int htree_total_pages;
 
-void htree_shutdown();
-struct htree_node *htree_init();
+struct htree_node *htree_init(void);
 void htree_free(struct htree_node *root);
 void htree_add(struct htree_node *root, IDXTYPE index, IDXTYPE content);
 void htree_del(struct htree_node *root, IDXTYPE index);
 IDXTYPE htree_find(struct htree_node *root, IDXTYPE index);
-void htree_test();
\ No newline at end of file
+void htree_test(void);
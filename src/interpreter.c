@@ -39,6 +39,7 @@
 #include "ibt.h"
 #include "mud_event.h"
 #include "account.h"
+#include "kwindex.h"
 
 void migrate_player(struct char_data *ch, int old_version);
 
@@ -411,6 +412,7 @@ cpp_extern const struct command_info cmd_info[] = {
   { "tlist"    , "tlist"   , POS_DEAD    , do_oasis_list, LVL_BUILDER, SCMD_OASIS_TLIST },
   { "tcopy"    , "tcopy"   , POS_DEAD    , do_oasis_copy, LVL_GOD, CON_TRIGEDIT },
   { "tstat"    , "tstat"   , POS_DEAD    , do_tstat    , LVL_BUILDER, 0 },
+  { "tprofile" , "tprof"   , POS_DEAD    , do_tprofile , LVL_BUILDER, 0 },
 
   { "unlock"   , "unlock"  , POS_SITTING , do_gen_door , 0, SCMD_UNLOCK },
   { "unban"    , "unban"   , POS_DEAD    , do_unban    , LVL_GRGOD, 0 },
@@ -726,6 +728,7 @@ ACMD(do_alias)
     if ((a = find_alias(GET_ALIASES(ch), arg)) != NULL) {
       REMOVE_FROM_LIST(a, GET_ALIASES(ch), next);
       free_alias(a);
+      SET_SAVE_DIRTY(ch, SAVE_ALIASES);
     }
     /* if no replacement string is specified, assume we want to delete */
     if (!*repl) {
@@ -1365,6 +1368,7 @@ int enter_player_game (struct descriptor_data *d)
 
   d->character->next = character_list;
   character_list = d->character;
+  kw_index_char(d->character);
   char_to_room(d->character, load_room);
   load_result = Crash_load(d->character);
   
@@ -2138,6 +2142,7 @@ if (active >= d->account->max_online) {
       STATE(d) = CON_ACCOUNT_CHAR_SELECT;
       return;
     }
+    GET_PFILEPOS(d->character) = load_result;
   
     reset_char(d->character);
   
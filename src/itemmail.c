@@ -27,38 +27,230 @@
 #include "handler.h"
 #include "mail.h"
 #include "itemmail.h"
+#include "journal.h"
+#include "savequeue.h"
+#include "binfile.h"
+#include "xdir.h"
 
 
 /*
- * Save a mailed item to disk.
+ * Parcels waiting for each player, loaded from LIB_ITEMMAIL at boot and kept
+ * in step with it. Each change rewrites the recipient's whole file, once,
+ * through the save queue.
  */
-void store_item_mail(struct item_mail_entry *entry) {
-char filename[MAX_INPUT_LENGTH];
-snprintf(filename, sizeof(filename), "%s%ld", LIB_ITEMMAIL, entry->recipient_id);
+struct itemmail_parcel {
+  struct item_mail_entry entry;
+  struct itemmail_parcel *next;
+};
+
+struct itemmail_box {
+  long idnum;
+  struct itemmail_parcel *parcels;   /* oldest first */
+  struct itemmail_box *next;
+};
+
+static struct itemmail_box *itemmail_boxes[ITEMMAIL_BUCKETS];
+
+static struct itemmail_box *itemmail_find(long idnum, bool create) {
+  struct itemmail_box *box, **bucket;
 
-FILE *fp = fopen(filename, "ab");
-if (!fp) {
-  perror("store_item_mail: cannot open itemmail file");
-  return;
+  bucket = &itemmail_boxes[((unsigned long) idnum * 2654435761UL) % ITEMMAIL_BUCKETS];
+  for (box = *bucket; box; box = box->next)
+    if (box->idnum == idnum)
+      return box;
+
+  if (!create)
+    return NULL;
+
+  CREATE(box, struct itemmail_box, 1);
+  box->idnum = idnum;
+  box->next = *bucket;
+  *bucket = box;
+  return box;
 }
-fwrite(entry, sizeof(struct item_mail_entry), 1, fp);
-fclose(fp);
+
+static void itemmail_add(struct itemmail_box *box, struct item_mail_entry *entry) {
+  struct itemmail_parcel *parcel, **tail;
+
+  for (tail = &box->parcels; *tail; tail = &(*tail)->next)
+    ;
+  CREATE(parcel, struct itemmail_parcel, 1);
+  parcel->entry = *entry;
+  *tail = parcel;
 }
 
 /*
- * Check if a player has any item mail.
- * Returns TRUE if there is item mail for the given idnum.
+ * Write all of a player's parcels to their file, or remove the file if none
+ * are left. Returns once the file is written, as callers journal the
+ * player's objects next and the two must not disagree after a crash.
  */
-bool has_item_mail(long idnum) {
+static void itemmail_save(struct itemmail_box *box) {
+  static struct bin_buf buf;
+  struct itemmail_parcel *parcel;
   char filename[MAX_INPUT_LENGTH];
-  snprintf(filename, sizeof(filename), "%s%ld", LIB_ITEMMAIL, idnum);
+  size_t start;
+  FILE *fp;
+
+  snprintf(filename, sizeof(filename), "%s%ld", LIB_ITEMMAIL, box->idnum);
+
+  if (!box->parcels) {
+    saveq_wait(filename);
+    if (remove(filename) < 0 && errno != ENOENT)
+      log("SYSERR: removing itemmail file %s: %s", filename, strerror(errno));
+    return;
+  }
 
-  FILE *fp = fopen(filename, "rb");
-  if (fp) {
+  buf.len = 0;
+  bin_put_bytes(&buf, ITEMMAIL_MAGIC, ITEMMAIL_MAGIC_LEN);
+  bin_put(&buf, ITEMMAIL_VERSION, 2);
+  for (parcel = box->parcels; parcel; parcel = parcel->next) {
+    start = buf.len;
+    bin_put(&buf, 0, 2);
+    bin_put(&buf, parcel->entry.recipient_id, 8);
+    bin_put(&buf, parcel->entry.sender_id, 8);
+    bin_put(&buf, parcel->entry.unique_id, 8);
+    bin_put(&buf, parcel->entry.vnum, 4);
+    bin_put(&buf, parcel->entry.date_sent, 8);
+    bin_put_str(&buf, parcel->entry.message, 2);
+    bin_patch(&buf, start, buf.len - start - 2, 2);
+  }
+
+  if (!(fp = saveq_open(filename))) {
+    log("SYSERR: store_item_mail: cannot open itemmail file %s", filename);
+    return;
+  }
+  if (fwrite(buf.data, buf.len, 1, fp) != 1) {
+    saveq_abort(fp);
+    return;
+  }
+  if (saveq_commit(fp))
+    saveq_wait(filename);
+}
+
+/*
+ * Read a player's itemmail file into their box. Files from before the
+ * versioned format hold raw item_mail_entry structs; those are read as such
+ * and rewritten. Returns the number of parcels read.
+ */
+static int itemmail_load(long idnum) {
+  struct itemmail_box *box;
+  struct item_mail_entry entry;
+  struct bin_reader r, rec;
+  unsigned char *data;
+  char filename[MAX_INPUT_LENGTH], *msg;
+  long len;
+  int count = 0, reclen;
+  FILE *fp;
+
+  snprintf(filename, sizeof(filename), "%s%ld", LIB_ITEMMAIL, idnum);
+  if (!(fp = fopen(filename, "rb")))
+    return 0;
+
+  fseek(fp, 0, SEEK_END);
+  len = ftell(fp);
+  rewind(fp);
+  CREATE(data, unsigned char, len + 1);
+  if (len > 0 && fread(data, len, 1, fp) != 1) {
+    log("SYSERR: reading itemmail file %s", filename);
     fclose(fp);
-    return TRUE;
+    free(data);
+    return 0;
+  }
+  fclose(fp);
+
+  box = itemmail_find(idnum, TRUE);
+
+  if (len < ITEMMAIL_MAGIC_LEN + 2 || memcmp(data, ITEMMAIL_MAGIC, ITEMMAIL_MAGIC_LEN)) {
+    for (; (count + 1) * (long) sizeof(entry) <= len; count++) {
+      memcpy(&entry, data + count * sizeof(entry), sizeof(entry));
+      entry.message[sizeof(entry.message) - 1] = '\0';
+      itemmail_add(box, &entry);
+    }
+    free(data);
+    log("   Converted itemmail file %s.", filename);
+    itemmail_save(box);
+    return count;
   }
-  return FALSE;
+
+  bin_reader_init(&r, data + ITEMMAIL_MAGIC_LEN, len - ITEMMAIL_MAGIC_LEN);
+  bin_get(&r, 2);   /* version */
+  while (r.pos < r.end) {
+    reclen = bin_get(&r, 2);
+    bin_reader_init(&rec, bin_get_bytes(&r, reclen), reclen);
+    if (r.bad)
+      break;
+    memset(&entry, 0, sizeof(entry));
+    entry.recipient_id = bin_get(&rec, 8);
+    entry.sender_id = bin_get(&rec, 8);
+    entry.unique_id = bin_get(&rec, 8);
+    entry.vnum = bin_get(&rec, 4);
+    entry.date_sent = bin_get(&rec, 8);
+    msg = bin_get_str(&rec, 2);
+    strlcpy(entry.message, msg, sizeof(entry.message));
+    free(msg);
+    if (rec.bad)
+      break;
+    itemmail_add(box, &entry);
+    count++;
+  }
+  if (r.bad || rec.bad)
+    log("SYSERR: itemmail file %s is truncated; kept %d parcels.", filename, count);
+
+  free(data);
+  return count;
+}
+
+/*
+ * Index every player's waiting parcels. Called once at boot.
+ */
+void itemmail_boot(void) {
+  struct xap_dir xd;
+  char dir_name[MAX_INPUT_LENGTH], *fname;
+  long idnum;
+  int i, total, count = 0, players = 0, n;
+
+#if defined(CIRCLE_WINDOWS)
+  snprintf(dir_name, sizeof(dir_name), "%s*", LIB_ITEMMAIL);
+#else
+  snprintf(dir_name, sizeof(dir_name), "%s", LIB_ITEMMAIL);
+#endif
+
+  if ((total = xdir_scan(dir_name, &xd)) <= 0)
+    return;
+
+  for (i = 0; i < total; i++) {
+    fname = xdir_get_name(&xd, i);
+    /* Only files named for an idnum; not ".", "..", or save queue temps. */
+    if (!isdigit(*fname) || sscanf(fname, "%ld%n", &idnum, &n) != 1 || fname[n])
+      continue;
+    if ((n = itemmail_load(idnum)) > 0) {
+      count += n;
+      players++;
+    }
+  }
+  xdir_close(&xd);
+
+  log("   %d parcels waiting for %d players.", count, players);
+}
+
+/*
+ * Save a mailed item for its recipient.
+ */
+void store_item_mail(struct item_mail_entry *entry) {
+  struct itemmail_box *box = itemmail_find(entry->recipient_id, TRUE);
+
+  itemmail_add(box, entry);
+  itemmail_save(box);
+}
+
+/*
+ * Check if a player has any item mail.
+ * Returns TRUE if there is item mail for the given idnum.
+ */
+bool has_item_mail(long idnum) {
+  struct itemmail_box *box = itemmail_find(idnum, FALSE);
+
+  return (box && box->parcels);
 }
 
 
@@ -137,7 +329,8 @@ ACMD(do_mailitem) {
   /* Remove the item from the player */
   obj_from_char(obj);
   extract_obj(obj);
-  GET_GOLD(ch) -= postage;
+  decrease_gold(ch, postage);
+  journal_objs(ch);
   send_to_char(ch, "You have successfully mailed the item.\r\n");
   send_to_char(ch, "You pay %d gold coins in postage.\r\n", postage);
 }
@@ -146,24 +339,25 @@ ACMD(do_mailitem) {
  * Command to collect all mailed items addressed to the player.
  */
 ACMD(do_collectitem) {
-  FILE *fp;
+  struct itemmail_box *box;
+  struct itemmail_parcel *waiting, *next, *kept = NULL, **kept_tail = &kept;
   struct item_mail_entry entry;
   bool found = FALSE;
-  char filename[MAX_INPUT_LENGTH];
 
-  snprintf(filename, sizeof(filename), "%s%ld", LIB_ITEMMAIL, GET_IDNUM(ch));
-
-  fp = fopen(filename, "rb");
-  if (!fp) {
+  if (!(box = itemmail_find(GET_IDNUM(ch), FALSE)) || !box->parcels) {
     send_to_char(ch, "You have no mailed items.\r\n");
     return;
   }
 
-  while (fread(&entry, sizeof(struct item_mail_entry), 1, fp)) {
+  for (waiting = box->parcels; waiting; waiting = next) {
+    next = waiting->next;
+    entry = waiting->entry;
+
     /* Create the object */
     struct obj_data *obj = read_object(entry.vnum, VIRTUAL);
     if (!obj) {
       send_to_char(ch, "One of your mailed items could not be loaded.\r\n");
+      free(waiting);
       continue;
     }
 
@@ -175,6 +369,10 @@ ACMD(do_collectitem) {
     if (!parcel) {
       send_to_char(ch, "Parcel object missing (vnum 3016).\r\n");
       extract_obj(obj);
+      /* Leave it at the post office until there is a box to put it in. */
+      waiting->next = NULL;
+      *kept_tail = waiting;
+      kept_tail = &waiting->next;
       continue;
     }
 
@@ -213,14 +411,15 @@ snprintf(buf, sizeof(buf),
 
     send_to_char(ch, "You collect a parcel addressed to you.\r\n");
     found = TRUE;
+    free(waiting);
   }
 
-  fclose(fp);
-
-  /* Remove file after collecting */
-  remove(filename);
+  /* Rewrite the file with what is left before journaling the parcels */
+  box->parcels = kept;
+  itemmail_save(box);
+  journal_objs(ch);
 
-  if (!found) {
+  if (!found && !kept) {
     send_to_char(ch, "You have no mailed items.\r\n");
   }
 }
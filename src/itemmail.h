@@ -16,6 +16,20 @@
 #define ITEMMAIL_H
 
 
+/* Buckets in the in-memory index of waiting parcels */
+#define ITEMMAIL_BUCKETS 256
+
+/*
+ * An itemmail file is ITEMMAIL_MAGIC and a 2 byte version, then one record
+ * per parcel, oldest first: a 2 byte length, then the recipient, sender and
+ * unique id (8 bytes each), vnum (4), date sent (8) and the message (2 byte
+ * length and text). Integers are little endian; see binfile.c. Readers
+ * ignore anything past the fields they know at the end of a record.
+ */
+#define ITEMMAIL_MAGIC      "TBIM"
+#define ITEMMAIL_MAGIC_LEN  4
+#define ITEMMAIL_VERSION    1
+
 struct item_mail_entry {
   long recipient_id;
   long sender_id;
@@ -25,6 +39,7 @@ struct item_mail_entry {
   char message[256];
 };
 
+void itemmail_boot(void);
 void store_item_mail(struct item_mail_entry *entry);
 bool has_item_mail(long idnum);
 
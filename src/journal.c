@@ -0,0 +1,478 @@
+/**
+* @file journal.c
+* Write-ahead journal of player gold, experience and objects.
+*
+* Part of the core tbaMUD source code distribution, which is a derivative
+* of, and continuation of, CircleMUD.
+*
+* Between autosaves a player's gold, experience and objects only live in
+* memory. Every change to them is appended to the journal as it happens, and
+* on boot the journal is replayed over the player and rent files, so a crash
+* loses only what had not reached the journal yet.
+*
+* A record is the payload length and a CRC-32 of the payload, both as 4 byte
+* integers, followed by the payload: a type byte, the player's idnum as a 4
+* byte integer, and then
+*   JNL_POINTS  gold, bank gold and experience, as 8 byte integers;
+*   JNL_OBJS    the player's crash file, as Crash_write_crashfile() makes it;
+*   JNL_DONE    nothing; the player left the game and was saved in full.
+* Replay stops at the first short or damaged record, which is where a crash
+* cut the last write off.
+*
+* Points are journaled as their new values and objects as the whole crash
+* file, not as individual moves: replaying a record twice is harmless, and
+* wearing an object or putting it in a bag needs no record of its own. Object
+* changes are collected and written once a second, except around the stash
+* and item mail, whose own files are written straight away.
+*
+* Every CONFIG_AUTOSAVE_TIME minutes the journal is moved aside and a new one
+* started. The old one is removed once every player with changes in it has
+* been autosaved and the save queue has caught up.
+*/
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include "structs.h"
+#include "utils.h"
+#include "comm.h"
+#include "db.h"
+#include "handler.h"
+#include "config.h"
+#include "savequeue.h"
+#include "journal.h"
+
+#define JNL_POINTS  1
+#define JNL_OBJS    2
+#define JNL_DONE    3
+
+#define JNL_HEADER  8   /* length and CRC */
+#define JNL_PREFIX  5   /* type and idnum */
+
+static FILE *jnl_fp = NULL;
+static long jnl_size = 0;
+static time_t jnl_started = 0;
+static int jnl_gen = 1;            /* generation of the current journal */
+static int jnl_old = FALSE;        /* JOURNAL_OLD_FILE is waiting to go */
+static FILE *jnl_scratch = NULL;   /* for formatting crash files */
+
+static unsigned char *jnl_buf = NULL;
+static size_t jnl_buf_size = 0;
+
+static void jnl_reserve(size_t len)
+{
+  if (len <= jnl_buf_size)
+    return;
+  jnl_buf_size = MAX(len, jnl_buf_size * 2);
+  RECREATE(jnl_buf, unsigned char, jnl_buf_size);
+}
+
+static unsigned long jnl_crc32(const unsigned char *p, size_t len)
+{
+  static unsigned long table[256];
+  static int ready = FALSE;
+  unsigned long crc;
+  int i, k;
+
+  if (!ready) {
+    for (i = 0; i < 256; i++) {
+      for (crc = i, k = 0; k < 8; k++)
+        crc = (crc & 1) ? 0xEDB88320UL ^ (crc >> 1) : crc >> 1;
+      table[i] = crc;
+    }
+    ready = TRUE;
+  }
+
+  for (crc = 0xFFFFFFFFUL; len; len--, p++)
+    crc = table[(crc ^ *p) & 0xFF] ^ (crc >> 8);
+
+  return (crc ^ 0xFFFFFFFFUL) & 0xFFFFFFFFUL;
+}
+
+static void jnl_put(unsigned char *p, unsigned long long val, int bytes)
+{
+  int i;
+
+  for (i = 0; i < bytes; i++, val >>= 8)
+    p[i] = (unsigned char) (val & 0xFF);
+}
+
+static unsigned long long jnl_get(const unsigned char *p, int bytes)
+{
+  unsigned long long val = 0;
+
+  while (bytes--)
+    val = (val << 8) | p[bytes];
+
+  return val;
+}
+
+/* Append one record whose payload body (after the type and idnum) is already
+ * at jnl_buf + JNL_HEADER + JNL_PREFIX. */
+static void jnl_write(int type, struct char_data *ch, size_t body)
+{
+  size_t len = JNL_PREFIX + body;
+
+  if (!jnl_fp || IS_NPC(ch))
+    return;
+
+  jnl_buf[JNL_HEADER] = (unsigned char) type;
+  jnl_put(jnl_buf + JNL_HEADER + 1, (unsigned long) GET_IDNUM(ch), 4);
+  jnl_put(jnl_buf, len, 4);
+  jnl_put(jnl_buf + 4, jnl_crc32(jnl_buf + JNL_HEADER, len), 4);
+
+  if (fwrite(jnl_buf, JNL_HEADER + len, 1, jnl_fp) != 1 || fflush(jnl_fp) != 0) {
+    mudlog(BRF, LVL_IMMORT, TRUE, "SYSERR: Writing the player journal failed: %s", strerror(errno));
+    return;
+  }
+  jnl_size += JNL_HEADER + len;
+
+  if (type == JNL_DONE)
+    GET_JOURNAL_GEN(ch) = GET_JOURNAL_LAST(ch) = 0;
+  else {
+    if (!GET_JOURNAL_GEN(ch))
+      GET_JOURNAL_GEN(ch) = jnl_gen;
+    GET_JOURNAL_LAST(ch) = jnl_gen;
+  }
+}
+
+/* Whether the current or the old journal still holds records for ch, which
+ * replay would apply. */
+static int jnl_has_records(struct char_data *ch)
+{
+  return GET_JOURNAL_LAST(ch) == jnl_gen ||
+         (jnl_old && GET_JOURNAL_LAST(ch) == jnl_gen - 1);
+}
+
+/** Journal ch's gold, bank gold and experience. */
+void journal_points(struct char_data *ch)
+{
+  unsigned char *p;
+
+  if (!jnl_fp || IS_NPC(ch))
+    return;
+
+  jnl_reserve(JNL_HEADER + JNL_PREFIX + 24);
+  p = jnl_buf + JNL_HEADER + JNL_PREFIX;
+  jnl_put(p,      (unsigned long long) GET_GOLD(ch), 8);
+  jnl_put(p + 8,  (unsigned long long) GET_BANK_GOLD(ch), 8);
+  jnl_put(p + 16, (unsigned long long) GET_EXP(ch), 8);
+  jnl_write(JNL_POINTS, ch, 24);
+}
+
+/** Journal ch's carried and worn objects now. */
+void journal_objs(struct char_data *ch)
+{
+  long len;
+
+  if (!jnl_fp || IS_NPC(ch))
+    return;
+
+  GET_JOURNAL_OBJS(ch) = FALSE;
+
+  if (!jnl_scratch && !(jnl_scratch = tmpfile())) {
+    log("SYSERR: Can't open a scratch file for the player journal: %s", strerror(errno));
+    return;
+  }
+
+  rewind(jnl_scratch);
+  if (!Crash_write_crashfile(jnl_scratch, ch) || (len = ftell(jnl_scratch)) <= 0 ||
+      fflush(jnl_scratch) != 0) {
+    log("SYSERR: Can't journal %s's objects.", GET_NAME(ch));
+    return;
+  }
+
+  jnl_reserve(JNL_HEADER + JNL_PREFIX + len);
+  rewind(jnl_scratch);
+  if (fread(jnl_buf + JNL_HEADER + JNL_PREFIX, len, 1, jnl_scratch) != 1) {
+    log("SYSERR: Can't journal %s's objects.", GET_NAME(ch));
+    return;
+  }
+  jnl_write(JNL_OBJS, ch, len);
+}
+
+/** Call after saving the SAVE_ section(s) 'sect' of ch. If a journal still
+ * has records for ch, even ones already saved, what was saved is journaled
+ * too, so replay never puts back anything older than the files. Objects
+ * waiting to be journaled always are. Once nothing is left unsaved, the
+ * journal ch's changes were in no longer has to wait for ch. */
+void journal_saved(struct char_data *ch, int sect)
+{
+  int records;
+
+  if (!jnl_fp || IS_NPC(ch))
+    return;
+
+  records = jnl_has_records(ch);
+  if (records && (sect & SAVE_STATS))
+    journal_points(ch);
+  if (GET_JOURNAL_OBJS(ch) || (records && (sect & SAVE_INVENTORY)))
+    journal_objs(ch);
+
+  if (!(GET_SAVE_DIRTY(ch) & (SAVE_STATS | SAVE_INVENTORY)))
+    GET_JOURNAL_GEN(ch) = 0;
+}
+
+/** Call once ch has left the game and been saved in full; replay ignores
+ * everything journaled for ch before this. Waits for ch's files to be
+ * written first, so the journal never gets ahead of them. */
+void journal_done(struct char_data *ch)
+{
+  char filename[MAX_INPUT_LENGTH];
+
+  if (!jnl_fp || IS_NPC(ch))
+    return;
+
+  if (get_filename(filename, sizeof(filename), PLR_FILE, GET_NAME(ch)))
+    saveq_wait(filename);
+  if (get_filename(filename, sizeof(filename), CRASH_FILE, GET_NAME(ch)))
+    saveq_wait(filename);
+
+  jnl_reserve(JNL_HEADER + JNL_PREFIX);
+  jnl_write(JNL_DONE, ch, 0);
+  GET_JOURNAL_OBJS(ch) = FALSE;
+}
+
+/* What replay found for one player. */
+struct jnl_player {
+  int points;
+  long gold, bank, exp;
+  char *objs;
+  size_t objs_len;
+};
+
+/* Read one journal file into 'found', indexed like player_table. Returns the
+ * number of records used. */
+static int jnl_read(const char *path, struct jnl_player *found)
+{
+  FILE *fl;
+  unsigned char head[JNL_HEADER];
+  unsigned char *p;
+  unsigned long len;
+  long pos;
+  int records = 0;
+  struct jnl_player *jp;
+
+  if (!(fl = fopen(path, "rb")))
+    return 0;
+
+  for (;;) {
+    if (fread(head, JNL_HEADER, 1, fl) != 1)
+      break;
+
+    len = (unsigned long) jnl_get(head, 4);
+    if (len < JNL_PREFIX || len > JOURNAL_MAX_SIZE * 2) {
+      log("SYSERR: %s: bad record length %lu, ignoring the rest.", path, len);
+      break;
+    }
+    jnl_reserve(len);
+    if (fread(jnl_buf, len, 1, fl) != 1) {
+      log("%s: last record is incomplete, ignoring it.", path);
+      break;
+    }
+    if (jnl_crc32(jnl_buf, len) != (unsigned long) jnl_get(head + 4, 4)) {
+      log("SYSERR: %s: bad checksum, ignoring the rest.", path);
+      break;
+    }
+
+    if ((pos = get_ptable_by_id((long) jnl_get(jnl_buf + 1, 4))) < 0)
+      continue;
+    jp = &found[pos];
+    p = jnl_buf + JNL_PREFIX;
+    len -= JNL_PREFIX;
+
+    switch (jnl_buf[0]) {
+    case JNL_POINTS:
+      if (len < 24)
+        continue;
+      jp->points = TRUE;
+      jp->gold = (long) jnl_get(p, 8);
+      jp->bank = (long) jnl_get(p + 8, 8);
+      jp->exp  = (long) jnl_get(p + 16, 8);
+      break;
+    case JNL_OBJS:
+      if (jp->objs)
+        free(jp->objs);
+      CREATE(jp->objs, char, len);
+      memcpy(jp->objs, p, len);
+      jp->objs_len = len;
+      break;
+    case JNL_DONE:
+      if (jp->objs)
+        free(jp->objs);
+      memset(jp, 0, sizeof(*jp));
+      break;
+    default:
+      continue;
+    }
+    records++;
+  }
+
+  fclose(fl);
+  return records;
+}
+
+/* Put what replay found for player_table[pos] back in their files. */
+static void jnl_restore(int pos, struct jnl_player *jp)
+{
+  struct char_data *ch;
+  char filename[MAX_INPUT_LENGTH];
+  FILE *fl;
+
+  if (jp->points) {
+    CREATE(ch, struct char_data, 1);
+    clear_char(ch);
+    CREATE(ch->player_specials, struct player_special_data, 1);
+    new_mobile_data(ch);
+    if (load_char(player_table[pos].name, ch) > -1) {
+      GET_GOLD(ch) = jp->gold;
+      GET_BANK_GOLD(ch) = jp->bank;
+      GET_EXP(ch) = jp->exp;
+      GET_PFILEPOS(ch) = pos;
+      save_char(ch);
+    }
+    free_char(ch);
+  }
+
+  if (jp->objs && get_filename(filename, sizeof(filename), CRASH_FILE, player_table[pos].name)) {
+    if ((fl = saveq_open(filename)) != NULL) {
+      if (fwrite(jp->objs, jp->objs_len, 1, fl) == 1)
+        saveq_commit(fl);
+      else
+        saveq_abort(fl);
+    }
+  }
+}
+
+/** Replay whatever journals a crash left behind, then start a new one. Needs
+ * the player index. */
+void journal_boot(void)
+{
+  struct jnl_player *found = NULL;
+  int i, records = 0, players = 0;
+
+  if (top_of_p_table >= 0) {
+    CREATE(found, struct jnl_player, top_of_p_table + 1);
+    records += jnl_read(JOURNAL_OLD_FILE, found);
+    records += jnl_read(JOURNAL_FILE, found);
+  }
+
+  for (i = 0; i <= top_of_p_table; i++) {
+    if (!found[i].points && !found[i].objs)
+      continue;
+    jnl_restore(i, &found[i]);
+    if (found[i].objs)
+      free(found[i].objs);
+    players++;
+  }
+  if (found)
+    free(found);
+
+  if (records) {
+    saveq_wait(NULL);
+    log("Replayed %d journal record%s for %d player%s.", records,
+        records == 1 ? "" : "s", players, players == 1 ? "" : "s");
+  }
+
+  remove(JOURNAL_OLD_FILE);
+  if (!(jnl_fp = fopen(JOURNAL_FILE, "wb")))
+    log("SYSERR: Can't open %s, running without a player journal: %s", JOURNAL_FILE, strerror(errno));
+  jnl_size = 0;
+  jnl_started = time(0);
+}
+
+/* Whether every player with changes in the old journal has been saved since.
+ * Players autosave will not get to, the linkless and those not playing (in
+ * OLC, say), are saved here. */
+static int jnl_old_done(void)
+{
+  struct char_data *ch;
+  int done = TRUE;
+
+  for (ch = character_list; ch; ch = ch->next) {
+    if (IS_NPC(ch) || !GET_JOURNAL_GEN(ch) || GET_JOURNAL_GEN(ch) >= jnl_gen)
+      continue;
+    if (!ch->desc || STATE(ch->desc) != CON_PLAYING || !CONFIG_AUTO_SAVE) {
+      if (GET_SAVE_DIRTY(ch) & SAVE_INVENTORY)
+        Crash_crashsave(ch);
+      save_char(ch);
+    }
+    if (GET_JOURNAL_GEN(ch))
+      done = FALSE;
+  }
+
+  return done;
+}
+
+/** Called every PULSE_JOURNAL. Journals object changes, syncs the journal to
+ * disk and moves on to a new journal when it is time. */
+void journal_pulse(void)
+{
+  struct descriptor_data *d;
+
+  if (!jnl_fp)
+    return;
+
+  for (d = descriptor_list; d; d = d->next)
+    if (STATE(d) == CON_PLAYING && !IS_NPC(d->character) && GET_JOURNAL_OBJS(d->character))
+      journal_objs(d->character);
+
+#if defined(CIRCLE_UNIX)
+  if (jnl_size)
+    fsync(fileno(jnl_fp));
+#endif
+
+  if (jnl_old) {
+    if (jnl_old_done()) {
+      saveq_wait(NULL);
+      remove(JOURNAL_OLD_FILE);
+      jnl_old = FALSE;
+    }
+  } else if (jnl_size && (jnl_size >= JOURNAL_MAX_SIZE ||
+             time(0) - jnl_started >= CONFIG_AUTOSAVE_TIME * SECS_PER_REAL_MIN)) {
+    if (rename(JOURNAL_FILE, JOURNAL_OLD_FILE) != 0) {
+      log("SYSERR: Can't move %s aside: %s", JOURNAL_FILE, strerror(errno));
+      jnl_started = time(0);
+      return;
+    }
+    fclose(jnl_fp);
+    jnl_old = TRUE;
+    jnl_gen++;
+    jnl_size = 0;
+    jnl_started = time(0);
+    if (!(jnl_fp = fopen(JOURNAL_FILE, "wb")))
+      mudlog(BRF, LVL_IMMORT, TRUE, "SYSERR: Can't reopen %s, running without a player journal: %s",
+             JOURNAL_FILE, strerror(errno));
+  }
+}
+
+/** Call at shutdown, after everyone has been saved and the save queue
+ * flushed. Keeps the journal for the next boot if anyone still has unsaved
+ * changes in it, and removes it otherwise. */
+void journal_shutdown(void)
+{
+  struct char_data *ch;
+  int unsaved = 0;
+
+  if (!jnl_fp)
+    return;
+
+  for (ch = character_list; ch; ch = ch->next) {
+    if (IS_NPC(ch))
+      continue;
+    if (GET_JOURNAL_OBJS(ch))
+      journal_objs(ch);
+    if (GET_JOURNAL_GEN(ch))
+      unsaved++;
+  }
+
+  fclose(jnl_fp);
+  jnl_fp = NULL;
+
+  if (unsaved)
+    log("Keeping the player journal, %d player%s not saved.", unsaved, unsaved == 1 ? "" : "s");
+  else {
+    remove(JOURNAL_OLD_FILE);
+    remove(JOURNAL_FILE);
+  }
+}
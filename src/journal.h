@@ -0,0 +1,24 @@
+/**
+* @file journal.h
+* Write-ahead journal of player gold, experience and objects.
+*
+* Part of the core tbaMUD source code distribution, which is a derivative
+* of, and continuation of, CircleMUD.
+*/
+
+#ifndef _JOURNAL_H_
+#define _JOURNAL_H_
+
+/** Start a new journal once the current one is this big, even if
+ * CONFIG_AUTOSAVE_TIME has not passed yet. */
+#define JOURNAL_MAX_SIZE  (4 * 1024 * 1024)
+
+void journal_boot(void);
+void journal_shutdown(void);
+void journal_pulse(void);
+void journal_points(struct char_data *ch);
+void journal_objs(struct char_data *ch);
+void journal_saved(struct char_data *ch, int sect);
+void journal_done(struct char_data *ch);
+
+#endif /* _JOURNAL_H_ */
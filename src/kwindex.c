@@ -0,0 +1,239 @@
+/**
+* @file kwindex.c
+* Keyword index for world-wide character and object lookups.
+*
+* Part of the core tbaMUD source code distribution, which is a derivative
+* of, and continuation of, CircleMUD.
+*
+* Every live character and object has one entry per distinct keyword prefix
+* in its namelist, filed in a hash table by the first KW_PREFIX letters of
+* the keyword (case folded). isname() matches abbreviations, so a lookup for
+* "gua" or "guard" both land in the "gua" bucket; the caller still runs its
+* usual isname()/CAN_SEE checks on the candidates it gets back.
+*
+* Entries carry the order the thing was first indexed in, and lookups hand
+* back candidates newest first, the same order as character_list and
+* object_list, so "2.guard" picks the same guard it always did. A thing
+* with no keyword long enough to file still gets one entry, with key 0 and
+* in no bucket, so renaming it later knows it is live.
+*/
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include "structs.h"
+#include "utils.h"
+#include "kwindex.h"
+
+struct kw_entry {
+  unsigned int key;               /* first KW_PREFIX letters, folded */
+  unsigned long order;            /* when the thing was first indexed */
+  void *thing;                    /* the char_data or obj_data */
+  struct kw_entry *next, *prev;   /* in the bucket */
+  struct kw_entry *next_of_thing; /* the thing's other entries */
+};
+
+static struct kw_entry *kw_table[2][KW_BUCKETS];
+static unsigned long kw_order = 0;
+
+/* Lookup results, reused by every call. */
+static void **kw_found = NULL;
+static struct kw_entry **kw_sort = NULL;
+static int kw_found_size = 0;
+
+#define KW_SEPARATOR(c)  ((c) == ' ' || (c) == '\t')
+
+/* The key for the word starting at str, or 0 if it is shorter than
+ * KW_PREFIX letters. */
+static unsigned int kw_key(const char *str)
+{
+  unsigned int key = 0;
+  int i;
+
+  for (i = 0; i < KW_PREFIX; i++) {
+    if (!str[i] || KW_SEPARATOR(str[i]))
+      return 0;
+    key = (key << 8) | (unsigned char) LOWER(str[i]);
+  }
+  return key;
+}
+
+static int kw_bucket(unsigned int key)
+{
+  return (int) ((key * 2654435761U) % KW_BUCKETS);
+}
+
+/* Drop all of a thing's entries. Returns the order they were filed with, or
+ * 0 if the thing was not indexed. */
+static unsigned long kw_remove(int table, struct kw_entry **chain)
+{
+  struct kw_entry *entry, *next;
+  unsigned long order = 0;
+
+  for (entry = *chain; entry; entry = next) {
+    next = entry->next_of_thing;
+    order = entry->order;
+
+    if (entry->key) {
+      if (entry->prev)
+        entry->prev->next = entry->next;
+      else
+        kw_table[table][kw_bucket(entry->key)] = entry->next;
+      if (entry->next)
+        entry->next->prev = entry->prev;
+    }
+
+    free(entry);
+  }
+  *chain = NULL;
+
+  return order;
+}
+
+static void kw_add(int table, struct kw_entry **chain, void *thing,
+                   const char *namelist, unsigned long order)
+{
+  struct kw_entry *entry;
+  unsigned int key;
+  int bucket;
+
+  while (namelist && *namelist) {
+    while (KW_SEPARATOR(*namelist))
+      namelist++;
+    if (!*namelist)
+      break;
+
+    if ((key = kw_key(namelist)) != 0) {
+      /* "guard guardian" needs only one "gua" entry. */
+      for (entry = *chain; entry; entry = entry->next_of_thing)
+        if (entry->key == key)
+          break;
+
+      if (!entry) {
+        CREATE(entry, struct kw_entry, 1);
+        entry->key = key;
+        entry->order = order;
+        entry->thing = thing;
+
+        bucket = kw_bucket(key);
+        entry->prev = NULL;
+        if ((entry->next = kw_table[table][bucket]) != NULL)
+          entry->next->prev = entry;
+        kw_table[table][bucket] = entry;
+
+        entry->next_of_thing = *chain;
+        *chain = entry;
+      }
+    }
+
+    while (*namelist && !KW_SEPARATOR(*namelist))
+      namelist++;
+  }
+
+  if (!*chain) {
+    CREATE(entry, struct kw_entry, 1);
+    entry->order = order;
+    entry->thing = thing;
+    *chain = entry;
+  }
+}
+
+/* (Re)file a thing under its current namelist, keeping its place in the
+ * list order if it was already indexed. */
+static void kw_index(int table, struct kw_entry **chain, void *thing,
+                     const char *namelist)
+{
+  unsigned long order = kw_remove(table, chain);
+
+  if (!order)
+    order = ++kw_order;
+
+  kw_add(table, chain, thing, namelist, order);
+}
+
+/** Call when a character enters character_list. */
+void kw_index_char(struct char_data *ch)
+{
+  kw_index(KW_CHARS, &ch->keywords, ch, ch->player.name);
+}
+
+/** Call after changing a character's namelist. Does nothing for characters
+ * that are not in the game, such as a player loaded to be edited offline. */
+void kw_reindex_char(struct char_data *ch)
+{
+  if (ch->keywords)
+    kw_index(KW_CHARS, &ch->keywords, ch, ch->player.name);
+}
+
+/** Call when a character leaves character_list. */
+void kw_unindex_char(struct char_data *ch)
+{
+  kw_remove(KW_CHARS, &ch->keywords);
+}
+
+/** Call when an object enters object_list. */
+void kw_index_obj(struct obj_data *obj)
+{
+  kw_index(KW_OBJS, &obj->keywords, obj, obj->name);
+}
+
+/** Call after changing an object's namelist. */
+void kw_reindex_obj(struct obj_data *obj)
+{
+  if (obj->keywords)
+    kw_index(KW_OBJS, &obj->keywords, obj, obj->name);
+}
+
+/** Call when an object leaves object_list. */
+void kw_unindex_obj(struct obj_data *obj)
+{
+  kw_remove(KW_OBJS, &obj->keywords);
+}
+
+static int kw_newest_first(const void *a, const void *b)
+{
+  const struct kw_entry *ea = *(struct kw_entry * const *) a;
+  const struct kw_entry *eb = *(struct kw_entry * const *) b;
+
+  return (ea->order < eb->order) - (ea->order > eb->order);
+}
+
+/** Candidates for isname(name, ...) among everything in one index, newest
+ * first. Returns NULL when name is too short for the index, in which case
+ * the caller has to walk the whole list. The array is only good until the
+ * next call. */
+void **kw_lookup(int table, const char *name, int *count)
+{
+  struct kw_entry *entry;
+  unsigned int key;
+  int i, n = 0;
+
+  *count = 0;
+  if (!name || !(key = kw_key(name)))
+    return NULL;
+
+  if (!kw_found_size) {
+    kw_found_size = 64;
+    CREATE(kw_found, void *, kw_found_size);
+    CREATE(kw_sort, struct kw_entry *, kw_found_size);
+  }
+
+  for (entry = kw_table[table][kw_bucket(key)]; entry; entry = entry->next) {
+    if (entry->key != key)
+      continue;
+    if (n == kw_found_size) {
+      kw_found_size *= 2;
+      RECREATE(kw_found, void *, kw_found_size);
+      RECREATE(kw_sort, struct kw_entry *, kw_found_size);
+    }
+    kw_sort[n++] = entry;
+  }
+
+  if (n > 1)
+    qsort(kw_sort, n, sizeof(*kw_sort), kw_newest_first);
+  for (i = 0; i < n; i++)
+    kw_found[i] = kw_sort[i]->thing;
+
+  *count = n;
+  return kw_found;
+}
@@ -0,0 +1,38 @@
+/**
+* @file kwindex.h
+* Keyword index for world-wide character and object lookups.
+*
+* Part of the core tbaMUD source code distribution, which is a derivative
+* of, and continuation of, CircleMUD.
+*/
+
+#ifndef _KWINDEX_H_
+#define _KWINDEX_H_
+
+/** Keywords are filed under their first KW_PREFIX letters, so a name shorter
+ * than that cannot be looked up and the caller walks the full list instead. */
+#define KW_PREFIX   3
+#define KW_BUCKETS  4096
+
+/* Which index kw_lookup() searches. */
+#define KW_CHARS    0
+#define KW_OBJS     1
+
+/* Walk what kw_lookup() found, or the whole list when it returned NULL:
+ *   for (i = KW_FIRST(found, n, list); i; i = KW_NEXT(found, n, k, i, next)) */
+#define KW_FIRST(found, n, list) \
+  ((found) ? ((n) ? (found)[0] : NULL) : (list))
+#define KW_NEXT(found, n, k, cur, link) \
+  ((found) ? (++(k) < (n) ? (found)[k] : NULL) : (cur)->link)
+
+struct kw_entry;
+
+void kw_index_char(struct char_data *ch);
+void kw_reindex_char(struct char_data *ch);
+void kw_unindex_char(struct char_data *ch);
+void kw_index_obj(struct obj_data *obj);
+void kw_reindex_obj(struct obj_data *obj);
+void kw_unindex_obj(struct obj_data *obj);
+void **kw_lookup(int table, const char *name, int *count);
+
+#endif /* _KWINDEX_H_ */
@@ -23,6 +23,7 @@
 #include "fight.h"
 #include "screen.h"
 #include "mud_event.h"
+#include "journal.h"
 
 /* local file scope function prototypes */
 static int graf(int grafage, int p0, int p1, int p2, int p3, int p4, int p5, int p6);
@@ -215,6 +216,7 @@ void set_title(struct char_data *ch, char *title)
 
     GET_TITLE(ch) = strdup(title);
   }
+  SET_SAVE_DIRTY(ch, SAVE_STATS);
 }
 
 void run_autowiz(void)
@@ -258,6 +260,8 @@ void gain_exp(struct char_data *ch, int gain)
     return;
   }
 
+  SET_SAVE_DIRTY(ch, SAVE_STATS);
+
   if (gain > 0) {
     /* Save original gain for debugging */
     int base_gain = gain;
@@ -376,6 +380,8 @@ void gain_exp(struct char_data *ch, int gain)
       GET_EXP(ch) = 0;
   }
 
+  journal_points(ch);
+
   if (GET_LEVEL(ch) >= LVL_IMMORT && !PLR_FLAGGED(ch, PLR_NOWIZLIST))
     run_autowiz();
 }
@@ -391,6 +397,8 @@ void gain_exp_regardless(struct char_data *ch, int gain)
   /* Save original gain for debugging */
   int base_gain = gain;
 
+  SET_SAVE_DIRTY(ch, SAVE_STATS);
+
   /* Apply Happy Hour bonus if active */
   if ((IS_HAPPYHOUR) && (IS_HAPPYEXP))
     gain += (int)((float)base_gain * ((float)HAPPY_EXP / (float)(100)));
@@ -464,6 +472,8 @@ void gain_exp_regardless(struct char_data *ch, int gain)
     GET_EXP(ch) = 0;
 
   if (!IS_NPC(ch)) {
+    journal_points(ch);
+
     while (GET_LEVEL(ch) < LVL_IMPL &&
            GET_EXP(ch) >= level_exp(GET_CLASS(ch), GET_LEVEL(ch) + 1)) {
       GET_LEVEL(ch) += 1;
@@ -515,17 +525,22 @@ void gain_exp_regardless(struct char_data *ch, int gain)
 void gain_condition(struct char_data *ch, int condition, int value)
 {
   bool intoxicated;
+  int old;
 
   if (IS_NPC(ch) || GET_COND(ch, condition) == -1)	/* No change */
     return;
 
   intoxicated = (GET_COND(ch, DRUNK) > 0);
+  old = GET_COND(ch, condition);
 
   GET_COND(ch, condition) += value;
 
   GET_COND(ch, condition) = MAX(0, GET_COND(ch, condition));
   GET_COND(ch, condition) = MIN(24, GET_COND(ch, condition));
 
+  if (GET_COND(ch, condition) != old)
+    SET_SAVE_DIRTY(ch, SAVE_STATS);
+
   if (GET_COND(ch, condition) || PLR_FLAGGED(ch, PLR_WRITING))
     return;
 
@@ -696,6 +711,10 @@ int increase_gold(struct char_data *ch, int amt)
     /* Validate to prevent overflow */
     if (GET_GOLD(ch) < curr_gold) GET_GOLD(ch) = MAX_GOLD;
   }
+  if (GET_GOLD(ch) != curr_gold) {
+    SET_SAVE_DIRTY(ch, SAVE_STATS);
+    journal_points(ch);
+  }
   if (GET_GOLD(ch) == MAX_GOLD)
     send_to_char(ch, "%sYou have reached the maximum gold!\r\n%sYou must spend it or bank it before you can gain any more.\r\n", QBRED, QNRM);
 
@@ -727,6 +746,10 @@ int increase_bank(struct char_data *ch, int amt)
     /* Validate to prevent overflow */
     if (GET_BANK_GOLD(ch) < curr_bank) GET_BANK_GOLD(ch) = MAX_BANK;
   }
+  if (GET_BANK_GOLD(ch) != curr_bank) {
+    SET_SAVE_DIRTY(ch, SAVE_STATS);
+    journal_points(ch);
+  }
   if (GET_BANK_GOLD(ch) == MAX_BANK)
     send_to_char(ch, "%sYou have reached the maximum bank balance!\r\n%sYou cannot put more into your account unless you withdraw some first.\r\n", QBRED, QNRM);
   return (GET_BANK_GOLD(ch));
@@ -20,6 +20,8 @@
 #include "mail.h"
 #include "modify.h"
 #include "itemmail.h"
+#include "kwindex.h"
+#include "savequeue.h"
 
 /* local (file scope) function prototypes */
 static void postmaster_send_mail(struct char_data *ch, struct char_data *mailman, int cmd, char *arg);
@@ -28,7 +30,18 @@ static void postmaster_receive_mail(struct char_data *ch, struct char_data *mail
 static int mail_recip_ok(const char *name);
 static void write_mail_record(FILE *mail_file, struct mail_t *record);
 static void free_mail_record(struct mail_t *record);
-static struct mail_t *read_mail_record(FILE *mail_file);
+static struct mail_t *read_mail_record(FILE *mail_file, long *pos, int *deleted);
+static mail_index_type *mail_find(long recipient, int create);
+static void mail_index_add(long recipient, long position);
+static void mail_index_free(void);
+static void mail_compact(void);
+
+/* Where each recipient's letters start in the mail file, oldest first. The
+ * file is only ever appended to: a letter that has been read keeps its place
+ * with its header marked deleted, until mail_pulse() rewrites the file
+ * without the dead letters. */
+static mail_index_type *mail_index[MAIL_INDEX_BUCKETS];
+static int mail_live, mail_dead;
 
 static int mail_recip_ok(const char *name)
 {
@@ -48,21 +61,35 @@ static void free_mail_record(struct mail_t *record)
   free(record);
 }
 
-static struct mail_t *read_mail_record(FILE *mail_file)
+/* Read the next letter in mail_file, dead or alive. If pos is given it is set
+ * to where the letter's header starts, and deleted to whether it was read. */
+static struct mail_t *read_mail_record(FILE *mail_file, long *pos, int *deleted)
 {
-  char line[READ_SIZE];
+  char line[READ_SIZE], mark;
   long sender, recipient;
   time_t sent_time;
   struct mail_t *record;
+  int c;
+
+  while ((c = getc(mail_file)) != EOF && isspace(c))
+    ;
+  if (c == EOF)
+    return NULL;
+  ungetc(c, mail_file);
+  if (pos)
+    *pos = ftell(mail_file);
 
   if (!get_line(mail_file, line))
   	return NULL;
 
-  if (sscanf(line, "### %ld %ld %ld", &recipient, &sender, (long *)&sent_time) != 3) {
+  if (sscanf(line, "#%c# %ld %ld %ld", &mark, &recipient, &sender, (long *)&sent_time) != 4 ||
+      (mark != '#' && mark != MAIL_DELETED_MARK)) {
   	log("Mail system - fatal error - malformed mail header");
   	log("Line was: %s", line);
   	return NULL;
   }
+  if (deleted)
+    *deleted = (mark == MAIL_DELETED_MARK);
 
   CREATE(record, struct mail_t, 1);
 
@@ -84,6 +111,59 @@ static void write_mail_record(FILE *mail_file, struct mail_t *record)
                      record->body );
 }
 
+static mail_index_type *mail_find(long recipient, int create)
+{
+  mail_index_type *entry, **bucket;
+
+  bucket = &mail_index[((unsigned long) recipient * 2654435761UL) % MAIL_INDEX_BUCKETS];
+  for (entry = *bucket; entry; entry = entry->next)
+    if (entry->recipient == recipient)
+      return (entry);
+
+  if (!create)
+    return (NULL);
+
+  CREATE(entry, mail_index_type, 1);
+  entry->recipient = recipient;
+  entry->next = *bucket;
+  *bucket = entry;
+  return (entry);
+}
+
+/* File a letter at position under its recipient, after any they already have. */
+static void mail_index_add(long recipient, long position)
+{
+  mail_index_type *entry = mail_find(recipient, TRUE);
+  position_list_type *pos, **tail;
+
+  for (tail = &entry->list_start; *tail; tail = &(*tail)->next)
+    ;
+  CREATE(pos, position_list_type, 1);
+  pos->position = position;
+  *tail = pos;
+  mail_live++;
+}
+
+static void mail_index_free(void)
+{
+  mail_index_type *entry, *next_entry;
+  position_list_type *pos, *next_pos;
+  int i;
+
+  for (i = 0; i < MAIL_INDEX_BUCKETS; i++) {
+    for (entry = mail_index[i]; entry; entry = next_entry) {
+      next_entry = entry->next;
+      for (pos = entry->list_start; pos; pos = next_pos) {
+        next_pos = pos->next;
+        free(pos);
+      }
+      free(entry);
+    }
+    mail_index[i] = NULL;
+  }
+  mail_live = mail_dead = 0;
+}
+
 /* int scan_file(none)
  * Returns false if mail file is corrupted or true if everything correct.
  *
@@ -92,8 +172,11 @@ static void write_mail_record(FILE *mail_file, struct mail_t *record)
 int scan_file(void)
 {
   FILE *mail_file;
-  int count = 0;
   struct mail_t *record;
+  long pos;
+  int deleted;
+
+  mail_index_free();
 
   if (!(mail_file = fopen(MAIL_FILE, "r"))) {
     log("   Mail file non-existant... creating new file.");
@@ -101,16 +184,16 @@ int scan_file(void)
     return TRUE;
   }
 
-  record = read_mail_record(mail_file);
-
-  while (record) {
+  while ((record = read_mail_record(mail_file, &pos, &deleted))) {
+    if (deleted)
+      mail_dead++;
+    else
+      mail_index_add(record->recipient, pos);
     free_mail_record(record);
-    record = read_mail_record(mail_file);
-    count++;
   }
 
   fclose(mail_file);
- 	log("   Mail file read -- %d messages.", count);
+ 	log("   Mail file read -- %d messages, %d read and awaiting removal.", mail_live, mail_dead);
  	return TRUE;
 }
 
@@ -121,27 +204,9 @@ int scan_file(void)
  * A simple little function which tells you if the player has mail or not. */
 int has_mail(long recipient)
 {
-  FILE *mail_file;
-  struct mail_t *record;
-
-  if (!(mail_file = fopen(MAIL_FILE, "r"))) {
-    perror("read_delete: Mail file not accessible.");
-    return FALSE;
-  }
-
-  record = read_mail_record(mail_file);
+  mail_index_type *entry = mail_find(recipient, FALSE);
 
-  while (record) {
-  	if (record->recipient == recipient) {
-  		free_mail_record(record);
-  		fclose(mail_file);
-  		return TRUE;
-    }
-    free_mail_record(record);
-    record = read_mail_record(mail_file);
-  }
-  fclose(mail_file);
-  return FALSE;
+  return (entry && entry->list_start);
 }
 
 /* void store_mail(long #1, long #2, char * #3)
@@ -156,11 +221,16 @@ void store_mail(long to, long from, char *message_pointer)
 {
   FILE *mail_file;
   struct mail_t *record;
+  long pos;
 
+  saveq_wait(MAIL_FILE);
   if (!(mail_file = fopen(MAIL_FILE, "a"))) {
     perror("store_mail: Mail file not accessible.");
     return;
   }
+  fseek(mail_file, 0, SEEK_END);
+  pos = ftell(mail_file);
+
   CREATE(record, struct mail_t, 1);
 
   record->recipient = to;
@@ -170,77 +240,128 @@ void store_mail(long to, long from, char *message_pointer)
 
   write_mail_record(mail_file, record);
   free(record); /* don't free the body */
-  fclose(mail_file);
+  if (fclose(mail_file) == 0)
+    mail_index_add(to, pos);
+  else
+    perror("store_mail: Writing mail file");
 }
 
 /* char *read_delete(long #1)
  * #1 - The id number of the person we're checking mail for.
  * Returns the message text of the mail received.
  *
- * Retrieves one messsage for a player. The mail is then discarded from
+ * Retrieves one messsage for a player. The mail is then marked deleted in
  * the file. Expects mail to exist. */
 char *read_delete(long recipient)
 {
-  FILE *mail_file, *new_file;
-  struct mail_t *record, *record_to_keep = NULL;
-  char buf[MAX_STRING_LENGTH];
+  FILE *mail_file;
+  mail_index_type *entry;
+  position_list_type *first;
+  struct mail_t *record;
+  char buf[MAX_STRING_LENGTH], timestr[25], *from, *to;
+  long pos;
+  int deleted;
 
-  if (!(mail_file = fopen(MAIL_FILE, "r"))) {
+  if (!(entry = mail_find(recipient, FALSE)) || !(first = entry->list_start))
+    return strdup("Mail system error - please report");
+
+  saveq_wait(MAIL_FILE);
+  if (!(mail_file = fopen(MAIL_FILE, "r+"))) {
     perror("read_delete: Mail file not accessible.");
     return strdup("Mail system malfunction - please report this");
   }
 
-  if (!(new_file = fopen(MAIL_FILE_TMP, "w"))) {
-    perror("read_delete: new Mail file not accessible.");
+  fseek(mail_file, first->position, SEEK_SET);
+  record = read_mail_record(mail_file, &pos, &deleted);
+  if (!record || deleted || record->recipient != recipient || pos != first->position) {
+    log("SYSERR: Mail index out of step with %s at %ld; reindexing.", MAIL_FILE, first->position);
+    if (record)
+      free_mail_record(record);
     fclose(mail_file);
-    return strdup("Mail system malfunction - please report this");
+    scan_file();
+    return strdup("Mail system error - please report");
   }
 
-  record = read_mail_record(mail_file);
+  /* Mark the header "#-#" in place of "###". */
+  fseek(mail_file, pos + 1, SEEK_SET);
+  fputc(MAIL_DELETED_MARK, mail_file);
+  fclose(mail_file);
 
-  while (record) {
-  	if (!record_to_keep && record->recipient == recipient) {
-  		record_to_keep = record;
-  		record = read_mail_record(mail_file);
-  		continue; /* don't write and free this one just yet */
-    }
-    write_mail_record(new_file, record);
-    free_mail_record(record);
-    record = read_mail_record(mail_file);
-  }
+  entry->list_start = first->next;
+  free(first);
+  mail_live--;
+  mail_dead++;
+
+  strftime(timestr, sizeof(timestr), "%c", localtime(&(record->sent_time)));
 
-  if (!record_to_keep)
-  	sprintf(buf, "Mail system error - please report");
-  else {
-    char timestr[25], *from, *to;
+  from = get_name_by_id(record->sender);
+  to = get_name_by_id(record->recipient);
 
-    strftime(timestr, sizeof(timestr), "%c", localtime(&(record_to_keep->sent_time)));
+  snprintf(buf, sizeof(buf),
+           " * * * * tbaMUD Mail System * * * *\r\n"
+           "Date: %s\r\n"
+           "To  : %s\r\n"
+           "From: %s\r\n"
+           "\r\n"
+           "%s",
 
-    from = get_name_by_id(record_to_keep->sender);
-    to = get_name_by_id(record_to_keep->recipient);
+           timestr,
+           to ? to : "Unknown",
+           from ? from : "Unknown",
+           record->body ? record->body : "No message" );
 
- 		snprintf(buf, sizeof(buf),
-             " * * * * tbaMUD Mail System * * * *\r\n"
-             "Date: %s\r\n"
-             "To  : %s\r\n"
-             "From: %s\r\n"
-             "\r\n"
-             "%s",
+  free_mail_record(record);
+
+  return strdup(buf);
+}
 
-             timestr,
-             to ? to : "Unknown",
-             from ? from : "Unknown",
-             record_to_keep->body ? record_to_keep->body : "No message" );
+/* Rewrite the mail file with only the letters not yet read, and index it
+ * afresh. The new file goes out through the save queue. */
+static void mail_compact(void)
+{
+  FILE *mail_file, *new_file;
+  struct mail_t *record;
+  long pos;
+  int deleted, dropped;
 
-    free_mail_record(record_to_keep);
+  saveq_wait(MAIL_FILE);
+  if (!(mail_file = fopen(MAIL_FILE, "r"))) {
+    perror("mail_compact: Mail file not accessible.");
+    return;
+  }
+  if (!(new_file = saveq_open(MAIL_FILE))) {
+    perror("mail_compact: new Mail file not accessible.");
+    fclose(mail_file);
+    return;
+  }
+
+  dropped = mail_dead;
+  mail_index_free();
+  while ((record = read_mail_record(mail_file, NULL, &deleted))) {
+    if (!deleted) {
+      pos = ftell(new_file);
+      write_mail_record(new_file, record);
+      mail_index_add(record->recipient, pos);
+    }
+    free_mail_record(record);
   }
   fclose(mail_file);
-  fclose(new_file);
 
-  remove(MAIL_FILE);
-  rename(MAIL_FILE_TMP, MAIL_FILE);
+  if (!saveq_commit(new_file)) {
+    /* The old file is still there; its dead letters wait for another try. */
+    scan_file();
+    return;
+  }
+  log("Mail file compacted: %d read letters removed, %d kept.", dropped, mail_live);
+}
 
-  return strdup(buf);
+/* Compact the mail file once enough of it is letters that have been read. */
+void mail_pulse(void)
+{
+  if (no_mail || mail_dead < MAIL_COMPACT_MIN)
+    return;
+  if (mail_dead * 100 >= (mail_live + mail_dead) * MAIL_COMPACT_PERCENT)
+    mail_compact();
 }
 
 /* spec_proc for a postmaster using the above routines.  By Jeremy Elson */
@@ -351,6 +472,7 @@ static void postmaster_receive_mail(struct char_data *ch, struct char_data *mail
     obj = create_obj(); 
     obj->item_number = 1; 
     obj->name = strdup("mail paper letter");
+    kw_reindex_obj(obj);
     obj->short_description = strdup("a piece of mail");
     obj->description = strdup("Someone has left a piece of mail here.");
 
@@ -27,6 +27,16 @@
 /* size of mail file allocation blocks		*/
 #define BLOCK_SIZE 100
 
+/* Buckets in the in-memory index of who has mail */
+#define MAIL_INDEX_BUCKETS 256
+
+/* Read letters stay in the mail file, their header marked with this in place
+ * of its second '#', until the file is compacted. That happens once there
+ * are MAIL_COMPACT_MIN of them making up MAIL_COMPACT_PERCENT of the file. */
+#define MAIL_DELETED_MARK   '-'
+#define MAIL_COMPACT_MIN     20
+#define MAIL_COMPACT_PERCENT 50
+
 /* General, publicly available functions */
 SPECIAL(postmaster);
 
@@ -42,6 +52,7 @@ int	has_mail(long recipient);
 void	store_mail(long to, long from, char *message_pointer);
 char	*read_delete(long recipient);
 void    notify_if_playing(struct char_data *from, int recipient_id);
+void	mail_pulse(void);
 
 struct mail_t {
 	long recipient;
@@ -50,6 +61,23 @@ struct mail_t {
 	char *body;
 };
 
+/* Offset in the mail file of a letter's header. */
+struct position_list_type_d {
+   long	position;
+   struct position_list_type_d *next;
+};
+
+typedef struct position_list_type_d position_list_type;
+
+/* The letters waiting for one player, oldest first. */
+struct mail_index_type_d {
+   long recipient;			/* who is this mail for?	*/
+   position_list_type *list_start;	/* list of mail positions	*/
+   struct mail_index_type_d *next;	/* link to next one		*/
+};
+
+typedef struct mail_index_type_d mail_index_type;
+
 /* old stuff below */
 #define HEADER_BLOCK  (-1)
 #define LAST_BLOCK    (-2)
@@ -90,19 +118,4 @@ struct data_block_type_d {
 typedef struct header_block_type_d header_block_type;
 typedef struct data_block_type_d data_block_type;
 
-struct position_list_type_d {
-   long	position;
-   struct position_list_type_d *next;
-};
-
-typedef struct position_list_type_d position_list_type;
-
-struct mail_index_type_d {
-   long recipient;			/* who is this mail for?	*/
-   position_list_type *list_start;	/* list of mail positions	*/
-   struct mail_index_type_d *next;	/* link to next one		*/
-};
-
-typedef struct mail_index_type_d mail_index_type;
-
 #endif /* _MAIL_H_ */
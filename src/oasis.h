@@ -377,6 +377,9 @@ extern const char *nrm, *grn, *cyn, *yel;
 #define CEDIT_MAP_SIZE     55
 #define CEDIT_MINIMAP_SIZE   56
 #define CEDIT_DEBUG_MODE     57
+#define CEDIT_SCRIPT_PULSE_LINES 58
+#define CEDIT_SCRIPT_PULSE_MSEC  59
+#define CEDIT_LAZY_ZONE_IDLE     60
 
 /* Hedit Submodes of connectedness. */
 #define HEDIT_CONFIRM_SAVESTRING        0
@@ -197,10 +197,8 @@ ACMD(do_dig)
   if (rvnum == NOTHING) {
     if (W_EXIT(IN_ROOM(ch), dir)) {
       /* free the old pointers, if any */
-      if (W_EXIT(IN_ROOM(ch), dir)->general_description)
-        free(W_EXIT(IN_ROOM(ch), dir)->general_description);
-      if (W_EXIT(IN_ROOM(ch), dir)->keyword)
-        free(W_EXIT(IN_ROOM(ch), dir)->keyword);
+      free_world_string(W_EXIT(IN_ROOM(ch), dir)->general_description);
+      free_world_string(W_EXIT(IN_ROOM(ch), dir)->keyword);
       free(W_EXIT(IN_ROOM(ch), dir));
       W_EXIT(IN_ROOM(ch), dir) = NULL;
       add_to_save_list(zone_table[world[IN_ROOM(ch)].zone].number, SL_WLD);
@@ -291,21 +289,12 @@ ACMD(do_dig)
 /* For buildwalk. Finds the next free vnum in the zone */
 static room_vnum redit_find_new_vnum(zone_rnum zone)
 {
-  room_vnum vnum = genolc_zone_bottom(zone);
-  room_rnum rnum = real_room(vnum);
-
-  if (rnum == NOWHERE)
-    return vnum;
+  room_vnum vnum;
 
-  for(;;) {
-    if (vnum > zone_table[zone].top)
-      return(NOWHERE);
-    if (rnum > top_of_world || world[rnum].number > vnum)
-      break;
-    rnum++;
-    vnum++;
-  }
-  return(vnum);
+  for (vnum = genolc_zone_bottom(zone); vnum <= zone_table[zone].top; vnum++)
+    if (real_room(vnum) == NOWHERE)
+      return(vnum);
+  return(NOWHERE);
 }
 
 int buildwalk(struct char_data *ch, int dir)
@@ -32,11 +32,8 @@ int free_strings(void *data, int type)
       room = (struct room_data *) data;
 
       /* Free Descriptions */
-      if (room->name)
-        free(room->name);
-
-      if (room->description)
-        free(room->description);
+      free_world_string(room->name);
+      free_world_string(room->description);
 
       if (room->ex_description)
         free_ex_descriptions(room->ex_description);
@@ -49,14 +46,10 @@ int free_strings(void *data, int type)
 
       for (i = 0; i < NUM_OF_DIRS; i++) { /* NUM_OF_DIRS, not DIR_COUNT */
         if (room->dir_option[i]) {
-          if (room->dir_option[i]->general_description) {
-            free(room->dir_option[i]->general_description);
-            room->dir_option[i]->general_description = NULL;
-          }
-          if (room->dir_option[i]->keyword) {
-            free(room->dir_option[i]->keyword);
-            room->dir_option[i]->keyword = NULL;
-          }
+          free_world_string(room->dir_option[i]->general_description);
+          room->dir_option[i]->general_description = NULL;
+          free_world_string(room->dir_option[i]->keyword);
+          room->dir_option[i]->keyword = NULL;
           free(room->dir_option[i]);
           room->dir_option[i] = NULL;
         }
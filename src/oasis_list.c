@@ -505,7 +505,7 @@ ACMD(do_oasis_links)
   zone_vnum zvnum;
   room_rnum nr, to_room;
   room_vnum first, last;
-  int j;
+  int vnum, j;
   char arg[MAX_INPUT_LENGTH];
 
   skip_spaces(&argument);
@@ -534,8 +534,8 @@ ACMD(do_oasis_links)
   first = zone_table[zrnum].bot;
 
   send_to_char(ch, "Zone %d is linked to the following zones:\r\n", zvnum);
-  for (nr = 0; nr <= top_of_world && (GET_ROOM_VNUM(nr) <= last); nr++) {
-    if (GET_ROOM_VNUM(nr) >= first) {
+  for (vnum = first; vnum <= last; vnum++) {
+    if ((nr = real_room(vnum)) != NOWHERE) {
       for (j = 0; j < DIR_COUNT; j++) {
 	if (world[nr].dir_option[j]) {
 	  to_room = world[nr].dir_option[j]->to_room;
@@ -556,7 +556,7 @@ static void list_rooms(struct char_data *ch, zone_rnum rnum, room_vnum vmin, roo
 {
   room_rnum i;
   room_vnum bottom, top;
-  int j, counter = 0;
+  int vnum, j, counter = 0;
   size_t len;
   char buf[MAX_STRING_LENGTH];
 
@@ -577,10 +577,11 @@ static void list_rooms(struct char_data *ch, zone_rnum rnum, room_vnum vmin, roo
   if (!top_of_world)
     return;
 
-  for (i = 0; i <= top_of_world; i++) {
+  /* Walk the range in vnum order; new rooms are not sorted in world[]. */
+  for (vnum = bottom; vnum <= top; vnum++) {
 
     /** Check to see if this room is one of the ones needed to be listed.    **/
-    if ((world[i].number >= bottom) && (world[i].number <= top)) {
+    if ((i = real_room(vnum)) != NOWHERE) {
       counter++;
 
       len += snprintf(buf + len, sizeof(buf) - len, "%4d) [%s%-5d%s] %s%-*s%s %s",
@@ -22,6 +22,10 @@
 #include "config.h"
 #include "modify.h"
 #include "genolc.h" /* for strip_cr and sprintascii */
+#include "kwindex.h"
+#include "savequeue.h"
+#include "journal.h"
+#include "binfile.h"
 
 /* these factors should be unique integers */
 #define RENT_FACTOR    1
@@ -30,6 +34,17 @@
 #define LOC_INVENTORY  0
 #define MAX_BAG_ROWS   5
 
+/* What the first line of a rent file, or the first record of a binary one,
+ * says about it. */
+struct rent_header {
+  int rentcode;
+  long timed;
+  int netcost;
+  long gold;
+  long account;
+  int nitems;
+};
+
 /* local functions */
 static int Crash_save(struct obj_data *obj, FILE *fp, int location);
 static void Crash_extract_norent_eq(struct char_data *ch);
@@ -46,9 +61,186 @@ static void Crash_extract_norents(struct obj_data *obj);
 static void Crash_extract_expensive(struct obj_data *obj);
 static void Crash_calculate_rent(struct obj_data *obj, int *cost);
 static void Crash_cryosave(struct char_data *ch, int cost);
+static void Crash_rent_done(struct char_data *ch);
 static int Crash_load_objs(struct char_data *ch);
 static int handle_obj(struct obj_data *obj, struct char_data *ch, int locate, struct obj_data **cont_rows);
 static int objsave_write_rentcode(FILE *fl, int rentcode, int cost_per_day, struct char_data *ch);
+static int objsave_read_rentcode(FILE *fl, struct rent_header *rent);
+static int objsave_binary_records(FILE *fl);
+static obj_save_data *objsave_parse_binary(FILE *fl);
+static int objsave_save_obj_binary(struct obj_data *obj, FILE *fp, int locate);
+
+/* Binary object files. A file is OBJ_BIN_MAGIC and a 2 byte version, then
+ * records of a 1 byte OBJREC_ type, a 4 byte length and that many bytes,
+ * ending with OBJREC_END or the end of the file. Rent and crash files start
+ * with an OBJREC_RENT record; house files have none. An object record is the
+ * prototype vnum, the location as in ASCII files (negative for container
+ * depth), the UID and generation, then only the fields that differ from the
+ * prototype, each a 1 byte OBF_ id and its value, up to OBF_END. Integers
+ * are little endian and strings have a 4 byte length; see binfile.c. */
+#define OBJ_BIN_MAGIC      "TBOF"
+#define OBJ_BIN_MAGIC_LEN  4
+#define OBJ_BIN_VERSION    1
+
+#define OBJREC_RENT  1  /* 4 rent code, 8 time, 4 cost/day, 8 gold, 8 bank, 4 items */
+#define OBJREC_OBJ   2
+#define OBJREC_END   3
+
+#define OBF_END      0
+#define OBF_VALS     1  /* 1 byte count, 4 each */
+#define OBF_EXTRA    2  /* EF_ARRAY_MAX x 4 */
+#define OBF_PERM     3  /* AF_ARRAY_MAX x 4 */
+#define OBF_WEAR     4  /* TW_ARRAY_MAX x 4 */
+#define OBF_NAME     5
+#define OBF_SHORT    6
+#define OBF_DESC     7
+#define OBF_ADESC    8
+#define OBF_TYPE     9  /* 1 */
+#define OBF_WEIGHT  10  /* 4 */
+#define OBF_COST    11  /* 4 */
+#define OBF_RENT    12  /* 4 */
+#define OBF_AFF     13  /* 1 slot, 1 location, 2 modifier */
+#define OBF_EDESCS  14  /* 2 byte count, then keyword and description each */
+
+/* The buffer binary object records are built and read in. */
+static struct bin_buf obj_bin;
+
+/* Start a record of the given type; objsave_bin_end() fills in its length. */
+static size_t objsave_bin_begin(int type)
+{
+  size_t start;
+
+  bin_put(&obj_bin, type, 1);
+  start = obj_bin.len;
+  bin_put(&obj_bin, 0, 4);
+  return (start);
+}
+
+static void objsave_bin_end(size_t start)
+{
+  bin_patch(&obj_bin, start, obj_bin.len - start - 4, 4);
+}
+
+static void objsave_bin_flags(int field, const int *flags, const int *proto, int count)
+{
+  int i;
+
+  if (!memcmp(flags, proto, count * sizeof(int)))
+    return;
+  bin_put(&obj_bin, field, 1);
+  for (i = 0; i < count; i++)
+    bin_put(&obj_bin, flags[i], 4);
+}
+
+static void objsave_bin_str(int field, const char *str, const char *proto)
+{
+  if (str && proto && !strcmp(str, proto))
+    return;
+  bin_put(&obj_bin, field, 1);
+  bin_put_str(&obj_bin, str ? str : "Undefined", 4);
+}
+
+/* Write the magic that makes fl a binary object file, if object files are
+ * being written in binary. Rent files get it from objsave_write_rentcode(). */
+void objsave_start_file(FILE *fl)
+{
+  if (!CONFIG_BINARY_OBJFILES)
+    return;
+  fwrite(OBJ_BIN_MAGIC, OBJ_BIN_MAGIC_LEN, 1, fl);
+  obj_bin.len = 0;
+  bin_put(&obj_bin, OBJ_BIN_VERSION, 2);
+  fwrite(obj_bin.data, obj_bin.len, 1, fl);
+}
+
+/* Mark the end of the objects in fl. */
+void objsave_end_file(FILE *fl)
+{
+  if (CONFIG_BINARY_OBJFILES)
+    fputc(OBJREC_END, fl);
+  else
+    fprintf(fl, "$~\n");
+}
+
+/* The binary form of objsave_save_obj_record(). This compares obj with its
+ * prototype in place rather than loading a copy to compare with. */
+static int objsave_save_obj_binary(struct obj_data *obj, FILE *fp, int locate)
+{
+  static struct obj_data blank;  /* What a unique object is compared with. */
+  const struct obj_data *proto;
+  struct extra_descr_data *ex_desc;
+  size_t start;
+  int i, count;
+
+  proto = GET_OBJ_RNUM(obj) != NOTHING ? &obj_proto[GET_OBJ_RNUM(obj)] : &blank;
+
+  obj_bin.len = 0;
+  start = objsave_bin_begin(OBJREC_OBJ);
+  bin_put(&obj_bin, GET_OBJ_VNUM(obj), 4);
+  bin_put(&obj_bin, locate, 2);
+  bin_put(&obj_bin, GET_OBJ_UID(obj), 8);
+  bin_put(&obj_bin, GET_OBJ_GENERATION(obj), 8);
+
+  if (memcmp(obj->obj_flags.value, proto->obj_flags.value, sizeof(obj->obj_flags.value))) {
+    bin_put(&obj_bin, OBF_VALS, 1);
+    bin_put(&obj_bin, NUM_OBJ_VAL_POSITIONS, 1);
+    for (i = 0; i < NUM_OBJ_VAL_POSITIONS; i++)
+      bin_put(&obj_bin, GET_OBJ_VAL(obj, i), 4);
+  }
+  objsave_bin_flags(OBF_EXTRA, GET_OBJ_EXTRA(obj), proto->obj_flags.extra_flags, EF_ARRAY_MAX);
+  objsave_bin_flags(OBF_PERM, GET_OBJ_AFFECT(obj), proto->obj_flags.bitvector, AF_ARRAY_MAX);
+  objsave_bin_flags(OBF_WEAR, GET_OBJ_WEAR(obj), proto->obj_flags.wear_flags, TW_ARRAY_MAX);
+
+  objsave_bin_str(OBF_NAME, obj->name, proto->name);
+  objsave_bin_str(OBF_SHORT, obj->short_description, proto->short_description);
+  objsave_bin_str(OBF_DESC, obj->description, proto->description);
+  if (obj->action_description || proto->action_description)
+    objsave_bin_str(OBF_ADESC, obj->action_description ? obj->action_description : "", proto->action_description);
+
+  if (GET_OBJ_TYPE(obj) != proto->obj_flags.type_flag) {
+    bin_put(&obj_bin, OBF_TYPE, 1);
+    bin_put(&obj_bin, GET_OBJ_TYPE(obj), 1);
+  }
+  if (GET_OBJ_WEIGHT(obj) != proto->obj_flags.weight) {
+    bin_put(&obj_bin, OBF_WEIGHT, 1);
+    bin_put(&obj_bin, GET_OBJ_WEIGHT(obj), 4);
+  }
+  if (GET_OBJ_COST(obj) != proto->obj_flags.cost) {
+    bin_put(&obj_bin, OBF_COST, 1);
+    bin_put(&obj_bin, GET_OBJ_COST(obj), 4);
+  }
+  if (GET_OBJ_RENT(obj) != proto->obj_flags.cost_per_day) {
+    bin_put(&obj_bin, OBF_RENT, 1);
+    bin_put(&obj_bin, GET_OBJ_RENT(obj), 4);
+  }
+
+  for (i = 0; i < MAX_OBJ_AFFECT; i++)
+    if (obj->affected[i].location != proto->affected[i].location ||
+        obj->affected[i].modifier != proto->affected[i].modifier) {
+      bin_put(&obj_bin, OBF_AFF, 1);
+      bin_put(&obj_bin, i, 1);
+      bin_put(&obj_bin, obj->affected[i].location, 1);
+      bin_put(&obj_bin, obj->affected[i].modifier, 2);
+    }
+
+  /* The whole list, which may be empty, whenever it is not the prototype's. */
+  if (obj->ex_description != proto->ex_description) {
+    for (count = 0, ex_desc = obj->ex_description; ex_desc; ex_desc = ex_desc->next)
+      if (*ex_desc->keyword && *ex_desc->description)
+        count++;
+    bin_put(&obj_bin, OBF_EDESCS, 1);
+    bin_put(&obj_bin, count, 2);
+    for (ex_desc = obj->ex_description; ex_desc; ex_desc = ex_desc->next)
+      if (*ex_desc->keyword && *ex_desc->description) {
+        bin_put_str(&obj_bin, ex_desc->keyword, 4);
+        bin_put_str(&obj_bin, ex_desc->description, 4);
+      }
+  }
+
+  bin_put(&obj_bin, OBF_END, 1);
+  objsave_bin_end(start);
+
+  return (fwrite(obj_bin.data, obj_bin.len, 1, fp) == 1);
+}
 
 /* Writes one object record to FILE.  Old name: Obj_to_store() */
 int objsave_save_obj_record(struct obj_data *obj, FILE *fp, int locate)
@@ -58,6 +250,9 @@ int objsave_save_obj_record(struct obj_data *obj, FILE *fp, int locate)
   char buf1[MAX_STRING_LENGTH +1];
   struct obj_data *temp = NULL;
 
+  if (CONFIG_BINARY_OBJFILES)
+    return (objsave_save_obj_binary(obj, fp, locate));
+
   if (GET_OBJ_VNUM(obj) != NOTHING)
     temp=read_object(GET_OBJ_VNUM(obj), VIRTUAL);
   else {
@@ -273,6 +468,7 @@ int Crash_delete_file(char *name)
   if (!get_filename(filename, sizeof(filename), CRASH_FILE, name))
     return FALSE;
 
+  saveq_wait(filename);
   if (!(fl = fopen(filename, "r"))) {
     if (errno != ENOENT)  /* if it fails but NOT because of no file */
       log("SYSERR: deleting crash file %s (1): %s", filename, strerror(errno));
@@ -292,25 +488,24 @@ int Crash_delete_crashfile(struct char_data *ch)
   char filename[MAX_INPUT_LENGTH];
   int numread;
   FILE *fl;
-  int rentcode;
-  char line[READ_SIZE];
+  struct rent_header rent;
 
   if (!get_filename(filename, sizeof(filename), CRASH_FILE, GET_NAME(ch)))
     return FALSE;
 
+  saveq_wait(filename);
   if (!(fl = fopen(filename, "r"))) {
     if (errno != ENOENT)  /* if it fails, NOT because of no file */
       log("SYSERR: checking for crash file %s (3): %s", filename, strerror(errno));
     return FALSE;
   }
-  numread = get_line(fl,line);
+  numread = objsave_read_rentcode(fl, &rent);
   fclose(fl);
 
   if (numread == FALSE)
     return FALSE;
-  sscanf(line,"%d ",&rentcode);
 
-  if (rentcode == RENT_CRASH)
+  if (rent.rentcode == RENT_CRASH)
     Crash_delete_file(GET_NAME(ch));
 
   return TRUE;
@@ -321,33 +516,30 @@ int Crash_clean_file(char *name)
   char filename[MAX_INPUT_LENGTH], filetype[20];
   int numread;
   FILE *fl;
-  int rentcode, timed, netcost, gold, account, nitems;
-  char line[READ_SIZE];
+  struct rent_header rent;
 
   if (!get_filename(filename, sizeof(filename), CRASH_FILE, name))
     return FALSE;
 
   /* Open so that permission problems will be flagged now, at boot time. */
+  saveq_wait(filename);
   if (!(fl = fopen(filename, "r"))) {
     if (errno != ENOENT)  /* if it fails, NOT because of no file */
       log("SYSERR: OPENING OBJECT FILE %s (4): %s", filename, strerror(errno));
     return FALSE;
   }
 
-  numread = get_line(fl,line);
+  numread = objsave_read_rentcode(fl, &rent);
   fclose(fl);
   if (numread == FALSE)
     return FALSE;
 
-  sscanf(line, "%d %d %d %d %d %d",&rentcode,&timed,&netcost,
-         &gold,&account,&nitems);
-
-  if ((rentcode == RENT_CRASH) ||
-      (rentcode == RENT_FORCED) ||
-      (rentcode == RENT_TIMEDOUT) ) {
-    if (timed < time(0) - (CONFIG_CRASH_TIMEOUT * SECS_PER_REAL_DAY)) {
+  if ((rent.rentcode == RENT_CRASH) ||
+      (rent.rentcode == RENT_FORCED) ||
+      (rent.rentcode == RENT_TIMEDOUT) ) {
+    if (rent.timed < time(0) - (CONFIG_CRASH_TIMEOUT * SECS_PER_REAL_DAY)) {
       Crash_delete_file(name);
-      switch (rentcode) {
+      switch (rent.rentcode) {
       case RENT_CRASH:
         strcpy(filetype, "crash");
         break;
@@ -365,8 +557,8 @@ int Crash_clean_file(char *name)
       return TRUE;
     }
     /* Must retrieve rented items w/in 30 days */
-  } else if (rentcode == RENT_RENTED)
-    if (timed < time(0) - (CONFIG_RENT_TIMEOUT * SECS_PER_REAL_DAY)) {
+  } else if (rent.rentcode == RENT_RENTED)
+    if (rent.timed < time(0) - (CONFIG_RENT_TIMEOUT * SECS_PER_REAL_DAY)) {
       Crash_delete_file(name);
       log("    Deleting %s's rent file.", name);
       return TRUE;
@@ -386,20 +578,22 @@ void update_obj_file(void)
 void Crash_listrent(struct char_data *ch, char *name)
 {
   FILE *fl;
-  char filename[MAX_INPUT_LENGTH], buf[MAX_STRING_LENGTH], line[READ_SIZE];
+  char filename[MAX_INPUT_LENGTH], buf[MAX_STRING_LENGTH];
   obj_save_data *loaded, *current;
-  int rentcode = RENT_UNDEF, timed, netcost, gold, account, nitems, numread, len;
+  struct rent_header rent;
+  int numread, len;
   
   if (!get_filename(filename, sizeof(filename), CRASH_FILE, name))
     return;
 
+  saveq_wait(filename);
   if (!(fl = fopen(filename, "r"))) {
     send_to_char(ch, "%s has no rent file.\r\n", name);
     return;
   }
   len = snprintf(buf, sizeof(buf),"%s\r\n", filename);
 
-  numread = get_line(fl, line);
+  numread = objsave_read_rentcode(fl, &rent);
 
   /* Oops, can't get the data, punt. */
   if (numread == FALSE) {
@@ -408,10 +602,7 @@ void Crash_listrent(struct char_data *ch, char *name)
     return;
   }
 
-  sscanf(line,"%d %d %d %d %d %d",
-        &rentcode,&timed,&netcost,&gold,&account,&nitems);
-
-  switch (rentcode) {
+  switch (rent.rentcode) {
   case RENT_RENTED:
     len += snprintf(buf+len, sizeof(buf)-len, "Rent\r\n");
     break;
@@ -561,10 +752,32 @@ static void Crash_calculate_rent(struct obj_data *obj, int *cost)
   }
 }
 
+/* Write ch's crash file contents to fp. Returns FALSE on a write error. */
+int Crash_write_crashfile(FILE *fp, struct char_data *ch)
+{
+  int j;
+
+  if (!objsave_write_rentcode(fp, RENT_CRASH, 0, ch))
+    return FALSE;
+
+  for (j = 0; j < NUM_WEARS; j++)
+    if (GET_EQ(ch, j)) {
+      if (!Crash_save(GET_EQ(ch, j), fp, j + 1))
+        return FALSE;
+      Crash_restore_weight(GET_EQ(ch, j));
+    }
+
+  if (!Crash_save(ch->carrying, fp, 0))
+    return FALSE;
+  Crash_restore_weight(ch->carrying);
+
+  objsave_end_file(fp);
+  return TRUE;
+}
+
 void Crash_crashsave(struct char_data *ch)
 {
   char buf[MAX_INPUT_LENGTH];
-  int j;
   FILE *fp;
 
   if (IS_NPC(ch))
@@ -573,30 +786,25 @@ void Crash_crashsave(struct char_data *ch)
   if (!get_filename(buf, sizeof(buf), CRASH_FILE, GET_NAME(ch)))
     return;
 
-  if (!(fp = fopen(buf, "w")))
+  if (!(fp = saveq_open(buf)))
     return;
 
-  if (!objsave_write_rentcode(fp, RENT_CRASH, 0, ch))
-  	return;
-
-  for (j = 0; j < NUM_WEARS; j++)
-    if (GET_EQ(ch, j)) {
-      if (!Crash_save(GET_EQ(ch, j), fp, j + 1)) {
-        fclose(fp);
-        return;
-      }
-      Crash_restore_weight(GET_EQ(ch, j));
-    }
-
-  if (!Crash_save(ch->carrying, fp, 0)) {
-    fclose(fp);
+  if (!Crash_write_crashfile(fp, ch)) {
+    saveq_abort(fp);
     return;
   }
-  Crash_restore_weight(ch->carrying);
 
-  fprintf(fp, "$~\n");
-  fclose(fp);
-  REMOVE_BIT_AR(PLR_FLAGS(ch), PLR_CRASH);
+  saveq_commit(fp);
+  GET_SAVE_DIRTY(ch) &= ~SAVE_INVENTORY;
+  journal_saved(ch, SAVE_INVENTORY);
+}
+
+/* ch's objects have gone to the rent file and been extracted. The empty
+ * inventory left behind must not reach the journal. */
+static void Crash_rent_done(struct char_data *ch)
+{
+  GET_SAVE_DIRTY(ch) &= ~SAVE_INVENTORY;
+  journal_done(ch);
 }
 
 void Crash_idlesave(struct char_data *ch)
@@ -612,7 +820,7 @@ void Crash_idlesave(struct char_data *ch)
   if (!get_filename(buf, sizeof(buf), CRASH_FILE, GET_NAME(ch)))
     return;
 
-  if (!(fp = fopen(buf, "w")))
+  if (!(fp = saveq_open(buf)))
     return;
 
   Crash_extract_norent_eq(ch);
@@ -644,19 +852,21 @@ void Crash_idlesave(struct char_data *ch)
   if (ch->carrying == NULL) {
     for (j = 0; j < NUM_WEARS && GET_EQ(ch, j) == NULL; j++) /* Nothing */ ;
     if (j == NUM_WEARS) {  /* No equipment or inventory. */
-      fclose(fp);
+      saveq_abort(fp);
       Crash_delete_file(GET_NAME(ch));
       return;
     }
   }
 
-  if (!objsave_write_rentcode(fp, RENT_TIMEDOUT, cost, ch))
-  	return;
+  if (!objsave_write_rentcode(fp, RENT_TIMEDOUT, cost, ch)) {
+    saveq_abort(fp);
+    return;
+  }
 
   for (j = 0; j < NUM_WEARS; j++) {
     if (GET_EQ(ch, j)) {
       if (!Crash_save(GET_EQ(ch, j), fp, j + 1)) {
-        fclose(fp);
+        saveq_abort(fp);
         return;
       }
       Crash_restore_weight(GET_EQ(ch, j));
@@ -664,13 +874,14 @@ void Crash_idlesave(struct char_data *ch)
     }
   }
   if (!Crash_save(ch->carrying, fp, 0)) {
-    fclose(fp);
+    saveq_abort(fp);
     return;
   }
-  fprintf(fp, "$~\n");
-  fclose(fp);
+  objsave_end_file(fp);
+  saveq_commit(fp);
 
   Crash_extract_objs(ch->carrying);
+  Crash_rent_done(ch);
 }
 
 void Crash_rentsave(struct char_data *ch, int cost)
@@ -685,19 +896,21 @@ void Crash_rentsave(struct char_data *ch, int cost)
   if (!get_filename(buf, sizeof(buf), CRASH_FILE, GET_NAME(ch)))
     return;
 
-  if (!(fp = fopen(buf, "w")))
+  if (!(fp = saveq_open(buf)))
     return;
 
   Crash_extract_norent_eq(ch);
   Crash_extract_norents(ch->carrying);
 
-  if (!objsave_write_rentcode(fp, RENT_RENTED, cost, ch))
-  	return;
+  if (!objsave_write_rentcode(fp, RENT_RENTED, cost, ch)) {
+    saveq_abort(fp);
+    return;
+  }
 
   for (j = 0; j < NUM_WEARS; j++)
     if (GET_EQ(ch, j)) {
       if (!Crash_save(GET_EQ(ch,j), fp, j + 1)) {
-        fclose(fp);
+        saveq_abort(fp);
         return;
       }
       Crash_restore_weight(GET_EQ(ch, j));
@@ -705,17 +918,38 @@ void Crash_rentsave(struct char_data *ch, int cost)
 
     }
   if (!Crash_save(ch->carrying, fp, 0)) {
-    fclose(fp);
+    saveq_abort(fp);
     return;
   }
-  fprintf(fp, "$~\n");
-  fclose(fp);
+  objsave_end_file(fp);
+  saveq_commit(fp);
 
   Crash_extract_objs(ch->carrying);
+  Crash_rent_done(ch);
 }
 
 static int objsave_write_rentcode(FILE *fl, int rentcode, int cost_per_day, struct char_data *ch)
 {
+  size_t start;
+
+  if (CONFIG_BINARY_OBJFILES) {
+    objsave_start_file(fl);
+    obj_bin.len = 0;
+    start = objsave_bin_begin(OBJREC_RENT);
+    bin_put(&obj_bin, rentcode, 4);
+    bin_put(&obj_bin, time(0), 8);
+    bin_put(&obj_bin, cost_per_day, 4);
+    bin_put(&obj_bin, GET_GOLD(ch), 8);
+    bin_put(&obj_bin, GET_BANK_GOLD(ch), 8);
+    bin_put(&obj_bin, 0, 4);
+    objsave_bin_end(start);
+    if (fwrite(obj_bin.data, obj_bin.len, 1, fl) != 1) {
+      perror("Syserr: Writing rent code");
+      return FALSE;
+    }
+    return TRUE;
+  }
+
   if (fprintf(fl, "%d %ld %d %ld %ld %d\r\n",
           rentcode,
           (long) time(0),
@@ -732,6 +966,49 @@ static int objsave_write_rentcode(FILE *fl, int rentcode, int cost_per_day, stru
 
 }
 
+/* Read the rent code of a rent file just opened as fl, in either format, and
+ * leave fl at the first object. Returns FALSE if there is none. */
+static int objsave_read_rentcode(FILE *fl, struct rent_header *rent)
+{
+  char magic[OBJ_BIN_MAGIC_LEN], line[READ_SIZE];
+  unsigned char head[2 + 1 + 4];
+  struct bin_reader r;
+  long len;
+
+  memset(rent, 0, sizeof(*rent));
+  rent->rentcode = RENT_UNDEF;
+
+  if (fread(magic, OBJ_BIN_MAGIC_LEN, 1, fl) == 1 && !memcmp(magic, OBJ_BIN_MAGIC, OBJ_BIN_MAGIC_LEN)) {
+    /* Version, then the OBJREC_RENT record's type and length. */
+    if (fread(head, sizeof(head), 1, fl) != 1)
+      return FALSE;
+    bin_reader_init(&r, head, sizeof(head));
+    bin_get(&r, 2);
+    if (bin_get(&r, 1) != OBJREC_RENT || (len = bin_get(&r, 4)) < 0)
+      return FALSE;
+    obj_bin.len = 0;
+    bin_need(&obj_bin, len);
+    if (len && fread(obj_bin.data, len, 1, fl) != 1)
+      return FALSE;
+
+    bin_reader_init(&r, obj_bin.data, len);
+    rent->rentcode = bin_get(&r, 4);
+    rent->timed = bin_get(&r, 8);
+    rent->netcost = bin_get(&r, 4);
+    rent->gold = bin_get(&r, 8);
+    rent->account = bin_get(&r, 8);
+    rent->nitems = bin_get(&r, 4);
+    return !r.bad;
+  }
+
+  rewind(fl);
+  if (!get_line(fl, line))
+    return FALSE;
+  sscanf(line, "%d %ld %d %ld %ld %d", &rent->rentcode, &rent->timed,
+         &rent->netcost, &rent->gold, &rent->account, &rent->nitems);
+  return TRUE;
+}
+
 static void Crash_cryosave(struct char_data *ch, int cost)
 {
   char buf[MAX_INPUT_LENGTH];
@@ -744,7 +1021,7 @@ static void Crash_cryosave(struct char_data *ch, int cost)
   if (!get_filename(buf, sizeof(buf), CRASH_FILE, GET_NAME(ch)))
     return;
 
-  if (!(fp = fopen(buf, "w")))
+  if (!(fp = saveq_open(buf)))
     return;
 
   Crash_extract_norent_eq(ch);
@@ -752,26 +1029,29 @@ static void Crash_cryosave(struct char_data *ch, int cost)
 
   GET_GOLD(ch) = MAX(0, GET_GOLD(ch) - cost);
 
-  if (!objsave_write_rentcode(fp, RENT_CRYO, 0, ch))
-  	return;
+  if (!objsave_write_rentcode(fp, RENT_CRYO, 0, ch)) {
+    saveq_abort(fp);
+    return;
+  }
 
   for (j = 0; j < NUM_WEARS; j++)
     if (GET_EQ(ch, j)) {
       if (!Crash_save(GET_EQ(ch, j), fp, j + 1)) {
-        fclose(fp);
+        saveq_abort(fp);
         return;
       }
       Crash_restore_weight(GET_EQ(ch, j));
       Crash_extract_objs(GET_EQ(ch, j));
     }
   if (!Crash_save(ch->carrying, fp, 0)) {
-    fclose(fp);
+    saveq_abort(fp);
     return;
   }
-  fprintf(fp, "$~\n");
-  fclose(fp);
+  objsave_end_file(fp);
+  saveq_commit(fp);
 
   Crash_extract_objs(ch->carrying);
+  Crash_rent_done(ch);
   SET_BIT_AR(PLR_FLAGS(ch), PLR_CRYO);
 }
 
@@ -967,18 +1247,224 @@ SPECIAL(cryogenicist)
   return (gen_receptionist(ch, (struct char_data *)me, cmd, argument, CRYO_FACTOR));
 }
 
+/* Write whichever of a player's rent file and player file have changed. */
+static void Crash_save_dirty(struct char_data *ch)
+{
+  if (GET_SAVE_DIRTY(ch) & SAVE_INVENTORY)
+    Crash_crashsave(ch);
+  if (GET_SAVE_DIRTY(ch) & SAVE_PFILE)
+    save_char(ch);
+  GET_LAST_SAVE(ch) = time(0);
+}
+
+/* Save every playing character with unsaved changes. */
 void Crash_save_all(void)
 {
   struct descriptor_data *d;
   for (d = descriptor_list; d; d = d->next) {
     if ((STATE(d) == CON_PLAYING) && !IS_NPC(d->character)) {
-      if (PLR_FLAGGED(d->character, PLR_CRASH)) {
-        Crash_crashsave(d->character);
-        save_char(d->character);
-        REMOVE_BIT_AR(PLR_FLAGS(d->character), PLR_CRASH);
+      if (GET_SAVE_DIRTY(d->character))
+        Crash_save_dirty(d->character);
+    }
+  }
+}
+
+/* Called every pulse. Saves the players with unsaved changes whose last save
+ * is at least CONFIG_AUTOSAVE_TIME minutes old, AUTOSAVES_PER_PULSE at a
+ * time, so a busy interval is written out over several pulses instead of
+ * all at once. */
+void Crash_autosave(void)
+{
+  struct descriptor_data *d;
+  time_t due = time(0) - CONFIG_AUTOSAVE_TIME * SECS_PER_REAL_MIN;
+  int saved = 0;
+
+  for (d = descriptor_list; d && saved < AUTOSAVES_PER_PULSE; d = d->next) {
+    if ((STATE(d) != CON_PLAYING) || IS_NPC(d->character))
+      continue;
+    if (!GET_SAVE_DIRTY(d->character) || GET_LAST_SAVE(d->character) > due)
+      continue;
+    Crash_save_dirty(d->character);
+    saved++;
+  }
+}
+
+/* Whether fl, at the start of a house file or just past a rent code, holds
+ * binary object records. Leaves fl at the first record either way. */
+static int objsave_binary_records(FILE *fl)
+{
+  char magic[OBJ_BIN_MAGIC_LEN + 2];
+  long pos;
+  int c;
+
+  if ((c = getc(fl)) == EOF)
+    return FALSE;
+  ungetc(c, fl);
+  if (c == OBJREC_OBJ || c == OBJREC_END)
+    return TRUE;
+  if (c != *OBJ_BIN_MAGIC)
+    return FALSE;
+
+  pos = ftell(fl);
+  if (fread(magic, sizeof(magic), 1, fl) == 1 && !memcmp(magic, OBJ_BIN_MAGIC, OBJ_BIN_MAGIC_LEN))
+    return TRUE;
+  fseek(fl, pos, SEEK_SET);
+  return FALSE;
+}
+
+static void objsave_bin_get_flags(struct bin_reader *r, int *flags, int count)
+{
+  int i;
+
+  for (i = 0; i < count; i++)
+    flags[i] = bin_get(r, 4);
+}
+
+/* Make the object an OBJREC_OBJ record describes, or NULL if its prototype
+ * is gone. */
+static struct obj_data *objsave_bin_object(struct bin_reader *r, int *locate)
+{
+  struct obj_data *obj;
+  struct extra_descr_data *ex_desc, **tail;
+  obj_vnum nr;
+  long long uid;
+  long gen;
+  int field, i, count, slot, location, modifier, val;
+  char *str;
+
+  nr = bin_get(r, 4);
+  *locate = bin_get(r, 2);
+  uid = bin_get(r, 8);
+  gen = bin_get(r, 8);
+
+  if (nr == NOTHING) {   /* then it is unique */
+    obj = create_obj();
+    obj->item_number = NOTHING;
+  } else if (real_object(nr) == NOTHING) {
+    log("SYSERR: Prevented loading of non-existant item #%d.", nr);
+    return (NULL);
+  } else
+    obj = read_object(nr, VIRTUAL);
+
+  GET_OBJ_UID(obj) = uid;
+  GET_OBJ_GENERATION(obj) = gen;
+
+  while (!r->bad && (field = bin_get(r, 1)) != OBF_END) {
+    switch (field) {
+    case OBF_VALS:
+      count = bin_get(r, 1);
+      for (i = 0; i < count; i++) {
+        val = bin_get(r, 4);
+        if (i < NUM_OBJ_VAL_POSITIONS)
+          GET_OBJ_VAL(obj, i) = val;
+      }
+      break;
+    case OBF_EXTRA:
+      objsave_bin_get_flags(r, GET_OBJ_EXTRA(obj), EF_ARRAY_MAX);
+      break;
+    case OBF_PERM:
+      objsave_bin_get_flags(r, GET_OBJ_AFFECT(obj), AF_ARRAY_MAX);
+      break;
+    case OBF_WEAR:
+      objsave_bin_get_flags(r, GET_OBJ_WEAR(obj), TW_ARRAY_MAX);
+      break;
+    case OBF_NAME:
+      obj->name = bin_get_str(r, 4);
+      kw_reindex_obj(obj);
+      break;
+    case OBF_SHORT:
+      obj->short_description = bin_get_str(r, 4);
+      break;
+    case OBF_DESC:
+      obj->description = bin_get_str(r, 4);
+      break;
+    case OBF_ADESC:
+      str = bin_get_str(r, 4);
+      if (!*str) {
+        free(str);
+        str = NULL;
+      }
+      obj->action_description = str;
+      break;
+    case OBF_TYPE:
+      GET_OBJ_TYPE(obj) = bin_get(r, 1);
+      break;
+    case OBF_WEIGHT:
+      GET_OBJ_WEIGHT(obj) = bin_get(r, 4);
+      break;
+    case OBF_COST:
+      GET_OBJ_COST(obj) = bin_get(r, 4);
+      break;
+    case OBF_RENT:
+      GET_OBJ_RENT(obj) = bin_get(r, 4);
+      break;
+    case OBF_AFF:
+      slot = bin_get(r, 1);
+      location = bin_get(r, 1);
+      modifier = bin_get(r, 2);
+      if (slot >= 0 && slot < MAX_OBJ_AFFECT) {
+        obj->affected[slot].location = location;
+        obj->affected[slot].modifier = modifier;
       }
+      break;
+    case OBF_EDESCS:
+      /* The prototype's list is shared, so it is replaced, never freed. */
+      obj->ex_description = NULL;
+      tail = &obj->ex_description;
+      for (count = bin_get(r, 2); count > 0 && !r->bad; count--) {
+        CREATE(ex_desc, struct extra_descr_data, 1);
+        ex_desc->keyword = bin_get_str(r, 4);
+        ex_desc->description = bin_get_str(r, 4);
+        *tail = ex_desc;
+        tail = &ex_desc->next;
+      }
+      break;
+    default:
+      log("SYSERR: Unknown field %d for object #%d in binary object file.", field, nr);
+      r->bad = TRUE;
+      break;
     }
   }
+  return (obj);
+}
+
+/* The binary form of objsave_parse_objects(). Records are read one at a time
+ * into obj_bin, so only one object's data is in memory at once. */
+static obj_save_data *objsave_parse_binary(FILE *fl)
+{
+  obj_save_data *head = NULL, **tail = &head, *current;
+  struct obj_data *obj;
+  struct bin_reader r;
+  unsigned char head_len[4];
+  long len;
+  int type, locate;
+
+  while ((type = getc(fl)) != EOF && type != OBJREC_END) {
+    if (fread(head_len, sizeof(head_len), 1, fl) != 1)
+      break;
+    bin_reader_init(&r, head_len, sizeof(head_len));
+    if ((len = bin_get(&r, 4)) < 0)
+      break;
+    obj_bin.len = 0;
+    bin_need(&obj_bin, len);
+    if (len && fread(obj_bin.data, len, 1, fl) != 1) {
+      log("SYSERR: Binary object file is truncated.");
+      break;
+    }
+    if (type != OBJREC_OBJ)   /* A record from a newer version; skip it. */
+      continue;
+
+    bin_reader_init(&r, obj_bin.data, len);
+    if (!(obj = objsave_bin_object(&r, &locate)))
+      continue;
+
+    CREATE(current, obj_save_data, 1);
+    current->obj = obj;
+    current->locate = locate;
+    *tail = current;
+    tail = &current->next;
+  }
+  return (head);
 }
 
 /* Parses the object records stored in fl, and returns the first object in a
@@ -991,6 +1477,9 @@ obj_save_data *objsave_parse_objects(FILE *fl)
   int t[4],i, nr;
   struct obj_data *temp;
 
+  if (objsave_binary_records(fl))
+    return (objsave_parse_binary(fl));
+
   CREATE(current, obj_save_data, 1);
   head = current;
   current->locate = 0;
@@ -1136,8 +1625,10 @@ obj_save_data *objsave_parse_objects(FILE *fl)
         current->locate = num;
       break;
     case 'N':
-      if (!strcmp(tag, "Name"))
+      if (!strcmp(tag, "Name")) {
         temp->name = strdup(line);
+        kw_reindex_obj(temp);
+      }
       break;
     case 'P':
       if (!strcmp(tag, "Perm")) {
@@ -1193,14 +1684,12 @@ obj_save_data *objsave_parse_objects(FILE *fl)
 static int Crash_load_objs(struct char_data *ch) {
   FILE *fl;
   char filename[PATH_MAX];
-  char line[READ_SIZE];
   char buf[MAX_STRING_LENGTH];
   char str[64];
   int i, num_of_days, orig_rent_code, num_objs=0;
   unsigned long cost;
   struct obj_data *cont_row[MAX_BAG_ROWS];
-  int rentcode = RENT_UNDEF;
-  int timed=0,netcost=0,gold,account,nitems;
+  struct rent_header rent;
 	obj_save_data *loaded, *current;
 
   if (!get_filename(filename, sizeof(filename), CRASH_FILE, GET_NAME(ch)))
@@ -1209,6 +1698,7 @@ static int Crash_load_objs(struct char_data *ch) {
   for (i = 0; i < MAX_BAG_ROWS; i++)
     cont_row[i] = NULL;
 
+  saveq_wait(filename);
   if (!(fl = fopen(filename, "r"))) {
     if (errno != ENOENT) { /* if it fails, NOT because of no file */
       snprintf(buf, MAX_STRING_LENGTH, "SYSERR: READING OBJECT FILE %s (5)", filename);
@@ -1221,15 +1711,13 @@ static int Crash_load_objs(struct char_data *ch) {
     return 1;
   }
  
-  if (!get_line(fl, line))
+  if (!objsave_read_rentcode(fl, &rent))
     mudlog(NRM, MAX(LVL_IMMORT, GET_INVIS_LEV(ch)), TRUE, "Failed to read player's rent code: %s.", GET_NAME(ch));
-  else
-    sscanf(line,"%d %d %d %d %d %d",&rentcode, &timed, &netcost,&gold,&account,&nitems);
 
-  if (rentcode == RENT_RENTED || rentcode == RENT_TIMEDOUT) {
+  if (rent.rentcode == RENT_RENTED || rent.rentcode == RENT_TIMEDOUT) {
     sprintf(str, "%d", SECS_PER_REAL_DAY);
-    num_of_days = (int)((float) (time(0) - timed) / atoi(str));
-    cost = (unsigned int) (netcost * num_of_days);
+    num_of_days = (int)((float) (time(0) - rent.timed) / atoi(str));
+    cost = (unsigned int) (rent.netcost * num_of_days);
     if (cost > (unsigned int)GET_GOLD(ch) + (unsigned int)GET_BANK_GOLD(ch)) {
       fclose(fl);
       mudlog(BRF, MAX(LVL_IMMORT, GET_INVIS_LEV(ch)), TRUE,
@@ -1242,7 +1730,7 @@ static int Crash_load_objs(struct char_data *ch) {
       save_char(ch);
     }
   }
-  switch (orig_rent_code = rentcode) {
+  switch (orig_rent_code = rent.rentcode) {
   case RENT_RENTED:
     mudlog(NRM, MAX(LVL_IMMORT, GET_INVIS_LEV(ch)), TRUE,
            "%s un-renting and entering game.", GET_NAME(ch));
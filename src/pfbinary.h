@@ -0,0 +1,147 @@
+/**
+* @file pfbinary.h
+* Layout of the binary player file.
+*
+* Part of the core tbaMUD source code distribution, which is a derivative
+* of, and continuation of, CircleMUD.
+*
+* Shared by players.c and util/plrconv.c, which converts player files
+* between this format and ASCII.
+*
+* A binary player file is PFB_MAGIC, a 2 byte schema version, and then
+* sections, each a 1 byte section id, a 4 byte payload length and the
+* payload. Readers skip sections they do not know. All integers are little
+* endian and signed.
+*
+* PFB_SEC_SCALARS holds a 2 byte field count followed by that many of the
+* PFB_SCALARS fields below, in order, each in its own fixed width. A file
+* with fewer fields than the reader knows leaves the rest at their defaults,
+* so new fields go at the end of the list. The other sections each hold a 2
+* byte count of entries; strings inside them are a 2 byte length and the
+* bytes, with no terminating nul.
+*
+*   PFB_SEC_TEXT     1 byte PFB_TXT_ id, 4 byte length, text
+*   PFB_SEC_SKILLS   2 byte skill number, 2 byte value
+*   PFB_SEC_AFFECTS  2 spell, 4 duration, 2 modifier, 2 location,
+*                    4 x 4 bitvector
+*   PFB_SEC_ALIASES  alias string, replacement string, 1 byte type
+*   PFB_SEC_QUESTS   4 byte quest vnum
+*   PFB_SEC_ZONES    1 byte of discovered zone flags
+*   PFB_SEC_KILLS    4 byte mob vnum, 4 byte amount
+*   PFB_SEC_TRIGS    4 byte trigger vnum
+*   PFB_SEC_VARS     name string, 8 byte context, value string
+*
+* Change PFB_VERSION whenever an existing field changes meaning or width.
+*/
+#ifndef _PFBINARY_H_
+#define _PFBINARY_H_
+
+#define PFB_MAGIC      "TBPF"
+#define PFB_MAGIC_LEN  4
+#define PFB_VERSION    1
+
+#define PFB_SEC_SCALARS  1
+#define PFB_SEC_TEXT     2
+#define PFB_SEC_SKILLS   3
+#define PFB_SEC_AFFECTS  4
+#define PFB_SEC_ALIASES  5
+#define PFB_SEC_QUESTS   6
+#define PFB_SEC_ZONES    7
+#define PFB_SEC_KILLS    8
+#define PFB_SEC_TRIGS    9
+#define PFB_SEC_VARS    10
+
+#define PFB_TXT_NAME     0
+#define PFB_TXT_PASSWD   1
+#define PFB_TXT_TITLE    2
+#define PFB_TXT_DESC     3
+#define PFB_TXT_POOFIN   4
+#define PFB_TXT_POOFOUT  5
+#define PFB_TXT_HOST     6
+#define NUM_PFB_TXT      7
+
+/* How the ASCII format writes a scalar: on its own, on its own even when it
+ * is the default, as "a/b" together with the next field, or as four
+ * sprintascii() words together with the next three. PFB_MORE marks those
+ * following fields. */
+#define PFB_NUM     0
+#define PFB_ALWAYS  1
+#define PFB_PAIR    2
+#define PFB_FLAGS   3
+#define PFB_MORE    4
+
+/* X(field, ASCII tag, width in bytes, default, kind). Only add to the end. */
+#define PFB_SCALARS(X) \
+  X(PFB_PVER,     "PVer",        4, 1,                    PFB_ALWAYS) \
+  X(PFB_SEX,      "Sex ",        1, PFDEF_SEX,            PFB_NUM)    \
+  X(PFB_CLASS,    "Clas",        1, PFDEF_CLASS,          PFB_NUM)    \
+  X(PFB_LEVEL,    "Levl",        2, PFDEF_LEVEL,          PFB_NUM)    \
+  X(PFB_ID,       "Id  ",        8, 0,                    PFB_ALWAYS) \
+  X(PFB_BIRTH,    "Brth",        8, 0,                    PFB_ALWAYS) \
+  X(PFB_PLAYED,   "Plyd",        4, 0,                    PFB_ALWAYS) \
+  X(PFB_LOGON,    "Last",        8, 0,                    PFB_ALWAYS) \
+  X(PFB_LMOT,     "Lmot",        8, PFDEF_LASTMOTD,       PFB_NUM)    \
+  X(PFB_LNEW,     "Lnew",        8, PFDEF_LASTNEWS,       PFB_NUM)    \
+  X(PFB_HEIGHT,   "Hite",        2, PFDEF_HEIGHT,         PFB_NUM)    \
+  X(PFB_WEIGHT,   "Wate",        2, PFDEF_WEIGHT,         PFB_NUM)    \
+  X(PFB_ALIGN,    "Alin",        4, PFDEF_ALIGNMENT,      PFB_NUM)    \
+  X(PFB_ACT,      "Act ",        4, PFDEF_PLRFLAGS,       PFB_FLAGS)  \
+  X(PFB_ACT1,     "",            4, PFDEF_PLRFLAGS,       PFB_MORE)   \
+  X(PFB_ACT2,     "",            4, PFDEF_PLRFLAGS,       PFB_MORE)   \
+  X(PFB_ACT3,     "",            4, PFDEF_PLRFLAGS,       PFB_MORE)   \
+  X(PFB_AFF,      "Aff ",        4, PFDEF_AFFFLAGS,       PFB_FLAGS)  \
+  X(PFB_AFF1,     "",            4, PFDEF_AFFFLAGS,       PFB_MORE)   \
+  X(PFB_AFF2,     "",            4, PFDEF_AFFFLAGS,       PFB_MORE)   \
+  X(PFB_AFF3,     "",            4, PFDEF_AFFFLAGS,       PFB_MORE)   \
+  X(PFB_PREF,     "Pref",        4, PFDEF_PREFFLAGS,      PFB_FLAGS)  \
+  X(PFB_PREF1,    "",            4, PFDEF_PREFFLAGS,      PFB_MORE)   \
+  X(PFB_PREF2,    "",            4, PFDEF_PREFFLAGS,      PFB_MORE)   \
+  X(PFB_PREF3,    "",            4, PFDEF_PREFFLAGS,      PFB_MORE)   \
+  X(PFB_MAGR,     "MagR",        4, 0,                    PFB_NUM)    \
+  X(PFB_ELER,     "EleR",        4, 0,                    PFB_NUM)    \
+  X(PFB_WIMP,     "Wimp",        4, PFDEF_WIMPLEV,        PFB_NUM)    \
+  X(PFB_FREZ,     "Frez",        2, PFDEF_FREEZELEV,      PFB_NUM)    \
+  X(PFB_INVS,     "Invs",        2, PFDEF_INVISLEV,       PFB_NUM)    \
+  X(PFB_ROOM,     "Room",        4, PFDEF_LOADROOM,       PFB_NUM)    \
+  X(PFB_BADP,     "Badp",        2, PFDEF_BADPWS,         PFB_NUM)    \
+  X(PFB_LERN,     "Lern",        4, PFDEF_PRACTICES,      PFB_NUM)    \
+  X(PFB_HUNG,     "Hung",        1, PFDEF_HUNGER,         PFB_NUM)    \
+  X(PFB_THIR,     "Thir",        1, PFDEF_THIRST,         PFB_NUM)    \
+  X(PFB_DRNK,     "Drnk",        1, PFDEF_DRUNK,          PFB_NUM)    \
+  X(PFB_HIT,      "Hit ",        2, PFDEF_HIT,            PFB_PAIR)   \
+  X(PFB_MAXHIT,   "",            2, PFDEF_MAXHIT,         PFB_MORE)   \
+  X(PFB_MANA,     "Mana",        2, PFDEF_MANA,           PFB_PAIR)   \
+  X(PFB_MAXMANA,  "",            2, PFDEF_MAXMANA,        PFB_MORE)   \
+  X(PFB_MOVE,     "Move",        2, PFDEF_MOVE,           PFB_PAIR)   \
+  X(PFB_MAXMOVE,  "",            2, PFDEF_MAXMOVE,        PFB_MORE)   \
+  X(PFB_STR,      "Str ",        4, PFDEF_STR,            PFB_PAIR)   \
+  X(PFB_STRADD,   "",            4, PFDEF_STRADD,         PFB_MORE)   \
+  X(PFB_INT,      "Int ",        4, PFDEF_INT,            PFB_NUM)    \
+  X(PFB_WIS,      "Wis ",        4, PFDEF_WIS,            PFB_NUM)    \
+  X(PFB_DEX,      "Dex ",        4, PFDEF_DEX,            PFB_NUM)    \
+  X(PFB_CON,      "Con ",        4, PFDEF_CON,            PFB_NUM)    \
+  X(PFB_CHA,      "Cha ",        4, PFDEF_CHA,            PFB_NUM)    \
+  X(PFB_AC,       "Ac  ",        4, PFDEF_AC,             PFB_NUM)    \
+  X(PFB_GOLD,     "Gold",        8, PFDEF_GOLD,           PFB_NUM)    \
+  X(PFB_BANK,     "Bank",        8, PFDEF_BANK,           PFB_NUM)    \
+  X(PFB_EXP,      "Exp ",        8, PFDEF_EXP,            PFB_NUM)    \
+  X(PFB_HROL,     "Hrol",        1, PFDEF_HITROLL,        PFB_NUM)    \
+  X(PFB_DROL,     "Drol",        1, PFDEF_DAMROLL,        PFB_NUM)    \
+  X(PFB_OLC,      "Olc ",        4, PFDEF_OLC,            PFB_NUM)    \
+  X(PFB_PAGE,     "Page",        2, PFDEF_PAGELENGTH,     PFB_NUM)    \
+  X(PFB_SCRW,     "ScrW",        2, PFDEF_SCREENWIDTH,    PFB_NUM)    \
+  X(PFB_QSTP,     "Qstp",        4, PFDEF_QUESTPOINTS,    PFB_NUM)    \
+  X(PFB_QCNT,     "Qcnt",        4, PFDEF_QUESTCOUNT,     PFB_NUM)    \
+  X(PFB_QCUR,     "Qcur",        4, PFDEF_CURRQUEST,      PFB_NUM)    \
+  X(PFB_KTOTAL,   "KillsTotal",  4, PFDEF_KILLS_TOTAL,    PFB_NUM)    \
+  X(PFB_KLEGIT,   "KillsLegit",  4, PFDEF_KILLS_LEGIT_TOTAL, PFB_NUM) \
+  X(PFB_KUNIQUE,  "KillsUnique", 4, PFDEF_KILLS_UNIQUE,   PFB_NUM)    \
+  X(PFB_DEATHS,   "Deaths",      4, 0,                    PFB_NUM)    \
+  X(PFB_CSLT,     "CSlt",        4, 0,                    PFB_ALWAYS) \
+  X(PFB_ZONESDISC,"Zonesdisc",   4, 0,                    PFB_NUM)
+
+#define PFB_ENUM(field, tag, width, def, kind) field,
+enum { PFB_SCALARS(PFB_ENUM) NUM_PFB_SCALARS };
+#undef PFB_ENUM
+
+#endif /* _PFBINARY_H_ */
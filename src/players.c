@@ -22,6 +22,10 @@
 #include "config.h" /* for pclean_criteria[] */
 #include "dg_scripts.h" /* To enable saving of player variables to disk */
 #include "quest.h"
+#include "savequeue.h"
+#include "journal.h"
+#include "pfbinary.h"
+#include "binfile.h"
 
 #define LOAD_HIT	0
 #define LOAD_MANA	1
@@ -41,6 +45,24 @@ static void load_quests(FILE *fl, struct char_data *ch);
 static void load_HMVS(struct char_data *ch, const char *line, int mode);
 static void write_aliases_ascii(FILE *file, struct char_data *ch);
 static void read_aliases_ascii(FILE *file, struct char_data *ch, int count);
+static void load_char_ascii(FILE *fl, struct char_data *ch, const char *name);
+static int load_char_binary(FILE *fl, struct char_data *ch);
+static int pfile_is_binary(FILE *fl);
+static void save_char_ascii(FILE *fl, struct char_data *ch, const struct char_base_data *base);
+static void save_char_binary(FILE *fl, struct char_data *ch, const struct char_base_data *base);
+static void ptable_link(int pos);
+static void ptable_unlink(int pos);
+static void ptable_rehash(int entries);
+static void purge_player(int pfilepos);
+
+/* Name and id hashes over player_table. The buckets hold table positions and
+ * each entry chains on to the next with the same hash through next_by_name
+ * and next_by_id. ptable_size is how many entries player_table has room for,
+ * which may be more than top_of_p_table + 1. */
+static int *ptable_by_name = NULL;
+static int *ptable_by_id = NULL;
+static int ptable_buckets = 0;
+static int ptable_size = 0;
 
 
 /* This function migrates player data from an old version to the current version.
@@ -96,6 +118,7 @@ void build_player_index(void)
   }
 
   CREATE(player_table, struct player_index_element, rec_count);
+  ptable_size = rec_count;
   for (i = 0; i < rec_count; i++) {
     get_line(plr_index, line);
     sscanf(line, "%ld %s %d %s %ld", &player_table[i].id, arg2,
@@ -108,6 +131,82 @@ void build_player_index(void)
 
   fclose(plr_index);
   top_of_p_file = top_of_p_table = i - 1;
+  ptable_rehash(rec_count);
+}
+
+static unsigned int ptable_name_hash(const char *name)
+{
+  unsigned int hash = 5381;
+
+  for (; *name; name++)
+    hash = hash * 33 + (unsigned char) LOWER(*name);
+
+  return hash & (ptable_buckets - 1);
+}
+
+static unsigned int ptable_id_hash(long id)
+{
+  return ((unsigned long) id * 2654435761UL) & (ptable_buckets - 1);
+}
+
+/* Entries with no name yet or no id yet are left out of that hash. */
+static void ptable_link(int pos)
+{
+  unsigned int h;
+
+  if (*PT_PNAME(pos)) {
+    h = ptable_name_hash(PT_PNAME(pos));
+    player_table[pos].next_by_name = ptable_by_name[h];
+    ptable_by_name[h] = pos;
+  }
+  if (PT_IDNUM(pos) >= 0) {
+    h = ptable_id_hash(PT_IDNUM(pos));
+    player_table[pos].next_by_id = ptable_by_id[h];
+    ptable_by_id[h] = pos;
+  }
+}
+
+static void ptable_unlink(int pos)
+{
+  int *link;
+
+  if (*PT_PNAME(pos))
+    for (link = &ptable_by_name[ptable_name_hash(PT_PNAME(pos))]; *link != -1;
+         link = &player_table[*link].next_by_name)
+      if (*link == pos) {
+        *link = player_table[pos].next_by_name;
+        break;
+      }
+
+  if (PT_IDNUM(pos) >= 0)
+    for (link = &ptable_by_id[ptable_id_hash(PT_IDNUM(pos))]; *link != -1;
+         link = &player_table[*link].next_by_id)
+      if (*link == pos) {
+        *link = player_table[pos].next_by_id;
+        break;
+      }
+}
+
+/* Size the hashes for at least 'entries' players, keeping chains short, and
+ * file every entry again. */
+static void ptable_rehash(int entries)
+{
+  int i;
+
+  for (ptable_buckets = 256; ptable_buckets < entries * 2; ptable_buckets <<= 1)
+    ;
+
+  if (ptable_by_name)
+    free(ptable_by_name);
+  if (ptable_by_id)
+    free(ptable_by_id);
+  CREATE(ptable_by_name, int, ptable_buckets);
+  CREATE(ptable_by_id, int, ptable_buckets);
+  for (i = 0; i < ptable_buckets; i++)
+    ptable_by_name[i] = ptable_by_id[i] = -1;
+
+  for (i = 0; i <= top_of_p_table; i++)
+    ptable_link(i);
 }
 
 /* Create a new entry in the in-memory index table for the player file. If the
@@ -117,14 +216,23 @@ int create_entry(char *name)
 {
   int i, pos;
 
-  if (top_of_p_table == -1) {	/* no table */
-    pos = top_of_p_table = 0;
-    CREATE(player_table, struct player_index_element, 1);
-  } else if ((pos = get_ptable_by_name(name)) == -1) {	/* new name */
-    i = ++top_of_p_table + 1;
+  if ((pos = get_ptable_by_name(name)) == -1) {	/* new name */
+    pos = ++top_of_p_table;
 
-    RECREATE(player_table, struct player_index_element, i);
-    pos = top_of_p_table;
+    /* Grow the table by doubling, not one entry at a time. */
+    if (pos >= ptable_size) {
+      ptable_size = MAX(16, ptable_size * 2);
+      if (player_table)
+        RECREATE(player_table, struct player_index_element, ptable_size);
+      else
+        CREATE(player_table, struct player_index_element, ptable_size);
+    }
+    player_table[pos].id = -1;
+    player_table[pos].level = 0;
+    player_table[pos].last = 0;
+  } else {
+    ptable_unlink(pos);
+    free(player_table[pos].name);
   }
 
   CREATE(player_table[pos].name, char, strlen(name) + 1);
@@ -136,42 +244,65 @@ int create_entry(char *name)
   /* clear the bitflag in case we have garbage data */
   player_table[pos].flags = 0;
 
+  if (top_of_p_table + 1 > ptable_buckets / 2)
+    ptable_rehash(ptable_size);
+  else
+    ptable_link(pos);
+
   return (pos);
 }
 
+/* Give a player index entry a new id, keeping the id hash in step. */
+void set_ptable_id(int pos, long id)
+{
+  if (pos < 0 || pos > top_of_p_table)
+    return;
+
+  ptable_unlink(pos);
+  PT_IDNUM(pos) = id;
+  ptable_link(pos);
+}
+
+/* Give a player index entry a new name, keeping the name hash in step. */
+void set_ptable_name(int pos, const char *name)
+{
+  int k;
+
+  if (pos < 0 || pos > top_of_p_table)
+    return;
+
+  ptable_unlink(pos);
+  free(PT_PNAME(pos));
+  PT_PNAME(pos) = strdup(name);
+  for (k = 0; (PT_PNAME(pos)[k] = LOWER(PT_PNAME(pos)[k])); k++)
+    /* Nothing */;
+  ptable_link(pos);
+}
+
 
 /* Remove an entry from the in-memory player index table.               *
- * Requires the 'pos' value returned by the get_ptable_by_name function */
+ * Requires the 'pos' value returned by the get_ptable_by_name function. *
+ * The last entry moves into the hole, so positions past 'pos' are not  *
+ * all renumbered; only the old top entry changes position.            */
 static void remove_player_from_index(int pos)
 {
-  int i;
+  int last = top_of_p_table;
 
   if (pos < 0 || pos > top_of_p_table)
     return;
 
-  /* We only need to free the name string */
+  ptable_unlink(pos);
   free(PT_PNAME(pos));
 
-  /* Move every other item in the list down the index */
-  for (i = pos+1; i <= top_of_p_table; i++) {
-    PT_PNAME(i-1) = PT_PNAME(i);
-    PT_IDNUM(i-1) = PT_IDNUM(i);
-    PT_LEVEL(i-1) = PT_LEVEL(i);
-    PT_FLAGS(i-1) = PT_FLAGS(i);
-    PT_LLAST(i-1) = PT_LLAST(i);
+  if (pos != last) {
+    ptable_unlink(last);
+    player_table[pos] = player_table[last];
+    ptable_link(pos);
   }
-  PT_PNAME(top_of_p_table) = NULL;
+  PT_PNAME(last) = NULL;
 
   /* Reduce the index table counter */
   top_of_p_table--;
-
-  /* And reduce the size of the table */
-  if (top_of_p_table >= 0)
-    RECREATE(player_table, struct player_index_element, (top_of_p_table+1));
-  else {
-    free(player_table);
-    player_table = NULL;
-  }
 }
 
 /* This function necessary to save a seperate ASCII player index */
@@ -213,39 +344,62 @@ void free_player_index(void)
   free(player_table);
   player_table = NULL;
   top_of_p_table = 0;
+  ptable_size = 0;
+
+  free(ptable_by_name);
+  free(ptable_by_id);
+  ptable_by_name = ptable_by_id = NULL;
+  ptable_buckets = 0;
 }
 
 long get_ptable_by_name(const char *name)
 {
   int i;
 
-  for (i = 0; i <= top_of_p_table; i++)
+  if (!ptable_buckets || !name || !*name)
+    return (-1);
+
+  for (i = ptable_by_name[ptable_name_hash(name)]; i != -1;
+       i = player_table[i].next_by_name)
     if (!str_cmp(player_table[i].name, name))
       return (i);
 
   return (-1);
 }
 
-long get_id_by_name(const char *name)
+long get_ptable_by_id(long id)
 {
   int i;
 
-  for (i = 0; i <= top_of_p_table; i++)
-    if (!str_cmp(player_table[i].name, name))
-      return (player_table[i].id);
+  if (!ptable_buckets || id < 0)
+    return (-1);
+
+  for (i = ptable_by_id[ptable_id_hash(id)]; i != -1;
+       i = player_table[i].next_by_id)
+    if (player_table[i].id == id)
+      return (i);
 
   return (-1);
 }
 
+long get_id_by_name(const char *name)
+{
+  long i;
+
+  if ((i = get_ptable_by_name(name)) < 0)
+    return (-1);
+
+  return (player_table[i].id);
+}
+
 char *get_name_by_id(long id)
 {
-  int i;
+  long i;
 
-  for (i = 0; i <= top_of_p_table; i++)
-    if (player_table[i].id == id)
-      return (player_table[i].name);
+  if ((i = get_ptable_by_id(id)) < 0)
+    return (NULL);
 
-  return (NULL);
+  return (player_table[i].name);
 }
 
 /* Stuff related to the save/load player system. */
@@ -253,19 +407,16 @@ char *get_name_by_id(long id)
  * if not. */
 int load_char(const char *name, struct char_data *ch)
 {
-  int id, i, num = 0, num2 = 0, num3 = 0;
+  int id, i;
   FILE *fl;
   char filename[40];
-  char buf[128], buf2[128], line[MAX_INPUT_LENGTH + 1], tag[6];
-  char f1[128], f2[128], f3[128], f4[128];
-  trig_data *t = NULL;
-  trig_rnum t_rnum = NOTHING;
 
   if ((id = get_ptable_by_name(name)) < 0)
     return (-1);
   else {
     if (!get_filename(filename, sizeof(filename), PLR_FILE, player_table[id].name))
       return (-1);
+    saveq_wait(filename);
     if (!(fl = fopen(filename, "r"))) {
       mudlog(NRM, LVL_GOD, TRUE, "SYSERR: Couldn't open player file %s", filename);
       return (-1);
@@ -333,324 +484,357 @@ int load_char(const char *name, struct char_data *ch)
 
     GET_PFILE_VERSION(ch) = 1;  // Default version if not found
 
-    while (get_line(fl, line)) {
-      tag_argument(line, tag);
+    if (!pfile_is_binary(fl))
+      load_char_ascii(fl, ch, name);
+    else if (load_char_binary(fl, ch) < 0) {
+      mudlog(NRM, LVL_GOD, TRUE, "SYSERR: Player file %s is damaged", filename);
+      fclose(fl);
+      return (-1);
+    }
+  }
+
+  if (GET_PFILE_VERSION(ch) < PFILE_VERSION) {
+  migrate_player(ch, GET_PFILE_VERSION(ch));
+  }
+
+  affect_total(ch);
+
+  /* initialization for imms */
+  if (GET_LEVEL(ch) >= LVL_IMMORT) {
+    for (i = 1; i <= MAX_SKILLS; i++)
+      GET_SKILL(ch, i) = 100;
+    GET_COND(ch, HUNGER) = -1;
+    GET_COND(ch, THIRST) = -1;
+    GET_COND(ch, DRUNK) = -1;
+  }
+  fclose(fl);
+  return(id);
+}
 
-      switch (*tag) {
-      case 'A':
-        if (!strcmp(tag, "Ac  "))	GET_AC(ch)		= atoi(line);
+/* Write the vital data of a player to the player file. */
+/* This is the ASCII Player Files save routine. */
+void save_char(struct char_data * ch)
+{
+  FILE *fl;
+  char filename[40];
+  int i, id, save_index = FALSE;
+  struct char_base_data base;
+
+  if (IS_NPC(ch) || GET_PFILEPOS(ch) < 0)
+    return;
+
+  /* If ch->desc is not null, then update session data before saving. */
+  if (ch->desc) {
+    if (*ch->desc->host) {
+      if (!GET_HOST(ch))
+        GET_HOST(ch) = strdup(ch->desc->host);
+      else if (GET_HOST(ch) && strcmp(GET_HOST(ch), ch->desc->host)) {
+        free(GET_HOST(ch));
+        GET_HOST(ch) = strdup(ch->desc->host);
+      }
+    }
+
+    /* Only update the time.played and time.logon if the character is playing. */
+    if (STATE(ch->desc) == CON_PLAYING) {
+      ch->player.time.played += time(0) - ch->player.time.logon;
+      ch->player.time.logon = time(0);
+    }
+  }
+
+  if (!get_filename(filename, sizeof(filename), PLR_FILE, GET_NAME(ch)))
+    return;
+  if (!(fl = saveq_open(filename))) {
+    mudlog(NRM, LVL_GOD, TRUE, "SYSERR: Couldn't open player file %s for write", filename);
+    return;
+  }
+
+  /* Save the raw values, as they are without eq or affects; otherwise the
+   * effects are doubled when the char logs back in. */
+  char_base_values(ch, &base);
+
+  if (CONFIG_BINARY_PFILES)
+    save_char_binary(fl, ch, &base);
+  else
+    save_char_ascii(fl, ch, &base);
+
+  saveq_commit(fl);
+  GET_SAVE_DIRTY(ch) &= ~SAVE_PFILE;
+  GET_LAST_SAVE(ch) = time(0);
+  journal_saved(ch, SAVE_STATS);
+
+  if ((id = get_ptable_by_name(GET_NAME(ch))) < 0)
+    return;
+
+  /* update the player in the player index */
+  if (player_table[id].level != GET_LEVEL(ch)) {
+    save_index = TRUE;
+    player_table[id].level = GET_LEVEL(ch);
+  }
+  if (player_table[id].last != ch->player.time.logon) {
+    save_index = TRUE;
+    player_table[id].last = ch->player.time.logon;
+  }
+  i = player_table[id].flags;
+  if (PLR_FLAGGED(ch, PLR_DELETED))
+    SET_BIT(player_table[id].flags, PINDEX_DELETED);
+  else
+    REMOVE_BIT(player_table[id].flags, PINDEX_DELETED);
+  if (PLR_FLAGGED(ch, PLR_NODELETE) || PLR_FLAGGED(ch, PLR_CRYO))
+    SET_BIT(player_table[id].flags, PINDEX_NODELETE);
+  else
+    REMOVE_BIT(player_table[id].flags, PINDEX_NODELETE);
+
+  if (PLR_FLAGGED(ch, PLR_FROZEN) || PLR_FLAGGED(ch, PLR_NOWIZLIST))
+    SET_BIT(player_table[id].flags, PINDEX_NOWIZLIST);
+  else
+    REMOVE_BIT(player_table[id].flags, PINDEX_NOWIZLIST);
+
+  if (player_table[id].flags != i || save_index)
+    save_player_index();
+}
+
+/* Read the tags of an ASCII player file into ch. */
+static void load_char_ascii(FILE *fl, struct char_data *ch, const char *name)
+{
+  int num = 0, num2 = 0, num3 = 0;
+  char buf[128], buf2[128], line[MAX_INPUT_LENGTH + 1], tag[6];
+  char f1[128], f2[128], f3[128], f4[128];
+  trig_data *t = NULL;
+  trig_rnum t_rnum = NOTHING;
+
+  while (get_line(fl, line)) {
+    tag_argument(line, tag);
+
+    switch (*tag) {
+    case 'A':
+      if (!strcmp(tag, "Ac  "))	GET_AC(ch)		= atoi(line);
 	else if (!strcmp(tag, "Act ")) {
-         if (sscanf(line, "%s %s %s %s", f1, f2, f3, f4) == 4) {
-          PLR_FLAGS(ch)[0] = asciiflag_conv(f1);
-          PLR_FLAGS(ch)[1] = asciiflag_conv(f2);
-          PLR_FLAGS(ch)[2] = asciiflag_conv(f3);
-          PLR_FLAGS(ch)[3] = asciiflag_conv(f4);
-        } else
-          PLR_FLAGS(ch)[0] = asciiflag_conv(line);
-      } else if (!strcmp(tag, "Aff ")) {
-        if (sscanf(line, "%s %s %s %s", f1, f2, f3, f4) == 4) {
-          AFF_FLAGS(ch)[0] = asciiflag_conv(f1);
-          AFF_FLAGS(ch)[1] = asciiflag_conv(f2);
-          AFF_FLAGS(ch)[2] = asciiflag_conv(f3);
-          AFF_FLAGS(ch)[3] = asciiflag_conv(f4);
-        } else
-          AFF_FLAGS(ch)[0] = asciiflag_conv(line);
+       if (sscanf(line, "%s %s %s %s", f1, f2, f3, f4) == 4) {
+        PLR_FLAGS(ch)[0] = asciiflag_conv(f1);
+        PLR_FLAGS(ch)[1] = asciiflag_conv(f2);
+        PLR_FLAGS(ch)[2] = asciiflag_conv(f3);
+        PLR_FLAGS(ch)[3] = asciiflag_conv(f4);
+      } else
+        PLR_FLAGS(ch)[0] = asciiflag_conv(line);
+    } else if (!strcmp(tag, "Aff ")) {
+      if (sscanf(line, "%s %s %s %s", f1, f2, f3, f4) == 4) {
+        AFF_FLAGS(ch)[0] = asciiflag_conv(f1);
+        AFF_FLAGS(ch)[1] = asciiflag_conv(f2);
+        AFF_FLAGS(ch)[2] = asciiflag_conv(f3);
+        AFF_FLAGS(ch)[3] = asciiflag_conv(f4);
+      } else
+        AFF_FLAGS(ch)[0] = asciiflag_conv(line);
 	}
 	if (!strcmp(tag, "Affs")) 	load_affects(fl, ch);
-        else if (!strcmp(tag, "Alin"))	GET_ALIGNMENT(ch)	= atoi(line);
+      else if (!strcmp(tag, "Alin"))	GET_ALIGNMENT(ch)	= atoi(line);
 	else if (!strcmp(tag, "Alis"))	read_aliases_ascii(fl, ch, atoi(line));
 	break;
 
-      case 'B':
+    case 'B':
 	     if (!strcmp(tag, "Badp"))	GET_BAD_PWS(ch)		= atoi(line);
 	else if (!strcmp(tag, "Bank"))	GET_BANK_GOLD(ch)	= atoi(line);
 	else if (!strcmp(tag, "Brth"))	ch->player.time.birth	= atol(line);
 	break;
 
-    case 'C':
-  if (!strcmp(tag, "Cha "))     ch->real_abils.cha = atoi(line);
-  else if (!strcmp(tag, "Clas")) GET_CLASS(ch) = atoi(line);
-  else if (!strcmp(tag, "Con ")) ch->real_abils.con = atoi(line);
-  else if (!strcmp(tag, "CSlt")) GET_BASE_CARRY_SLOTS(ch) = atoi(line); 
-    break;
+  case 'C':
+if (!strcmp(tag, "Cha "))     ch->real_abils.cha = atoi(line);
+else if (!strcmp(tag, "Clas")) GET_CLASS(ch) = atoi(line);
+else if (!strcmp(tag, "Con ")) ch->real_abils.con = atoi(line);
+else if (!strcmp(tag, "CSlt")) GET_BASE_CARRY_SLOTS(ch) = atoi(line); 
+  break;
 
-      case 'D':
+    case 'D':
 	     if (!strcmp(tag, "Desc"))	ch->player.description	= fread_string(fl, buf2);
 	else if (!strcmp(tag, "Dex "))	ch->real_abils.dex	= atoi(line);
 	else if (!strcmp(tag, "Drnk"))	GET_COND(ch, DRUNK)	= atoi(line);
 	else if (!strcmp(tag, "Drol"))	GET_DAMROLL(ch)		= atoi(line);
-  else if (!strcmp(tag, "Deaths")) {
-          GET_DEATHS(ch) = atoi(line);
-          if (GET_DEATHS(ch) < 0)
-            GET_DEATHS(ch) = 0; /* Prevent negative deaths */
-    }
+else if (!strcmp(tag, "Deaths")) {
+        GET_DEATHS(ch) = atoi(line);
+        if (GET_DEATHS(ch) < 0)
+          GET_DEATHS(ch) = 0; /* Prevent negative deaths */
+  }
 	break;
 
-      case 'E':
+    case 'E':
 	     if (!strcmp(tag, "Exp "))	GET_EXP(ch)		= atoi(line);
 	break;
 
-      case 'F':
+    case 'F':
 	     if (!strcmp(tag, "Frez"))	GET_FREEZE_LEV(ch)	= atoi(line);
 	break;
 
-      case 'G':
+    case 'G':
 	     if (!strcmp(tag, "Gold"))	GET_GOLD(ch)		= atoi(line);
 	break;
 
-      case 'H':
+    case 'H':
 	     if (!strcmp(tag, "Hit "))	load_HMVS(ch, line, LOAD_HIT);
 	else if (!strcmp(tag, "Hite"))	GET_HEIGHT(ch)		= atoi(line);
-        else if (!strcmp(tag, "Host")) {
-          if (GET_HOST(ch))
-            free(GET_HOST(ch));
-          GET_HOST(ch) = strdup(line);
-        }
-        else if (!strcmp(tag, "Hrol"))	GET_HITROLL(ch)		= atoi(line);
+      else if (!strcmp(tag, "Host")) {
+        if (GET_HOST(ch))
+          free(GET_HOST(ch));
+        GET_HOST(ch) = strdup(line);
+      }
+      else if (!strcmp(tag, "Hrol"))	GET_HITROLL(ch)		= atoi(line);
 	else if (!strcmp(tag, "Hung"))	GET_COND(ch, HUNGER)	= atoi(line);
 	break;
 
-      case 'I':
+    case 'I':
 	     if (!strcmp(tag, "Id  "))	GET_IDNUM(ch)		= atol(line);
 	else if (!strcmp(tag, "Int "))	ch->real_abils.intel	= atoi(line);
 	else if (!strcmp(tag, "Invs"))	GET_INVIS_LEV(ch)	= atoi(line);
 	break;
-      case 'K':
-        if(!strcmp(tag, "Kamt")) {
-          num = 0;
+    case 'K':
+      if(!strcmp(tag, "Kamt")) {
+        num = 0;
 	  do {
 	    get_line(fl, line);
-            sscanf(line, "%d %d", &num2, &num3);
-            if(num2 != -1)
-              kill_add(ch, num2, num3, TRUE);
-            num++;
-          } while ((num2 != -1) && (num != MAX_KILL_MEMORY) 
-           && (num3 != 0) && (num2 != MAX_KILL_MEMORY));
+          sscanf(line, "%d %d", &num2, &num3);
+          if(num2 != -1)
+            kill_add(ch, num2, num3, TRUE);
+          num++;
+        } while ((num2 != -1) && (num != MAX_KILL_MEMORY) 
+         && (num3 != 0) && (num2 != MAX_KILL_MEMORY));
 	} else if(!strcmp(tag, "Knum")) {
 	  do {
 	    get_line(fl, line);
 	    sscanf(line, "%d %d", &num, &num2);
-    } while (num != (MAX_KILL_MEMORY) && (num2 != 50) && (num3 != 0));
+  } while (num != (MAX_KILL_MEMORY) && (num2 != 50) && (num3 != 0));
 	}
-          else if (!strcmp(tag, "KillsTotal")) {
-          GET_KILLS_TOTAL(ch) = atoi(line);
-        }
-        else if (!strcmp(tag, "KillsLegit")) {
-          GET_KILLS_LEGIT_TOTAL(ch) = atoi(line);
-        }
-        else if (!strcmp(tag, "KillsUnique")) {
-          GET_KILLS_UNIQUE_MOBS(ch) = atoi(line);
-        }
-    break;
-      case 'L':
+        else if (!strcmp(tag, "KillsTotal")) {
+        GET_KILLS_TOTAL(ch) = atoi(line);
+      }
+      else if (!strcmp(tag, "KillsLegit")) {
+        GET_KILLS_LEGIT_TOTAL(ch) = atoi(line);
+      }
+      else if (!strcmp(tag, "KillsUnique")) {
+        GET_KILLS_UNIQUE_MOBS(ch) = atoi(line);
+      }
+  break;
+    case 'L':
 	     if (!strcmp(tag, "Last"))	ch->player.time.logon	= atol(line);
-  else if (!strcmp(tag, "Lern"))	GET_PRACTICES(ch)	= atoi(line);
+else if (!strcmp(tag, "Lern"))	GET_PRACTICES(ch)	= atoi(line);
 	else if (!strcmp(tag, "Levl"))	GET_LEVEL(ch)		= atoi(line);
-        else if (!strcmp(tag, "Lmot"))   GET_LAST_MOTD(ch)   = atoi(line);
-        else if (!strcmp(tag, "Lnew"))   GET_LAST_NEWS(ch)   = atoi(line);
+      else if (!strcmp(tag, "Lmot"))   GET_LAST_MOTD(ch)   = atoi(line);
+      else if (!strcmp(tag, "Lnew"))   GET_LAST_NEWS(ch)   = atoi(line);
 	break;
 
-      case 'M':
+    case 'M':
 	     if (!strcmp(tag, "Mana"))	load_HMVS(ch, line, LOAD_MANA);
 	else if (!strcmp(tag, "Move"))	load_HMVS(ch, line, LOAD_MOVE);
 	break;
 
-      case 'N':
+    case 'N':
 	     if (!strcmp(tag, "Name"))	GET_PC_NAME(ch)	= strdup(line);
 	break;
 
-      case 'O':
-       if (!strcmp(tag, "Olc "))  GET_OLC_ZONE(ch) = atoi(line);
-  break;
-
-      case 'P':
-        if (!strcmp(tag, "PVer")) ch->player_specials->saved.pfile_version = atoi(line);
-        else if (!strcmp(tag, "Page"))  GET_PAGE_LENGTH(ch) = atoi(line);
-        else if (!strcmp(tag, "Pass"))	strcpy(GET_PASSWD(ch), line);
-        else if (!strcmp(tag, "Plyd"))	ch->player.time.played	= atoi(line);
-        else if (!strcmp(tag, "PfIn"))	POOFIN(ch)		= strdup(line);
-        else if (!strcmp(tag, "PfOt"))	POOFOUT(ch)		= strdup(line);
-        else if (!strcmp(tag, "Pref")) {
-          if (sscanf(line, "%s %s %s %s", f1, f2, f3, f4) == 4) {
-            PRF_FLAGS(ch)[0] = asciiflag_conv(f1);
-            PRF_FLAGS(ch)[1] = asciiflag_conv(f2);
-            PRF_FLAGS(ch)[2] = asciiflag_conv(f3);
-            PRF_FLAGS(ch)[3] = asciiflag_conv(f4);
-          } else
+    case 'O':
+     if (!strcmp(tag, "Olc "))  GET_OLC_ZONE(ch) = atoi(line);
+break;
+
+    case 'P':
+      if (!strcmp(tag, "PVer")) ch->player_specials->saved.pfile_version = atoi(line);
+      else if (!strcmp(tag, "Page"))  GET_PAGE_LENGTH(ch) = atoi(line);
+      else if (!strcmp(tag, "Pass"))	strcpy(GET_PASSWD(ch), line);
+      else if (!strcmp(tag, "Plyd"))	ch->player.time.played	= atoi(line);
+      else if (!strcmp(tag, "PfIn"))	POOFIN(ch)		= strdup(line);
+      else if (!strcmp(tag, "PfOt"))	POOFOUT(ch)		= strdup(line);
+      else if (!strcmp(tag, "Pref")) {
+        if (sscanf(line, "%s %s %s %s", f1, f2, f3, f4) == 4) {
+          PRF_FLAGS(ch)[0] = asciiflag_conv(f1);
+          PRF_FLAGS(ch)[1] = asciiflag_conv(f2);
+          PRF_FLAGS(ch)[2] = asciiflag_conv(f3);
+          PRF_FLAGS(ch)[3] = asciiflag_conv(f4);
+        } else
 	    PRF_FLAGS(ch)[0] = asciiflag_conv(f1);
-        }
-        break;
+      }
+      break;
 
 
-      case 'Q':
+    case 'Q':
 	     if (!strcmp(tag, "Qstp"))  GET_QUESTPOINTS(ch)     = atoi(line);
-       else if (!strcmp(tag, "Qpnt")) GET_QUESTPOINTS(ch) = atoi(line); /* Backward compatibility */
-       else if (!strcmp(tag, "Qcur")) GET_QUEST(ch) = atoi(line);
-       else if (!strcmp(tag, "Qcnt")) GET_QUEST_COUNTER(ch) = atoi(line);
-       else if (!strcmp(tag, "Qest")) load_quests(fl, ch);
-        break;
+     else if (!strcmp(tag, "Qpnt")) GET_QUESTPOINTS(ch) = atoi(line); /* Backward compatibility */
+     else if (!strcmp(tag, "Qcur")) GET_QUEST(ch) = atoi(line);
+     else if (!strcmp(tag, "Qcnt")) GET_QUEST_COUNTER(ch) = atoi(line);
+     else if (!strcmp(tag, "Qest")) load_quests(fl, ch);
+      break;
 
-      case 'R':
+    case 'R':
 	     if (!strcmp(tag, "Room"))	GET_LOADROOM(ch)	= atoi(line);
 	break;
 
-      case 'S':
+    case 'S':
 	     if (!strcmp(tag, "Sex "))	GET_SEX(ch)		= atoi(line);
-  else if (!strcmp(tag, "ScrW"))  GET_SCREEN_WIDTH(ch) = atoi(line);
+else if (!strcmp(tag, "ScrW"))  GET_SCREEN_WIDTH(ch) = atoi(line);
 	else if (!strcmp(tag, "Skil"))	load_skills(fl, ch);
 	else if (!strcmp(tag, "Str "))	load_HMVS(ch, line, LOAD_STRENGTH);
 	break;
 
-      case 'T':
-        if (!strcmp(tag, "Thir"))
-          GET_COND(ch, THIRST) = atoi(line);
-        else if (!strcmp(tag, "Titl"))
-        {
-          GET_TITLE(ch) = strdup(line);
-          if (!GET_TITLE(ch) || !*GET_TITLE(ch))
-            GET_TITLE(ch) = strdup("");
-        }
-        else if (!strcmp(tag, "Trig") && CONFIG_SCRIPT_PLAYERS) {
-          if ((t_rnum = real_trigger(atoi(line))) != NOTHING) {
-            t = read_trigger(t_rnum);
-            if (!SCRIPT(ch))
-              CREATE(SCRIPT(ch), struct script_data, 1);
-            add_trigger(SCRIPT(ch), t, -1);
-          }
+    case 'T':
+      if (!strcmp(tag, "Thir"))
+        GET_COND(ch, THIRST) = atoi(line);
+      else if (!strcmp(tag, "Titl"))
+      {
+        GET_TITLE(ch) = strdup(line);
+        if (!GET_TITLE(ch) || !*GET_TITLE(ch))
+          GET_TITLE(ch) = strdup("");
+      }
+      else if (!strcmp(tag, "Trig") && CONFIG_SCRIPT_PLAYERS) {
+        if ((t_rnum = real_trigger(atoi(line))) != NOTHING) {
+          t = read_trigger(t_rnum);
+          if (!SCRIPT(ch))
+            CREATE(SCRIPT(ch), struct script_data, 1);
+          add_trigger(SCRIPT(ch), t, -1);
         }
-        else if (!strcmp(tag, "MagR"))
-          GET_MAGIC_RESISTANCE(ch) = atoi(line);
-        else if (!strcmp(tag, "EleR"))
-          GET_ELEMENTAL_RESISTANCE(ch) = atoi(line);
-        break;
+      }
+      else if (!strcmp(tag, "MagR"))
+        GET_MAGIC_RESISTANCE(ch) = atoi(line);
+      else if (!strcmp(tag, "EleR"))
+        GET_ELEMENTAL_RESISTANCE(ch) = atoi(line);
+      break;
 
-      case 'V':
+    case 'V':
 	     if (!strcmp(tag, "Vars"))	read_saved_vars_ascii(fl, ch, atoi(line));
-      break;
+    break;
 
-      case 'W':
+    case 'W':
 	     if (!strcmp(tag, "Wate"))	GET_WEIGHT(ch)		= atoi(line);
 	else if (!strcmp(tag, "Wimp"))	GET_WIMP_LEV(ch)	= atoi(line);
 	else if (!strcmp(tag, "Wis "))	ch->real_abils.wis	= atoi(line);
 	break;
-      case 'Z':
-        if (!strcmp(tag, "Zonedisc")) {
-          for (int i = 0; i < ZONE_FLAG_BYTES; i++) {
-          unsigned int byte;
-            if (sscanf(line + i * 2, "%02X", &byte) != 1) {
-            mudlog(NRM, LVL_GOD, TRUE, "SYSERR: Error parsing discovered zone byte %d in pfile %s", i, name);
-            byte = 0;
-          }
-        ch->player_specials->saved.discovered_zones[i] = (uint8_t)byte;
-      }
-    }
-        else if (!strcmp(tag, "Zonesdisc")) {
-        GET_ZONES_DISCOVERED(ch) = atoi(line);
-        if (GET_ZONES_DISCOVERED(ch) < 0)
-        GET_ZONES_DISCOVERED(ch) = 0; // safety
-    }
-  break;
-      default:
-	sprintf(buf, "SYSERR: Unknown tag %s in pfile %s", tag, name);
-      }
+    case 'Z':
+      if (!strcmp(tag, "Zonedisc")) {
+        for (int i = 0; i < ZONE_FLAG_BYTES; i++) {
+        unsigned int byte;
+          if (sscanf(line + i * 2, "%02X", &byte) != 1) {
+          mudlog(NRM, LVL_GOD, TRUE, "SYSERR: Error parsing discovered zone byte %d in pfile %s", i, name);
+          byte = 0;
+        }
+      ch->player_specials->saved.discovered_zones[i] = (uint8_t)byte;
     }
   }
-
-  if (GET_PFILE_VERSION(ch) < PFILE_VERSION) {
-  migrate_player(ch, GET_PFILE_VERSION(ch));
+      else if (!strcmp(tag, "Zonesdisc")) {
+      GET_ZONES_DISCOVERED(ch) = atoi(line);
+      if (GET_ZONES_DISCOVERED(ch) < 0)
+      GET_ZONES_DISCOVERED(ch) = 0; // safety
   }
-
-  affect_total(ch);
-
-  /* initialization for imms */
-  if (GET_LEVEL(ch) >= LVL_IMMORT) {
-    for (i = 1; i <= MAX_SKILLS; i++)
-      GET_SKILL(ch, i) = 100;
-    GET_COND(ch, HUNGER) = -1;
-    GET_COND(ch, THIRST) = -1;
-    GET_COND(ch, DRUNK) = -1;
+break;
+    default:
+	sprintf(buf, "SYSERR: Unknown tag %s in pfile %s", tag, name);
+    }
   }
-  fclose(fl);
-  return(id);
 }
 
-/* Write the vital data of a player to the player file. */
-/* This is the ASCII Player Files save routine. */
-void save_char(struct char_data * ch)
+/* Write ch to an ASCII player file, with base holding the values that go
+ * into it unchanged by equipment and affects. */
+static void save_char_ascii(FILE *fl, struct char_data *ch, const struct char_base_data *base)
 {
-  FILE *fl;
-  char filename[40], buf[MAX_STRING_LENGTH], bits[127], bits2[127], bits3[127], bits4[127];
-  int i, j, id, save_index = FALSE;
-  struct affected_type *aff, tmp_aff[MAX_AFFECT];
-  struct obj_data *char_eq[NUM_WEARS];
+  char buf[MAX_STRING_LENGTH], bits[127], bits2[127], bits3[127], bits4[127];
+  int i;
+  struct affected_type *aff;
   struct kill_node *kill = NULL, *next_kill = NULL;
   trig_data *t;
 
-  if (IS_NPC(ch) || GET_PFILEPOS(ch) < 0)
-    return;
-
-  /* If ch->desc is not null, then update session data before saving. */
-  if (ch->desc) {
-    if (*ch->desc->host) {
-      if (!GET_HOST(ch))
-        GET_HOST(ch) = strdup(ch->desc->host);
-      else if (GET_HOST(ch) && strcmp(GET_HOST(ch), ch->desc->host)) {
-        free(GET_HOST(ch));
-        GET_HOST(ch) = strdup(ch->desc->host);
-      }
-    }
-
-    /* Only update the time.played and time.logon if the character is playing. */
-    if (STATE(ch->desc) == CON_PLAYING) {
-      ch->player.time.played += time(0) - ch->player.time.logon;
-      ch->player.time.logon = time(0);
-    }
-  }
-
-  if (!get_filename(filename, sizeof(filename), PLR_FILE, GET_NAME(ch)))
-    return;
-  if (!(fl = fopen(filename, "w"))) {
-    mudlog(NRM, LVL_GOD, TRUE, "SYSERR: Couldn't open player file %s for write", filename);
-    return;
-  }
-
-  /* Unaffect everything a character can be affected by. */
-  for (i = 0; i < NUM_WEARS; i++) {
-    if (GET_EQ(ch, i)) {
-      char_eq[i] = unequip_char(ch, i);
-#ifndef NO_EXTRANEOUS_TRIGGERS
-      remove_otrigger(char_eq[i], ch);
-#endif
-    }
-    else
-      char_eq[i] = NULL;
-  }
-
-  for (aff = ch->affected, i = 0; i < MAX_AFFECT; i++) {
-    if (aff) {
-      tmp_aff[i] = *aff;
-      for (j=0; j<AF_ARRAY_MAX; j++)
-        tmp_aff[i].bitvector[j] = aff->bitvector[j];
-      tmp_aff[i].next = 0;
-      aff = aff->next;
-    } else {
-      new_affect(&(tmp_aff[i]));
-      tmp_aff[i].next = 0;
-    }
-  }
-
-  /* Remove the affections so that the raw values are stored; otherwise the
-   * effects are doubled when the char logs back in. */
-
-  while (ch->affected)
-    affect_remove(ch, ch->affected);
-
-  if ((i >= MAX_AFFECT) && aff && aff->next)
-    log("SYSERR: WARNING: OUT OF STORE ROOM FOR AFFECTED TYPES!!!");
-
-  ch->aff_abils = ch->real_abils;
-  /* end char_to_store code */
-
   if (GET_NAME(ch))				  fprintf(fl, "Name: %s\n", GET_NAME(ch));
                             fprintf(fl, "PVer: %d\n", GET_PFILE_VERSION(ch));
   if (GET_PASSWD(ch))				fprintf(fl, "Pass: %s\n", GET_PASSWD(ch));
@@ -667,7 +851,7 @@ void save_char(struct char_data * ch)
   if (GET_LEVEL(ch)	   != PFDEF_LEVEL)	fprintf(fl, "Levl: %d\n", GET_LEVEL(ch));
 
   fprintf(fl, "Id  : %ld\n", GET_IDNUM(ch));
-  fprintf(fl, "Brth: %ld\n", (long)ch->player.time.birth);
+  fprintf(fl, "Brth: %ld\n", (long)base->birth);
   fprintf(fl, "Plyd: %d\n",  ch->player.time.played);
   fprintf(fl, "Last: %ld\n", (long)ch->player.time.logon);
 
@@ -677,8 +861,8 @@ void save_char(struct char_data * ch)
     fprintf(fl, "Lnew: %d\n", (int)GET_LAST_NEWS(ch));
 
   if (GET_HOST(ch))				fprintf(fl, "Host: %s\n", GET_HOST(ch));
-  if (GET_HEIGHT(ch)	   != PFDEF_HEIGHT)	fprintf(fl, "Hite: %d\n", GET_HEIGHT(ch));
-  if (GET_WEIGHT(ch)	   != PFDEF_WEIGHT)	fprintf(fl, "Wate: %d\n", GET_WEIGHT(ch));
+  if (base->height	   != PFDEF_HEIGHT)	fprintf(fl, "Hite: %d\n", base->height);
+  if (base->weight	   != PFDEF_WEIGHT)	fprintf(fl, "Wate: %d\n", base->weight);
   if (GET_ALIGNMENT(ch)  != PFDEF_ALIGNMENT)	fprintf(fl, "Alin: %d\n", GET_ALIGNMENT(ch));
 
 
@@ -689,10 +873,10 @@ void save_char(struct char_data * ch)
   sprintascii(bits4, PLR_FLAGS(ch)[3]);
   fprintf(fl, "Act : %s %s %s %s\n", bits, bits2, bits3, bits4);
 
-  sprintascii(bits,  AFF_FLAGS(ch)[0]);
-  sprintascii(bits2, AFF_FLAGS(ch)[1]);
-  sprintascii(bits3, AFF_FLAGS(ch)[2]);
-  sprintascii(bits4, AFF_FLAGS(ch)[3]);
+  sprintascii(bits,  base->affected_by[0]);
+  sprintascii(bits2, base->affected_by[1]);
+  sprintascii(bits3, base->affected_by[2]);
+  sprintascii(bits4, base->affected_by[3]);
   fprintf(fl, "Aff : %s %s %s %s\n", bits, bits2, bits3, bits4);
 
   sprintascii(bits,  PRF_FLAGS(ch)[0]);
@@ -701,10 +885,10 @@ void save_char(struct char_data * ch)
   sprintascii(bits4, PRF_FLAGS(ch)[3]);
   fprintf(fl, "Pref: %s %s %s %s\n", bits, bits2, bits3, bits4);
 
-  if (GET_MAGIC_RESISTANCE(ch) != 0)
-    fprintf(fl, "MagR: %d\n", GET_MAGIC_RESISTANCE(ch));
-  if (GET_ELEMENTAL_RESISTANCE(ch) != 0)
-    fprintf(fl, "EleR: %d\n", GET_ELEMENTAL_RESISTANCE(ch));
+  if (base->magic_resistance != 0)
+    fprintf(fl, "MagR: %d\n", base->magic_resistance);
+  if (base->elemental_resistance != 0)
+    fprintf(fl, "EleR: %d\n", base->elemental_resistance);
 
       /* Kill List -Thanks Cyric --Eko */
   	  fprintf(fl, "Kamt:\n");
@@ -726,25 +910,25 @@ void save_char(struct char_data * ch)
   if (GET_COND(ch, THIRST) != PFDEF_THIRST && GET_LEVEL(ch) < LVL_IMMORT) fprintf(fl, "Thir: %d\n", GET_COND(ch, THIRST));
   if (GET_COND(ch, DRUNK)  != PFDEF_DRUNK  && GET_LEVEL(ch) < LVL_IMMORT) fprintf(fl, "Drnk: %d\n", GET_COND(ch, DRUNK));
 
-  if (GET_HIT(ch)	   != PFDEF_HIT  || GET_MAX_HIT(ch)  != PFDEF_MAXHIT)  fprintf(fl, "Hit : %d/%d\n", GET_HIT(ch),  GET_MAX_HIT(ch));
-  if (GET_MANA(ch)	   != PFDEF_MANA || GET_MAX_MANA(ch) != PFDEF_MAXMANA) fprintf(fl, "Mana: %d/%d\n", GET_MANA(ch), GET_MAX_MANA(ch));
-  if (GET_MOVE(ch)	   != PFDEF_MOVE || GET_MAX_MOVE(ch) != PFDEF_MAXMOVE) fprintf(fl, "Move: %d/%d\n", GET_MOVE(ch), GET_MAX_MOVE(ch));
+  if (GET_HIT(ch)	   != PFDEF_HIT  || base->points.max_hit  != PFDEF_MAXHIT)  fprintf(fl, "Hit : %d/%d\n", GET_HIT(ch),  base->points.max_hit);
+  if (GET_MANA(ch)	   != PFDEF_MANA || base->points.max_mana != PFDEF_MAXMANA) fprintf(fl, "Mana: %d/%d\n", GET_MANA(ch), base->points.max_mana);
+  if (GET_MOVE(ch)	   != PFDEF_MOVE || base->points.max_move != PFDEF_MAXMOVE) fprintf(fl, "Move: %d/%d\n", GET_MOVE(ch), base->points.max_move);
 
-  if (GET_STR(ch)	   != PFDEF_STR  || GET_ADD(ch)      != PFDEF_STRADD)  fprintf(fl, "Str : %d/%d\n", GET_STR(ch),  GET_ADD(ch));
+  if (base->abils.str	   != PFDEF_STR  || base->abils.str_add != PFDEF_STRADD)  fprintf(fl, "Str : %d/%d\n", base->abils.str,  base->abils.str_add);
 
 
-  if (GET_INT(ch)	   != PFDEF_INT)	fprintf(fl, "Int : %d\n", GET_INT(ch));
-  if (GET_WIS(ch)	   != PFDEF_WIS)	fprintf(fl, "Wis : %d\n", GET_WIS(ch));
-  if (GET_DEX(ch)	   != PFDEF_DEX)	fprintf(fl, "Dex : %d\n", GET_DEX(ch));
-  if (GET_CON(ch)	   != PFDEF_CON)	fprintf(fl, "Con : %d\n", GET_CON(ch));
-  if (GET_CHA(ch)	   != PFDEF_CHA)	fprintf(fl, "Cha : %d\n", GET_CHA(ch));
+  if (base->abils.intel	   != PFDEF_INT)	fprintf(fl, "Int : %d\n", base->abils.intel);
+  if (base->abils.wis	   != PFDEF_WIS)	fprintf(fl, "Wis : %d\n", base->abils.wis);
+  if (base->abils.dex	   != PFDEF_DEX)	fprintf(fl, "Dex : %d\n", base->abils.dex);
+  if (base->abils.con	   != PFDEF_CON)	fprintf(fl, "Con : %d\n", base->abils.con);
+  if (base->abils.cha	   != PFDEF_CHA)	fprintf(fl, "Cha : %d\n", base->abils.cha);
 
-  if (GET_AC(ch)	   != PFDEF_AC)		fprintf(fl, "Ac  : %d\n", GET_AC(ch));
+  if (base->points.armor	   != PFDEF_AC)		fprintf(fl, "Ac  : %d\n", base->points.armor);
   if (GET_GOLD(ch)	   != PFDEF_GOLD)	fprintf(fl, "Gold: %ld\n", GET_GOLD(ch));
   if (GET_BANK_GOLD(ch)	   != PFDEF_BANK)	fprintf(fl, "Bank: %ld\n", GET_BANK_GOLD(ch));
   if (GET_EXP(ch)	   != PFDEF_EXP)	fprintf(fl, "Exp : %ld\n", GET_EXP(ch));
-  if (GET_HITROLL(ch)	   != PFDEF_HITROLL)	fprintf(fl, "Hrol: %d\n", GET_HITROLL(ch));
-  if (GET_DAMROLL(ch)	   != PFDEF_DAMROLL)	fprintf(fl, "Drol: %d\n", GET_DAMROLL(ch));
+  if (base->points.hitroll   != PFDEF_HITROLL)	fprintf(fl, "Hrol: %d\n", base->points.hitroll);
+  if (base->points.damroll   != PFDEF_DAMROLL)	fprintf(fl, "Drol: %d\n", base->points.damroll);
   if (GET_OLC_ZONE(ch)     != PFDEF_OLC)        fprintf(fl, "Olc : %d\n", GET_OLC_ZONE(ch));
   if (GET_PAGE_LENGTH(ch)  != PFDEF_PAGELENGTH) fprintf(fl, "Page: %d\n", GET_PAGE_LENGTH(ch));
   if (GET_SCREEN_WIDTH(ch) != PFDEF_SCREENWIDTH) fprintf(fl, "ScrW: %d\n", GET_SCREEN_WIDTH(ch));
@@ -798,70 +982,506 @@ void save_char(struct char_data * ch)
   }
 
   /* Save affects */
-  if (tmp_aff[0].spell > 0) {
+  if (ch->affected && ch->affected->spell > 0) {
     fprintf(fl, "Affs:\n");
-    for (i = 0; i < MAX_AFFECT; i++) {
-      aff = &tmp_aff[i];
+    for (aff = ch->affected, i = 0; aff && i < MAX_AFFECT; aff = aff->next, i++) {
       if (aff->spell)
 		fprintf(fl, "%d %d %d %d %d %d %d %d\n", aff->spell, aff->duration,
           aff->modifier, aff->location, aff->bitvector[0], aff->bitvector[1], aff->bitvector[2], aff->bitvector[3]);
     }
     fprintf(fl, "0 0 0 0 0 0 0 0\n");
+    if (aff)
+      log("SYSERR: WARNING: OUT OF STORE ROOM FOR AFFECTED TYPES!!!");
   }
 
   write_aliases_ascii(fl, ch);
   save_char_vars_ascii(fl, ch);
+}
 
-  fclose(fl);
+/* Binary player files. The layout is in pfbinary.h; these read and write
+ * one in a single pass over a buffer, without parsing any text. */
+
+static const int pfb_width[NUM_PFB_SCALARS] = {
+#define PFB_WIDTH(field, tag, width, def, kind) width,
+  PFB_SCALARS(PFB_WIDTH)
+#undef PFB_WIDTH
+};
+
+static const long long pfb_default[NUM_PFB_SCALARS] = {
+#define PFB_DEFAULT(field, tag, width, def, kind) def,
+  PFB_SCALARS(PFB_DEFAULT)
+#undef PFB_DEFAULT
+};
+
+/* The buffer a binary player file is built in. It is kept between saves. */
+static struct bin_buf pfb_buf;
+
+/* Start a section and its entry count; pfb_end() fills both in. */
+static size_t pfb_begin(int section)
+{
+  size_t start;
+
+  bin_put(&pfb_buf, section, 1);
+  start = pfb_buf.len;
+  bin_put(&pfb_buf, 0, 4);
+  bin_put(&pfb_buf, 0, 2);
+  return (start);
+}
+
+static void pfb_end(size_t start, int count)
+{
+  bin_patch(&pfb_buf, start, pfb_buf.len - start - 4, 4);
+  bin_patch(&pfb_buf, start + 4, count, 2);
+}
+
+/* Add one PFB_TXT_ string to the text section, counting it in *count. */
+static void pfb_text(int which, const char *text, int *count)
+{
+  if (!text)
+    return;
+  bin_put(&pfb_buf, which, 1);
+  bin_put_str(&pfb_buf, text, 4);
+  (*count)++;
+}
+
+/* Write ch to a binary player file, with base holding the values that go
+ * into it unchanged by equipment and affects. */
+static void save_char_binary(FILE *fl, struct char_data *ch, const struct char_base_data *base)
+{
+  long long val[NUM_PFB_SCALARS];
+  struct affected_type *aff;
+  struct alias_data *alias;
+  struct kill_node *kill;
+  struct trig_var_data *var;
+  trig_data *t;
+  size_t sec;
+  int i, count;
+
+  val[PFB_PVER] = GET_PFILE_VERSION(ch);
+  val[PFB_SEX] = GET_SEX(ch);
+  val[PFB_CLASS] = GET_CLASS(ch);
+  val[PFB_LEVEL] = GET_LEVEL(ch);
+  val[PFB_ID] = GET_IDNUM(ch);
+  val[PFB_BIRTH] = base->birth;
+  val[PFB_PLAYED] = ch->player.time.played;
+  val[PFB_LOGON] = ch->player.time.logon;
+  val[PFB_LMOT] = GET_LAST_MOTD(ch);
+  val[PFB_LNEW] = GET_LAST_NEWS(ch);
+  val[PFB_HEIGHT] = base->height;
+  val[PFB_WEIGHT] = base->weight;
+  val[PFB_ALIGN] = GET_ALIGNMENT(ch);
+  for (i = 0; i < 4; i++) {
+    val[PFB_ACT + i] = PLR_FLAGS(ch)[i];
+    val[PFB_AFF + i] = base->affected_by[i];
+    val[PFB_PREF + i] = PRF_FLAGS(ch)[i];
+  }
+  val[PFB_MAGR] = base->magic_resistance;
+  val[PFB_ELER] = base->elemental_resistance;
+  val[PFB_WIMP] = GET_WIMP_LEV(ch);
+  val[PFB_FREZ] = GET_FREEZE_LEV(ch);
+  val[PFB_INVS] = GET_INVIS_LEV(ch);
+  val[PFB_ROOM] = GET_LOADROOM(ch);
+  val[PFB_BADP] = GET_BAD_PWS(ch);
+  val[PFB_LERN] = GET_PRACTICES(ch);
+  /* As in ASCII files, immortals always come back with default conditions. */
+  val[PFB_HUNG] = GET_LEVEL(ch) < LVL_IMMORT ? GET_COND(ch, HUNGER) : PFDEF_HUNGER;
+  val[PFB_THIR] = GET_LEVEL(ch) < LVL_IMMORT ? GET_COND(ch, THIRST) : PFDEF_THIRST;
+  val[PFB_DRNK] = GET_LEVEL(ch) < LVL_IMMORT ? GET_COND(ch, DRUNK) : PFDEF_DRUNK;
+  val[PFB_HIT] = GET_HIT(ch);
+  val[PFB_MAXHIT] = base->points.max_hit;
+  val[PFB_MANA] = GET_MANA(ch);
+  val[PFB_MAXMANA] = base->points.max_mana;
+  val[PFB_MOVE] = GET_MOVE(ch);
+  val[PFB_MAXMOVE] = base->points.max_move;
+  val[PFB_STR] = base->abils.str;
+  val[PFB_STRADD] = base->abils.str_add;
+  val[PFB_INT] = base->abils.intel;
+  val[PFB_WIS] = base->abils.wis;
+  val[PFB_DEX] = base->abils.dex;
+  val[PFB_CON] = base->abils.con;
+  val[PFB_CHA] = base->abils.cha;
+  val[PFB_AC] = base->points.armor;
+  val[PFB_GOLD] = GET_GOLD(ch);
+  val[PFB_BANK] = GET_BANK_GOLD(ch);
+  val[PFB_EXP] = GET_EXP(ch);
+  val[PFB_HROL] = base->points.hitroll;
+  val[PFB_DROL] = base->points.damroll;
+  val[PFB_OLC] = GET_OLC_ZONE(ch);
+  val[PFB_PAGE] = GET_PAGE_LENGTH(ch);
+  val[PFB_SCRW] = GET_SCREEN_WIDTH(ch);
+  val[PFB_QSTP] = GET_QUESTPOINTS(ch);
+  val[PFB_QCNT] = GET_QUEST_COUNTER(ch);
+  val[PFB_QCUR] = GET_QUEST(ch);
+  val[PFB_KTOTAL] = GET_KILLS_TOTAL(ch);
+  val[PFB_KLEGIT] = GET_KILLS_LEGIT_TOTAL(ch);
+  val[PFB_KUNIQUE] = GET_KILLS_UNIQUE_MOBS(ch);
+  val[PFB_DEATHS] = GET_DEATHS(ch);
+  val[PFB_CSLT] = GET_BASE_CARRY_SLOTS(ch);
+  val[PFB_ZONESDISC] = GET_ZONES_DISCOVERED(ch);
+
+  pfb_buf.len = 0;
+  bin_put_bytes(&pfb_buf, PFB_MAGIC, PFB_MAGIC_LEN);
+  bin_put(&pfb_buf, PFB_VERSION, 2);
+
+  sec = pfb_begin(PFB_SEC_SCALARS);
+  for (i = 0; i < NUM_PFB_SCALARS; i++)
+    bin_put(&pfb_buf, val[i], pfb_width[i]);
+  pfb_end(sec, NUM_PFB_SCALARS);
+
+  sec = pfb_begin(PFB_SEC_TEXT);
+  count = 0;
+  pfb_text(PFB_TXT_NAME, GET_NAME(ch), &count);
+  pfb_text(PFB_TXT_PASSWD, GET_PASSWD(ch), &count);
+  pfb_text(PFB_TXT_TITLE, GET_TITLE(ch), &count);
+  pfb_text(PFB_TXT_DESC, ch->player.description, &count);
+  pfb_text(PFB_TXT_POOFIN, POOFIN(ch), &count);
+  pfb_text(PFB_TXT_POOFOUT, POOFOUT(ch), &count);
+  pfb_text(PFB_TXT_HOST, GET_HOST(ch), &count);
+  pfb_end(sec, count);
+
+  /* Immortals get every skill at 100 when they log in. */
+  if (GET_LEVEL(ch) < LVL_IMMORT) {
+    sec = pfb_begin(PFB_SEC_SKILLS);
+    for (count = 0, i = 1; i <= MAX_SKILLS; i++)
+      if (GET_SKILL(ch, i)) {
+        bin_put(&pfb_buf, i, 2);
+        bin_put(&pfb_buf, GET_SKILL(ch, i), 2);
+        count++;
+      }
+    pfb_end(sec, count);
+  }
 
-  /* More char_to_store code to add spell and eq affections back in. */
-  for (i = 0; i < MAX_AFFECT; i++) {
-    if (tmp_aff[i].spell)
-      affect_to_char(ch, &tmp_aff[i]);
+  sec = pfb_begin(PFB_SEC_AFFECTS);
+  for (count = 0, aff = ch->affected; aff && count < MAX_AFFECT; aff = aff->next) {
+    if (!aff->spell)
+      continue;
+    bin_put(&pfb_buf, aff->spell, 2);
+    bin_put(&pfb_buf, aff->duration, 4);
+    bin_put(&pfb_buf, aff->modifier, 2);
+    bin_put(&pfb_buf, aff->location, 2);
+    for (i = 0; i < 4; i++)
+      bin_put(&pfb_buf, aff->bitvector[i], 4);
+    count++;
   }
+  pfb_end(sec, count);
+  if (aff)
+    log("SYSERR: WARNING: OUT OF STORE ROOM FOR AFFECTED TYPES!!!");
 
-  for (i = 0; i < NUM_WEARS; i++) {
-    if (char_eq[i])
-#ifndef NO_EXTRANEOUS_TRIGGERS
-        if (wear_otrigger(char_eq[i], ch, i))
-#endif
-    equip_char(ch, char_eq[i], i);
-#ifndef NO_EXTRANEOUS_TRIGGERS
-          else
-          obj_to_char(char_eq[i], ch);
-#endif
+  sec = pfb_begin(PFB_SEC_ALIASES);
+  for (count = 0, alias = GET_ALIASES(ch); alias; alias = alias->next, count++) {
+    bin_put_str(&pfb_buf, alias->alias, 2);
+    bin_put_str(&pfb_buf, alias->replacement, 2);
+    bin_put(&pfb_buf, alias->type, 1);
   }
-  /* end char_to_store code */
+  pfb_end(sec, count);
 
-  if ((id = get_ptable_by_name(GET_NAME(ch))) < 0)
-    return;
+  sec = pfb_begin(PFB_SEC_QUESTS);
+  for (i = 0; i < GET_NUM_QUESTS(ch); i++)
+    bin_put(&pfb_buf, ch->player_specials->saved.completed_quests[i], 4);
+  pfb_end(sec, GET_NUM_QUESTS(ch));
 
-  /* update the player in the player index */
-  if (player_table[id].level != GET_LEVEL(ch)) {
-    save_index = TRUE;
-    player_table[id].level = GET_LEVEL(ch);
+  sec = pfb_begin(PFB_SEC_ZONES);
+  bin_put_bytes(&pfb_buf, ch->player_specials->saved.discovered_zones, ZONE_FLAG_BYTES);
+  pfb_end(sec, ZONE_FLAG_BYTES);
+
+  sec = pfb_begin(PFB_SEC_KILLS);
+  for (count = 0, kill = ch->kill_mem; kill; kill = kill->next, count++) {
+    bin_put(&pfb_buf, kill->vnum, 4);
+    bin_put(&pfb_buf, kill->amount, 4);
   }
-  if (player_table[id].last != ch->player.time.logon) {
-    save_index = TRUE;
-    player_table[id].last = ch->player.time.logon;
+  pfb_end(sec, count);
+
+  if (SCRIPT(ch)) {
+    sec = pfb_begin(PFB_SEC_TRIGS);
+    for (count = 0, t = TRIGGERS(SCRIPT(ch)); t; t = t->next, count++)
+      bin_put(&pfb_buf, GET_TRIG_VNUM(t), 4);
+    pfb_end(sec, count);
+
+    /* Variables starting with '-' are not saved. */
+    sec = pfb_begin(PFB_SEC_VARS);
+    for (count = 0, var = SCRIPT(ch)->global_vars; var; var = var->next) {
+      if (*var->name == '-')
+        continue;
+      bin_put_str(&pfb_buf, var->name, 2);
+      bin_put(&pfb_buf, var->context, 8);
+      bin_put_str(&pfb_buf, var->value, 2);
+      count++;
+    }
+    pfb_end(sec, count);
   }
-  i = player_table[id].flags;
-  if (PLR_FLAGGED(ch, PLR_DELETED))
-    SET_BIT(player_table[id].flags, PINDEX_DELETED);
-  else
-    REMOVE_BIT(player_table[id].flags, PINDEX_DELETED);
-  if (PLR_FLAGGED(ch, PLR_NODELETE) || PLR_FLAGGED(ch, PLR_CRYO))
-    SET_BIT(player_table[id].flags, PINDEX_NODELETE);
-  else
-    REMOVE_BIT(player_table[id].flags, PINDEX_NODELETE);
 
-  if (PLR_FLAGGED(ch, PLR_FROZEN) || PLR_FLAGGED(ch, PLR_NOWIZLIST))
-    SET_BIT(player_table[id].flags, PINDEX_NOWIZLIST);
-  else
-    REMOVE_BIT(player_table[id].flags, PINDEX_NOWIZLIST);
+  fwrite(pfb_buf.data, pfb_buf.len, 1, fl);
+}
 
-  if (player_table[id].flags != i || save_index)
-    save_player_index();
+/* Whether fl is a binary player file. Leaves fl just past the magic if so,
+ * and at the start otherwise. */
+static int pfile_is_binary(FILE *fl)
+{
+  char magic[PFB_MAGIC_LEN];
+
+  if (fread(magic, PFB_MAGIC_LEN, 1, fl) == 1 && !memcmp(magic, PFB_MAGIC, PFB_MAGIC_LEN))
+    return (TRUE);
+  rewind(fl);
+  return (FALSE);
+}
+
+static void pfb_load_scalars(struct bin_reader *r, struct char_data *ch, int count)
+{
+  long long val[NUM_PFB_SCALARS];
+  int i;
+
+  for (i = 0; i < NUM_PFB_SCALARS; i++)
+    val[i] = i < count ? bin_get(r, pfb_width[i]) : pfb_default[i];
+
+  GET_PFILE_VERSION(ch) = val[PFB_PVER];
+  GET_SEX(ch) = val[PFB_SEX];
+  GET_CLASS(ch) = val[PFB_CLASS];
+  GET_LEVEL(ch) = val[PFB_LEVEL];
+  GET_IDNUM(ch) = val[PFB_ID];
+  ch->player.time.birth = val[PFB_BIRTH];
+  ch->player.time.played = val[PFB_PLAYED];
+  ch->player.time.logon = val[PFB_LOGON];
+  GET_LAST_MOTD(ch) = val[PFB_LMOT];
+  GET_LAST_NEWS(ch) = val[PFB_LNEW];
+  GET_HEIGHT(ch) = val[PFB_HEIGHT];
+  GET_WEIGHT(ch) = val[PFB_WEIGHT];
+  GET_ALIGNMENT(ch) = val[PFB_ALIGN];
+  for (i = 0; i < 4; i++) {
+    PLR_FLAGS(ch)[i] = val[PFB_ACT + i];
+    AFF_FLAGS(ch)[i] = val[PFB_AFF + i];
+    PRF_FLAGS(ch)[i] = val[PFB_PREF + i];
+  }
+  GET_MAGIC_RESISTANCE(ch) = val[PFB_MAGR];
+  GET_ELEMENTAL_RESISTANCE(ch) = val[PFB_ELER];
+  GET_WIMP_LEV(ch) = val[PFB_WIMP];
+  GET_FREEZE_LEV(ch) = val[PFB_FREZ];
+  GET_INVIS_LEV(ch) = val[PFB_INVS];
+  GET_LOADROOM(ch) = val[PFB_ROOM];
+  GET_BAD_PWS(ch) = val[PFB_BADP];
+  GET_PRACTICES(ch) = val[PFB_LERN];
+  GET_COND(ch, HUNGER) = val[PFB_HUNG];
+  GET_COND(ch, THIRST) = val[PFB_THIR];
+  GET_COND(ch, DRUNK) = val[PFB_DRNK];
+  GET_HIT(ch) = val[PFB_HIT];
+  GET_MAX_HIT(ch) = val[PFB_MAXHIT];
+  GET_MANA(ch) = val[PFB_MANA];
+  GET_MAX_MANA(ch) = val[PFB_MAXMANA];
+  GET_MOVE(ch) = val[PFB_MOVE];
+  GET_MAX_MOVE(ch) = val[PFB_MAXMOVE];
+  ch->real_abils.str = val[PFB_STR];
+  ch->real_abils.str_add = val[PFB_STRADD];
+  ch->real_abils.intel = val[PFB_INT];
+  ch->real_abils.wis = val[PFB_WIS];
+  ch->real_abils.dex = val[PFB_DEX];
+  ch->real_abils.con = val[PFB_CON];
+  ch->real_abils.cha = val[PFB_CHA];
+  GET_AC(ch) = val[PFB_AC];
+  GET_GOLD(ch) = val[PFB_GOLD];
+  GET_BANK_GOLD(ch) = val[PFB_BANK];
+  GET_EXP(ch) = val[PFB_EXP];
+  GET_HITROLL(ch) = val[PFB_HROL];
+  GET_DAMROLL(ch) = val[PFB_DROL];
+  GET_OLC_ZONE(ch) = val[PFB_OLC];
+  GET_PAGE_LENGTH(ch) = val[PFB_PAGE];
+  GET_SCREEN_WIDTH(ch) = val[PFB_SCRW];
+  GET_QUESTPOINTS(ch) = val[PFB_QSTP];
+  GET_QUEST_COUNTER(ch) = val[PFB_QCNT];
+  GET_QUEST(ch) = val[PFB_QCUR];
+  GET_KILLS_TOTAL(ch) = val[PFB_KTOTAL];
+  GET_KILLS_LEGIT_TOTAL(ch) = val[PFB_KLEGIT];
+  GET_KILLS_UNIQUE_MOBS(ch) = val[PFB_KUNIQUE];
+  GET_DEATHS(ch) = MAX(0, val[PFB_DEATHS]);
+  GET_BASE_CARRY_SLOTS(ch) = val[PFB_CSLT];
+  GET_ZONES_DISCOVERED(ch) = MAX(0, val[PFB_ZONESDISC]);
+}
+
+static void pfb_load_text(struct bin_reader *r, struct char_data *ch, int count)
+{
+  char *text;
+  int which;
+
+  while (count-- > 0 && !r->bad) {
+    which = bin_get(r, 1);
+    text = bin_get_str(r, 4);
+
+    switch (which) {
+    case PFB_TXT_NAME:
+      GET_PC_NAME(ch) = text;
+      break;
+    case PFB_TXT_PASSWD:
+      strlcpy(GET_PASSWD(ch), text, MAX_PWD_LENGTH + 1);
+      free(text);
+      break;
+    case PFB_TXT_TITLE:
+      GET_TITLE(ch) = text;
+      break;
+    case PFB_TXT_DESC:
+      ch->player.description = text;
+      break;
+    case PFB_TXT_POOFIN:
+      POOFIN(ch) = text;
+      break;
+    case PFB_TXT_POOFOUT:
+      POOFOUT(ch) = text;
+      break;
+    case PFB_TXT_HOST:
+      if (GET_HOST(ch))
+        free(GET_HOST(ch));
+      GET_HOST(ch) = text;
+      break;
+    default:
+      free(text);
+    }
+  }
+}
+
+/* Read the sections of a binary player file into ch; fl is just past the
+ * magic. Returns -1 if the file is damaged. */
+static int load_char_binary(FILE *fl, struct char_data *ch)
+{
+  struct bin_reader r, sec;
+  struct affected_type af;
+  struct alias_data *alias, **alias_tail;
+  struct kill_node *kill, **kill_tail;
+  trig_data *t;
+  trig_rnum t_rnum;
+  char *name, *value;
+  long context, size;
+  int type, count, i, num;
+
+  if ((size = fseek(fl, 0, SEEK_END) == 0 ? ftell(fl) : -1) < PFB_MAGIC_LEN + 2)
+    return (-1);
+  size -= PFB_MAGIC_LEN;
+  pfb_buf.len = 0;
+  bin_need(&pfb_buf, size);
+  fseek(fl, PFB_MAGIC_LEN, SEEK_SET);
+  if (fread(pfb_buf.data, size, 1, fl) != 1)
+    return (-1);
+
+  bin_reader_init(&r, pfb_buf.data, size);
+
+  if (bin_get(&r, 2) > PFB_VERSION)
+    return (-1);
+
+  while (r.pos < r.end && !r.bad) {
+    type = bin_get(&r, 1);
+    size = bin_get(&r, 4);
+    if (r.bad || size < 2 || r.end - r.pos < size)
+      return (-1);
+
+    bin_reader_init(&sec, bin_get_bytes(&r, size), size);
+    count = bin_get(&sec, 2);
+
+    switch (type) {
+    case PFB_SEC_SCALARS:
+      pfb_load_scalars(&sec, ch, count);
+      break;
+
+    case PFB_SEC_TEXT:
+      pfb_load_text(&sec, ch, count);
+      break;
+
+    case PFB_SEC_SKILLS:
+      for (i = 0; i < count && !sec.bad; i++) {
+        num = bin_get(&sec, 2);
+        if (num > 0 && num <= MAX_SKILLS)
+          GET_SKILL(ch, num) = bin_get(&sec, 2);
+        else
+          bin_get(&sec, 2);
+      }
+      break;
+
+    case PFB_SEC_AFFECTS:
+      for (i = 0; i < count && !sec.bad; i++) {
+        new_affect(&af);
+        af.spell = bin_get(&sec, 2);
+        af.duration = bin_get(&sec, 4);
+        af.modifier = bin_get(&sec, 2);
+        af.location = bin_get(&sec, 2);
+        for (num = 0; num < 4; num++)
+          af.bitvector[num] = bin_get(&sec, 4);
+        if (af.spell > 0 && !sec.bad)
+          affect_to_char(ch, &af);
+      }
+      break;
+
+    case PFB_SEC_ALIASES:
+      for (alias_tail = &GET_ALIASES(ch); *alias_tail; alias_tail = &(*alias_tail)->next)
+        ;
+      for (i = 0; i < count && !sec.bad; i++) {
+        CREATE(alias, struct alias_data, 1);
+        alias->alias = bin_get_str(&sec, 2);
+        alias->replacement = bin_get_str(&sec, 2);
+        alias->type = bin_get(&sec, 1);
+        *alias_tail = alias;
+        alias_tail = &alias->next;
+      }
+      break;
+
+    case PFB_SEC_QUESTS:
+      if (count > 0 && !ch->player_specials->saved.completed_quests) {
+        CREATE(ch->player_specials->saved.completed_quests, qst_vnum, count);
+        for (i = 0; i < count && !sec.bad; i++)
+          ch->player_specials->saved.completed_quests[i] = bin_get(&sec, 4);
+        GET_NUM_QUESTS(ch) = i;
+      }
+      break;
+
+    case PFB_SEC_ZONES:
+      for (i = 0; i < count && !sec.bad; i++) {
+        num = bin_get(&sec, 1);
+        if (i < ZONE_FLAG_BYTES)
+          ch->player_specials->saved.discovered_zones[i] = (uint8_t) num;
+      }
+      break;
+
+    case PFB_SEC_KILLS:
+      for (kill_tail = &ch->kill_mem; *kill_tail; kill_tail = &(*kill_tail)->next)
+        ;
+      for (i = 0; i < count && !sec.bad; i++) {
+        CREATE(kill, struct kill_node, 1);
+        kill->vnum = bin_get(&sec, 4);
+        kill->amount = bin_get(&sec, 4);
+        *kill_tail = kill;
+        kill_tail = &kill->next;
+      }
+      break;
+
+    case PFB_SEC_TRIGS:
+      for (i = 0; i < count && !sec.bad; i++) {
+        num = bin_get(&sec, 4);
+        if (CONFIG_SCRIPT_PLAYERS && (t_rnum = real_trigger(num)) != NOTHING) {
+          t = read_trigger(t_rnum);
+          if (!SCRIPT(ch))
+            CREATE(SCRIPT(ch), struct script_data, 1);
+          add_trigger(SCRIPT(ch), t, -1);
+        }
+      }
+      break;
+
+    case PFB_SEC_VARS:
+      /* Coming back to the menu from the game keeps the variables. */
+      if (SCRIPT(ch) && SCRIPT(ch)->global_vars)
+        break;
+      if (!SCRIPT(ch))
+        CREATE(SCRIPT(ch), struct script_data, 1);
+      for (i = 0; i < count && !sec.bad; i++) {
+        name = bin_get_str(&sec, 2);
+        context = bin_get(&sec, 8);
+        value = bin_get_str(&sec, 2);
+        if (!sec.bad)
+          add_var(&(SCRIPT(ch)->global_vars), name, value, context);
+        free(name);
+        free(value);
+      }
+      break;
+    }
+
+    if (sec.bad)
+      return (-1);
+  }
+
+  return (r.bad ? -1 : 0);
 }
 
 /* Separate a 4-character id tag from the data it precedes */
@@ -887,36 +1507,45 @@ void tag_argument(char *argument, char *tag)
 /* remove_player() removes all files associated with a player who is self-deleted,
  * deleted by an immortal, or deleted by the auto-wipe system (if enabled). */
 void remove_player(int pfilepos)
+{
+  if (pfilepos < 0 || pfilepos > top_of_p_table || !*player_table[pfilepos].name)
+    return;
+
+  purge_player(pfilepos);
+  save_player_index();
+}
+
+/* Delete a player's files and index entry without rewriting the index file,
+ * so clean_pfiles() can write it once at the end. */
+static void purge_player(int pfilepos)
 {
   char filename[MAX_STRING_LENGTH], timestr[25];
   int i;
 
-  if (!*player_table[pfilepos].name)
-    return;
-
   /* Unlink all player-owned files */
   for (i = 0; i < MAX_FILES; i++) {
-    if (get_filename(filename, sizeof(filename), i, player_table[pfilepos].name))
+    if (get_filename(filename, sizeof(filename), i, player_table[pfilepos].name)) {
+      saveq_wait(filename);
       unlink(filename);
+    }
   }
 
   strftime(timestr, sizeof(timestr), "%c", localtime(&(player_table[pfilepos].last)));
   log("PCLEAN: %s Lev: %d Last: %s",
 	player_table[pfilepos].name, player_table[pfilepos].level,
 	timestr);
-  player_table[pfilepos].name[0] = '\0';
 
   /* Update index table. */
   remove_player_from_index(pfilepos);
-
-  save_player_index();
 }
 
 void clean_pfiles(void)
 {
-  int i, ci;
+  int i, ci, removed = 0;
 
-  for (i = 0; i <= top_of_p_table; i++) {
+  /* Removing an entry moves the last one into its place, so only step past
+   * entries that are kept. */
+  for (i = 0; i <= top_of_p_table; ) {
     /* We only want to go further if the player isn't protected from deletion
      * and hasn't already been deleted. */
     if (!IS_SET(player_table[i].flags, PINDEX_NODELETE) &&
@@ -924,24 +1553,33 @@ void clean_pfiles(void)
       /* If the player is already flagged for deletion, then go ahead and get
        * rid of him. */
       if (IS_SET(player_table[i].flags, PINDEX_DELETED)) {
-	remove_player(i);
+	purge_player(i);
+	removed++;
+	continue;
       } else {
         /* Check to see if the player has overstayed his welcome based on level. */
 	for (ci = 0; pclean_criteria[ci].level > -1; ci++) {
 	  if (player_table[i].level <= pclean_criteria[ci].level &&
 	      ((time(0) - player_table[i].last) >
 	       (pclean_criteria[ci].days * SECS_PER_REAL_DAY))) {
-	    remove_player(i);
 	    break;
 	  }
 	}
+	if (pclean_criteria[ci].level > -1) {
+	  purge_player(i);
+	  removed++;
+	  continue;
+	}
         /* If we got this far and the players hasn't been kicked out, then he
 	 * can stay a little while longer. */
       }
     }
+    i++;
   }
-  /* After everything is done, we should rebuild player_index and remove the
-   * entries of the players that were just deleted. */
+
+  /* Write the index once for everyone removed above. */
+  if (removed)
+    save_player_index();
 }
 
 /* load_affects function now handles both 32-bit and
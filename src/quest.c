@@ -19,6 +19,7 @@
 #include "comm.h"
 #include "screen.h"
 #include "quest.h"
+#include "htree.h"
 #include "act.h" /* for do_tell */
 
 
@@ -61,12 +62,16 @@ static const char *quest_imm_usage =
 
 qst_rnum real_quest(qst_vnum vnum)
 {
-  int rnum;
+  qst_rnum rnum;
 
-  for (rnum = 0; rnum < total_quests; rnum++)
-    if (QST_NUM(rnum) == vnum)
-      return(rnum);
-  return(NOTHING);
+  if (vnum == NOTHING || (rnum = htree_find(qst_htree, vnum)) == NOTHING)
+    return(NOTHING);
+
+  if (rnum >= total_quests || QST_NUM(rnum) != vnum) {
+    log("SYSERR: qst_htree out of sync: %d -> %d", vnum, rnum);
+    return(NOTHING);
+  }
+  return(rnum);
 }
 
 int is_complete(struct char_data *ch, qst_vnum vnum)
@@ -108,6 +113,8 @@ void destroy_quests(void)
   free(aquest_table);
   aquest_table = NULL;
   total_quests = 0;
+  htree_free(qst_htree);
+  qst_htree = NULL;
 
   return;
 }
@@ -202,6 +209,9 @@ void parse_quest(FILE *quest_f, int nr)
     }
     switch(*line) {
     case 'S':
+      if (!qst_htree)
+        qst_htree = htree_init();
+      htree_add(qst_htree, nr, i);
       total_quests = ++i;
       return;
     }
@@ -240,6 +250,7 @@ void set_quest(struct char_data *ch, qst_rnum rnum)
   GET_QUEST_TIME(ch) = QST_TIME(rnum);
   GET_QUEST_COUNTER(ch) = QST_QUANTITY(rnum);
   SET_BIT_AR(PRF_FLAGS(ch), PRF_QUEST);
+  SET_SAVE_DIRTY(ch, SAVE_QUESTS);
   return;
 }
 
@@ -249,6 +260,7 @@ void clear_quest(struct char_data *ch)
   GET_QUEST_TIME(ch) = -1;
   GET_QUEST_COUNTER(ch) = 0;
   REMOVE_BIT_AR(PRF_FLAGS(ch), PRF_QUEST);
+  SET_SAVE_DIRTY(ch, SAVE_QUESTS);
   return;
 }
 
@@ -263,6 +275,7 @@ void add_completed_quest(struct char_data *ch, qst_vnum vnum)
 
   temp[GET_NUM_QUESTS(ch)] = vnum;
   GET_NUM_QUESTS(ch)++;
+  SET_SAVE_DIRTY(ch, SAVE_QUESTS);
 
   if (ch->player_specials->saved.completed_quests)
     free(ch->player_specials->saved.completed_quests);
@@ -280,6 +293,7 @@ void remove_completed_quest(struct char_data *ch, qst_vnum vnum)
       temp[j++] = ch->player_specials->saved.completed_quests[i];
 
   GET_NUM_QUESTS(ch)--;
+  SET_SAVE_DIRTY(ch, SAVE_QUESTS);
 
   if (ch->player_specials->saved.completed_quests)
     free(ch->player_specials->saved.completed_quests);
@@ -293,6 +307,7 @@ void generic_complete_quest(struct char_data *ch)
   struct obj_data *new_obj;
   int happy_qp, happy_gold, happy_exp;
 
+  SET_SAVE_DIRTY(ch, SAVE_QUESTS);
   if (--GET_QUEST_COUNTER(ch) <= 0) {
     rnum = real_quest(vnum);
     if (IS_HAPPYHOUR && IS_HAPPYQP) {
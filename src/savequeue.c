@@ -0,0 +1,446 @@
+/**
+* @file savequeue.c
+* Background writer for player, rent and script variable files.
+*
+* Part of the core tbaMUD source code distribution, which is a derivative
+* of, and continuation of, CircleMUD.
+*
+* Savers format into the FILE * that saveq_open() hands back, exactly as they
+* would into a real file, and call saveq_commit() instead of fclose(). Where
+* threads are available the FILE * is an in-memory stream and the finished
+* image is queued for a writer thread; otherwise it is a temporary file next
+* to the target. Either way the target is only ever replaced by rename(), so a
+* crash part way through a save leaves the previous file whole.
+*
+* Anything that reads, removes or renames one of these files must call
+* saveq_wait() on it first so it does not race a queued write.
+*/
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include "structs.h"
+#include "utils.h"
+#include "savequeue.h"
+
+#if defined(HAVE_LIBPTHREAD) && defined(CIRCLE_UNIX)
+#define SAVEQ_THREADED
+#include <pthread.h>
+#endif
+
+/* A file being formatted on the game thread. */
+struct saveq_file {
+  FILE *fp;
+  char *path;
+  char *buf;                  /* the in-memory image, once closed */
+  size_t len;
+  struct saveq_file *next;
+};
+
+static struct saveq_file *saveq_files = NULL;
+
+static struct saveq_file *saveq_find_file(FILE *fp)
+{
+  struct saveq_file *f;
+
+  for (f = saveq_files; f; f = f->next)
+    if (f->fp == fp)
+      return f;
+
+  return NULL;
+}
+
+static void saveq_free_file(struct saveq_file *f)
+{
+  struct saveq_file *temp;
+
+  REMOVE_FROM_LIST(f, saveq_files, next);
+  free(f->path);
+  free(f);
+}
+
+/* Flush 'fl' to disk, close it and move it over 'path'. Returns FALSE and
+ * fills in 'err' on failure, in which case 'tmp' has been removed. */
+static int saveq_finish(FILE *fl, const char *tmp, const char *path,
+                        char *err, size_t errlen)
+{
+  const char *step = NULL;
+
+  if (fflush(fl) != 0)
+    step = "write";
+#if defined(CIRCLE_UNIX)
+  else if (fsync(fileno(fl)) != 0)
+    step = "sync";
+#endif
+
+  if (fclose(fl) != 0 && !step)
+    step = "close";
+
+  if (!step) {
+#if defined(CIRCLE_WINDOWS)
+    remove(path);   /* rename() will not replace an existing file here. */
+#endif
+    if (rename(tmp, path) == 0)
+      return TRUE;
+    step = "rename";
+  }
+
+  snprintf(err, errlen, "SYSERR: saving %s (%s): %s", path, step, strerror(errno));
+  remove(tmp);
+  return FALSE;
+}
+
+#ifdef SAVEQ_THREADED
+
+static int saveq_write_file(const char *path, const char *buf, size_t len,
+                            char *err, size_t errlen)
+{
+  char tmp[PATH_MAX];
+  FILE *fl;
+
+  snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+  if (!(fl = fopen(tmp, "w"))) {
+    snprintf(err, errlen, "SYSERR: saving %s (open): %s", path, strerror(errno));
+    return FALSE;
+  }
+
+  if (len && fwrite(buf, 1, len, fl) != len) {
+    snprintf(err, errlen, "SYSERR: saving %s (write): %s", path, strerror(errno));
+    fclose(fl);
+    remove(tmp);
+    return FALSE;
+  }
+
+  return saveq_finish(fl, tmp, path, err, errlen);
+}
+
+/* A finished image waiting for the writer. */
+struct saveq_job {
+  char *path;
+  char *buf;
+  size_t len;
+  struct timeval due;         /* written no earlier than this */
+  struct saveq_job *next;
+};
+
+/* Errors from the writer, logged by the game thread in saveq_pulse(). */
+#define SAVEQ_MAX_ERRORS  16
+
+static pthread_t saveq_thread;
+static pthread_mutex_t saveq_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t saveq_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t saveq_done = PTHREAD_COND_INITIALIZER;
+
+static struct saveq_job *saveq_head = NULL, *saveq_tail = NULL;
+static struct saveq_job *saveq_busy = NULL;
+static int saveq_flushing = 0;
+static bool saveq_running = FALSE, saveq_stopping = FALSE;
+
+static char *saveq_errors[SAVEQ_MAX_ERRORS];
+static int saveq_num_errors = 0, saveq_lost_errors = 0;
+
+/* Has 'path' (any file, if NULL) got a write queued or in progress? Called
+ * with saveq_lock held. */
+static int saveq_pending(const char *path)
+{
+  struct saveq_job *job;
+
+  if (saveq_busy && (!path || !strcmp(saveq_busy->path, path)))
+    return TRUE;
+
+  for (job = saveq_head; job; job = job->next)
+    if (!path || !strcmp(job->path, path))
+      return TRUE;
+
+  return FALSE;
+}
+
+static void *saveq_writer(void *arg)
+{
+  struct saveq_job *job;
+  struct timeval now;
+  struct timespec until;
+  char err[MAX_STRING_LENGTH];
+  int ok;
+
+  pthread_mutex_lock(&saveq_lock);
+  for (;;) {
+    if (!saveq_head) {
+      if (saveq_stopping)
+        break;
+      pthread_cond_wait(&saveq_work, &saveq_lock);
+      continue;
+    }
+
+    /* Hold the oldest save back until its window closes, so further saves
+     * of the same file land on it, unless someone is waiting on us. */
+    gettimeofday(&now, NULL);
+    if (!saveq_flushing && !saveq_stopping && timercmp(&now, &saveq_head->due, <)) {
+      until.tv_sec = saveq_head->due.tv_sec;
+      until.tv_nsec = saveq_head->due.tv_usec * 1000;
+      pthread_cond_timedwait(&saveq_work, &saveq_lock, &until);
+      continue;
+    }
+
+    job = saveq_head;
+    if (!(saveq_head = job->next))
+      saveq_tail = NULL;
+    saveq_busy = job;
+    pthread_mutex_unlock(&saveq_lock);
+
+    ok = saveq_write_file(job->path, job->buf, job->len, err, sizeof(err));
+
+    pthread_mutex_lock(&saveq_lock);
+    if (!ok) {
+      if (saveq_num_errors < SAVEQ_MAX_ERRORS)
+        saveq_errors[saveq_num_errors++] = strdup(err);
+      else
+        saveq_lost_errors++;
+    }
+    saveq_busy = NULL;
+    pthread_cond_broadcast(&saveq_done);
+    pthread_mutex_unlock(&saveq_lock);
+
+    free(job->path);
+    free(job->buf);
+    free(job);
+    pthread_mutex_lock(&saveq_lock);
+  }
+  pthread_mutex_unlock(&saveq_lock);
+
+  return NULL;
+}
+
+void saveq_init(void)
+{
+  if (saveq_running)
+    return;
+
+  saveq_stopping = FALSE;
+  if (pthread_create(&saveq_thread, NULL, saveq_writer, NULL) != 0) {
+    log("SYSERR: Could not start the save writer, saving in the foreground: %s",
+        strerror(errno));
+    return;
+  }
+  saveq_running = TRUE;
+}
+
+/** Write everything still queued and stop the writer. Saves after this are
+ * written straight away. */
+void saveq_shutdown(void)
+{
+  if (!saveq_running)
+    return;
+
+  pthread_mutex_lock(&saveq_lock);
+  saveq_stopping = TRUE;
+  pthread_cond_signal(&saveq_work);
+  pthread_mutex_unlock(&saveq_lock);
+
+  pthread_join(saveq_thread, NULL);
+  saveq_running = FALSE;
+
+  saveq_pulse();
+}
+
+/** Start a save of 'path'. Format into the FILE * returned, then pass it to
+ * saveq_commit() or saveq_abort() instead of fclose(). */
+FILE *saveq_open(const char *path)
+{
+  struct saveq_file *f;
+
+  CREATE(f, struct saveq_file, 1);
+  if (!(f->fp = open_memstream(&f->buf, &f->len))) {
+    free(f);
+    return NULL;
+  }
+  f->path = strdup(path);
+  f->next = saveq_files;
+  saveq_files = f;
+
+  return f->fp;
+}
+
+/** Hand a finished save to the writer. A save of the same file that is still
+ * waiting is replaced rather than written twice. */
+int saveq_commit(FILE *fp)
+{
+  struct saveq_file *f;
+  struct saveq_job *job;
+  char err[MAX_STRING_LENGTH];
+  int ok = TRUE;
+
+  if (!(f = saveq_find_file(fp)))
+    return FALSE;
+
+  if (fclose(fp) != 0) {
+    log("SYSERR: saving %s (format): %s", f->path, strerror(errno));
+    free(f->buf);
+    saveq_free_file(f);
+    return FALSE;
+  }
+
+  if (!saveq_running) {
+    if (!(ok = saveq_write_file(f->path, f->buf, f->len, err, sizeof(err))))
+      log("%s", err);
+    free(f->buf);
+    saveq_free_file(f);
+    return ok;
+  }
+
+  pthread_mutex_lock(&saveq_lock);
+  for (job = saveq_head; job; job = job->next)
+    if (!strcmp(job->path, f->path))
+      break;
+
+  if (job) {
+    free(job->buf);
+    job->buf = f->buf;
+    job->len = f->len;
+  } else {
+    CREATE(job, struct saveq_job, 1);
+    job->path = strdup(f->path);
+    job->buf = f->buf;
+    job->len = f->len;
+    gettimeofday(&job->due, NULL);
+    job->due.tv_usec += SAVEQ_WINDOW_MS * 1000;
+    job->due.tv_sec += job->due.tv_usec / 1000000;
+    job->due.tv_usec %= 1000000;
+    if (saveq_tail)
+      saveq_tail->next = job;
+    else
+      saveq_head = job;
+    saveq_tail = job;
+    pthread_cond_signal(&saveq_work);
+  }
+  pthread_mutex_unlock(&saveq_lock);
+
+  saveq_free_file(f);
+  return TRUE;
+}
+
+/** Drop a save started with saveq_open(), leaving the file as it was. */
+void saveq_abort(FILE *fp)
+{
+  struct saveq_file *f;
+
+  if (!(f = saveq_find_file(fp)))
+    return;
+
+  fclose(fp);
+  free(f->buf);
+  saveq_free_file(f);
+}
+
+/** Block until nothing is queued for 'path', or for any file if 'path' is
+ * NULL. */
+void saveq_wait(const char *path)
+{
+  if (!saveq_running)
+    return;
+
+  pthread_mutex_lock(&saveq_lock);
+  if (saveq_pending(path)) {
+    saveq_flushing++;
+    pthread_cond_signal(&saveq_work);
+    while (saveq_pending(path))
+      pthread_cond_wait(&saveq_done, &saveq_lock);
+    saveq_flushing--;
+  }
+  pthread_mutex_unlock(&saveq_lock);
+}
+
+/** Log anything the writer could not save. Called every pulse. */
+void saveq_pulse(void)
+{
+  char *errors[SAVEQ_MAX_ERRORS];
+  int i, num, lost;
+
+  pthread_mutex_lock(&saveq_lock);
+  num = saveq_num_errors;
+  lost = saveq_lost_errors;
+  for (i = 0; i < num; i++)
+    errors[i] = saveq_errors[i];
+  saveq_num_errors = saveq_lost_errors = 0;
+  pthread_mutex_unlock(&saveq_lock);
+
+  for (i = 0; i < num; i++) {
+    mudlog(BRF, LVL_GOD, TRUE, "%s", errors[i]);
+    free(errors[i]);
+  }
+  if (lost)
+    mudlog(BRF, LVL_GOD, TRUE, "SYSERR: %d more saves failed.", lost);
+}
+
+#else /* !SAVEQ_THREADED */
+
+/* No writer thread: format straight into a temporary file and move it into
+ * place on commit. */
+
+void saveq_init(void)
+{
+}
+
+void saveq_shutdown(void)
+{
+}
+
+FILE *saveq_open(const char *path)
+{
+  struct saveq_file *f;
+  char tmp[PATH_MAX];
+
+  snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+  CREATE(f, struct saveq_file, 1);
+  if (!(f->fp = fopen(tmp, "w"))) {
+    free(f);
+    return NULL;
+  }
+  f->path = strdup(path);
+  f->next = saveq_files;
+  saveq_files = f;
+
+  return f->fp;
+}
+
+int saveq_commit(FILE *fp)
+{
+  struct saveq_file *f;
+  char tmp[PATH_MAX], err[MAX_STRING_LENGTH];
+  int ok;
+
+  if (!(f = saveq_find_file(fp)))
+    return FALSE;
+
+  snprintf(tmp, sizeof(tmp), "%s.tmp", f->path);
+  if (!(ok = saveq_finish(fp, tmp, f->path, err, sizeof(err))))
+    log("%s", err);
+
+  saveq_free_file(f);
+  return ok;
+}
+
+void saveq_abort(FILE *fp)
+{
+  struct saveq_file *f;
+  char tmp[PATH_MAX];
+
+  if (!(f = saveq_find_file(fp)))
+    return;
+
+  snprintf(tmp, sizeof(tmp), "%s.tmp", f->path);
+  fclose(fp);
+  remove(tmp);
+  saveq_free_file(f);
+}
+
+void saveq_wait(const char *path)
+{
+}
+
+void saveq_pulse(void)
+{
+}
+
+#endif /* SAVEQ_THREADED */
@@ -0,0 +1,24 @@
+/**
+* @file savequeue.h
+* Background writer for player, rent and script variable files.
+*
+* Part of the core tbaMUD source code distribution, which is a derivative
+* of, and continuation of, CircleMUD.
+*/
+
+#ifndef _SAVEQUEUE_H_
+#define _SAVEQUEUE_H_
+
+/** Saves of the same file made within this many milliseconds of the first
+ * one still waiting are written once, with the newest contents. */
+#define SAVEQ_WINDOW_MS  500
+
+void  saveq_init(void);
+void  saveq_shutdown(void);
+FILE *saveq_open(const char *path);
+int   saveq_commit(FILE *fp);
+void  saveq_abort(FILE *fp);
+void  saveq_wait(const char *path);
+void  saveq_pulse(void);
+
+#endif /* _SAVEQUEUE_H_ */
@@ -556,8 +556,10 @@ static void shopping_buy(char *arg, struct char_data *ch, struct char_data *keep
       obj_to_char(obj, ch);
 
       goldamt += GET_OBJ_COST(obj);
-      if (!IS_GOD(ch))
+      if (!IS_GOD(ch)) {
         GET_QUESTPOINTS(ch) -= GET_OBJ_COST(obj);
+        SET_SAVE_DIRTY(ch, SAVE_QUESTS);
+      }
 
       last_obj = obj;
       obj = get_purchase_obj(ch, arg, keeper, shop_nr, FALSE);
@@ -26,6 +26,7 @@
 #include "class.h"
 #include "fight.h"
 #include "modify.h"
+#include "kwindex.h"
 #define SINFO spell_info[spellnum]
 
 /* locally defined functions of local (file) scope */
@@ -190,7 +191,7 @@ SPECIAL(guild)
         return TRUE;
       }
 
-      GET_GOLD(ch) -= cost;
+      decrease_gold(ch, cost);
 
       for (int i = 1; i <= TOP_SPELL_DEFINE; i++) {
         if (GET_SKILL(ch, i) > 0)
@@ -220,7 +221,7 @@ SPECIAL(guild)
       return TRUE;
     }
 
-    GET_GOLD(ch) -= cost;
+    decrease_gold(ch, cost);
     GET_PRACTICES(ch)++;
     SET_SKILL(ch, skill_num, 0);
 
@@ -735,6 +736,7 @@ SPECIAL(pet_shops)
       snprintf(buf, sizeof(buf), "%s %s", pet->player.name, pet_name);
       /* free(pet->player.name); don't free the prototype! */
       pet->player.name = strdup(buf);
+      kw_reindex_char(pet);
 
       snprintf(buf, sizeof(buf), "%sA small sign on a chain around the neck says 'My name is %s'\r\n",
 	      pet->player.description, pet_name);
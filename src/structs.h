@@ -228,7 +228,7 @@
 #define PLR_DONTSET       3   /**< Don't EVER set (ISNPC bit, set by mud) */
 #define PLR_WRITING       4   /**< Player writing (board/mail/olc) */
 #define PLR_MAILING       5   /**< Player is writing mail */
-#define PLR_CRASH         6   /**< Player needs to be crash-saved */
+#define PLR_CRASH         6   /**< Unused, see SAVE_INVENTORY */
 #define PLR_SITEOK        7   /**< Player has been site-cleared */
 #define PLR_NOSHOUT       8   /**< Player not allowed to shout/goss */
 #define PLR_NOTITLE       9   /**< Player not allowed to set title */
@@ -243,6 +243,17 @@
 #define PLR_IDEA         18   /**< Player is writing an idea */
 #define PLR_TYPO         19   /**< Player is writing a typo */
 
+/* Save sections: what has changed on a player since it was last saved, in
+ * player_special_data.save_dirty. Autosave skips players with none set. */
+#define SAVE_STATS      (1 << 0)   /**< Points, gold, exp, flags, affects */
+#define SAVE_SKILLS     (1 << 1)   /**< Skills and spells */
+#define SAVE_ALIASES    (1 << 2)   /**< Command aliases */
+#define SAVE_INVENTORY  (1 << 3)   /**< Carried and worn objects (rent file) */
+#define SAVE_VARS       (1 << 4)   /**< DG Script global variables */
+#define SAVE_QUESTS     (1 << 5)   /**< Current and completed quests */
+/** Every section written by save_char(), as opposed to the rent file. */
+#define SAVE_PFILE      (SAVE_STATS | SAVE_SKILLS | SAVE_ALIASES | SAVE_VARS | SAVE_QUESTS)
+
 /* Mobile flags: used by char_data.char_specials.act */
 #define MOB_SPEC            0   /**< Mob has a callable spec-proc */
 #define MOB_SENTINEL        1   /**< Mob should not move */
@@ -687,14 +698,18 @@
 
 /** Controls when a zone update will occur. */
 #define PULSE_ZONE      (10 RL_SEC)
+/** Most zone reset commands an automatic reset runs in one pulse; the rest
+ * carry over to the following pulses. */
+#define RESET_CMDS_PER_PULSE 100
 /** Controls when mobile (NPC) actions and updates will occur. */
 #define PULSE_MOBILE    (10 RL_SEC)
 /** Controls the time between turns of combat. */
 #define PULSE_VIOLENCE  ( 2 RL_SEC)
-/** Controls when characters and houses (if implemented) will be autosaved.
+/** Most characters, and most houses, autosave writes in one pulse. Anything
+ * else that is due waits for the following pulses.
  * @see CONFIG_AUTO_SAVE
  */
-#define PULSE_AUTOSAVE  (60 RL_SEC)
+#define AUTOSAVES_PER_PULSE 2
 /** Controls when checks are made for idle name and password CON_ states */
 #define PULSE_IDLEPWD   (15 RL_SEC)
 /** Currently unused. */
@@ -706,6 +721,12 @@
 /** Controls when to save the current ingame MUD time to disk.
  * This should be set >= SECS_PER_MUD_HOUR */
 #define PULSE_TIMESAVE	(30 * 60 RL_SEC)
+/** How often the player journal is synced to disk. */
+#define PULSE_JOURNAL   (1 RL_SEC)
+/** How often to check whether the mail file needs compacting. */
+#define PULSE_MAIL      (60 RL_SEC)
+/** How often changed persistent rooms and account stashes are saved. */
+#define PULSE_PERSIST   (5 RL_SEC)
 /* Variables for the output buffering system */
 #define MAX_SOCK_BUF       (24 * 1024) /**< Size of kernel's sock buf   */
 #define MAX_PROMPT_LENGTH  1024          /**< Max length of prompt        */
@@ -850,6 +871,9 @@ struct obj_data
 
   struct obj_data *next_content;  /**< For 'contains' lists   */
   struct obj_data *next;          /**< For the object list */
+  struct obj_data *next_instance; /**< Other live copies of this prototype */
+  struct obj_data *prev_instance; /**< Other live copies of this prototype */
+  struct kw_entry *keywords;      /**< This object's keyword index entries */
   struct char_data *sitting_here; /**< For furniture, who is sitting in it */
   
   struct list_data *events;      /**< Used for object events */
@@ -1036,6 +1060,20 @@ struct char_point_data
   sbyte damroll;   /**< Any bonus or penalty to the damage roll */
 };
 
+/** A character's values with no equipment worn and no affects applied, as
+ * worked out by char_base_values(). This is what goes in the player file. */
+struct char_base_data
+{
+  struct char_ability_data abils;   /**< Same as real_abils */
+  struct char_point_data points;    /**< Max points, AC, hit and dam rolls */
+  int affected_by[AF_ARRAY_MAX];    /**< AFF_ bits not granted by eq/affects */
+  int magic_resistance;             /**< Magic resistance */
+  int elemental_resistance;         /**< Elemental resistance */
+  ubyte weight;                     /**< Weight */
+  ubyte height;                     /**< Height */
+  time_t birth;                     /**< Birth time, before APPLY_AGE */
+};
+
 /** char_special_data_saved: specials which both a PC and an NPC have in
  * common, but which must be saved to the players file for PC's. */
 struct char_special_data_saved
@@ -1174,6 +1212,11 @@ struct player_special_data
   int last_olc_mode;     /**< ? Currently Unused ? */
   char *host;            /**< Resolved hostname, or ip, for player. */
   int buildwalk_sector;  /**< Default sector type for buildwalk */
+  int save_dirty;        /**< SAVE_ sections changed since the last save */
+  time_t last_save;      /**< When the player file was last written */
+  int journal_gen;       /**< Oldest journal holding unsaved changes, or 0 */
+  int journal_last;      /**< Journal last written to for the player, or 0 */
+  bool journal_objs;     /**< Objects changed since they were last journaled */
 };
 
 /** Special data used by NPCs, not PCs */
@@ -1259,6 +1302,9 @@ struct char_data
   struct char_data *next_in_room;  /**< Next PC in the room */
   struct char_data *next;          /**< Next char_data in the room */
   struct char_data *next_fighting; /**< Next in line to fight */
+  struct char_data *next_instance; /**< Other live copies of this mob */
+  struct char_data *prev_instance; /**< Other live copies of this mob */
+  struct kw_entry *keywords;       /**< This char's keyword index entries */
 
   struct follow_type *followers; /**< List of characters following */
   struct char_data *master;      /**< List of character being followed */
@@ -1427,6 +1473,8 @@ struct index_data
 {
   mob_vnum vnum; /**< virtual number of this mob/obj   */
   int number; /**< number of existing units of this mob/obj  */
+  struct char_data *mobs; /**< Live units, if this indexes mobiles. */
+  struct obj_data *objs; /**< Live units, if this indexes objects. */
   /** Point to any SPECIAL function assoicated with mob/obj.
    * Note: These are not trigger scripts. They are functions hard coded in
    * the source code. */
@@ -1553,6 +1601,12 @@ struct game_operation
   int protocol_negotiation; /**< Enable the protocol negotiation system ? */
   int special_in_comm; /**< Enable use of a special character in communication channels ? */
   int debug_mode; /**< Current Debug Mode */
+  int script_pulse_lines; /**< Script lines allowed per pulse, 0 = no limit */
+  int script_pulse_msec; /**< Script time allowed per pulse, 0 = no limit */
+  int lazy_zones; /**< Populate zones on first player entry instead of at boot? */
+  int lazy_zone_idle; /**< Minutes a zone may sit empty before it is unloaded, 0 = never */
+  int binary_pfiles; /**< Write player files in the binary format? */
+  int binary_objfiles; /**< Write rent and house files in the binary format? */
 };
 
 /** The Autowizard options. */
@@ -0,0 +1,642 @@
+/* ************************************************************************
+*  file:  plrconv.c                                        Part of tbaMUD *
+*  Usage: convert player files between the ASCII and binary formats       *
+*  All Rights Reserved                                                    *
+************************************************************************* */
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include "structs.h"
+#include "utils.h"
+#include "db.h"
+#include "pfdefaults.h"
+#include "pfbinary.h"
+
+#define MAX_SECTION  (PFB_SEC_VARS + 1)
+
+static const char *pfb_tag[NUM_PFB_SCALARS] = {
+#define PFB_TAG(field, tag, width, def, kind) tag,
+  PFB_SCALARS(PFB_TAG)
+#undef PFB_TAG
+};
+
+static const int pfb_width[NUM_PFB_SCALARS] = {
+#define PFB_WIDTH(field, tag, width, def, kind) width,
+  PFB_SCALARS(PFB_WIDTH)
+#undef PFB_WIDTH
+};
+
+static const long long pfb_default[NUM_PFB_SCALARS] = {
+#define PFB_DEFAULT(field, tag, width, def, kind) def,
+  PFB_SCALARS(PFB_DEFAULT)
+#undef PFB_DEFAULT
+};
+
+static const int pfb_kind[NUM_PFB_SCALARS] = {
+#define PFB_KIND(field, tag, width, def, kind) kind,
+  PFB_SCALARS(PFB_KIND)
+#undef PFB_KIND
+};
+
+/* The ASCII tags of the PFB_TXT_ strings. */
+static const char *pfb_text_tag[NUM_PFB_TXT] = {
+  "Name", "Pass", "Titl", "Desc", "PfIn", "PfOt", "Host"
+};
+
+/* A player file on its way from one format to the other: the scalars, the
+ * strings, and the entries of every other section packed as in the binary
+ * format. */
+struct buf {
+  unsigned char *data;
+  size_t len, size;
+  int count;
+};
+
+struct pfile {
+  long long val[NUM_PFB_SCALARS];
+  char *text[NUM_PFB_TXT];
+  struct buf sec[MAX_SECTION];
+};
+
+struct reader {
+  const unsigned char *pos, *end;
+};
+
+bitvector_t asciiflag_conv(char *flag);
+int sprintascii(char *out, bitvector_t bits);
+
+static void put_int(struct buf *b, long long val, int width)
+{
+  int i;
+
+  if (b->len + width > b->size) {
+    b->size = b->size ? b->size * 2 : 256;
+    if (!(b->data = realloc(b->data, b->size))) {
+      perror("realloc");
+      exit(1);
+    }
+  }
+  for (i = 0; i < width; i++, val >>= 8)
+    b->data[b->len++] = (unsigned char) (val & 0xFF);
+}
+
+static void put_bytes(struct buf *b, const char *data, size_t len)
+{
+  while (len--)
+    put_int(b, *data++, 1);
+}
+
+static void put_str(struct buf *b, const char *str)
+{
+  size_t len = strlen(str) < 32767 ? strlen(str) : 32767;
+
+  put_int(b, len, 2);
+  put_bytes(b, str, len);
+}
+
+static long long get_int(struct reader *r, int width)
+{
+  unsigned long long val = 0;
+  int i;
+
+  if (r->end - r->pos < width) {
+    fprintf(stderr, "Player file is truncated.\n");
+    exit(1);
+  }
+  for (i = width - 1; i >= 0; i--)
+    val = (val << 8) | r->pos[i];
+  r->pos += width;
+
+  if (width < 8 && (val & (1ULL << (width * 8 - 1))))
+    val |= ~0ULL << (width * 8);
+  return ((long long) val);
+}
+
+static char *get_str(struct reader *r, int width)
+{
+  long long len = get_int(r, width);
+  char *str;
+
+  if (len < 0 || r->end - r->pos < len) {
+    fprintf(stderr, "Player file is truncated.\n");
+    exit(1);
+  }
+  if (!(str = calloc(len + 1, 1))) {
+    perror("calloc");
+    exit(1);
+  }
+  memcpy(str, r->pos, len);
+  r->pos += len;
+  return (str);
+}
+
+static int read_line(FILE *fl, char *buf)
+{
+  size_t len;
+
+  do {
+    if (!fgets(buf, MAX_STRING_LENGTH, fl))
+      return (0);
+  } while (*buf == '*' || *buf == '\n' || *buf == '\r');
+
+  len = strlen(buf);
+  while (len > 0 && (buf[len - 1] == '\n' || buf[len - 1] == '\r'))
+    buf[--len] = '\0';
+  return (1);
+}
+
+/* Read a '~' terminated string the way fread_string() does. */
+static char *read_tilde_string(FILE *fl)
+{
+  char line[MAX_STRING_LENGTH], text[MAX_STRING_LENGTH * 4], *tilde;
+  size_t len = 0;
+
+  *text = '\0';
+  while (fgets(line, sizeof(line), fl)) {
+    if ((tilde = strchr(line, '~')) != NULL)
+      *tilde = '\0';
+    else
+      line[strcspn(line, "\r\n")] = '\0';
+    len += snprintf(text + len, sizeof(text) - len, "%s%s", line, tilde ? "" : "\r\n");
+    if (tilde || len >= sizeof(text))
+      break;
+  }
+  return (strdup(text));
+}
+
+static void read_ascii(FILE *fl, struct pfile *pf)
+{
+  char line[MAX_STRING_LENGTH], tag[MAX_INPUT_LENGTH], *arg;
+  char f[4][MAX_INPUT_LENGTH];
+  long long a, b, c, d, e, g, h, k;
+  unsigned int byte;
+  int i, n, count;
+
+  while (read_line(fl, line)) {
+    n = strcspn(line, ":");
+    snprintf(tag, sizeof(tag), "%.*s", n, line);
+    for (arg = line + n; *arg == ':' || *arg == ' '; arg++)
+      ;
+
+    for (i = 0; i < NUM_PFB_TXT; i++)
+      if (!strcmp(tag, pfb_text_tag[i]))
+        break;
+    if (i < NUM_PFB_TXT) {
+      if (pf->text[i])
+        free(pf->text[i]);
+      pf->text[i] = i == PFB_TXT_DESC ? read_tilde_string(fl) : strdup(arg);
+      continue;
+    }
+
+    for (i = 0; i < NUM_PFB_SCALARS; i++)
+      if (pfb_kind[i] != PFB_MORE && !strcmp(tag, pfb_tag[i]))
+        break;
+    if (i < NUM_PFB_SCALARS) {
+      if (pfb_kind[i] == PFB_PAIR) {
+        a = b = 0;
+        sscanf(arg, "%lld/%lld", &a, &b);
+        pf->val[i] = a;
+        pf->val[i + 1] = b;
+      } else if (pfb_kind[i] == PFB_FLAGS) {
+        if (sscanf(arg, "%s %s %s %s", f[0], f[1], f[2], f[3]) == 4)
+          for (n = 0; n < 4; n++)
+            pf->val[i + n] = asciiflag_conv(f[n]);
+        else
+          pf->val[i] = asciiflag_conv(arg);
+      } else
+        pf->val[i] = atoll(arg);
+      continue;
+    }
+
+    if (!strcmp(tag, "Qpnt"))
+      pf->val[PFB_QSTP] = atoll(arg);
+    else if (!strcmp(tag, "Skil")) {
+      while (read_line(fl, line) && sscanf(line, "%lld %lld", &a, &b) == 2 && a != 0) {
+        put_int(&pf->sec[PFB_SEC_SKILLS], a, 2);
+        put_int(&pf->sec[PFB_SEC_SKILLS], b, 2);
+        pf->sec[PFB_SEC_SKILLS].count++;
+      }
+    } else if (!strcmp(tag, "Affs")) {
+      while (read_line(fl, line) && (n = sscanf(line, "%lld %lld %lld %lld %lld %lld %lld %lld", &a, &b, &c, &d, &e, &g, &h, &k)) >= 1 && a != 0) {
+        if (n != 8 && n != 5)
+          continue;
+        put_int(&pf->sec[PFB_SEC_AFFECTS], a, 2);
+        put_int(&pf->sec[PFB_SEC_AFFECTS], b, 4);
+        put_int(&pf->sec[PFB_SEC_AFFECTS], c, 2);
+        put_int(&pf->sec[PFB_SEC_AFFECTS], d, 2);
+        if (n == 5) {
+          /* Old single bit affects, as load_affects() reads them. */
+          unsigned int bits[4] = {0, 0, 0, 0};
+
+          if (e > 0 && e < NUM_AFF_FLAGS)
+            bits[e / 32] |= 1U << (e % 32);
+          e = bits[0]; g = bits[1]; h = bits[2]; k = bits[3];
+        }
+        put_int(&pf->sec[PFB_SEC_AFFECTS], e, 4);
+        put_int(&pf->sec[PFB_SEC_AFFECTS], g, 4);
+        put_int(&pf->sec[PFB_SEC_AFFECTS], h, 4);
+        put_int(&pf->sec[PFB_SEC_AFFECTS], k, 4);
+        pf->sec[PFB_SEC_AFFECTS].count++;
+      }
+    } else if (!strcmp(tag, "Alis")) {
+      char alias[MAX_STRING_LENGTH], repl[MAX_STRING_LENGTH];
+
+      for (count = atoi(arg); count > 0; count--) {
+        if (!read_line(fl, alias) || !read_line(fl, repl) || !read_line(fl, line))
+          break;
+        /* The server keeps a space in front of every replacement. */
+        put_str(&pf->sec[PFB_SEC_ALIASES], *alias == ' ' ? alias + 1 : alias);
+        if (*repl == ' ')
+          put_str(&pf->sec[PFB_SEC_ALIASES], repl);
+        else {
+          char spaced[MAX_STRING_LENGTH + 1];
+
+          snprintf(spaced, sizeof(spaced), " %s", repl);
+          put_str(&pf->sec[PFB_SEC_ALIASES], spaced);
+        }
+        put_int(&pf->sec[PFB_SEC_ALIASES], atoi(line), 1);
+        pf->sec[PFB_SEC_ALIASES].count++;
+      }
+    } else if (!strcmp(tag, "Qest")) {
+      while (read_line(fl, line) && (a = atoll(line)) != NOTHING) {
+        put_int(&pf->sec[PFB_SEC_QUESTS], a, 4);
+        pf->sec[PFB_SEC_QUESTS].count++;
+      }
+    } else if (!strcmp(tag, "Zonedisc")) {
+      pf->sec[PFB_SEC_ZONES].len = pf->sec[PFB_SEC_ZONES].count = 0;
+      for (i = 0; i < ZONE_FLAG_BYTES; i++) {
+        if (sscanf(arg + i * 2, "%02X", &byte) != 1)
+          byte = 0;
+        put_int(&pf->sec[PFB_SEC_ZONES], byte, 1);
+        pf->sec[PFB_SEC_ZONES].count++;
+      }
+    } else if (!strcmp(tag, "Kamt")) {
+      while (read_line(fl, line) && sscanf(line, "%lld %lld", &a, &b) == 2 && a != -1) {
+        put_int(&pf->sec[PFB_SEC_KILLS], a, 4);
+        put_int(&pf->sec[PFB_SEC_KILLS], b, 4);
+        pf->sec[PFB_SEC_KILLS].count++;
+      }
+    } else if (!strcmp(tag, "Knum")) {
+      while (read_line(fl, line) && atoi(line) != MAX_KILL_MEMORY)
+        ;
+    } else if (!strcmp(tag, "Trig")) {
+      put_int(&pf->sec[PFB_SEC_TRIGS], atoll(arg), 4);
+      pf->sec[PFB_SEC_TRIGS].count++;
+    } else if (!strcmp(tag, "Vars")) {
+      char name[MAX_INPUT_LENGTH];
+
+      for (count = atoi(arg); count > 0 && read_line(fl, line); count--) {
+        if (sscanf(line, "%s %lld %n", name, &a, &n) < 2)
+          continue;
+        put_str(&pf->sec[PFB_SEC_VARS], name);
+        put_int(&pf->sec[PFB_SEC_VARS], a, 8);
+        put_str(&pf->sec[PFB_SEC_VARS], line + n);
+        pf->sec[PFB_SEC_VARS].count++;
+      }
+    } else
+      fprintf(stderr, "Unknown tag %s, skipping it.\n", tag);
+  }
+}
+
+static void write_section(FILE *fl, int id, struct buf *b)
+{
+  struct buf head = { NULL, 0, 0, 0 };
+
+  put_int(&head, id, 1);
+  put_int(&head, b->len + 2, 4);
+  put_int(&head, b->count, 2);
+  fwrite(head.data, head.len, 1, fl);
+  if (b->len)
+    fwrite(b->data, b->len, 1, fl);
+  free(head.data);
+}
+
+static void write_binary(FILE *fl, struct pfile *pf)
+{
+  struct buf b = { NULL, 0, 0, 0 };
+  int i;
+
+  fwrite(PFB_MAGIC, PFB_MAGIC_LEN, 1, fl);
+  put_int(&b, PFB_VERSION, 2);
+  fwrite(b.data, b.len, 1, fl);
+
+  b.len = 0;
+  for (i = 0; i < NUM_PFB_SCALARS; i++)
+    put_int(&b, pf->val[i], pfb_width[i]);
+  b.count = NUM_PFB_SCALARS;
+  write_section(fl, PFB_SEC_SCALARS, &b);
+
+  b.len = b.count = 0;
+  for (i = 0; i < NUM_PFB_TXT; i++)
+    if (pf->text[i]) {
+      put_int(&b, i, 1);
+      put_int(&b, strlen(pf->text[i]), 4);
+      put_bytes(&b, pf->text[i], strlen(pf->text[i]));
+      b.count++;
+    }
+  write_section(fl, PFB_SEC_TEXT, &b);
+  free(b.data);
+
+  /* Immortals have no skills section; the server gives them every skill. */
+  for (i = PFB_SEC_SKILLS; i < MAX_SECTION; i++)
+    if (i != PFB_SEC_SKILLS || pf->val[PFB_LEVEL] < LVL_IMMORT)
+      write_section(fl, i, &pf->sec[i]);
+}
+
+static void read_binary(FILE *fl, struct pfile *pf)
+{
+  struct reader r, sec;
+  unsigned char *data;
+  long size;
+  int id, count, i, which;
+
+  fseek(fl, 0, SEEK_END);
+  size = ftell(fl) - PFB_MAGIC_LEN;
+  fseek(fl, PFB_MAGIC_LEN, SEEK_SET);
+  if (size < 2 || !(data = malloc(size)) || fread(data, size, 1, fl) != 1) {
+    fprintf(stderr, "Player file is truncated.\n");
+    exit(1);
+  }
+  r.pos = data;
+  r.end = data + size;
+
+  if ((i = get_int(&r, 2)) > PFB_VERSION) {
+    fprintf(stderr, "Player file is version %d, this program reads up to %d.\n", i, PFB_VERSION);
+    exit(1);
+  }
+
+  while (r.pos < r.end) {
+    id = get_int(&r, 1);
+    size = get_int(&r, 4);
+    if (size < 2 || r.end - r.pos < size) {
+      fprintf(stderr, "Player file is truncated.\n");
+      exit(1);
+    }
+    sec.pos = r.pos;
+    sec.end = r.pos + size;
+    r.pos += size;
+    count = get_int(&sec, 2);
+
+    if (id == PFB_SEC_SCALARS) {
+      for (i = 0; i < count && i < NUM_PFB_SCALARS; i++)
+        pf->val[i] = get_int(&sec, pfb_width[i]);
+    } else if (id == PFB_SEC_TEXT) {
+      for (i = 0; i < count; i++) {
+        which = get_int(&sec, 1);
+        if (which >= 0 && which < NUM_PFB_TXT)
+          pf->text[which] = get_str(&sec, 4);
+        else
+          free(get_str(&sec, 4));
+      }
+    } else if (id > 0 && id < MAX_SECTION) {
+      pf->sec[id].len = 0;
+      put_bytes(&pf->sec[id], (const char *) sec.pos, sec.end - sec.pos);
+      pf->sec[id].count = count;
+    } else
+      fprintf(stderr, "Unknown section %d, skipping it.\n", id);
+  }
+  free(data);
+}
+
+static void write_flags(FILE *fl, const char *tag, const long long *val)
+{
+  char bits[4][127];
+  int i;
+
+  for (i = 0; i < 4; i++)
+    sprintascii(bits[i], (bitvector_t) val[i]);
+  fprintf(fl, "%s: %s %s %s %s\n", tag, bits[0], bits[1], bits[2], bits[3]);
+}
+
+static void write_ascii(FILE *fl, struct pfile *pf)
+{
+  struct reader r;
+  char *str, *str2;
+  long long a;
+  int i, n;
+
+  for (i = 0; i < NUM_PFB_TXT; i++) {
+    if (!pf->text[i])
+      continue;
+    if (i == PFB_TXT_DESC) {
+      if (!*pf->text[i])
+        continue;
+      for (str = str2 = pf->text[i]; *str; str++)
+        if (*str != '\r')
+          *str2++ = *str;
+      *str2 = '\0';
+      fprintf(fl, "Desc:\n%s~\n", pf->text[i]);
+    } else
+      fprintf(fl, "%s: %s\n", pfb_text_tag[i], pf->text[i]);
+  }
+
+  for (i = 0; i < NUM_PFB_SCALARS; i++) {
+    switch (pfb_kind[i]) {
+    case PFB_NUM:
+      /* Immortals' conditions are not saved; see save_char(). */
+      if ((i == PFB_HUNG || i == PFB_THIR || i == PFB_DRNK) && pf->val[PFB_LEVEL] >= LVL_IMMORT)
+        break;
+      if (pf->val[i] != pfb_default[i])
+        fprintf(fl, "%s: %lld\n", pfb_tag[i], pf->val[i]);
+      break;
+    case PFB_ALWAYS:
+      fprintf(fl, "%s: %lld\n", pfb_tag[i], pf->val[i]);
+      break;
+    case PFB_PAIR:
+      if (pf->val[i] != pfb_default[i] || pf->val[i + 1] != pfb_default[i + 1])
+        fprintf(fl, "%s: %lld/%lld\n", pfb_tag[i], pf->val[i], pf->val[i + 1]);
+      break;
+    case PFB_FLAGS:
+      write_flags(fl, pfb_tag[i], pf->val + i);
+      break;
+    }
+  }
+
+  r.pos = pf->sec[PFB_SEC_KILLS].data;
+  r.end = r.pos + pf->sec[PFB_SEC_KILLS].len;
+  fprintf(fl, "Kamt:\n");
+  for (i = 0; i < pf->sec[PFB_SEC_KILLS].count; i++) {
+    a = get_int(&r, 4);
+    fprintf(fl, "%lld %lld\n", a, get_int(&r, 4));
+  }
+  fprintf(fl, "-1 -1\n");
+
+  if (pf->sec[PFB_SEC_QUESTS].count) {
+    r.pos = pf->sec[PFB_SEC_QUESTS].data;
+    r.end = r.pos + pf->sec[PFB_SEC_QUESTS].len;
+    fprintf(fl, "Qest:\n");
+    for (i = 0; i < pf->sec[PFB_SEC_QUESTS].count; i++)
+      fprintf(fl, "%lld\n", get_int(&r, 4));
+    fprintf(fl, "%d\n", NOTHING);
+  }
+
+  r.pos = pf->sec[PFB_SEC_ZONES].data;
+  r.end = r.pos + pf->sec[PFB_SEC_ZONES].len;
+  fprintf(fl, "Zonedisc: ");
+  for (i = 0; i < ZONE_FLAG_BYTES; i++)
+    fprintf(fl, "%02X", i < pf->sec[PFB_SEC_ZONES].count ? (unsigned int) get_int(&r, 1) & 0xFF : 0);
+  fprintf(fl, "\n");
+
+  r.pos = pf->sec[PFB_SEC_TRIGS].data;
+  r.end = r.pos + pf->sec[PFB_SEC_TRIGS].len;
+  for (i = 0; i < pf->sec[PFB_SEC_TRIGS].count; i++)
+    fprintf(fl, "Trig: %lld\n", get_int(&r, 4));
+
+  if (pf->val[PFB_LEVEL] < LVL_IMMORT) {
+    r.pos = pf->sec[PFB_SEC_SKILLS].data;
+    r.end = r.pos + pf->sec[PFB_SEC_SKILLS].len;
+    fprintf(fl, "Skil:\n");
+    for (i = 0; i < pf->sec[PFB_SEC_SKILLS].count; i++) {
+      a = get_int(&r, 2);
+      fprintf(fl, "%lld %lld\n", a, get_int(&r, 2));
+    }
+    fprintf(fl, "0 0\n");
+  }
+
+  if (pf->sec[PFB_SEC_AFFECTS].count) {
+    r.pos = pf->sec[PFB_SEC_AFFECTS].data;
+    r.end = r.pos + pf->sec[PFB_SEC_AFFECTS].len;
+    fprintf(fl, "Affs:\n");
+    for (i = 0; i < pf->sec[PFB_SEC_AFFECTS].count; i++) {
+      fprintf(fl, "%lld", get_int(&r, 2));
+      fprintf(fl, " %lld", get_int(&r, 4));
+      fprintf(fl, " %lld", get_int(&r, 2));
+      fprintf(fl, " %lld", get_int(&r, 2));
+      for (n = 0; n < 4; n++)
+        fprintf(fl, " %lld", get_int(&r, 4));
+      fprintf(fl, "\n");
+    }
+    fprintf(fl, "0 0 0 0 0 0 0 0\n");
+  }
+
+  if (pf->sec[PFB_SEC_ALIASES].count) {
+    r.pos = pf->sec[PFB_SEC_ALIASES].data;
+    r.end = r.pos + pf->sec[PFB_SEC_ALIASES].len;
+    fprintf(fl, "Alis: %d\n", pf->sec[PFB_SEC_ALIASES].count);
+    for (i = 0; i < pf->sec[PFB_SEC_ALIASES].count; i++) {
+      str = get_str(&r, 2);
+      str2 = get_str(&r, 2);
+      fprintf(fl, " %s\n%s\n%lld\n", str, str2, get_int(&r, 1));
+      free(str);
+      free(str2);
+    }
+  }
+
+  if (pf->sec[PFB_SEC_VARS].count) {
+    r.pos = pf->sec[PFB_SEC_VARS].data;
+    r.end = r.pos + pf->sec[PFB_SEC_VARS].len;
+    fprintf(fl, "Vars: %d\n", pf->sec[PFB_SEC_VARS].count);
+    for (i = 0; i < pf->sec[PFB_SEC_VARS].count; i++) {
+      str = get_str(&r, 2);
+      a = get_int(&r, 8);
+      str2 = get_str(&r, 2);
+      fprintf(fl, "%s %lld %s\n", str, a, str2);
+      free(str);
+      free(str2);
+    }
+  }
+}
+
+static void convert(int to_binary, const char *in, const char *out)
+{
+  struct pfile pf;
+  char magic[PFB_MAGIC_LEN], tmpname[PATH_MAX];
+  FILE *fl;
+  int i, is_binary;
+
+  memset(&pf, 0, sizeof(pf));
+  for (i = 0; i < NUM_PFB_SCALARS; i++)
+    pf.val[i] = pfb_default[i];
+
+  if (!(fl = fopen(in, "rb"))) {
+    perror(in);
+    exit(1);
+  }
+  is_binary = fread(magic, PFB_MAGIC_LEN, 1, fl) == 1 && !memcmp(magic, PFB_MAGIC, PFB_MAGIC_LEN);
+  if (is_binary == to_binary) {
+    printf("%s is already %s.\n", in, to_binary ? "binary" : "ASCII");
+    fclose(fl);
+    return;
+  }
+  if (is_binary)
+    read_binary(fl, &pf);
+  else {
+    rewind(fl);
+    read_ascii(fl, &pf);
+  }
+  fclose(fl);
+
+  /* Write next to the output and rename, so in and out may be the same. */
+  snprintf(tmpname, sizeof(tmpname), "%s.tmp", out);
+  if (!(fl = fopen(tmpname, "wb"))) {
+    perror(tmpname);
+    exit(1);
+  }
+  if (to_binary)
+    write_binary(fl, &pf);
+  else
+    write_ascii(fl, &pf);
+  if (fclose(fl) || rename(tmpname, out)) {
+    perror(out);
+    exit(1);
+  }
+
+  for (i = 0; i < NUM_PFB_TXT; i++)
+    if (pf.text[i])
+      free(pf.text[i]);
+  for (i = 0; i < MAX_SECTION; i++)
+    if (pf.sec[i].data)
+      free(pf.sec[i].data);
+}
+
+int main(int argc, char **argv)
+{
+  if ((argc != 3 && argc != 4) || (strcmp(argv[1], "-a") && strcmp(argv[1], "-b"))) {
+    printf("Usage: %s <-a|-b> playerfile [outfile]\n"
+           "  -a converts to ASCII, -b to binary. Without an outfile the\n"
+           "  player file is converted in place.\n", argv[0]);
+    return (1);
+  }
+  convert(argv[1][1] == 'b', argv[2], argc == 4 ? argv[3] : argv[2]);
+  return (0);
+}
+
+bitvector_t asciiflag_conv(char *flag)
+{
+  bitvector_t flags = 0;
+  int is_num = TRUE;
+  char *p;
+
+  for (p = flag; *p; p++) {
+    if (islower(*p))
+      flags |= 1 << (*p - 'a');
+    else if (isupper(*p))
+      flags |= 1 << (26 + (*p - 'A'));
+
+    if (!isdigit(*p) && (*p != '-' || p != flag))
+      is_num = FALSE;
+  }
+
+  if (is_num)
+    flags = atol(flag);
+
+  return (flags);
+}
+
+int sprintascii(char *out, bitvector_t bits)
+{
+  int i, j = 0;
+  /* 32 bits, don't just add letters to try to get more unless your bitvector_t is also as large. */
+  char *flags = "abcdefghijklmnopqrstuvwxyzABCDEF";
+
+  for (i = 0; flags[i] != '\0'; i++)
+    if (bits & (1 << i))
+      out[j++] = flags[i];
+
+  if (j == 0) /* Didn't write anything. */
+    out[j++] = '0';
+
+  out[j++] = '\0';
+  return j;
+}
@@ -25,10 +25,19 @@
 #include "genolc.h"
 #include "cJSON.h"
 #include "account.h"
+#include "kwindex.h"
+#include "savequeue.h"
 #include <sys/stat.h>
 
+#if defined(HAVE_LIBPTHREAD) && defined(CIRCLE_UNIX)
+#define PERSIST_THREADED
+#include <pthread.h>
+#endif
+
 
 #define MAX_PERSIST_OBJS 1000
+/* Threads reading and parsing persistent room files at boot. */
+#define PERSIST_LOAD_THREADS 4
 
 /* Stash API (enkla wrappers för kommandot mm.) */
 void acc_stash_list(struct char_data *ch);
@@ -36,8 +45,8 @@ bool acc_stash_put_obj(struct char_data *ch, struct obj_data *obj);
 bool acc_stash_take_to_char(struct char_data *ch, int slot);
 bool acc_stash_set_capacity(struct char_data *ch, int newcap);
 /* Forward declarations (place before stash_save_json / stash_load_json) */
-static cJSON *json_from_obj(struct obj_data *obj, bool include_contents);
 static struct obj_data *obj_from_json_node(const cJSON *jo, bool include_contents);
+static void json_write_obj(FILE *fp, struct obj_data *obj, bool include_contents);
 static bool stash_load_json(const char *accname, struct account_stash **out);
 static bool stash_save_json(const char *accname, const struct account_stash *st);
 bool acc_stash_put_obj_in_slot(struct char_data *ch, struct obj_data *obj, int slot);
@@ -1695,47 +1704,164 @@ int get_crit_damage(struct char_data *ch) {
 
 bool room_dirty[MAX_PERSISTENT_ROOMS] = { FALSE };
 
+/* The rooms set in room_dirty, in the order they were first marked. */
+static room_vnum *dirty_rooms = NULL;
+static int num_dirty_rooms = 0, max_dirty_rooms = 0;
+
+/* Rooms that may have a file in PERSISTENT_PATH, as listed in PERSIST_MANIFEST.
+ * A room is listed before its first file is written and unlisted after its
+ * file is removed, so the list never misses a file, even after a crash. */
+static bool room_saved[MAX_PERSISTENT_ROOMS] = { FALSE };
+static bool manifest_dirty = FALSE;
+
+static cJSON *room_read_json(room_vnum vnum);
+static void room_place_objects(room_rnum room, cJSON *root);
+
+static void persist_write_manifest(void) {
+  FILE *fp;
+
+  if (!(fp = saveq_open(PERSIST_MANIFEST)))
+    return;
+  for (room_rnum i = 0; i <= top_of_world; i++)
+    if (world[i].number < MAX_PERSISTENT_ROOMS && room_saved[world[i].number])
+      fprintf(fp, "%d\n", world[i].number);
+  saveq_commit(fp);
+  manifest_dirty = FALSE;
+}
+
+/* Returns FALSE if there is no manifest, and every room must be tried. */
+static bool persist_read_manifest(void) {
+  FILE *fp;
+  int vnum;
+
+  if (!(fp = fopen(PERSIST_MANIFEST, "r")))
+    return FALSE;
+  while (fscanf(fp, "%d", &vnum) == 1)
+    if (vnum >= 0 && vnum < MAX_PERSISTENT_ROOMS)
+      room_saved[vnum] = TRUE;
+  fclose(fp);
+  return TRUE;
+}
+
 /**
  * Marks a room as dirty, indicating that it has been modified and needs to be saved.
- * This function sets the corresponding entry in the room_dirty array to TRUE
- * for the specified room virtual number.
+ * The room is saved by the next room_save_dirty_rooms(), however many times
+ * it is marked before then.
  * @param vnum The virtual number of the room to mark as dirty.
  */
 void mark_room_dirty(room_vnum vnum) {
-  if (vnum >= 0 && vnum < MAX_PERSISTENT_ROOMS) {
+  if (vnum >= 0 && vnum < MAX_PERSISTENT_ROOMS && !room_dirty[vnum]) {
     room_dirty[vnum] = TRUE;
-    mudlog(BRF, LVL_IMPL, TRUE, ">> Marked room %d as dirty", vnum);
-    room_save_objects(vnum);
+    if (num_dirty_rooms == max_dirty_rooms) {
+      max_dirty_rooms = MAX(32, max_dirty_rooms * 2);
+      RECREATE(dirty_rooms, room_vnum, max_dirty_rooms);
+    }
+    dirty_rooms[num_dirty_rooms++] = vnum;
   }
 }
 
 /**
  * Save all dirty persistent rooms.
- * This function iterates through all persistent rooms and saves those that
- * have been marked as dirty.
+ * Called every PULSE_PERSIST and before shutdown or copyover. The files are
+ * written by the save queue.
  */
 void room_save_dirty_rooms(void) {
-  for (int i = 0; i <= top_of_world; i++) {
-    room_vnum vnum = world[i].number;
+  for (int i = 0; i < num_dirty_rooms; i++) {
+    room_dirty[dirty_rooms[i]] = FALSE;
+    room_save_objects(dirty_rooms[i]);
+  }
+  num_dirty_rooms = 0;
 
-    if (ROOM_FLAGGED(i, ROOM_PERSISTENT) && room_dirty[vnum]) {
-      room_save_objects(vnum);
-      mudlog(CMP, LVL_IMMORT, TRUE, "Dirty save room called for: %d", vnum);
-      room_dirty[vnum] = FALSE;
-    }
+  if (manifest_dirty)
+    persist_write_manifest();
+}
+
+/* Boot-time restore. Reading and parsing the room files is spread over
+ * worker threads; making the objects, which touches the world, is left to the
+ * game thread. */
+struct persist_load {
+  room_rnum rnum;
+  cJSON *root;
+};
+
+static struct persist_load *persist_jobs;
+static int persist_num_jobs, persist_next_job;
+
+#ifdef PERSIST_THREADED
+static pthread_mutex_t persist_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void *persist_load_worker(void *unused) {
+  int i;
+
+  for (;;) {
+#ifdef PERSIST_THREADED
+    pthread_mutex_lock(&persist_lock);
+#endif
+    i = persist_next_job++;
+#ifdef PERSIST_THREADED
+    pthread_mutex_unlock(&persist_lock);
+#endif
+    if (i >= persist_num_jobs)
+      break;
+    persist_jobs[i].root = room_read_json(world[persist_jobs[i].rnum].number);
   }
+  return NULL;
 }
 
 /**
  * Load all persistent rooms and their objects.
- * This function iterates through all rooms in the world and loads objects
- * for those marked as persistent.
+ * Only rooms in PERSIST_MANIFEST are read; without one, every persistent
+ * room is tried and a manifest is written.
  */
 void load_persistent_rooms(void) {
-  for (room_rnum i = 0; i <= top_of_world; i++) {
-    if (ROOM_FLAGGED(i, ROOM_PERSISTENT))
-      room_load_objects(world[i].number);  // world[i].number = real vnum
+  bool have_manifest = persist_read_manifest();
+  int i, count = 0;
+
+  CREATE(persist_jobs, struct persist_load, top_of_world + 1);
+  persist_num_jobs = persist_next_job = 0;
+  for (room_rnum r = 0; r <= top_of_world; r++)
+    if (ROOM_FLAGGED(r, ROOM_PERSISTENT) && world[r].number < MAX_PERSISTENT_ROOMS &&
+        (!have_manifest || room_saved[world[r].number]))
+      persist_jobs[persist_num_jobs++].rnum = r;
+
+#ifdef PERSIST_THREADED
+  {
+    pthread_t threads[PERSIST_LOAD_THREADS];
+    int started = 0;
+
+    for (i = 0; i < PERSIST_LOAD_THREADS - 1 && i < persist_num_jobs - 1; i++)
+      if (pthread_create(&threads[started], NULL, persist_load_worker, NULL) == 0)
+        started++;
+    persist_load_worker(NULL);
+    for (i = 0; i < started; i++)
+      pthread_join(threads[i], NULL);
+  }
+#else
+  persist_load_worker(NULL);
+#endif
+
+  for (i = 0; i < persist_num_jobs; i++) {
+    room_vnum vnum = world[persist_jobs[i].rnum].number;
+
+    room_saved[vnum] = (persist_jobs[i].root != NULL);
+    if (persist_jobs[i].root) {
+      room_place_objects(persist_jobs[i].rnum, persist_jobs[i].root);
+      cJSON_Delete(persist_jobs[i].root);
+      count++;
+    }
   }
+  free(persist_jobs);
+  persist_jobs = NULL;
+
+  /* What was just loaded is what is on disk already. */
+  for (i = 0; i < num_dirty_rooms; i++)
+    room_dirty[dirty_rooms[i]] = FALSE;
+  num_dirty_rooms = 0;
+
+  if (!have_manifest)
+    persist_write_manifest();
+  log("   Restored %d persistent rooms.", count);
 }
 
 /**
@@ -1749,9 +1875,6 @@ bool should_persist_object(struct obj_data *obj) {
   if (!obj)
     return FALSE;
 
-   mudlog(BRF, LVL_IMPL, TRUE, "Checking persist: %s (flags: %d)", 
-         obj->short_description ? obj->short_description : "<null>", 
-         GET_OBJ_EXTRA(obj)[0]);
   // Skip corpses
   if (GET_OBJ_TYPE(obj) == ITEM_CONTAINER && GET_OBJ_VAL(obj, 3) == 1)
     return FALSE;
@@ -1765,200 +1888,110 @@ bool should_persist_object(struct obj_data *obj) {
 
 /**
  * Saves all objects in a room to a JSON file.
- * This function iterates through all objects in the specified room and
- * writes their properties to a JSON file named "room_<vnum>.json".
+ * This function writes every object in the specified room, and everything
+ * inside them, as a JSON array to "room_<vnum>.json". The file is replaced
+ * whole by the save queue, never left half written.
  * @param vnum The virtual number of the room to save objects from.
  */
 void room_save_objects(room_vnum vnum) {
   FILE *fp;
   char filename[256];
+  struct obj_data *obj;
+  bool first = TRUE;
   int room = real_room(vnum);
   if (room == NOWHERE)
     return;
 
   snprintf(filename, sizeof(filename), "%sroom_%d.json", PERSISTENT_PATH, vnum);
-  fp = fopen(filename, "w");
-  if (!fp)
+
+  for (obj = world[room].contents; obj && !should_persist_object(obj); obj = obj->next_content)
+    ;
+  if (!obj) {
+    /* Nothing to keep: no file, and no need to open one at boot. */
+    saveq_wait(filename);
+    if (remove(filename) < 0 && errno != ENOENT)
+      log("SYSERR: removing %s: %s", filename, strerror(errno));
+    else if (vnum < MAX_PERSISTENT_ROOMS && room_saved[vnum]) {
+      room_saved[vnum] = FALSE;
+      manifest_dirty = TRUE;
+    }
     return;
+  }
+  if (vnum < MAX_PERSISTENT_ROOMS && !room_saved[vnum]) {
+    room_saved[vnum] = TRUE;
+    persist_write_manifest();
+  }
 
-  cJSON *root = cJSON_CreateArray();
+  if (!(fp = saveq_open(filename)))
+    return;
 
-  for (struct obj_data *obj = world[room].contents; obj; obj = obj->next_content) {
+  fputc('[', fp);
+  for (obj = world[room].contents; obj; obj = obj->next_content) {
     if (!should_persist_object(obj)) continue;
-
-    cJSON *json_obj = cJSON_CreateObject();
-    cJSON_AddNumberToObject(json_obj, "vnum", GET_OBJ_VNUM(obj));
-    cJSON_AddStringToObject(json_obj, "name", obj->name ?: "undefined");
-    cJSON_AddStringToObject(json_obj, "short", obj->short_description ?: "undefined");
-    cJSON_AddStringToObject(json_obj, "desc", obj->description ?: "undefined");
-    cJSON_AddNumberToObject(json_obj, "type", GET_OBJ_TYPE(obj));
-    cJSON_AddNumberToObject(json_obj, "weight", GET_OBJ_WEIGHT(obj));
-    cJSON_AddNumberToObject(json_obj, "cost", GET_OBJ_COST(obj));
-    cJSON_AddNumberToObject(json_obj, "timer", GET_OBJ_TIMER(obj));
-    cJSON_AddNumberToObject(json_obj, "level", obj->obj_flags.level);
-
-    cJSON *val = cJSON_CreateIntArray(&(obj->obj_flags.value[0]), 4);
-    cJSON *extra = cJSON_CreateIntArray(GET_OBJ_EXTRA(obj), 4);
-    cJSON *wear = cJSON_CreateIntArray(GET_OBJ_WEAR(obj), 4);
-    cJSON_AddItemToObject(json_obj, "val", val);
-    cJSON_AddItemToObject(json_obj, "extra", extra);
-    cJSON_AddItemToObject(json_obj, "wear", wear);
-
-    if (GET_OBJ_TYPE(obj) == ITEM_CONTAINER && obj->contains) {
-      cJSON *contents = cJSON_CreateArray();
-      for (struct obj_data *cont = obj->contains; cont; cont = cont->next_content) {
-        if (!should_persist_object(cont)) continue;
-        cJSON *json_cont = cJSON_CreateObject();
-        cJSON_AddNumberToObject(json_cont, "vnum", GET_OBJ_VNUM(cont));
-        cJSON_AddStringToObject(json_cont, "name", cont->name ?: "undefined");
-        cJSON_AddStringToObject(json_cont, "short", cont->short_description ?: "undefined");
-        cJSON_AddStringToObject(json_cont, "desc", cont->description ?: "undefined");
-        cJSON_AddNumberToObject(json_cont, "type", GET_OBJ_TYPE(cont));
-        cJSON_AddNumberToObject(json_cont, "weight", GET_OBJ_WEIGHT(cont));
-        cJSON_AddNumberToObject(json_cont, "cost", GET_OBJ_COST(cont));
-        cJSON_AddNumberToObject(json_cont, "timer", GET_OBJ_TIMER(cont));
-        cJSON_AddNumberToObject(json_cont, "level", cont->obj_flags.level);
-
-        cJSON *v2 = cJSON_CreateIntArray(&(cont->obj_flags.value[0]), 4);
-        cJSON *e2 = cJSON_CreateIntArray(GET_OBJ_EXTRA(cont), 4);
-        cJSON *w2 = cJSON_CreateIntArray(GET_OBJ_WEAR(cont), 4);
-        cJSON_AddItemToObject(json_cont, "val", v2);
-        cJSON_AddItemToObject(json_cont, "extra", e2);
-        cJSON_AddItemToObject(json_cont, "wear", w2);
-
-        cJSON_AddItemToArray(contents, json_cont);
-      }
-      cJSON_AddItemToObject(json_obj, "contents", contents);
-    }
-
-    cJSON_AddItemToArray(root, json_obj);
+    if (!first)
+      fputc(',', fp);
+    fputc('\n', fp);
+    json_write_obj(fp, obj, TRUE);
+    first = FALSE;
   }
+  fputs("\n]\n", fp);
 
-  char *out = cJSON_Print(root);
-  fprintf(fp, "%s", out);
-  fclose(fp);
-
-  free(out);
-  cJSON_Delete(root);
-}  
+  saveq_commit(fp);
+}
 
 
-/**
- * Loads persistent objects from a JSON file into a room.
- * This function reads the JSON file corresponding to the room's virtual number
- * and populates the room with objects defined in that file.
- * @param vnum The virtual number of the room to load objects into.
- */
-void room_load_objects(room_vnum vnum) {
+/* Read and parse a room's file. Safe to call off the game thread: it only
+ * reads the file. Returns NULL if there is no file or it is unreadable. */
+static cJSON *room_read_json(room_vnum vnum) {
   FILE *fp;
   char filename[256];
-  int room = real_room(vnum);
-  struct stat st;
-
-  if (room == NOWHERE)
-    return;
+  char *buffer;
+  cJSON *root;
+  long len;
 
   snprintf(filename, sizeof(filename), "%sroom_%d.json", PERSISTENT_PATH, vnum);
-  if (stat(filename, &st) != 0)
-    return;
-
-  fp = fopen(filename, "r");
-  if (!fp)
-    return;
+  if (!(fp = fopen(filename, "r")))
+    return NULL;
 
   fseek(fp, 0, SEEK_END);
-  long len = ftell(fp);
+  len = ftell(fp);
   rewind(fp);
 
-  char *buffer = malloc(len + 1);
+  buffer = malloc(len + 1);
   if (fread(buffer, 1, len, fp) != len) {
     fclose(fp);
     free(buffer);
     log("SYSERR: Failed to read full JSON room file for room %d", vnum);
-    return;
+    return NULL;
   }
   buffer[len] = '\0';
   fclose(fp);
 
-  cJSON *root = cJSON_Parse(buffer);
+  root = cJSON_Parse(buffer);
   free(buffer);
   if (!root || !cJSON_IsArray(root)) {
+    log("SYSERR: Persistent room file for room %d is not a JSON array", vnum);
     cJSON_Delete(root);
-    return;
+    return NULL;
   }
+  return root;
+}
 
-  int obj_count = cJSON_GetArraySize(root);
+/* Make the objects a parsed room file describes and put them in the room. */
+static void room_place_objects(room_rnum room, cJSON *root) {
+  cJSON *json_obj;
+  int i = 0;
 
-  for (int i = 0; i < obj_count && i < MAX_PERSIST_OBJS; i++) {
-    cJSON *json_obj = cJSON_GetArrayItem(root, i);
+  cJSON_ArrayForEach(json_obj, root) {
+    if (i++ >= MAX_PERSIST_OBJS)
+      break;
     if (!cJSON_IsObject(json_obj)) continue;
 
-    cJSON *v = cJSON_GetObjectItem(json_obj, "vnum");
-    if (!cJSON_IsNumber(v)) continue;
-
-    struct obj_data *proto = read_object(v->valueint, VIRTUAL);
-    if (!proto) continue;
-
-    struct obj_data *obj = create_obj();
-    memcpy(obj, proto, sizeof(struct obj_data));
-
-    obj->name = strdup(cJSON_GetStringValue(cJSON_GetObjectItem(json_obj, "name")) ?: "undefined");
-    obj->short_description = strdup(cJSON_GetStringValue(cJSON_GetObjectItem(json_obj, "short")) ?: "undefined");
-    obj->description = strdup(cJSON_GetStringValue(cJSON_GetObjectItem(json_obj, "desc")) ?: "undefined");
-
-    GET_OBJ_TYPE(obj) = cJSON_GetObjectItem(json_obj, "type")->valueint;
-    GET_OBJ_WEIGHT(obj) = cJSON_GetObjectItem(json_obj, "weight")->valueint;
-    GET_OBJ_COST(obj) = cJSON_GetObjectItem(json_obj, "cost")->valueint;
-    GET_OBJ_TIMER(obj) = cJSON_GetObjectItem(json_obj, "timer")->valueint;
-    obj->obj_flags.level = cJSON_GetObjectItem(json_obj, "level")->valueint;
-
-    cJSON *val = cJSON_GetObjectItem(json_obj, "val");
-    cJSON *extra = cJSON_GetObjectItem(json_obj, "extra");
-    cJSON *wear = cJSON_GetObjectItem(json_obj, "wear");
-
-    for (int j = 0; j < 4; j++) {
-      GET_OBJ_VAL(obj, j) = cJSON_GetArrayItem(val, j)->valueint;
-      GET_OBJ_EXTRA(obj)[j] = cJSON_GetArrayItem(extra, j)->valueint;
-      GET_OBJ_WEAR(obj)[j] = cJSON_GetArrayItem(wear, j)->valueint;
-    }
-
-    // Handle contained objects
-    cJSON *contents = cJSON_GetObjectItem(json_obj, "contents");
-    if (cJSON_IsArray(contents)) {
-      for (cJSON *child = contents->child; child; child = child->next) {
-        struct obj_data *contained = read_object(cJSON_GetObjectItem(child, "vnum")->valueint, VIRTUAL);
-        if (!contained) continue;
-        struct obj_data *child_obj = create_obj();
-        memcpy(child_obj, contained, sizeof(struct obj_data));
-
-        child_obj->name = strdup(cJSON_GetStringValue(cJSON_GetObjectItem(child, "name")) ?: "undefined");
-        child_obj->short_description = strdup(cJSON_GetStringValue(cJSON_GetObjectItem(child, "short")) ?: "undefined");
-        child_obj->description = strdup(cJSON_GetStringValue(cJSON_GetObjectItem(child, "desc")) ?: "undefined");
-
-        GET_OBJ_TYPE(child_obj) = cJSON_GetObjectItem(child, "type")->valueint;
-        GET_OBJ_WEIGHT(child_obj) = cJSON_GetObjectItem(child, "weight")->valueint;
-        GET_OBJ_COST(child_obj) = cJSON_GetObjectItem(child, "cost")->valueint;
-        GET_OBJ_TIMER(child_obj) = cJSON_GetObjectItem(child, "timer")->valueint;
-        child_obj->obj_flags.level = cJSON_GetObjectItem(child, "level")->valueint;
-
-        cJSON *v2 = cJSON_GetObjectItem(child, "val");
-        cJSON *e2 = cJSON_GetObjectItem(child, "extra");
-        cJSON *w2 = cJSON_GetObjectItem(child, "wear");
-
-        for (int j = 0; j < 4; j++) {
-          GET_OBJ_VAL(child_obj, j) = cJSON_GetArrayItem(v2, j)->valueint;
-          GET_OBJ_EXTRA(child_obj)[j] = cJSON_GetArrayItem(e2, j)->valueint;
-          GET_OBJ_WEAR(child_obj)[j] = cJSON_GetArrayItem(w2, j)->valueint;
-        }
-
-        obj_to_obj(child_obj, obj);
-      }
-    }
+    struct obj_data *obj = obj_from_json_node(json_obj, TRUE);
+    if (!obj) continue;
 
     obj_to_room(obj, room);
   }
-
-  cJSON_Delete(root);
 }
 
 /**
@@ -2059,39 +2092,71 @@ const char *format_duration(int seconds)
 }
 
 
-/* -------------------------------------------------------------------------- */
-/* Generic object <-> JSON helpers (compatible with your room_save_objects)    */
-/* -------------------------------------------------------------------------- */
+/* Object <-> JSON. The writer streams each object to fp as it is visited,
+ * with no cJSON tree in between; obj_from_json_node() reads it back. */
+static void json_write_str(FILE *fp, const char *str) {
+  const unsigned char *p;
 
-/* Serialize one object. include_contents=true if you want to allow bags with items. */
-static cJSON *json_from_obj(struct obj_data *obj, bool include_contents) {
-  if (!obj) return cJSON_CreateNull();
+  fputc('"', fp);
+  for (p = (const unsigned char *) str; *p; p++) {
+    switch (*p) {
+    case '"':  fputs("\\\"", fp); break;
+    case '\\': fputs("\\\\", fp); break;
+    case '\n': fputs("\\n", fp); break;
+    case '\r': fputs("\\r", fp); break;
+    case '\t': fputs("\\t", fp); break;
+    default:
+      if (*p < 0x20)
+        fprintf(fp, "\\u%04x", *p);
+      else
+        fputc(*p, fp);
+    }
+  }
+  fputc('"', fp);
+}
 
-  cJSON *jo = cJSON_CreateObject();
-  cJSON_AddNumberToObject(jo, "vnum", GET_OBJ_VNUM(obj));
-  cJSON_AddStringToObject(jo, "name",  obj->name ? obj->name : "undefined");
-  cJSON_AddStringToObject(jo, "short", obj->short_description ? obj->short_description : "undefined");
-  cJSON_AddStringToObject(jo, "desc",  obj->description ? obj->description : "undefined");
-  cJSON_AddNumberToObject(jo, "type",   GET_OBJ_TYPE(obj));
-  cJSON_AddNumberToObject(jo, "weight", GET_OBJ_WEIGHT(obj));
-  cJSON_AddNumberToObject(jo, "cost",   GET_OBJ_COST(obj));
-  cJSON_AddNumberToObject(jo, "timer",  GET_OBJ_TIMER(obj));
-  cJSON_AddNumberToObject(jo, "level",  obj->obj_flags.level);
+static void json_write_ints(FILE *fp, const char *key, const int *vals, int count) {
+  fprintf(fp, ",\"%s\":[", key);
+  for (int i = 0; i < count; i++)
+    fprintf(fp, i ? ",%d" : "%d", vals[i]);
+  fputc(']', fp);
+}
 
-  cJSON_AddItemToObject(jo, "val",   cJSON_CreateIntArray(&(obj->obj_flags.value[0]), 4));
-  cJSON_AddItemToObject(jo, "extra", cJSON_CreateIntArray(GET_OBJ_EXTRA(obj), 4));
-  cJSON_AddItemToObject(jo, "wear",  cJSON_CreateIntArray(GET_OBJ_WEAR(obj), 4));
+/* A container is written with its own weight, as obj_to_obj() adds back its
+ * contents' when they are loaded into it. */
+static void json_write_obj(FILE *fp, struct obj_data *obj, bool include_contents) {
+  struct obj_data *cont;
+  int weight = GET_OBJ_WEIGHT(obj);
+  bool first = TRUE;
+
+  if (GET_OBJ_VAL(obj, 0) > 0)
+    for (cont = obj->contains; cont; cont = cont->next_content)
+      weight -= GET_OBJ_WEIGHT(cont);
+
+  fprintf(fp, "{\"vnum\":%d,\"name\":", GET_OBJ_VNUM(obj));
+  json_write_str(fp, obj->name ? obj->name : "undefined");
+  fputs(",\"short\":", fp);
+  json_write_str(fp, obj->short_description ? obj->short_description : "undefined");
+  fputs(",\"desc\":", fp);
+  json_write_str(fp, obj->description ? obj->description : "undefined");
+  fprintf(fp, ",\"type\":%d,\"weight\":%d,\"cost\":%d,\"timer\":%d,\"level\":%d",
+          GET_OBJ_TYPE(obj), weight, GET_OBJ_COST(obj), GET_OBJ_TIMER(obj), obj->obj_flags.level);
+  json_write_ints(fp, "val", obj->obj_flags.value, 4);
+  json_write_ints(fp, "extra", GET_OBJ_EXTRA(obj), 4);
+  json_write_ints(fp, "wear", GET_OBJ_WEAR(obj), 4);
 
   if (include_contents && GET_OBJ_TYPE(obj) == ITEM_CONTAINER && obj->contains) {
-    cJSON *arr = cJSON_CreateArray();
-    for (struct obj_data *cont = obj->contains; cont; cont = cont->next_content) {
+    fputs(",\"contents\":[", fp);
+    for (cont = obj->contains; cont; cont = cont->next_content) {
       if (!should_persist_object(cont)) continue;
-      cJSON_AddItemToArray(arr, json_from_obj(cont, /*include_contents=*/true));
+      if (!first)
+        fputc(',', fp);
+      json_write_obj(fp, cont, TRUE);
+      first = FALSE;
     }
-    cJSON_AddItemToObject(jo, "contents", arr);
+    fputc(']', fp);
   }
-
-  return jo;
+  fputc('}', fp);
 }
 
 /* Deserialize one object */
@@ -2107,7 +2172,10 @@ static struct obj_data *obj_from_json_node(const cJSON *jo, bool include_content
   const cJSON *jname  = cJSON_GetObjectItemCaseSensitive(jo, "name");
   const cJSON *jshort = cJSON_GetObjectItemCaseSensitive(jo, "short");
   const cJSON *jdesc  = cJSON_GetObjectItemCaseSensitive(jo, "desc");
-  if (cJSON_IsString(jname)  && jname->valuestring)  obj->name = strdup(jname->valuestring);
+  if (cJSON_IsString(jname)  && jname->valuestring) {
+    obj->name = strdup(jname->valuestring);
+    kw_reindex_obj(obj);
+  }
   if (cJSON_IsString(jshort) && jshort->valuestring) obj->short_description = strdup(jshort->valuestring);
   if (cJSON_IsString(jdesc)  && jdesc->valuestring)  obj->description = strdup(jdesc->valuestring);
 
@@ -2167,13 +2235,163 @@ static void stash_path(const char *accname, char *out, size_t n) {
   snprintf(out, n, ACCOUNT_STASH_PATH "%s.json", accname);
 }
 
+/* Stashes changed since they were last saved, in the order they were first
+ * changed. A stash is listed while its dirty flag is set. */
+static struct account_stash **dirty_stashes = NULL;
+static int num_dirty_stashes = 0, max_dirty_stashes = 0;
+
+/* The stash is saved by the next acc_stash_save_dirty(), however many times
+ * it changes before then. */
+static void stash_mark_dirty(struct account_stash *st) {
+  if (st->dirty) return;
+  st->dirty = 1;
+  if (num_dirty_stashes == max_dirty_stashes) {
+    max_dirty_stashes = MAX(16, max_dirty_stashes * 2);
+    RECREATE(dirty_stashes, struct account_stash *, max_dirty_stashes);
+  }
+  dirty_stashes[num_dirty_stashes++] = st;
+}
+
+/* Slot index. Every occupied slot is chained into the bucket of its item's
+ * key, so finding a stack to join only compares the items in one bucket, and
+ * free_map finds an empty slot a word of slots at a time. */
+#define STASH_MAP_BITS  (8 * (int) sizeof(unsigned long))
+
+static unsigned long stash_hash(unsigned long h, const void *data, size_t len) {
+  const unsigned char *p = data;
+
+  while (len--) {
+    h ^= *p++;
+    h *= 16777619UL;
+  }
+  return h;
+}
+
+/* Hashes what stash_same_item() compares, field by field so that padding
+ * in obj_flag_data does not count. */
+static unsigned long stash_item_key(struct obj_data *obj) {
+  const struct obj_flag_data *f = &obj->obj_flags;
+  obj_vnum vnum = GET_OBJ_VNUM(obj);
+  unsigned long h = 2166136261UL;
+
+  h = stash_hash(h, &vnum, sizeof(vnum));
+  if (obj->name)
+    h = stash_hash(h, obj->name, strlen(obj->name));
+  if (obj->short_description)
+    h = stash_hash(h, obj->short_description, strlen(obj->short_description));
+  h = stash_hash(h, f->value, sizeof(f->value));
+  h = stash_hash(h, &f->type_flag, sizeof(f->type_flag));
+  h = stash_hash(h, &f->level, sizeof(f->level));
+  h = stash_hash(h, f->wear_flags, sizeof(f->wear_flags));
+  h = stash_hash(h, f->extra_flags, sizeof(f->extra_flags));
+  h = stash_hash(h, &f->weight, sizeof(f->weight));
+  h = stash_hash(h, &f->cost, sizeof(f->cost));
+  h = stash_hash(h, &f->cost_per_day, sizeof(f->cost_per_day));
+  h = stash_hash(h, &f->timer, sizeof(f->timer));
+  h = stash_hash(h, f->bitvector, sizeof(f->bitvector));
+  return h;
+}
+
+/* Whether obj can be stacked onto a slot holding stored. */
+static bool stash_same_item(struct obj_data *stored, struct obj_data *obj) {
+  return GET_OBJ_VNUM(stored) == GET_OBJ_VNUM(obj) &&
+         !strcmp(stored->name, obj->name) &&
+         !strcmp(stored->short_description, obj->short_description) &&
+         memcmp(&stored->obj_flags, &obj->obj_flags, sizeof(struct obj_flag_data)) == 0;
+}
+
+static void stash_index_add(struct account_stash *st, int slot) {
+  struct account_stash_slot *s = &st->slots[slot];
+  int b;
+
+  s->key = stash_item_key(s->obj);
+  b = s->key & (st->num_buckets - 1);
+  s->next = st->buckets[b];
+  st->buckets[b] = slot;
+  st->free_map[slot / STASH_MAP_BITS] &= ~(1UL << (slot % STASH_MAP_BITS));
+}
+
+static void stash_index_remove(struct account_stash *st, int slot) {
+  int *p = &st->buckets[st->slots[slot].key & (st->num_buckets - 1)];
+
+  while (*p != slot)
+    p = &st->slots[*p].next;
+  *p = st->slots[slot].next;
+  st->free_map[slot / STASH_MAP_BITS] |= 1UL << (slot % STASH_MAP_BITS);
+}
+
+/* (Re)build the index for the current slots and capacity. */
+static void stash_build_index(struct account_stash *st) {
+  int i, words = (st->capacity + STASH_MAP_BITS - 1) / STASH_MAP_BITS;
+
+  for (st->num_buckets = 16; st->num_buckets < st->capacity; st->num_buckets <<= 1)
+    ;
+  free(st->buckets);
+  free(st->free_map);
+  CREATE(st->buckets, int, st->num_buckets);
+  CREATE(st->free_map, unsigned long, MAX(words, 1));
+
+  for (i = 0; i < st->num_buckets; i++)
+    st->buckets[i] = -1;
+  for (i = 0; i < st->capacity; i++) {
+    if (st->slots[i].obj)
+      stash_index_add(st, i);
+    else
+      st->free_map[i / STASH_MAP_BITS] |= 1UL << (i % STASH_MAP_BITS);
+  }
+}
+
+/* The slot holding a stack obj can join, or -1. */
+static int stash_find_stack(struct account_stash *st, struct obj_data *obj) {
+  unsigned long key = stash_item_key(obj);
+  int i;
+
+  for (i = st->buckets[key & (st->num_buckets - 1)]; i >= 0; i = st->slots[i].next)
+    if (st->slots[i].key == key && stash_same_item(st->slots[i].obj, obj))
+      return i;
+  return -1;
+}
+
+/* The lowest empty slot, or -1 if the stash is full. */
+static int stash_first_free(struct account_stash *st) {
+  int w, b;
+
+  for (w = 0; w * STASH_MAP_BITS < st->capacity; w++)
+    if (st->free_map[w]) {
+      for (b = 0; !(st->free_map[w] & (1UL << b)); b++)
+        ;
+      return w * STASH_MAP_BITS + b;
+    }
+  return -1;
+}
+
+static void stash_fill_slot(struct account_stash *st, int slot, struct obj_data *obj, int count) {
+  st->slots[slot].obj = obj;  /* stash owns it now */
+  st->slots[slot].count = count;
+  st->used++;
+  stash_index_add(st, slot);
+  stash_mark_dirty(st);
+}
+
+/* Empties an occupied slot; the caller becomes owner of the object. */
+static struct obj_data *stash_empty_slot(struct account_stash *st, int slot) {
+  struct obj_data *obj = st->slots[slot].obj;
+
+  stash_index_remove(st, slot);
+  st->slots[slot].obj = NULL;
+  st->slots[slot].count = 0;
+  if (st->used > 0) st->used--;
+  stash_mark_dirty(st);
+  return obj;
+}
+
 /* Lazy init */
 static struct account_stash *stash_new(int cap) {
   if (cap < 0) cap = 0;
   struct account_stash *st = calloc(1, sizeof(*st));
   st->capacity = cap;
   st->slots = calloc(cap, sizeof(*st->slots));
-  st->dirty = true;
+  stash_build_index(st);
   return st;
 }
 
@@ -2185,72 +2403,37 @@ static const char *acc_name_for(struct char_data *ch) {
 static struct account_stash *acc_get_or_load_stash(struct char_data *ch) {
   struct account_data *acc = GET_ACCOUNT(ch);
   if (!acc) return NULL;
-  if (!acc->stash) (void)stash_load_json(acc->name, &acc->stash);
+  if (!acc->stash && stash_load_json(acc->name, &acc->stash))
+    acc->stash->owner = acc;
   return acc->stash;
 }
 
-/* Replaces stash_put_vnum(...) */
-static bool stash_put_obj(struct account_stash *st, struct obj_data *obj) {
-  if (!st || !obj) return false;
-
-  /* Optional policy: block containers with contents or non-persist items */
-  if (GET_OBJ_TYPE(obj) == ITEM_CONTAINER && obj->contains) return false;
-  if (!should_persist_object(obj)) return false;
-
-  for (int i = 0; i < st->capacity; ++i) {
-    if (!st->slots[i].obj) {
-      st->slots[i].obj = obj;  /* stash owns it now */
-      st->used++;
-      st->dirty = 1;
-      return true;
-    }
-  }
-  return false; /* no free slot */
-}
-
 /* Returns the object pointer (caller becomes owner). NULL if empty/invalid. */
 static struct obj_data *stash_take_slot(struct account_stash *st, int slot) {
   if (!st || slot < 0 || slot >= st->capacity) return NULL;
-  struct obj_data *obj = st->slots[slot].obj;
-  if (!obj) return NULL;
-  st->slots[slot].obj = NULL;
-  if (st->used > 0) st->used--;
-  st->dirty = 1;
-  return obj;
+  if (!st->slots[slot].obj) return NULL;
+  return stash_empty_slot(st, slot);
 }
 
 static bool stash_set_capacity(struct account_stash *st, int newcap) {
   if (!st || newcap < 0) return false;
   if (newcap == st->capacity) return true;
 
+  /* Reject a shrink that would drop objects; the admin must empty those
+     slots first. */
+  for (int i = newcap; i < st->capacity; ++i)
+    if (st->slots[i].obj)
+      return false;
+
   struct account_stash_slot *ns = calloc(newcap, sizeof(*ns));
-  int kept = 0;
-  /* keep the first newcap objects; drop beyond newcap (admin must ensure safe shrink) */
-  for (int i = 0; i < newcap && i < st->capacity; ++i) {
-    ns[i].obj = st->slots[i].obj;
-    if (ns[i].obj) kept++;
-  }
-  /* NOTE: if newcap < old capacity and there are objects beyond newcap,
-     they will be leaked unless we handle them. Either:
-       - reject shrink when it would drop objects (recommended), OR
-       - extract_obj() those beyond newcap here.
-     For safety, reject shrink if any would be dropped:
-  */
-  if (newcap < st->capacity) {
-    for (int i = newcap; i < st->capacity; ++i) {
-      if (st->slots[i].obj) {
-        /* reject shrink */
-        free(ns);
-        return false;
-      }
-    }
-  }
+  for (int i = 0; i < newcap && i < st->capacity; ++i)
+    ns[i] = st->slots[i];
 
   free(st->slots);
   st->slots = ns;
   st->capacity = newcap;
-  st->used = kept;
-  st->dirty = 1;
+  stash_build_index(st);
+  stash_mark_dirty(st);
   return true;
 }
 
@@ -2259,13 +2442,13 @@ static bool stash_load_json(const char *accname, struct account_stash **out) {
   ensure_stash_dirs();
   char path[1024]; stash_path(accname, path, sizeof(path));
 
+  /* A save of this stash may still be queued from an earlier login. */
+  saveq_wait(path);
+
   FILE *fp = fopen(path, "rb");
   if (!fp) {
-    struct account_stash *st = calloc(1, sizeof(*st));
-    st->capacity = 10;
-    st->slots = calloc(st->capacity, sizeof(*st->slots));
-    st->used = 0; st->dirty = 0;
-    *out = st; return true;
+    *out = stash_new(10);
+    return true;
   }
 
   fseek(fp, 0, SEEK_END);
@@ -2283,63 +2466,93 @@ static bool stash_load_json(const char *accname, struct account_stash **out) {
   const cJSON *jcap = cJSON_GetObjectItemCaseSensitive(root, "capacity");
   if (cJSON_IsNumber(jcap)) cap = jcap->valueint;
 
-  struct account_stash *st = calloc(1, sizeof(*st));
-  st->capacity = cap;
-  st->slots = calloc(st->capacity, sizeof(*st->slots));
-  st->used = 0; st->dirty = 0;
+  struct account_stash *st = stash_new(cap);
 
   const cJSON *jslots = cJSON_GetObjectItemCaseSensitive(root, "slots");
   if (cJSON_IsArray(jslots)) {
     cJSON *it = NULL;
     cJSON_ArrayForEach(it, jslots) {
-      const cJSON *jslot = cJSON_GetObjectItemCaseSensitive(it, "slot");
-      const cJSON *jobj  = cJSON_GetObjectItemCaseSensitive(it, "obj");
+      const cJSON *jslot  = cJSON_GetObjectItemCaseSensitive(it, "slot");
+      const cJSON *jcount = cJSON_GetObjectItemCaseSensitive(it, "count");
+      const cJSON *jobj   = cJSON_GetObjectItemCaseSensitive(it, "obj");
       if (!cJSON_IsNumber(jslot)) continue;
       int s = jslot->valueint;
-      if (s < 0 || s >= st->capacity) continue;
+      if (s < 0 || s >= st->capacity || st->slots[s].obj) continue;
       if (jobj && !cJSON_IsNull(jobj)) {
         st->slots[s].obj = obj_from_json_node(jobj, /*include_contents=*/false);
-        if (st->slots[s].obj) st->used++;
+        if (st->slots[s].obj) {
+          /* Files from before counts were saved hold one item per slot. */
+          st->slots[s].count = cJSON_IsNumber(jcount) ? MAX(1, jcount->valueint) : 1;
+          st->used++;
+        }
       }
     }
   }
   cJSON_Delete(root);
+  stash_build_index(st);
   *out = st;
   return true;
 }
 
-/* SAVE */
+/* SAVE: written straight into the save queue, one entry per occupied slot. */
 static bool stash_save_json(const char *accname, const struct account_stash *st) {
+  FILE *fp;
+  bool first = true;
+
   if (!st) return true;
   ensure_stash_dirs();
   char path[1024]; stash_path(accname, path, sizeof(path));
 
-  cJSON *root = cJSON_CreateObject();
-  cJSON_AddNumberToObject(root, "capacity", st->capacity);
+  if (!(fp = saveq_open(path)))
+    return false;
 
-  cJSON *slots = cJSON_CreateArray();
+  fprintf(fp, "{\"capacity\":%d,\"slots\":[", st->capacity);
   for (int i = 0; i < st->capacity; ++i) {
-    cJSON *entry = cJSON_CreateObject();
-    cJSON_AddNumberToObject(entry, "slot", i);
-    if (st->slots[i].obj) {
-      cJSON_AddItemToObject(entry, "obj",
-        json_from_obj(st->slots[i].obj, /*include_contents=*/false));
-    } else {
-      cJSON_AddItemToObject(entry, "obj", cJSON_CreateNull());
-    }
-    cJSON_AddItemToArray(slots, entry);
+    if (!st->slots[i].obj) continue;
+    fprintf(fp, "%s\n{\"slot\":%d,\"count\":%d,\"obj\":", first ? "" : ",",
+            i, MAX(1, st->slots[i].count));
+    json_write_obj(fp, st->slots[i].obj, /*include_contents=*/false);
+    fputc('}', fp);
+    first = false;
   }
-  cJSON_AddItemToObject(root, "slots", slots);
+  fputs("\n]}\n", fp);
 
-  char *json = cJSON_PrintBuffered(root, 4096, 1);
-  cJSON_Delete(root);
+  return saveq_commit(fp);
+}
 
-  FILE *fp = fopen(path, "wb");
-  if (!fp) { free(json); return false; }
-  fwrite(json, 1, strlen(json), fp);
-  fclose(fp);
-  free(json);
-  return true;
+/* Take a stash off the dirty list and save it now. */
+static void stash_save_now(struct account_stash *st) {
+  for (int i = 0; i < num_dirty_stashes; ++i)
+    if (dirty_stashes[i] == st) {
+      dirty_stashes[i] = dirty_stashes[--num_dirty_stashes];
+      break;
+    }
+  st->dirty = 0;
+  (void)stash_save_json(st->owner->name, st);
+}
+
+/* Save a character's stash if it changed, and wait until it is written.
+ * Call before journaling objects that moved in or out of the stash, so a
+ * crash cannot leave the two disagreeing. */
+void acc_stash_flush(struct char_data *ch) {
+  struct account_data *acc = GET_ACCOUNT(ch);
+  char path[1024];
+
+  if (!acc || !acc->stash || !acc->stash->dirty)
+    return;
+  stash_save_now(acc->stash);
+  stash_path(acc->name, path, sizeof(path));
+  saveq_wait(path);
+}
+
+/* Save every stash changed since the last call. Called every PULSE_PERSIST
+ * and before shutdown or copyover. */
+void acc_stash_save_dirty(void) {
+  for (int i = 0; i < num_dirty_stashes; i++) {
+    dirty_stashes[i]->dirty = 0;
+    (void)stash_save_json(dirty_stashes[i]->owner->name, dirty_stashes[i]);
+  }
+  num_dirty_stashes = 0;
 }
 
 void acc_stash_list(struct char_data *ch) {
@@ -2350,10 +2563,7 @@ void acc_stash_list(struct char_data *ch) {
   }
 
   /* Lazy-load if not already loaded */
-  if (!acc->stash)
-    (void)stash_load_json(acc->name, &acc->stash);
-
-  struct account_stash *st = acc->stash;
+  struct account_stash *st = acc_get_or_load_stash(ch);
   if (!st) {
     send_to_char(ch, "\trCould not load your stash.\tn\r\n");
     return;
@@ -2375,12 +2585,6 @@ void acc_stash_list(struct char_data *ch) {
                    name);
     }
   }
-
-  /* Auto-save if stash changed */
-  if (st->dirty) {
-    (void)stash_save_json(acc->name, st);
-    st->dirty = 0;
-  }
 }
 
 bool acc_stash_put_obj(struct char_data *ch, struct obj_data *obj) {
@@ -2390,10 +2594,7 @@ bool acc_stash_put_obj(struct char_data *ch, struct obj_data *obj) {
     return false;
   }
 
-  if (!acc->stash)
-    (void)stash_load_json(acc->name, &acc->stash);
-
-  struct account_stash *st = acc->stash;
+  struct account_stash *st = acc_get_or_load_stash(ch);
   if (!st) {
     send_to_char(ch, "\trCould not load your stash.\tn\r\n");
     return false;
@@ -2405,43 +2606,33 @@ bool acc_stash_put_obj(struct char_data *ch, struct obj_data *obj) {
   }
 
   /* First, try to stack with an existing identical item */
-  for (int i = 0; i < st->capacity; i++) {
-    if (st->slots[i].obj &&
-        GET_OBJ_VNUM(st->slots[i].obj) == GET_OBJ_VNUM(obj) &&
-        !strcmp(st->slots[i].obj->name, obj->name) &&
-        !strcmp(st->slots[i].obj->short_description, obj->short_description) &&
-        memcmp(&st->slots[i].obj->obj_flags, &obj->obj_flags, sizeof(struct obj_flag_data)) == 0) {
-
-      st->slots[i].count++;
-      st->dirty = true;
-      obj_from_char(obj);
-      extract_obj(obj);
+  int i = stash_find_stack(st, obj);
+  if (i >= 0) {
+    st->slots[i].count++;
+    stash_mark_dirty(st);
+    obj_from_char(obj);
+    extract_obj(obj);
 
     char buf[MAX_STRING_LENGTH];
     snprintf(buf, sizeof(buf), "\tgYou stack $p into slot\tn \ty%d\tn.", i + 1);
     act(buf, FALSE, ch, st->slots[i].obj, NULL, TO_CHAR);
 
     act("\tg$n stacks $p into a stash.\tn", TRUE, ch, st->slots[i].obj, NULL, TO_ROOM);
-      return true;
-    }
+    return true;
   }
 
   /* Otherwise, put in first empty slot */
-  for (int i = 0; i < st->capacity; i++) {
-    if (!st->slots[i].obj) {
-      obj_from_char(obj);
-      st->slots[i].obj = obj;
-      st->slots[i].count = 1;
-      st->used++;
-      st->dirty = true;
+  i = stash_first_free(st);
+  if (i >= 0) {
+    obj_from_char(obj);
+    stash_fill_slot(st, i, obj, 1);
 
     char buf[MAX_STRING_LENGTH];
     snprintf(buf, sizeof(buf), "\tgYou stash $p into slot\tn \ty%d\tn.", i + 1);
     act(buf, FALSE, ch, obj, NULL, TO_CHAR);
 
     act("\tg$n stashes $p into a stash.\tn", TRUE, ch, obj, NULL, TO_ROOM);
-      return true;
-    }
+    return true;
   }
 
   send_to_char(ch, "\trYour stash is full.\tn\r\n");
@@ -2449,10 +2640,7 @@ bool acc_stash_put_obj(struct char_data *ch, struct obj_data *obj) {
 }
 
 bool acc_stash_take_to_char(struct char_data *ch, int slot) {
-  struct account_data *acc = GET_ACCOUNT(ch);
-  if (!acc) return false;
-  if (!acc->stash) (void)stash_load_json(acc->name, &acc->stash);
-  struct account_stash *st = acc->stash;
+  struct account_stash *st = acc_get_or_load_stash(ch);
   if (!st) return false;
 
   struct obj_data *obj = stash_take_slot(st, slot);
@@ -2460,33 +2648,35 @@ bool acc_stash_take_to_char(struct char_data *ch, int slot) {
 
   obj_to_char(obj, ch);
   act("\tgYou withdraw $p from your stash.\tn", false, ch, obj, 0, TO_CHAR);
-  (void)stash_save_json(acc->name, st); st->dirty = 0;
   return true;
 }
 
 bool acc_stash_set_capacity(struct char_data *ch, int newcap) {
-  struct account_data *acc = GET_ACCOUNT(ch);
-  if (!acc) return false;
-  if (!acc->stash) (void)stash_load_json(acc->name, &acc->stash);
-  struct account_stash *st = acc->stash;
+  struct account_stash *st = acc_get_or_load_stash(ch);
   if (!st) return false;
 
-  bool ok = stash_set_capacity(st, newcap);
-  if (ok) { (void)stash_save_json(acc->name, st); st->dirty = 0; }
-  return ok;
+  return stash_set_capacity(st, newcap);
 }
 
 /* utils.c */
 void acc_stash_free(struct account_data *acc) {
   if (!acc || !acc->stash) return;
-  for (int i = 0; i < acc->stash->capacity; ++i) {
-    if (acc->stash->slots[i].obj) {
-      extract_obj(acc->stash->slots[i].obj);
-      acc->stash->slots[i].obj = NULL;
+  struct account_stash *st = acc->stash;
+
+  /* Save now rather than at the next flush, which would find it gone. */
+  if (st->dirty)
+    stash_save_now(st);
+
+  for (int i = 0; i < st->capacity; ++i) {
+    if (st->slots[i].obj) {
+      extract_obj(st->slots[i].obj);
+      st->slots[i].obj = NULL;
     }
   }
-  free(acc->stash->slots);
-  free(acc->stash);
+  free(st->slots);
+  free(st->buckets);
+  free(st->free_map);
+  free(st);
   acc->stash = NULL;
 }
 
@@ -2499,10 +2689,7 @@ bool acc_stash_put_obj_in_slot(struct char_data *ch, struct obj_data *obj, int s
     return false;
   }
 
-  if (!acc->stash)
-    (void)stash_load_json(acc->name, &acc->stash);
-
-  struct account_stash *st = acc->stash;
+  struct account_stash *st = acc_get_or_load_stash(ch);
   if (!st) {
     send_to_char(ch, "\trCould not load your stash.\tn\r\n");
     return false;
@@ -2520,13 +2707,11 @@ bool acc_stash_put_obj_in_slot(struct char_data *ch, struct obj_data *obj, int s
 
   /* If slot already contains identical item → stack */
   if (st->slots[slot].obj &&
-      GET_OBJ_VNUM(st->slots[slot].obj) == GET_OBJ_VNUM(obj) &&
-      !strcmp(st->slots[slot].obj->name, obj->name) &&
-      !strcmp(st->slots[slot].obj->short_description, obj->short_description) &&
-      memcmp(&st->slots[slot].obj->obj_flags, &obj->obj_flags, sizeof(struct obj_flag_data)) == 0) {
+      st->slots[slot].key == stash_item_key(obj) &&
+      stash_same_item(st->slots[slot].obj, obj)) {
 
     st->slots[slot].count++;
-    st->dirty = true;
+    stash_mark_dirty(st);
     obj_from_char(obj);
     extract_obj(obj);
 
@@ -2541,10 +2726,7 @@ bool acc_stash_put_obj_in_slot(struct char_data *ch, struct obj_data *obj, int s
   /* If slot is empty → put item */
   if (!st->slots[slot].obj) {
     obj_from_char(obj);
-    st->slots[slot].obj = obj;
-    st->slots[slot].count = 1;
-    st->used++;
-    st->dirty = true;
+    stash_fill_slot(st, slot, obj, 1);
 
     char buf[MAX_STRING_LENGTH];
     snprintf(buf, sizeof(buf), "\tgYou stash $p into slot\tn \ty%d\tn.", slot + 1);
@@ -2569,10 +2751,7 @@ bool acc_stash_take_from_slot(struct char_data *ch, int slot) {
   }
 
   /* Lazy-load the stash if not loaded */
-  if (!acc->stash)
-    (void)stash_load_json(acc->name, &acc->stash);
-
-  struct account_stash *st = acc->stash;
+  struct account_stash *st = acc_get_or_load_stash(ch);
   if (!st) {
     send_to_char(ch, "\trCould not load your stash.\tn\r\n");
     return false;
@@ -2596,6 +2775,7 @@ bool acc_stash_take_from_slot(struct char_data *ch, int slot) {
   if (st->slots[slot].count > 1) {
     /* Reduce count in stash */
     st->slots[slot].count--;
+    stash_mark_dirty(st);
 
     /* Create a duplicate object */
     obj = read_object(GET_OBJ_VNUM(st->slots[slot].obj), VIRTUAL);
@@ -2604,18 +2784,14 @@ bool acc_stash_take_from_slot(struct char_data *ch, int slot) {
       obj->short_description = strdup(st->slots[slot].obj->short_description);
       obj->description = strdup(st->slots[slot].obj->description);
       obj->name = strdup(st->slots[slot].obj->name);
+      kw_reindex_obj(obj);
       obj->obj_flags = st->slots[slot].obj->obj_flags;
     }
   } else {
     /* Single item → remove from stash */
-    obj = st->slots[slot].obj;
-    st->slots[slot].obj = NULL;
-    st->slots[slot].count = 0;
-    st->used--;
+    obj = stash_empty_slot(st, slot);
   }
 
-  st->dirty = true;
-
   /* Give the object to the character */
   if (obj) {
     obj_to_char(obj, ch);
@@ -76,7 +76,6 @@ void broadcast_game_message(const char *fmt, ...);
 int get_exp_percentage_bonus(struct char_data *ch);
 void kill_add(struct char_data *ch, int vnum, int count, int end);
 void room_save_objects(room_vnum vnum);
-void room_load_objects(room_vnum vnum);
 void room_save_dirty_rooms(void);
 void mark_room_dirty(room_vnum vnum);
 bool should_persist_object(struct obj_data *obj);
@@ -88,6 +87,8 @@ void strip_trailing_whitespace(char *buffer);
 const char *format_duration(int seconds);
 
 void acc_stash_free(struct account_data *acc);
+void acc_stash_save_dirty(void);
+void acc_stash_flush(struct char_data *ch);
 bool acc_stash_put_obj(struct char_data *ch, struct obj_data *obj);
 bool acc_stash_take_to_char(struct char_data *ch, int slot);
 bool acc_stash_set_capacity(struct char_data *ch, int newcap);
@@ -690,7 +691,8 @@ do                                                              \
 /* Exploration */
 #define GET_ZONES_DISCOVERED(ch)  (GET_STATISTICS(ch).zones_discovered)
 #define SET_ZONE_DISCOVERED(ch, zn) \
-  ((ch)->player_specials->saved.discovered_zones[(zn)/8] |= (1 << ((zn)%8)))
+  ((ch)->player_specials->save_dirty |= SAVE_STATS, \
+   (ch)->player_specials->saved.discovered_zones[(zn)/8] |= (1 << ((zn)%8)))
 
 #define IS_ZONE_DISCOVERED(ch, zn) \
   ((ch)->player_specials->saved.discovered_zones[(zn)/8] & (1 << ((zn)%8)))
@@ -708,7 +710,22 @@ do                                                              \
 /** The current skill level of ch for skill i. */
 #define GET_SKILL(ch, i)	CHECK_PLAYER_SPECIAL((ch), ((ch)->player_specials->saved.skills[i]))
 /** Copy the current skill level i of ch to pct. */
-#define SET_SKILL(ch, i, pct)	do { CHECK_PLAYER_SPECIAL((ch), (ch)->player_specials->saved.skills[i]) = pct; } while(0)
+#define SET_SKILL(ch, i, pct)	do { CHECK_PLAYER_SPECIAL((ch), (ch)->player_specials->saved.skills[i]) = pct; SET_SAVE_DIRTY((ch), SAVE_SKILLS); } while(0)
+
+/** The SAVE_ sections of ch that autosave still has to write. */
+#define GET_SAVE_DIRTY(ch)	CHECK_PLAYER_SPECIAL((ch), ((ch)->player_specials->save_dirty))
+/** Mark SAVE_ section(s) of ch as changed, and have a changed inventory
+ * journaled. Does nothing for mobs. */
+#define SET_SAVE_DIRTY(ch, sect)	do { if (!IS_NPC(ch)) { (ch)->player_specials->save_dirty |= (sect); \
+    if ((sect) & SAVE_INVENTORY) (ch)->player_specials->journal_objs = TRUE; } } while(0)
+/** When ch's player file was last written. */
+#define GET_LAST_SAVE(ch)	CHECK_PLAYER_SPECIAL((ch), ((ch)->player_specials->last_save))
+/** The oldest journal generation with changes to ch not yet saved, or 0. */
+#define GET_JOURNAL_GEN(ch)	CHECK_PLAYER_SPECIAL((ch), ((ch)->player_specials->journal_gen))
+/** The journal generation of ch's latest record, or 0 once ch is done. */
+#define GET_JOURNAL_LAST(ch)	CHECK_PLAYER_SPECIAL((ch), ((ch)->player_specials->journal_last))
+/** Whether ch's objects have changed since they were last journaled. */
+#define GET_JOURNAL_OBJS(ch)	CHECK_PLAYER_SPECIAL((ch), ((ch)->player_specials->journal_objs))
 
 /** The player's default sector type when buildwalking */
 #define GET_BUILDWALK_SECTOR(ch) CHECK_PLAYER_SPECIAL((ch), ((ch)->player_specials->buildwalk_sector))
@@ -1148,6 +1165,18 @@ do                                                              \
 #define CONFIG_SPECIAL_IN_COMM config_info.operation.special_in_comm
 /** Activate debug mode? */
 #define CONFIG_DEBUG_MODE config_info.operation.debug_mode
+/** Script lines that may run per pulse before triggers are suspended. */
+#define CONFIG_SCRIPT_PULSE_LINES config_info.operation.script_pulse_lines
+/** Script milliseconds that may run per pulse before triggers are suspended. */
+#define CONFIG_SCRIPT_PULSE_MSEC config_info.operation.script_pulse_msec
+/** Populate zones on first player entry instead of at boot? */
+#define CONFIG_LAZY_ZONES config_info.operation.lazy_zones
+/** Minutes an empty zone is kept populated before it is unloaded. */
+#define CONFIG_LAZY_ZONE_IDLE config_info.operation.lazy_zone_idle
+/** Write player files in the binary format? */
+#define CONFIG_BINARY_PFILES config_info.operation.binary_pfiles
+/** Write rent and house files in the binary format? */
+#define CONFIG_BINARY_OBJFILES config_info.operation.binary_objfiles
 
 /* Autowiz */
 /** Use autowiz or not? */
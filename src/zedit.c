@@ -297,6 +297,7 @@ static void zedit_save_internally(struct descriptor_data *d)
     return;
   }
 
+  finish_zone_reset(OLC_ZNUM(d));
   remove_room_zone_commands(OLC_ZNUM(d), room_num);
 
   /* Now add all the entries in the players descriptor list */
@@ -334,6 +335,7 @@ static void zedit_save_internally(struct descriptor_data *d)
     }
     add_cmd_to_list(&(zone_table[OLC_ZNUM(d)].cmd), &MYCMD, subcmd);
   }
+  compile_zone_resets(OLC_ZNUM(d));
 
   /* Finally, if zone headers have been changed, copy over */
   if (OLC_ZONE(d)->number) {